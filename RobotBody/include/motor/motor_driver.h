@@ -18,6 +18,9 @@ public:
     void stop();
     void update();  // 定期呼び出し用（ランプ・ブースト制御）
     
+    int8_t getRotationSpeed() const { return current_rotation_speed; }
+    int8_t getDriveSpeed() const { return current_drive_speed; }
+    
 private:
     // spec.mdに従ったピン配置
     static constexpr uint MOTOR1_PIN_A = 8;   // GPIO8  (PWM_6A)
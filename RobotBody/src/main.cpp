@@ -13,6 +13,7 @@
 #define FALL_THRESHOLD_DEG 45.0f  // 転倒検知：ロール/ピッチ45度以上
 #define LIFT_THRESHOLD_G 0.5f     // 持ち上げ検知：Z軸加速度0.5G未満
 #define COMM_TIMEOUT_MS 5000      // 通信タイムアウト：5秒
+#define MOTOR_RESEND_MS 1000      // モーター状態の再送間隔（変化が無くても送る）
 
 // グローバルオブジェクト
 MPU6886 imu;
@@ -96,6 +97,29 @@ void handleCommand(const uint8_t* data, size_t len) {
     }
 }
 
+// モーター状態送信（変化時と、変化が無くてもMOTOR_RESEND_MSごと: MOTOR,rot,drive）
+// Zero2W側はこれを見て自己運動中の画像処理（動き検出など）を切り替える
+// 1行の欠落やZero2W側の再起動があっても、再送で次の速度変化を待たずに状態が戻る
+void reportMotorState(uint64_t now) {
+    static int last_rotation = 0;
+    static int last_drive = 0;
+    static uint64_t last_sent = 0;
+    int rotation = motor.getRotationSpeed();
+    int drive = motor.getDriveSpeed();
+    if (rotation == last_rotation && drive == last_drive && now - last_sent < MOTOR_RESEND_MS) {
+        return;
+    }
+    last_rotation = rotation;
+    last_drive = drive;
+    last_sent = now;
+    
+    char buffer[32];
+    int len = snprintf(buffer, sizeof(buffer), "MOTOR,%d,%d\n", rotation, drive);
+    if (len > 0) {
+        uart.send((uint8_t*)buffer, len);
+    }
+}
+
 // IMUデータ送信
 void sendIMUData() {
     char buffer[64];
@@ -186,6 +210,8 @@ int main() {
     // メインループ
     uint64_t last_imu_time = 0;
     const uint64_t IMU_INTERVAL_MS = 50; // 20Hz
+    uint64_t last_motor_report_time = 0;
+    const uint64_t MOTOR_REPORT_INTERVAL_MS = 50;
     last_command_time = to_ms_since_boot(get_absolute_time());
     
     while (true) {
@@ -197,6 +223,12 @@ int main() {
         // モーター制御更新（ランプ・ブースト制御）
         motor.update();
         
+        // モーター状態通知（ランプ中の変化は20Hzに間引く）
+        if (now - last_motor_report_time >= MOTOR_REPORT_INTERVAL_MS) {
+            reportMotorState(now);
+            last_motor_report_time = now;
+        }
+        
         // 通信タイムアウト検知（縮小運転モード）
         if (!reduced_mode && (now - last_command_time > COMM_TIMEOUT_MS)) {
             reduced_mode = true;
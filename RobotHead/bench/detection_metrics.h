@@ -0,0 +1,107 @@
+/**
+ * @file detection_metrics.h
+ * @brief Detection accuracy metrics (IoU / AP / recall) for benchmark tools
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef DETECTION_METRICS_H
+#define DETECTION_METRICS_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+#include <algorithm>
+
+/** @brief 1フレーム内の1検出（AP計算用） */
+struct ScoredBox {
+    int frame;          ///< フレーム番号
+    float score;        ///< 信頼度
+    cv::Rect box;       ///< バウンディングボックス
+};
+
+/** @brief 2矩形のIoU */
+inline float rectIoU(const cv::Rect& a, const cv::Rect& b) {
+    int inter = (a & b).area();
+    int uni = a.area() + b.area() - inter;
+    return uni > 0 ? (float)inter / (float)uni : 0.0f;
+}
+
+/**
+ * @brief 単一クラスのAverage Precision（VOC all-point補間）
+ * @param predictions 全フレームの検出結果
+ * @param ground_truth フレームごとの正解矩形
+ * @param iou_threshold 正解とみなすIoU閾値
+ * @param recall_out 最終リコール（nullptr可）
+ * @return AP（正解が0件の場合は0）
+ */
+inline double averagePrecision(std::vector<ScoredBox> predictions,
+                               const std::vector<std::vector<cv::Rect>>& ground_truth,
+                               float iou_threshold, double* recall_out = nullptr) {
+    size_t num_gt = 0;
+    std::vector<std::vector<bool>> matched(ground_truth.size());
+    for (size_t f = 0; f < ground_truth.size(); ++f) {
+        num_gt += ground_truth[f].size();
+        matched[f].assign(ground_truth[f].size(), false);
+    }
+    if (recall_out) *recall_out = 0.0;
+    if (num_gt == 0) {
+        return 0.0;
+    }
+
+    std::sort(predictions.begin(), predictions.end(),
+              [](const ScoredBox& a, const ScoredBox& b) { return a.score > b.score; });
+
+    std::vector<double> precision, recall;
+    precision.reserve(predictions.size());
+    recall.reserve(predictions.size());
+    size_t tp = 0, fp = 0;
+    for (const auto& p : predictions) {
+        int best = -1;
+        float best_iou = iou_threshold;
+        if (p.frame >= 0 && p.frame < (int)ground_truth.size()) {
+            const auto& gts = ground_truth[p.frame];
+            for (size_t g = 0; g < gts.size(); ++g) {
+                float iou = rectIoU(p.box, gts[g]);
+                if (iou >= best_iou && !matched[p.frame][g]) {
+                    best_iou = iou;
+                    best = (int)g;
+                }
+            }
+        }
+        if (best >= 0) {
+            matched[p.frame][best] = true;
+            ++tp;
+        } else {
+            ++fp;
+        }
+        precision.push_back((double)tp / (double)(tp + fp));
+        recall.push_back((double)tp / (double)num_gt);
+    }
+
+    if (recall_out && !recall.empty()) *recall_out = recall.back();
+
+    // 適合率を右から単調非増加に補間して面積を求める
+    double ap = 0.0, prev_recall = 0.0;
+    for (int i = (int)precision.size() - 2; i >= 0; --i) {
+        precision[i] = std::max(precision[i], precision[i + 1]);
+    }
+    for (size_t i = 0; i < precision.size(); ++i) {
+        ap += (recall[i] - prev_recall) * precision[i];
+        prev_recall = recall[i];
+    }
+    return ap;
+}
+
+/**
+ * @brief COCO形式のAP@[0.50:0.95]（IoU閾値0.05刻みのAPの平均）
+ */
+inline double averagePrecision50to95(const std::vector<ScoredBox>& predictions,
+                                     const std::vector<std::vector<cv::Rect>>& ground_truth) {
+    double sum = 0.0;
+    for (int i = 0; i < 10; ++i) {
+        sum += averagePrecision(predictions, ground_truth, 0.50f + 0.05f * i);
+    }
+    return sum / 10.0;
+}
+
+#endif // DETECTION_METRICS_H
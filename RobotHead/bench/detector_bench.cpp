@@ -0,0 +1,500 @@
+/**
+ * @file detector_bench.cpp
+ * @brief Offline benchmark for ObjectDetector over a directory of recorded frames
+ * @author RobotC Project
+ * @date 2026-01-23
+ *
+ * 使い方:
+ *   ./detector_bench --frames <dir> --model yolov8n_320.onnx --model yolov8n_320_int8.onnx
+ *   ./detector_bench --frames <dir> --gt <label_dir> --model yolov4-tiny.weights --input-size 320 --input-size 416
+ *
+ * モデル × 入力サイズの組み合わせごとに、段階別レイテンシ（前処理/推論/デコード/NMS）、
+ * スループット、読み込みによるRSS増加、ピークRSS、personのAP@0.5・AP@[0.5:0.95]・リコールを求める。
+ * --gtを指定した場合は正解ラベル（YOLO形式: 画像と同名の.txtに "class cx cy w h"、正規化座標）に対する精度、
+ * 指定しない場合は最初のFP32モデル（無ければ最初の組み合わせ）の検出に対する一致度（agreement）を求める。
+ * 一致度は基準モデルとの差を見るもので精度ではない（表・JSONでも区別して出力する）。
+ * また、合成したINT8（CV_8S）出力テンソルをINT8のまま解析した結果と、逆量子化してFP32で解析した結果を
+ * 両方の出力形式（[1, C, N] / [N, C]）で比較する（FP32出力のモデルでは通らないINT8デコードの確認）。
+ * 結果は表形式で標準出力に、比較用のJSONを--jsonのパスに出力する。
+ * --write-manifestを付けると、既定入力サイズでの実測（latency_ms、rss_mb）をモデルのマニフェスト
+ * （<モデル名>.yaml）に書き込む。既存のマニフェストのlabels・fallbackは保持する。
+ */
+
+#include <opencv2/opencv.hpp>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <ctime>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include "detection/object_detector.h"
+#include "platform/process_stats.h"
+#include "detection_metrics.h"
+
+using namespace cv;
+using namespace std;
+
+struct StageStats {
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+};
+
+struct RunResult {
+    string model_path;
+    bool quantized = false;
+    int input_size = 0;
+    size_t frames = 0;
+    StageStats preprocess;
+    StageStats forward;
+    StageStats decode;
+    StageStats nms;
+    StageStats total;
+    double throughput_fps = 0.0;
+    double load_rss_mb = 0.0;
+    double peak_rss_mb = 0.0;
+    double person_ap50 = 0.0;
+    double person_ap50_95 = 0.0;
+    double person_recall = 0.0;
+    vector<vector<Rect>> person_boxes;   // フレームごとのperson検出
+    vector<ScoredBox> person_scored;     // AP計算用
+};
+
+// INT8出力デコードの確認結果（出力形式ごと）
+struct Int8DecodeCheck {
+    string layout;
+    size_t candidates_fp32 = 0;
+    size_t candidates_int8 = 0;
+    size_t mismatched = 0;          // クラス・スコア・矩形のいずれかが異なる候補
+    double decode_fp32_ms = 0.0;
+    double decode_int8_ms = 0.0;
+
+    bool ok() const { return candidates_fp32 == candidates_int8 && mismatched == 0 && candidates_fp32 > 0; }
+};
+
+static double percentile(vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    sort(values.begin(), values.end());
+    size_t idx = (size_t)(p * (values.size() - 1));
+    return values[idx];
+}
+
+static StageStats summarize(const vector<double>& values) {
+    StageStats s;
+    if (values.empty()) return s;
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    s.mean_ms = sum / values.size();
+    s.p50_ms = percentile(values, 0.50);
+    s.p95_ms = percentile(values, 0.95);
+    return s;
+}
+
+// YOLO形式のラベルを読み込み、指定クラスの矩形（画像座標）を返す。ファイルが無ければfalse
+static bool loadYoloLabels(const string& path, const Size& image_size, int class_id, vector<Rect>& boxes) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        return false;
+    }
+    string line;
+    while (getline(file, line)) {
+        istringstream iss(line);
+        int cls;
+        float cx, cy, w, h;
+        if (!(iss >> cls >> cx >> cy >> w >> h) || cls != class_id) {
+            continue;
+        }
+        int bw = (int)(w * image_size.width);
+        int bh = (int)(h * image_size.height);
+        boxes.push_back(Rect((int)(cx * image_size.width) - bw / 2, (int)(cy * image_size.height) - bh / 2, bw, bh));
+    }
+    return true;
+}
+
+static string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c; break;
+        }
+    }
+    return out;
+}
+
+static void writeStage(ostream& os, const char* name, const StageStats& s, bool last = false) {
+    os << "        \"" << name << "\": {\"mean_ms\": " << s.mean_ms
+       << ", \"p50_ms\": " << s.p50_ms << ", \"p95_ms\": " << s.p95_ms << "}" << (last ? "\n" : ",\n");
+}
+
+static bool writeJson(const string& path, const string& frames_dir, const string& reference, bool use_gt,
+                      int iterations, const vector<RunResult>& results, const vector<Int8DecodeCheck>& int8_checks) {
+    ofstream os(path);
+    if (!os.is_open()) {
+        cerr << "JSONファイルを開けません: " << path << endl;
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    os << "{\n"
+       << "  \"timestamp\": \"" << timestamp << "\",\n"
+       << "  \"frames_dir\": \"" << jsonEscape(frames_dir) << "\",\n"
+       << "  \"reference\": \"" << jsonEscape(reference) << "\",\n"
+       << "  \"reference_kind\": \"" << (use_gt ? "ground_truth" : "model") << "\",\n"
+       << "  \"iterations\": " << iterations << ",\n"
+       << "  \"runs\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const RunResult& r = results[i];
+        os << "    {\n"
+           << "      \"model\": \"" << jsonEscape(r.model_path) << "\",\n"
+           << "      \"int8\": " << (r.quantized ? "true" : "false") << ",\n"
+           << "      \"input_size\": " << r.input_size << ",\n"
+           << "      \"frames\": " << r.frames << ",\n"
+           << "      \"latency\": {\n";
+        writeStage(os, "preprocess", r.preprocess);
+        writeStage(os, "forward", r.forward);
+        writeStage(os, "decode", r.decode);
+        writeStage(os, "nms", r.nms);
+        writeStage(os, "total", r.total, true);
+        os << "      },\n"
+           << "      \"throughput_fps\": " << r.throughput_fps << ",\n"
+           << "      \"load_rss_mb\": " << r.load_rss_mb << ",\n"
+           << "      \"peak_rss_mb\": " << r.peak_rss_mb << ",\n"
+           << "      \"" << (use_gt ? "person" : "person_agreement") << "\": {\"ap50\": " << r.person_ap50 << ", \"ap50_95\": " << r.person_ap50_95
+           << ", \"recall50\": " << r.person_recall << "}\n"
+           << "    }" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ],\n"
+       << "  \"int8_output_decode\": [\n";
+    for (size_t i = 0; i < int8_checks.size(); i++) {
+        const Int8DecodeCheck& c = int8_checks[i];
+        os << "    {\"layout\": \"" << c.layout << "\", \"candidates_fp32\": " << c.candidates_fp32
+           << ", \"candidates_int8\": " << c.candidates_int8 << ", \"mismatched\": " << c.mismatched
+           << ", \"decode_fp32_ms\": " << c.decode_fp32_ms << ", \"decode_int8_ms\": " << c.decode_int8_ms
+           << ", \"ok\": " << (c.ok() ? "true" : "false") << "}"
+           << (i + 1 < int8_checks.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+    return true;
+}
+
+// 合成したINT8出力（正規化座標、person等を混ぜたスコア）をINT8のまま解析した結果と、
+// 逆量子化したFP32テンソルを解析した結果が一致するかを確かめる
+static Int8DecodeCheck checkInt8OutputDecode(bool channel_major) {
+    const int kClasses = 80;
+    const int kAnchors = 2100;          // yolov8n 320x320
+    const int kChannels = 4 + kClasses;
+    const float kScale = 1.0f / 200.0f; // 実数値 = (q - zero_point) * scale（[-0.5, 0.775]）
+    const int kZeroPoint = -28;
+    const float kThreshold = 0.5f;      // 量子化ドメインでは q > 72
+    const int kIterations = 200;
+
+    Int8DecodeCheck check;
+    check.layout = channel_major ? "channel_major" : "anchor_major";
+
+    int sizes[3] = {1, kChannels, kAnchors};
+    Mat q = channel_major ? Mat(3, sizes, CV_8S) : Mat(kAnchors, kChannels, CV_8S);
+    int8_t* data = q.ptr<int8_t>();
+    auto at = [&](int ch, int i) -> int8_t& {
+        return channel_major ? data[(size_t)ch * kAnchors + i] : data[(size_t)i * kChannels + ch];
+    };
+    mt19937 rng(23);
+    uniform_int_distribution<int> coord(kZeroPoint, 127);       // 0〜0.775
+    uniform_int_distribution<int> background(-128, 60);         // 閾値未満
+    uniform_int_distribution<int> object(90, 127);              // 閾値超え
+    for (int i = 0; i < kAnchors; i++) {
+        for (int ch = 0; ch < 4; ch++) {
+            at(ch, i) = (int8_t)coord(rng);
+        }
+        bool is_object = (rng() % 50 == 0);
+        int main_class = (int)(rng() % kClasses);
+        for (int c = 0; c < kClasses; c++) {
+            at(4 + c, i) = (int8_t)((is_object && c == main_class) ? object(rng) : background(rng));
+        }
+    }
+    // 逆量子化はデコードと同じ式で行う（convertToの丸めの違いで矩形が1px変わらないように）
+    Mat f = channel_major ? Mat(3, sizes, CV_32F) : Mat(kAnchors, kChannels, CV_32F);
+    float* dequantized = f.ptr<float>();
+    for (size_t k = 0; k < q.total(); k++) {
+        dequantized[k] = ((float)data[k] - (float)kZeroPoint) * kScale;
+    }
+
+    // 正規化座標の出力として240x320のフレームに戻す
+    const float scale_x = 240.0f;
+    const float scale_y = 320.0f;
+    NmsBuffer nms_f32, nms_s8;
+    vector<float> best_f32;
+    vector<int8_t> best_s8;
+    vector<int> best_classes;
+
+    auto t0 = chrono::steady_clock::now();
+    for (int it = 0; it < kIterations; it++) {
+        nms_f32.clear();
+        collectYOLOv8Candidates(f, kThreshold, scale_x, scale_y, best_f32, best_classes, nms_f32);
+    }
+    auto t1 = chrono::steady_clock::now();
+    for (int it = 0; it < kIterations; it++) {
+        nms_s8.clear();
+        collectYOLOv8Candidates(q, kScale, kZeroPoint, kThreshold, scale_x, scale_y, best_s8, best_classes, nms_s8);
+    }
+    auto t2 = chrono::steady_clock::now();
+    check.decode_fp32_ms = chrono::duration<double, milli>(t1 - t0).count() / kIterations;
+    check.decode_int8_ms = chrono::duration<double, milli>(t2 - t1).count() / kIterations;
+
+    check.candidates_fp32 = nms_f32.size();
+    check.candidates_int8 = nms_s8.size();
+    size_t n = min(nms_f32.size(), nms_s8.size());
+    for (size_t i = 0; i < n; i++) {
+        if (nms_f32.classId((int)i) != nms_s8.classId((int)i) ||
+            fabs(nms_f32.score((int)i) - nms_s8.score((int)i)) > 1e-6f ||
+            nms_f32.box((int)i) != nms_s8.box((int)i)) {
+            check.mismatched++;
+        }
+    }
+    return check;
+}
+
+static void printUsage(const char* prog) {
+    cerr << "使い方: " << prog << " --frames <dir> --model <path> [--model <path> ...]"
+         << " [--input-size N ...] [--gt <label_dir>] [--gt-person-class N]"
+         << " [--labels <coco.names>] [--warmup N] [--iterations N] [--json <path>] [--write-manifest]" << endl;
+}
+
+int main(int argc, char** argv) {
+    string frames_dir;
+    string gt_dir;
+    string labels_path = "./Data/models/coco.names";
+    string json_path = "detector_bench_result.json";
+    vector<string> model_paths;
+    vector<int> input_sizes;
+    int gt_person_class = 0;
+    int warmup = 3;
+    int iterations = 1;
+    bool write_manifest = false;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--frames" && i + 1 < argc) {
+            frames_dir = argv[++i];
+        } else if (arg == "--model" && i + 1 < argc) {
+            model_paths.push_back(argv[++i]);
+        } else if (arg == "--input-size" && i + 1 < argc) {
+            input_sizes.push_back(atoi(argv[++i]));
+        } else if (arg == "--gt" && i + 1 < argc) {
+            gt_dir = argv[++i];
+        } else if (arg == "--gt-person-class" && i + 1 < argc) {
+            gt_person_class = atoi(argv[++i]);
+        } else if (arg == "--labels" && i + 1 < argc) {
+            labels_path = argv[++i];
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            warmup = atoi(argv[++i]);
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = max(1, atoi(argv[++i]));
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (arg == "--write-manifest") {
+            write_manifest = true;
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    if (frames_dir.empty() || model_paths.empty()) {
+        printUsage(argv[0]);
+        return -1;
+    }
+    if (input_sizes.empty()) {
+        input_sizes.push_back(0);   // 0 = モデルの既定サイズ
+    }
+
+    // フレーム読み込み（計測対象外）
+    vector<String> files, png_files;
+    glob(frames_dir + "/*.jpg", files, false);
+    glob(frames_dir + "/*.png", png_files, false);
+    files.insert(files.end(), png_files.begin(), png_files.end());
+    sort(files.begin(), files.end());
+
+    vector<Mat> frames;
+    vector<vector<Rect>> ground_truth;
+    size_t missing_labels = 0;
+    for (const auto& f : files) {
+        Mat img = imread(f);
+        if (img.empty()) {
+            continue;
+        }
+        frames.push_back(img);
+
+        if (!gt_dir.empty()) {
+            string name = f.substr(f.find_last_of('/') + 1);
+            string label_path = gt_dir + "/" + name.substr(0, name.find_last_of('.')) + ".txt";
+            vector<Rect> boxes;
+            if (!loadYoloLabels(label_path, img.size(), gt_person_class, boxes)) {
+                missing_labels++;   // ラベルファイルが無いフレームは正解0件として扱う
+            }
+            ground_truth.push_back(boxes);
+        }
+    }
+    if (frames.empty()) {
+        cerr << "フレームが見つかりません: " << frames_dir << endl;
+        return -1;
+    }
+    cout << "フレーム数: " << frames.size() << endl;
+    if (!gt_dir.empty()) {
+        cout << "正解ラベル: " << gt_dir << "（ラベル無し " << missing_labels << "フレーム）" << endl;
+    }
+
+    vector<RunResult> results;
+    for (const auto& model_path : model_paths) {
+        size_t rss_before = readRssKb();
+        ObjectDetector* detector = nullptr;
+        try {
+            detector = new ObjectDetector(model_path, labels_path, 0.25f);
+        } catch (const exception& e) {
+            cerr << "モデルの読み込みに失敗しました: " << model_path << " (" << e.what() << ")" << endl;
+            continue;
+        }
+        double load_rss_mb = ((double)readRssKb() - (double)rss_before) / 1024.0;
+
+        for (int requested_size : input_sizes) {
+            // 固定入力のモデル（ONNX）は既定サイズ以外を指定しても変えられない
+            if (requested_size > 0 && requested_size != detector->inputSize() && !detector->supportsVariableInput()) {
+                cerr << model_path << ": 入力サイズ " << requested_size << " は指定できません（固定入力モデル）" << endl;
+                continue;
+            }
+
+            RunResult r;
+            r.model_path = model_path;
+            r.quantized = detector->isQuantized();
+            r.input_size = requested_size > 0 ? requested_size : detector->inputSize();
+            r.frames = frames.size();
+            r.load_rss_mb = load_rss_mb;
+
+            Mat blob;
+            for (int i = 0; i < warmup; i++) {
+                const Mat& frame = frames[i % frames.size()];
+                detector->preprocess(frame, blob, r.input_size);
+                detector->detectBlob(blob, frame.size());
+            }
+
+            vector<double> pre_ms, fwd_ms, dec_ms, nms_ms, total_ms;
+            r.person_boxes.assign(frames.size(), vector<Rect>());
+            auto wall_start = chrono::steady_clock::now();
+            for (int it = 0; it < iterations; it++) {
+                for (size_t f = 0; f < frames.size(); f++) {
+                    auto t0 = chrono::steady_clock::now();
+                    detector->preprocess(frames[f], blob, r.input_size);
+                    auto t1 = chrono::steady_clock::now();
+                    vector<DetectedObject> dets = detector->detectBlob(blob, frames[f].size());
+                    auto t2 = chrono::steady_clock::now();
+
+                    const DetectionTiming& timing = detector->lastTiming();
+                    pre_ms.push_back(chrono::duration<double, milli>(t1 - t0).count());
+                    fwd_ms.push_back(timing.forward_ms);
+                    dec_ms.push_back(timing.decode_ms);
+                    nms_ms.push_back(timing.nms_ms);
+                    total_ms.push_back(chrono::duration<double, milli>(t2 - t0).count());
+
+                    if (it == 0) {
+                        for (const auto& d : dets) {
+                            if (d.class_name == "person") {
+                                r.person_boxes[f].push_back(d.bbox);
+                                r.person_scored.push_back({(int)f, d.confidence, d.bbox});
+                            }
+                        }
+                    }
+                }
+            }
+            double wall_s = chrono::duration<double>(chrono::steady_clock::now() - wall_start).count();
+
+            r.preprocess = summarize(pre_ms);
+            r.forward = summarize(fwd_ms);
+            r.decode = summarize(dec_ms);
+            r.nms = summarize(nms_ms);
+            r.total = summarize(total_ms);
+            r.throughput_fps = wall_s > 0 ? (double)total_ms.size() / wall_s : 0.0;
+            r.peak_rss_mb = readPeakRssKb() / 1024.0;
+            results.push_back(r);
+
+            // マニフェストは既定入力サイズでの実測のみ記録する
+            if (write_manifest && r.input_size == detector->inputSize()) {
+                ModelManifest manifest;
+                manifest.load(model_path);
+                manifest.input_size = r.input_size;
+                manifest.layout = detector->isYOLOv8() ? "yolov8" : "darknet";
+                manifest.num_classes = (int)detector->numClasses();
+                manifest.quantization = r.quantized ? "int8_qdq" : "fp32";
+                manifest.latency_ms = r.total.mean_ms;
+                manifest.rss_mb = load_rss_mb;
+                if (manifest.save(model_path)) {
+                    cout << "マニフェストを書き込みました: " << ModelManifest::pathFor(model_path) << endl;
+                }
+            }
+        }
+
+        delete detector;
+    }
+
+    if (results.empty()) {
+        return -1;
+    }
+
+    // 正解ラベルが無ければ最初のFP32モデルのperson検出を基準にする（精度ではなく一致度）
+    bool use_gt = !gt_dir.empty();
+    size_t ref_index = 0;
+    for (size_t i = 0; i < results.size(); i++) {
+        if (!results[i].quantized) {
+            ref_index = i;
+            break;
+        }
+    }
+    const RunResult& ref_run = results[ref_index];
+    const vector<vector<Rect>>& reference = use_gt ? ground_truth : ref_run.person_boxes;
+    string reference_name = use_gt ? gt_dir : ref_run.model_path + "@" + to_string(ref_run.input_size);
+    for (auto& r : results) {
+        r.person_ap50 = averagePrecision(r.person_scored, reference, 0.5f, &r.person_recall);
+        r.person_ap50_95 = averagePrecision50to95(r.person_scored, reference);
+    }
+
+    cout << endl << "基準: " << reference_name << (use_gt ? "（正解ラベル）" : "（モデルの検出、精度ではなく一致度）") << endl;
+    cout << "model\tint8\tinput\tpre_ms\tforward_ms\tdecode_ms\tnms_ms\ttotal_ms\tp95_ms\tfps"
+         << "\tload_rss_mb\tpeak_rss_mb"
+         << (use_gt ? "\tperson_ap50\tperson_ap50_95\trecall" : "\tagree_ap50\tagree_ap50_95\tagree_recall") << endl;
+    for (const auto& r : results) {
+        cout << r.model_path << "\t"
+             << (r.quantized ? "yes" : "no") << "\t"
+             << r.input_size << "\t"
+             << r.preprocess.mean_ms << "\t" << r.forward.mean_ms << "\t"
+             << r.decode.mean_ms << "\t" << r.nms.mean_ms << "\t"
+             << r.total.mean_ms << "\t" << r.total.p95_ms << "\t"
+             << r.throughput_fps << "\t"
+             << r.load_rss_mb << "\t" << r.peak_rss_mb << "\t"
+             << r.person_ap50 << "\t" << r.person_ap50_95 << "\t" << r.person_recall << endl;
+    }
+    cout << endl << "※ peak_rss_mbはプロセス全体の最大値（厳密な比較はモデルごとに別プロセスで実行）" << endl;
+
+    // INT8出力のデコード（OpenCV DNNのQDQモデルは出力がFP32のため、ここで両方の出力形式を確認する）
+    vector<Int8DecodeCheck> int8_checks = {checkInt8OutputDecode(true), checkInt8OutputDecode(false)};
+    bool int8_ok = true;
+    cout << endl << "INT8出力デコード（合成テンソル、逆量子化したFP32の解析と比較）" << endl;
+    for (const auto& c : int8_checks) {
+        cout << c.layout << ": 候補 " << c.candidates_int8 << " / " << c.candidates_fp32
+             << "、不一致 " << c.mismatched << "、decode " << c.decode_int8_ms << "ms（FP32 "
+             << c.decode_fp32_ms << "ms）" << (c.ok() ? "" : " ← 一致しません") << endl;
+        int8_ok = int8_ok && c.ok();
+    }
+
+    if (writeJson(json_path, frames_dir, reference_name, use_gt, iterations, results, int8_checks)) {
+        cout << "JSONを出力しました: " << json_path << endl;
+    }
+
+    return int8_ok ? 0 : 1;
+}
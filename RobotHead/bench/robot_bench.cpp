@@ -0,0 +1,1274 @@
+/**
+ * @file robot_bench.cpp
+ * @brief Microbenchmarks for RobotHead hot paths
+ * @author RobotC Project
+ * @date 2026-01-23
+ *
+ * 使い方:
+ *   ./robot_bench                 全ケースを実行
+ *   ./robot_bench --case nms      指定ケースのみ実行（--listで一覧）
+ *   ./robot_bench --iterations N  計測回数（既定200）
+ *   ./robot_bench --warmup N      計測前の空回し回数（既定は計測回数の1/10）
+ *   ./robot_bench --list          ケース一覧
+ *
+ * 結果はケースごとにTSV（case, variant, n, median_us, p95_us, ns_per_op, bytes_per_op, allocs_per_op, 補足）で出力する。
+ * bytes_per_op / allocs_per_op はmalloc系の呼び出し（cv::Matの確保を含む、全スレッド）を数えたもの。
+ * ホストでも動く（cmake -DNATIVE_BUILD=ON）ので、カーネルの変更はPCで先に確認できる。
+ */
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <iostream>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <ctime>
+#include <cstring>
+#include <atomic>
+#include <condition_variable>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstdio>
+#include "detection/nms.h"
+#include "detection/object_tracker.h"
+#include "detection/object_detector.h"
+#include "network/mjpeg_broadcaster.h"
+#include "network/jpeg_encoder.h"
+#include "platform/black_box.h"
+#include "sensors/depth_overlay.h"
+#include "sensors/vl53l8cx_api.h"
+#include "hardware/uart_pico.h"
+
+using namespace cv;
+using namespace std;
+
+struct BenchCase {
+    const char* name;
+    const char* description;
+    function<void(int iterations)> run;
+};
+
+// ---------------------------------------------------------------------------
+// 確保量の計測: glibcのmalloc系を差し替えて回数とバイト数を数える
+// operator newだけでなくcv::fastMalloc（posix_memalign）も通るため、cv::Matの確保も数えられる
+// ---------------------------------------------------------------------------
+
+extern "C" {
+void* __libc_malloc(size_t size);
+void* __libc_calloc(size_t count, size_t size);
+void* __libc_realloc(void* ptr, size_t size);
+void* __libc_memalign(size_t alignment, size_t size);
+void __libc_free(void* ptr);
+}
+
+static atomic<uint64_t> g_alloc_count(0);
+static atomic<uint64_t> g_alloc_bytes(0);
+
+static inline void countAlloc(size_t size) {
+    g_alloc_count.fetch_add(1, memory_order_relaxed);
+    g_alloc_bytes.fetch_add(size, memory_order_relaxed);
+}
+
+extern "C" {
+void* malloc(size_t size) {
+    countAlloc(size);
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size) {
+    countAlloc(count * size);
+    return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size) {
+    countAlloc(size);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void* ptr) {
+    __libc_free(ptr);
+}
+
+int posix_memalign(void** out, size_t alignment, size_t size) {
+    countAlloc(size);
+    void* p = __libc_memalign(alignment, size);
+    if (!p) {
+        return ENOMEM;
+    }
+    *out = p;
+    return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+    countAlloc(size);
+    return __libc_memalign(alignment, size);
+}
+
+void* memalign(size_t alignment, size_t size) {
+    countAlloc(size);
+    return __libc_memalign(alignment, size);
+}
+}
+
+// 計算結果を使ったことにして、最適化で処理ごと消されないようにする
+static inline void keepAlive(const void* p) {
+    asm volatile("" : : "r"(p) : "memory");
+}
+
+static double percentile(vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    sort(values.begin(), values.end());
+    size_t idx = (size_t)(p * (values.size() - 1));
+    return values[idx];
+}
+
+// 計測前の空回し回数（負ならiterationsの1/10、--warmupで変更）
+static int g_warmup = -1;
+
+struct Measurement {
+    vector<double> times;        // 1回ごとの時間（マイクロ秒）
+    double ns_per_op = 0.0;      // 平均
+    double bytes_per_op = 0.0;   // 1回あたりの確保バイト数
+    double allocs_per_op = 0.0;  // 1回あたりの確保回数
+};
+
+// fnを空回ししてから、iterations回実行して1回ごとの時間と確保量を返す
+// on_startは空回しの後、計測の直前に呼ばれる（syscall数などケース側のカウンタを戻す）
+static Measurement measure(int iterations, const function<void()>& fn, const function<void()>& on_start = nullptr) {
+    int warmup = g_warmup >= 0 ? g_warmup : max(1, iterations / 10);
+    for (int i = 0; i < warmup; i++) {
+        fn();
+    }
+    if (on_start) {
+        on_start();
+    }
+
+    Measurement m;
+    m.times.reserve(iterations);
+    uint64_t count0 = g_alloc_count.load();
+    uint64_t bytes0 = g_alloc_bytes.load();
+    auto start = chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        auto t0 = chrono::steady_clock::now();
+        fn();
+        auto t1 = chrono::steady_clock::now();
+        m.times.push_back(chrono::duration<double, micro>(t1 - t0).count());
+    }
+    double total_ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count();
+    // timesのreserve後なので、ここまでの確保はfnによるもの
+    m.ns_per_op = total_ns / iterations;
+    m.allocs_per_op = (double)(g_alloc_count.load() - count0) / iterations;
+    m.bytes_per_op = (double)(g_alloc_bytes.load() - bytes0) / iterations;
+    return m;
+}
+
+// 1回が数百ns以下のカーネル用: fnをbatch回まとめて1回として計測し、1回あたりに割り戻す
+// （steady_clockの呼び出しコストが結果に混ざらないようにする）
+static Measurement measureBatch(int iterations, int batch, const function<void()>& fn) {
+    Measurement m = measure(iterations, [&]() {
+        for (int i = 0; i < batch; i++) {
+            fn();
+        }
+    });
+    for (double& t : m.times) {
+        t /= batch;
+    }
+    m.ns_per_op /= batch;
+    m.bytes_per_op /= batch;
+    m.allocs_per_op /= batch;
+    return m;
+}
+
+static void printHeader(const string& note_name) {
+    cout << "case\tvariant\tn\tmedian_us\tp95_us\tns_per_op\tbytes_per_op\tallocs_per_op\t" << note_name << endl;
+}
+
+static void printRow(const string& name, const string& variant, size_t n,
+                     const Measurement& m, const string& note) {
+    char per_op[96];
+    snprintf(per_op, sizeof(per_op), "%.1f\t%.0f\t%.2f", m.ns_per_op, m.bytes_per_op, m.allocs_per_op);
+    cout << name << "\t" << variant << "\t" << n << "\t"
+         << percentile(m.times, 0.50) << "\t" << percentile(m.times, 0.95) << "\t" << per_op << "\t" << note << endl;
+}
+
+// ---------------------------------------------------------------------------
+// NMS: 低い信頼度閾値で出る候補数（数百〜数千）を模擬する
+// ---------------------------------------------------------------------------
+
+struct Candidate {
+    float x, y, w, h, score;
+    int class_id;
+};
+
+// 物体ごとに位置・大きさが少しずつずれた候補が集まる分布（実際の検出器出力に近い）
+static vector<Candidate> makeCandidates(size_t count, int num_objects, int num_classes, unsigned seed) {
+    mt19937 rng(seed);
+    uniform_real_distribution<float> pos(0.0f, 400.0f);
+    uniform_real_distribution<float> size(20.0f, 160.0f);
+    normal_distribution<float> jitter(0.0f, 6.0f);
+    uniform_real_distribution<float> score(0.05f, 0.95f);
+
+    vector<Candidate> objects;
+    for (int i = 0; i < num_objects; i++) {
+        objects.push_back({pos(rng), pos(rng), size(rng), size(rng), 0.0f, (int)(rng() % num_classes)});
+    }
+
+    vector<Candidate> candidates;
+    candidates.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const Candidate& o = objects[i % objects.size()];
+        // 同じ位置に別クラスの候補も混ざる（クラス別NMSで差が出る）
+        int cls = (rng() % 4 == 0) ? (int)(rng() % num_classes) : o.class_id;
+        candidates.push_back({o.x + jitter(rng), o.y + jitter(rng),
+                              max(4.0f, o.w + jitter(rng)), max(4.0f, o.h + jitter(rng)),
+                              score(rng), cls});
+    }
+    return candidates;
+}
+
+static void benchNms(int iterations) {
+    const size_t kCounts[] = {300, 1000, 3000};
+
+    printHeader("kept");
+    for (size_t count : kCounts) {
+        vector<Candidate> cands = makeCandidates(count, 40, 10, 42);
+
+        // OpenCV dnn::NMSBoxes（毎回vectorを構築、クラス無関係）
+        size_t kept_cv = 0;
+        auto t_cv = measure(iterations, [&]() {
+            vector<Rect> boxes;
+            vector<float> scores;
+            vector<int> indices;
+            for (const auto& c : cands) {
+                boxes.push_back(Rect((int)c.x, (int)c.y, (int)c.w, (int)c.h));
+                scores.push_back(c.score);
+            }
+            dnn::NMSBoxes(boxes, scores, 0.0f, 0.4f, indices);
+            kept_cv = indices.size();
+        });
+        printRow("nms", "cv_NMSBoxes", count, t_cv, to_string(kept_cv));
+
+        // NmsBuffer（バッファ再利用）: クラス無関係 / クラス別 / top-k
+        NmsBuffer nms;
+        nms.reserve(count);
+        struct Variant { const char* name; NmsMode mode; int top_k; };
+        const Variant kVariants[] = {
+            {"soa_agnostic", NmsMode::ClassAgnostic, 0},
+            {"soa_class_aware", NmsMode::ClassAware, 0},
+            {"soa_class_aware_top200", NmsMode::ClassAware, 200},
+        };
+        for (const auto& v : kVariants) {
+            NmsConfig config;
+            config.iou_threshold = 0.4f;
+            config.mode = v.mode;
+            config.top_k = v.top_k;
+            config.max_detections = 0;
+
+            size_t kept = 0;
+            auto t = measure(iterations, [&]() {
+                nms.clear();
+                for (const auto& c : cands) {
+                    nms.push(c.x, c.y, c.w, c.h, c.score, c.class_id);
+                }
+                kept = nms.run(config).size();
+            });
+            printRow("nms", v.name, count, t, to_string(kept));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// トラッカー: 等速で動く物体を検出漏れ・位置ノイズ付きで与えた時の1回のupdate()
+// ---------------------------------------------------------------------------
+
+static void benchTracker(int iterations) {
+    const int kObjectCounts[] = {5, 20, 50};
+
+    printHeader("tracks");
+    for (int num_objects : kObjectCounts) {
+        mt19937 rng(7);
+        uniform_real_distribution<float> pos(0.0f, 400.0f);
+        uniform_real_distribution<float> vel(-40.0f, 40.0f);
+        normal_distribution<float> noise(0.0f, 3.0f);
+
+        struct Mover { float x, y, vx, vy, w, h; int class_id; };
+        vector<Mover> movers;
+        for (int i = 0; i < num_objects; i++) {
+            movers.push_back({pos(rng), pos(rng), vel(rng), vel(rng), 40.0f + (i % 5) * 15.0f, 80.0f, i % 3});
+        }
+
+        // 計測外でフレームごとの検出（10%は検出漏れ）を作っておく
+        const int kFrames = 400;
+        vector<vector<DetectedObject>> frames(kFrames);
+        for (int f = 0; f < kFrames; f++) {
+            for (auto& m : movers) {
+                m.x += m.vx * 0.2f;
+                m.y += m.vy * 0.2f;
+                if (rng() % 10 == 0) {
+                    continue;
+                }
+                DetectedObject det;
+                det.class_id = m.class_id;
+                det.class_name = "obj";
+                det.confidence = 0.8f;
+                det.bbox = Rect((int)(m.x + noise(rng)), (int)(m.y + noise(rng)), (int)m.w, (int)m.h);
+                frames[f].push_back(det);
+            }
+        }
+
+        ObjectTracker tracker;
+        auto t = chrono::steady_clock::now();
+        int f = 0;
+        auto times = measure(iterations, [&]() {
+            t += chrono::milliseconds(200);
+            tracker.update(frames[f], t);
+            f = (f + 1) % kFrames;
+        });
+        printRow("tracker", "update", num_objects, times, to_string(tracker.tracks().size()));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// Darknet出力の解析: 従来の行ごとminMaxLoc と objectness先行棄却 + SIMD argmax
+// ---------------------------------------------------------------------------
+
+// OpenCVのRegionレイヤー出力を模擬（[x, y, w, h, objectness, objectness×クラス確率...]）
+// 実際のyolov4-tiny出力と同様に、ほとんどの行はobjectnessがほぼ0
+static Mat makeRegionOutput(int rows, int num_classes, mt19937& rng) {
+    normal_distribution<float> logit(-7.0f, 2.5f);
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+    Mat out(rows, 5 + num_classes, CV_32F);
+    for (int r = 0; r < rows; r++) {
+        float* row = out.ptr<float>(r);
+        row[0] = unit(rng);
+        row[1] = unit(rng);
+        row[2] = 0.05f + 0.3f * unit(rng);
+        row[3] = 0.05f + 0.3f * unit(rng);
+        float objectness = 1.0f / (1.0f + exp(-logit(rng)));
+        row[4] = objectness;
+        int main_class = (int)(rng() % num_classes);
+        for (int c = 0; c < num_classes; c++) {
+            float prob = (c == main_class) ? 0.6f + 0.4f * unit(rng) : 0.05f * unit(rng);
+            float score = objectness * prob;
+            row[5 + c] = (score > 0.2f) ? score : 0.0f;   // Regionレイヤーは閾値未満を0にする
+        }
+    }
+    return out;
+}
+
+// 変更前のparseYOLOv3v4Output相当（全行でクラス列のMatを作りminMaxLocで走査）
+static size_t legacyDarknetParse(const vector<Mat>& outputs, float threshold, int fw, int fh) {
+    vector<int> class_ids;
+    vector<float> confidences;
+    vector<Rect> boxes;
+    for (size_t i = 0; i < outputs.size(); ++i) {
+        const float* data = (const float*)outputs[i].data;
+        for (int j = 0; j < outputs[i].rows; ++j, data += outputs[i].cols) {
+            Mat scores = outputs[i].row(j).colRange(5, outputs[i].cols);
+            Point class_id_point;
+            double confidence;
+            minMaxLoc(scores, 0, &confidence, 0, &class_id_point);
+            if (confidence > threshold) {
+                int width = (int)(data[2] * fw);
+                int height = (int)(data[3] * fh);
+                class_ids.push_back(class_id_point.x);
+                confidences.push_back((float)confidence);
+                boxes.push_back(Rect((int)(data[0] * fw) - width / 2, (int)(data[1] * fh) - height / 2, width, height));
+            }
+        }
+    }
+    return boxes.size();
+}
+
+static void benchDarknetParse(int iterations) {
+    // yolov4-tinyの出力（3アンカー × 13x13 / 26x26 @416、10x10 / 20x20 @320）、COCO 80クラス
+    struct Shape { const char* name; int rows0; int rows1; };
+    const Shape kShapes[] = {
+        {"yolov4-tiny_320", 3 * 10 * 10, 3 * 20 * 20},
+        {"yolov4-tiny_416", 3 * 13 * 13, 3 * 26 * 26},
+    };
+    const float kThresholds[] = {0.25f, 0.6f};
+
+    printHeader("candidates");
+    for (const auto& shape : kShapes) {
+        mt19937 rng(11);
+        vector<Mat> outputs = {makeRegionOutput(shape.rows0, 80, rng), makeRegionOutput(shape.rows1, 80, rng)};
+        size_t rows = (size_t)(shape.rows0 + shape.rows1);
+
+        for (float threshold : kThresholds) {
+            string suffix = string(shape.name) + "_th" + to_string((int)(threshold * 100));
+
+            size_t legacy = 0;
+            auto t_legacy = measure(iterations, [&]() {
+                legacy = legacyDarknetParse(outputs, threshold, 480, 640);
+            });
+            printRow("darknet_parse", "minMaxLoc_" + suffix, rows, t_legacy, to_string(legacy));
+
+            NmsBuffer nms;
+            auto t_fast = measure(iterations, [&]() {
+                nms.clear();
+                for (const auto& out : outputs) {
+                    collectDarknetCandidates(out, threshold, 480, 640, nms);
+                }
+            });
+            printRow("darknet_parse", "objectness_first_" + suffix, rows, t_fast, to_string(nms.size()));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MJPEG配信: 視聴者数に対するエンコードコスト（クライアントごとにエンコード vs 1回だけエンコード）
+// ---------------------------------------------------------------------------
+
+// --streamの表示フレーム（カメラ640x480 + ヒートマップ640x640）を模擬
+static Mat makeStreamFrame(unsigned seed) {
+    Mat frame(480 + 640, 640, CV_8UC3);
+    RNG rng(seed);
+    rng.fill(frame, RNG::UNIFORM, Scalar::all(0), Scalar::all(255));
+    GaussianBlur(frame, frame, Size(9, 9), 0);   // ノイズだけだと実画像よりJPEGが重くなる
+    return frame;
+}
+
+static void benchMjpeg(int iterations) {
+    const int kClients[] = {1, 5};
+    iterations = min(iterations, 50);   // 1回あたり数十ms
+    Mat frame = makeStreamFrame(5);
+
+    printHeader("encodes_per_frame/cpu_ms_per_frame");
+    for (int clients : kClients) {
+        // 従来: クライアントのスレッドがそれぞれフレームを複製してエンコード
+        clock_t cpu0 = 0;
+        auto t_legacy = measure(iterations, [&]() {
+            vector<future<size_t>> sends;
+            for (int c = 0; c < clients; c++) {
+                sends.push_back(async(launch::async, [&frame]() {
+                    Mat local = frame.clone();
+                    vector<uchar> buf;
+                    imencode(".jpg", local, buf);
+                    return buf.size();
+                }));
+            }
+            for (auto& s : sends) {
+                s.get();
+            }
+        }, [&]() { cpu0 = clock(); });
+        double legacy_cpu_ms = 1000.0 * (clock() - cpu0) / CLOCKS_PER_SEC / iterations;
+        printRow("mjpeg", "per_client_encode", (size_t)clients, t_legacy,
+                 to_string(clients) + ".00/" + to_string(legacy_cpu_ms));
+
+        // MjpegBroadcaster: 1回エンコードして全クライアントが同じバッファを送る
+        MjpegBroadcaster broadcaster;
+        broadcaster.start();
+        mutex done_mutex;
+        condition_variable done_cv;
+        uint64_t received = 0;
+        atomic<bool> stop(false);
+        vector<thread> threads;
+        for (int c = 0; c < clients; c++) {
+            broadcaster.addClient();
+            threads.emplace_back([&]() {
+                vector<uchar> sink;   // send()の代わりに送信バッファへコピー
+                uint64_t last_seq = 0;
+                while (!stop) {
+                    JpegFramePtr jpeg = broadcaster.waitForFrame(last_seq, 100);
+                    if (!jpeg) {
+                        continue;
+                    }
+                    last_seq = jpeg->seq;
+                    sink.resize(jpeg->data.size());
+                    memcpy(sink.data(), jpeg->data.data(), jpeg->data.size());
+                    lock_guard<mutex> lock(done_mutex);
+                    received++;
+                    done_cv.notify_one();
+                }
+            });
+        }
+
+        uint64_t encodes0 = 0;
+        auto t_shared = measure(iterations, [&]() {
+            uint64_t target;
+            {
+                lock_guard<mutex> lock(done_mutex);
+                target = received + (uint64_t)clients;
+            }
+            broadcaster.submit(frame);
+            unique_lock<mutex> lock(done_mutex);
+            done_cv.wait(lock, [&]() { return received >= target; });
+        }, [&]() {
+            cpu0 = clock();
+            encodes0 = broadcaster.encodeCount();
+        });
+        double shared_cpu_ms = 1000.0 * (clock() - cpu0) / CLOCKS_PER_SEC / iterations;
+
+        stop = true;
+        for (auto& t : threads) {
+            t.join();
+        }
+        broadcaster.stop();
+        printRow("mjpeg", "encode_once", (size_t)clients, t_shared,
+                 to_string((double)(broadcaster.encodeCount() - encodes0) / iterations) + "/" + to_string(shared_cpu_ms));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MJPEGパートの送信: send()3回 vs sendmsg 1回 vs sendmsg + MSG_ZEROCOPY（ループバックTCP）
+// ---------------------------------------------------------------------------
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+// ループバックで接続済みのTCPソケットの組を作る
+static bool makeTcpPair(int& tx, int& rx) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (listener < 0 || bind(listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(listener, 1) != 0 ||
+        getsockname(listener, (struct sockaddr*)&addr, &len) != 0) {
+        if (listener >= 0) close(listener);
+        return false;
+    }
+    tx = socket(AF_INET, SOCK_STREAM, 0);
+    if (connect(tx, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(listener);
+        close(tx);
+        return false;
+    }
+    rx = accept(listener, nullptr, nullptr);
+    close(listener);
+    int one = 1;
+    setsockopt(tx, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return rx >= 0;
+}
+
+// 部分送信を考慮してiovを全て送る（呼び出したsyscall数を数える）
+static bool sendAll(int fd, struct iovec* iov, int count, int flags, uint64_t& syscalls) {
+    while (count > 0) {
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t n = sendmsg(fd, &msg, flags);
+        syscalls++;
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == ENOBUFS && (flags & MSG_ZEROCOPY)) {
+                flags &= ~MSG_ZEROCOPY;   // optmemの上限: コピーで送る
+                continue;
+            }
+            return false;
+        }
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= n;
+        }
+    }
+    return true;
+}
+
+static double threadCpuUs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec * 1e6 + ts.tv_nsec / 1e3;
+}
+
+static void benchMjpegSend(int iterations) {
+    enum Variant { ThreeSends, SingleSendmsg, ZeroCopy };
+    struct VariantInfo { Variant v; const char* name; };
+    const VariantInfo kVariants[] = {
+        {ThreeSends, "three_send"},
+        {SingleSendmsg, "sendmsg_iov"},
+        {ZeroCopy, "sendmsg_zerocopy"},
+    };
+    const size_t kJpegSizes[] = {30 * 1024, 120 * 1024};
+
+    printHeader("syscalls_per_frame/cpu_us_per_frame");
+    for (size_t jpeg_size : kJpegSizes) {
+        vector<unsigned char> jpeg(jpeg_size, 0x5a);
+        for (const auto& variant : kVariants) {
+            int tx, rx;
+            if (!makeTcpPair(tx, rx)) {
+                cerr << "ループバックTCPを作れません" << endl;
+                return;
+            }
+            if (variant.v == ZeroCopy) {
+                int one = 1;
+                if (setsockopt(tx, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) != 0) {
+                    cout << "mjpeg_send\t" << variant.name << "\t" << jpeg_size << "\t-\t-\t-\t-\t-\tSO_ZEROCOPY未対応" << endl;
+                    close(tx);
+                    close(rx);
+                    continue;
+                }
+            }
+
+            // 受信側（ブラウザの代わり）は読み捨てるだけ
+            thread reader([rx]() {
+                vector<char> buf(256 * 1024);
+                while (recv(rx, buf.data(), buf.size(), 0) > 0) {
+                }
+            });
+
+            uint64_t syscalls = 0;
+            double cpu0 = 0.0;
+            auto times = measure(iterations, [&]() {
+                // パートヘッダーは固定長バッファに書式化（std::stringの連結をしない）
+                char header[96];
+                int header_size = snprintf(header, sizeof(header),
+                                           "--frame\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n", jpeg.size());
+                static const char crlf[] = "\r\n";
+                if (variant.v == ThreeSends) {
+                    const void* parts[] = {header, jpeg.data(), crlf};
+                    size_t sizes[] = {(size_t)header_size, jpeg.size(), 2};
+                    for (int p = 0; p < 3; p++) {
+                        struct iovec iov = {const_cast<void*>(parts[p]), sizes[p]};
+                        sendAll(tx, &iov, 1, MSG_NOSIGNAL, syscalls);
+                    }
+                } else {
+                    struct iovec iov[3] = {
+                        {header, (size_t)header_size},
+                        {jpeg.data(), jpeg.size()},
+                        {const_cast<char*>(crlf), 2},
+                    };
+                    sendAll(tx, iov, 3, MSG_NOSIGNAL | (variant.v == ZeroCopy ? MSG_ZEROCOPY : 0), syscalls);
+                    if (variant.v == ZeroCopy) {
+                        // 完了通知を読み捨てる（実際のサーバーではここでバッファを解放する）
+                        char control[128];
+                        struct msghdr msg;
+                        while (true) {
+                            memset(&msg, 0, sizeof(msg));
+                            msg.msg_control = control;
+                            msg.msg_controllen = sizeof(control);
+                            syscalls++;
+                            if (recvmsg(tx, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) break;
+                        }
+                    }
+                }
+            }, [&]() {
+                syscalls = 0;
+                cpu0 = threadCpuUs();
+            });
+            double cpu_us = (threadCpuUs() - cpu0) / iterations;
+
+            shutdown(tx, SHUT_WR);
+            reader.join();
+            close(tx);
+            close(rx);
+
+            char note[64];
+            snprintf(note, sizeof(note), "%.2f/%.1f", (double)syscalls / iterations, cpu_us);
+            printRow("mjpeg_send", variant.name, jpeg_size, times, note);
+        }
+    }
+    cout << "# ループバックではMSG_ZEROCOPYもカーネル内でコピーされる（効果はWi-Fi等の実NICで確認）" << endl;
+}
+
+// ---------------------------------------------------------------------------
+// JPEGエンコード: cv::imencode vs JpegEncoder（BGR入力 / I420入力、TurboJPEG有効時）
+// ---------------------------------------------------------------------------
+
+static void benchJpegEncode(int iterations) {
+    const Size kSizes[] = {Size(320, 240), Size(640, 480)};
+    iterations = min(iterations, 200);
+
+    printHeader(string("jpeg_bytes") +
+                (JpegEncoder::usesTurboJpeg() ? "" : "  # ENABLE_TURBOJPEG無効: JpegEncoderもimencodeを使う"));
+    for (const Size& size : kSizes) {
+        Mat bgr = makeStreamFrame(7)(Rect(0, 0, size.width, size.height)).clone();
+        Mat i420;
+        cvtColor(bgr, i420, COLOR_BGR2YUV_I420);   // YUVで取り込んだ場合を模擬（変換は計測に含めない）
+        size_t pixels = (size_t)size.area();
+
+        // 従来: 毎回パラメータを作り、出力ベクタを新しく確保
+        vector<uchar> last;
+        auto t_imencode = measure(iterations, [&]() {
+            vector<uchar> buf;
+            imencode(".jpg", bgr, buf, {IMWRITE_JPEG_QUALITY, 95});
+            last.swap(buf);
+        });
+        printRow("jpeg_encode", "imencode_q95", pixels, t_imencode, to_string(last.size()));
+
+        const JpegSubsampling kSubsamplings[] = {JpegSubsampling::S420, JpegSubsampling::S444};
+        for (JpegSubsampling subsampling : kSubsamplings) {
+            JpegEncoder encoder(95, subsampling);
+            vector<unsigned char> out;
+            auto t_bgr = measure(iterations, [&]() { encoder.encode(bgr, out); });
+            printRow("jpeg_encode", string("encoder_bgr_") + jpegSubsamplingName(subsampling), pixels, t_bgr,
+                     to_string(out.size()));
+        }
+
+        JpegEncoder encoder(95);
+        vector<unsigned char> out;
+        auto t_yuv = measure(iterations, [&]() { encoder.encodeI420(i420, size.width, size.height, out); });
+        printRow("jpeg_encode", "encoder_i420", pixels, t_yuv, to_string(out.size()));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ブラックボックス: 1件の記録（リングへのmemcpy）と、間引いたフレームのエンコード込みの記録
+// ---------------------------------------------------------------------------
+
+static void benchBlackBox(int iterations) {
+    const char* kRingPath = "/dev/shm/robot_bench.blackbox";
+    BlackBoxRecorder recorder;
+    if (!recorder.open(kRingPath, 8 * 1024 * 1024, "/tmp/robot_bench_blackbox")) {
+        cout << "# リングを開けないためスキップ" << endl;
+        return;
+    }
+    recorder.setFrameInterval(chrono::milliseconds(0));
+    iterations = max(iterations, 1000);
+
+    printHeader("bytes");
+    DepthFrame depth;
+    memset(&depth, 0, sizeof(depth));
+    depth.zones = 64;
+    auto t_depth = measure(iterations, [&]() {
+        depth.seq++;
+        depth.timestamp_us = BlackBoxRecorder::nowUs();
+        recorder.recordDepth(depth);
+    });
+    printRow("blackbox", "depth_8x8", iterations, t_depth, to_string(depthFrameEncodedSize(64)));
+
+    const string imu_line = "IMU,0.012,-0.034,9.801,0.120,-0.250,0.031";
+    auto t_uart = measure(iterations, [&]() { recorder.recordUart(false, imu_line); });
+    printRow("blackbox", "uart_line", iterations, t_uart, to_string(imu_line.size()));
+
+    // エンコード済みのJPEGと同じ大きさのデータ（memcpyのみ）
+    vector<unsigned char> jpeg(12 * 1024, 0x5A);
+    auto t_copy = measure(iterations, [&]() {
+        recorder.record(BlackBoxRecordType::Frame, jpeg.data(), jpeg.size(), BlackBoxRecorder::nowUs());
+    });
+    printRow("blackbox", "frame_copy_12k", iterations, t_copy, to_string(jpeg.size()));
+
+    // robot_headと同じ: 回転後の240x320をq70でエンコードして記録
+    Mat frame = makeStreamFrame(9)(Rect(0, 0, 240, 320)).clone();
+    auto t_frame = measure(min(iterations, 200), [&]() { recorder.recordFrame(frame, BlackBoxRecorder::nowUs()); });
+    printRow("blackbox", "frame_encode_240x320", t_frame.times.size(), t_frame, "");
+
+    // 2fpsのフレーム + 15HzのToF + 50HzのIMU行で1秒あたりに使うCPU時間
+    double per_second_us = 2 * percentile(t_frame.times, 0.5) + 15 * percentile(t_depth.times, 0.5) +
+                           50 * percentile(t_uart.times, 0.5);
+    cout << "# 既定の設定での記録負荷: " << per_second_us / 1e4 << "%（1コア換算）, 保持 "
+         << recorder.retainedSeconds() << "秒分の記録" << endl;
+    recorder.close();
+    unlink(kRingPath);
+}
+
+// ---------------------------------------------------------------------------
+// YOLOv8出力のデコード: アンカーごとのクラス最大値と閾値判定（[1, 84, N] / [N, 84]のFP32出力）
+// ---------------------------------------------------------------------------
+
+// yolov8nの出力を模擬（座標は入力ピクセル、物体があるのは0.5%のアンカーで、残りは全クラス低スコア）
+static Mat makeYolov8Output(int num_anchors, int num_classes, int input_size, bool channel_major, mt19937& rng) {
+    uniform_real_distribution<float> unit(0.0f, 1.0f);
+    exponential_distribution<float> background(40.0f);
+
+    int channels = 4 + num_classes;
+    Mat out;
+    if (channel_major) {
+        int sizes[] = {1, channels, num_anchors};
+        out.create(3, sizes, CV_32F);
+    } else {
+        out.create(num_anchors, channels, CV_32F);
+    }
+    float* data = out.ptr<float>();
+    auto at = [&](int ch, int i) -> float& {
+        return channel_major ? data[(size_t)ch * num_anchors + i] : data[(size_t)i * channels + ch];
+    };
+    for (int i = 0; i < num_anchors; i++) {
+        at(0, i) = input_size * unit(rng);
+        at(1, i) = input_size * unit(rng);
+        at(2, i) = 16.0f + 0.4f * input_size * unit(rng);
+        at(3, i) = 16.0f + 0.4f * input_size * unit(rng);
+        bool object = (rng() % 200 == 0);
+        int main_class = (int)(rng() % num_classes);
+        for (int c = 0; c < num_classes; c++) {
+            at(4 + c, i) = (object && c == main_class) ? 0.5f + 0.5f * unit(rng) : min(1.0f, background(rng));
+        }
+    }
+    return out;
+}
+
+static void benchYoloDecode(int iterations) {
+    struct Shape { const char* name; int input_size; int anchors; };
+    const Shape kShapes[] = {
+        {"yolov8n_320", 320, 2100},
+        {"yolov8n_640", 640, 8400},
+    };
+
+    printHeader("candidates");
+    for (const auto& shape : kShapes) {
+        for (bool channel_major : {true, false}) {
+            mt19937 rng(17);
+            Mat output = makeYolov8Output(shape.anchors, 80, shape.input_size, channel_major, rng);
+
+            NmsBuffer nms;
+            vector<float> best_scores;
+            vector<int> best_classes;
+            float scale_x = 240.0f / shape.input_size;
+            float scale_y = 320.0f / shape.input_size;
+            auto t = measure(iterations, [&]() {
+                nms.clear();
+                collectYOLOv8Candidates(output, 0.5f, scale_x, scale_y, best_scores, best_classes, nms);
+            });
+            printRow("yolo_decode", string(channel_major ? "channel_major_" : "anchor_major_") + shape.name,
+                     (size_t)shape.anchors, t, to_string(nms.size()));
+        }
+    }
+}
+
+// ---------------------------------------------------------------------------
+// 前処理: 回転後の240x320フレームからのblobFromImage（毎回新しいblob vs 再利用）
+// ---------------------------------------------------------------------------
+
+static void benchBlob(int iterations) {
+    const int kInputSizes[] = {320, 416};
+    Mat frame = makeStreamFrame(3)(Rect(0, 0, 240, 320)).clone();
+
+    printHeader("blob_bytes");
+    for (int size : kInputSizes) {
+        // ObjectDetector::preprocess()と同じパラメータ
+        auto t_new = measure(iterations, [&]() {
+            Mat blob = dnn::blobFromImage(frame, 1 / 255.0, Size(size, size), Scalar(0, 0, 0), true, false);
+            keepAlive(blob.data);
+        });
+        Mat blob;
+        auto t_reuse = measure(iterations, [&]() {
+            dnn::blobFromImage(frame, blob, 1 / 255.0, Size(size, size), Scalar(0, 0, 0), true, false);
+            keepAlive(blob.data);
+        });
+        string blob_bytes = to_string(blob.total() * blob.elemSize());
+        printRow("blob", "new_blob", (size_t)size, t_new, blob_bytes);
+        printRow("blob", "reused_blob", (size_t)size, t_reuse, blob_bytes);
+    }
+}
+
+// ---------------------------------------------------------------------------
+// ToFのカラーマップ表示: キャリブレーション済みの重ね描き / 縦結合（drawDepthOverlay）
+// ---------------------------------------------------------------------------
+
+static void benchDepthOverlay(int iterations) {
+    Mat frame = makeStreamFrame(4)(Rect(0, 0, 240, 320)).clone();
+    int16_t distance_mm[64];
+    for (int i = 0; i < 64; i++) {
+        distance_mm[i] = (int16_t)(250 + (i % 8) * 150 + (i / 8) * 60);   // 斜めに遠くなる面
+    }
+
+    printHeader("display");
+    DepthOverlayConfig calibrated;
+    calibrated.calibrated = true;
+    Mat display;
+    // robot_headと同じく、表示用の画像はフレームの複製に重ねる（複製は計測に含む、バッファは再利用）
+    auto t_overlay = measure(iterations, [&]() {
+        frame.copyTo(display);
+        drawDepthOverlay(frame, distance_mm, calibrated, display);
+    });
+    printRow("depth_overlay", "calibrated_blend", 64, t_overlay, to_string(display.cols) + "x" + to_string(display.rows));
+
+    DepthOverlayConfig uncalibrated;
+    auto t_vconcat = measure(iterations, [&]() { drawDepthOverlay(frame, distance_mm, uncalibrated, display); });
+    printRow("depth_overlay", "vconcat_heatmap", 64, t_vconcat, to_string(display.cols) + "x" + to_string(display.rows));
+}
+
+// ---------------------------------------------------------------------------
+// ToFの読み出し後の処理: VL53L8CX_SwapBuffer と vl53l8cx_decode_ranging_data（I2Cの転送は含まない）
+// ---------------------------------------------------------------------------
+
+/*
+ * vl53l8cx_start_ranging()と同じ出力設定（8x8、platform.hで有効な項目）の1フレームを、
+ * センサーから読んだ直後の並び（4バイトごとのバイト順入れ替え前）で作る。
+ * 戻り値はdata_read_size（start_rangingと同じ計算）。
+ */
+static uint32_t makeRawRangingFrame(uint8_t* buffer, size_t capacity, mt19937& rng) {
+    const uint32_t kOutputs[] = {
+        VL53L8CX_METADATA_BH, VL53L8CX_COMMONDATA_BH, VL53L8CX_AMBIENT_RATE_BH, VL53L8CX_SPAD_COUNT_BH,
+        VL53L8CX_NB_TARGET_DETECTED_BH, VL53L8CX_SIGNAL_RATE_BH, VL53L8CX_RANGE_SIGMA_MM_BH,
+        VL53L8CX_DISTANCE_BH, VL53L8CX_REFLECTANCE_BH, VL53L8CX_TARGET_STATUS_BH, VL53L8CX_MOTION_DETECT_BH,
+    };
+    const uint16_t kResolution = VL53L8CX_RESOLUTION_8X8;
+
+    memset(buffer, 0, capacity);
+    uint32_t read_size = 4 + 24;   // VL53L8CX_START_BH + ヘッダー・フッター
+    uint32_t pos = 16;             // decodeは16バイト目からブロックを探す
+    for (uint32_t output : kOutputs) {
+        union Block_header bh;
+        bh.bytes = output;
+        uint32_t payload = bh.size;
+        if (bh.type >= 0x1 && bh.type < 0x0d) {
+            bool per_zone = (bh.idx >= 0x54d0 && bh.idx < 0x54d0 + 960);
+            bh.size = per_zone ? kResolution : kResolution * VL53L8CX_NB_TARGET_PER_ZONE;
+            payload = bh.type * bh.size;
+        }
+        read_size += payload + 4;
+        if (pos + 4 + payload > capacity) {
+            return 0;
+        }
+
+        memcpy(buffer + pos, &bh.bytes, 4);
+        uint8_t* data = buffer + pos + 4;
+        for (uint32_t b = 0; b < payload; b++) {
+            data[b] = (uint8_t)rng();
+        }
+        if (bh.idx == VL53L8CX_DISTANCE_IDX) {
+            // 距離は4倍の値で届く（decodeで/4）
+            int16_t* distance = (int16_t*)data;
+            for (uint32_t z = 0; z < payload / 2; z++) {
+                distance[z] = (int16_t)(4 * (200 + rng() % 1800));
+            }
+        } else if (bh.idx == VL53L8CX_NB_TARGET_DETECTED_IDX) {
+            for (uint32_t z = 0; z < payload; z++) {
+                data[z] = (rng() % 10 == 0) ? 0 : 1;   // 1割のゾーンは対象なし
+            }
+        }
+        pos += 4 + payload;
+    }
+    if (read_size > capacity) {
+        return 0;
+    }
+
+    // ヘッダーとフッターのフレームIDを揃える（揃っていないとCORRUPTED_FRAMEになる）
+    buffer[0x8] = 0x12;
+    buffer[0x9] = 0x34;
+    buffer[read_size - 4] = 0x12;
+    buffer[read_size - 3] = 0x34;
+
+    // ここまではdecodeが見る並び。入れ替えは自身の逆なので、もう一度かければ読んだ直後の並びになる
+    VL53L8CX_SwapBuffer(buffer, (uint16_t)read_size);
+    return read_size;
+}
+
+// temp_bufferを含めて大きいため静的に置く
+static VL53L8CX_Configuration g_tof_dev;
+static VL53L8CX_ResultsData g_tof_results;
+
+static bool prepareTofFrame(vector<uint8_t>& raw) {
+    mt19937 rng(13);
+    raw.assign(VL53L8CX_TEMPORARY_BUFFER_SIZE, 0);
+    g_tof_dev.data_read_size = makeRawRangingFrame(raw.data(), raw.size(), rng);
+    if (g_tof_dev.data_read_size == 0) {
+        cout << "# temp_bufferにフレームが収まらないためスキップ" << endl;
+        return false;
+    }
+    return true;
+}
+
+// 以前のVL53L8CX_SwapBuffer（1バイトずつの入れ替え、比較用）
+static void legacySwapBuffer(uint8_t* buffer, uint16_t size) {
+    for (uint16_t i = 0; i + 3 < size; i += 4) {
+        uint8_t b0 = buffer[i];
+        buffer[i] = buffer[i + 3];
+        buffer[i + 3] = b0;
+        uint8_t b1 = buffer[i + 1];
+        buffer[i + 1] = buffer[i + 2];
+        buffer[i + 2] = b1;
+    }
+}
+
+/*
+ * 以前のvl53l8cx_decode_ranging_data（比較用）: temp_buffer全体を入れ替えてから、ブロックごとにmemcpyで展開する。
+ * platform.hの既定（全項目有効、USE_RAW_FORMATなし）の場合だけを写している。
+ */
+static uint8_t legacyDecodeRangingData(VL53L8CX_Configuration* p_dev, VL53L8CX_ResultsData* p_results) {
+    uint8_t status = VL53L8CX_STATUS_OK;
+    uint8_t* buffer = p_dev->temp_buffer;
+    p_dev->streamcount = buffer[0];
+    legacySwapBuffer(buffer, (uint16_t)p_dev->data_read_size);
+
+    for (uint32_t i = 16; i < p_dev->data_read_size; i += 4) {
+        union Block_header* bh_ptr = (union Block_header*)&buffer[i];
+        uint32_t msize = (bh_ptr->type > 0x1 && bh_ptr->type < 0xd) ? bh_ptr->type * bh_ptr->size : bh_ptr->size;
+        void* dst = nullptr;
+        switch (bh_ptr->idx) {
+        case VL53L8CX_METADATA_IDX:
+            p_results->silicon_temp_degc = (int8_t)buffer[i + 12];
+            break;
+        case VL53L8CX_AMBIENT_RATE_IDX: dst = p_results->ambient_per_spad; break;
+        case VL53L8CX_SPAD_COUNT_IDX: dst = p_results->nb_spads_enabled; break;
+        case VL53L8CX_NB_TARGET_DETECTED_IDX: dst = p_results->nb_target_detected; break;
+        case VL53L8CX_SIGNAL_RATE_IDX: dst = p_results->signal_per_spad; break;
+        case VL53L8CX_RANGE_SIGMA_MM_IDX: dst = p_results->range_sigma_mm; break;
+        case VL53L8CX_DISTANCE_IDX: dst = p_results->distance_mm; break;
+        case VL53L8CX_REFLECTANCE_EST_PC_IDX: dst = p_results->reflectance; break;
+        case VL53L8CX_TARGET_STATUS_IDX: dst = p_results->target_status; break;
+        case VL53L8CX_MOTION_DETEC_IDX: dst = &p_results->motion_indicator; break;
+        default: break;
+        }
+        if (dst != nullptr) {
+            memcpy(dst, &buffer[i + 4], msize);
+        }
+        i += msize;
+    }
+
+    for (uint32_t i = 0; i < VL53L8CX_RESOLUTION_8X8; i++) {
+        p_results->ambient_per_spad[i] /= 2048;
+    }
+    for (uint32_t i = 0; i < VL53L8CX_RESOLUTION_8X8 * VL53L8CX_NB_TARGET_PER_ZONE; i++) {
+        p_results->distance_mm[i] /= 4;
+        p_results->reflectance[i] /= 2;
+        p_results->range_sigma_mm[i] /= 128;
+        p_results->signal_per_spad[i] /= 2048;
+    }
+    for (uint32_t i = 0; i < VL53L8CX_RESOLUTION_8X8; i++) {
+        if (p_results->nb_target_detected[i] == 0) {
+            for (uint32_t j = 0; j < VL53L8CX_NB_TARGET_PER_ZONE; j++) {
+                p_results->target_status[VL53L8CX_NB_TARGET_PER_ZONE * i + j] = 255;
+            }
+        }
+    }
+    for (uint32_t i = 0; i < 32; i++) {
+        p_results->motion_indicator.motion[i] /= 65535;
+    }
+
+    uint16_t header_id = (uint16_t)((buffer[0x8] << 8) | buffer[0x9]);
+    uint16_t footer_id = (uint16_t)((buffer[p_dev->data_read_size - 4] << 8) | buffer[p_dev->data_read_size - 3]);
+    if (header_id != footer_id) {
+        status |= VL53L8CX_STATUS_CORRUPTED_FRAME;
+    }
+    return status;
+}
+
+static void benchTofSwap(int iterations) {
+    vector<uint8_t> raw;
+    if (!prepareTofFrame(raw)) {
+        return;
+    }
+    uint16_t size = (uint16_t)g_tof_dev.data_read_size;
+    memcpy(g_tof_dev.temp_buffer, raw.data(), size);
+
+    // 2つの実装が同じ並びを作るか
+    vector<uint8_t> expected(raw.begin(), raw.begin() + size);
+    legacySwapBuffer(expected.data(), size);
+    VL53L8CX_SwapBuffer(g_tof_dev.temp_buffer, size);
+    bool same = memcmp(expected.data(), g_tof_dev.temp_buffer, size) == 0;
+    VL53L8CX_SwapBuffer(g_tof_dev.temp_buffer, size);
+
+    printHeader("bytes");
+    // 入れ替えを繰り返すだけ（偶数回で元に戻る）
+    auto t_legacy = measureBatch(iterations, 100, [&]() {
+        legacySwapBuffer(g_tof_dev.temp_buffer, size);
+        keepAlive(g_tof_dev.temp_buffer);
+    });
+    printRow("tof_swap", "bytewise", size, t_legacy, to_string(size));
+    auto t = measureBatch(iterations, 100, [&]() {
+        VL53L8CX_SwapBuffer(g_tof_dev.temp_buffer, size);
+        keepAlive(g_tof_dev.temp_buffer);
+    });
+    printRow("tof_swap", "swap_buffer", size, t, to_string(size) + (same ? "" : " MISMATCH"));
+}
+
+static void benchTofUnpack(int iterations) {
+    vector<uint8_t> raw;
+    if (!prepareTofFrame(raw)) {
+        return;
+    }
+    uint32_t size = g_tof_dev.data_read_size;
+
+    printHeader("status/distance0_mm");
+    // I2Cで読んだ直後の状態に戻すコピー（下のdecodeに含まれる分の目安）
+    auto t_copy = measureBatch(iterations, 100, [&]() {
+        memcpy(g_tof_dev.temp_buffer, raw.data(), size);
+        keepAlive(g_tof_dev.temp_buffer);
+    });
+    printRow("tof_unpack", "copy_only", size, t_copy, "");
+
+    // 以前の展開（全体を入れ替えてからmemcpy）と、使うブロックだけを結果に直接入れ替える展開の結果を比べる
+    static VL53L8CX_ResultsData legacy_results;
+    memset(&legacy_results, 0, sizeof(legacy_results));
+    memset(&g_tof_results, 0, sizeof(g_tof_results));
+    memcpy(g_tof_dev.temp_buffer, raw.data(), size);
+    uint8_t legacy_status = legacyDecodeRangingData(&g_tof_dev, &legacy_results);
+    memcpy(g_tof_dev.temp_buffer, raw.data(), size);
+    uint8_t status = vl53l8cx_decode_ranging_data(&g_tof_dev, &g_tof_results);
+    bool same = legacy_status == status && memcmp(&legacy_results, &g_tof_results, sizeof(g_tof_results)) == 0;
+
+    auto t_legacy = measureBatch(iterations, 100, [&]() {
+        memcpy(g_tof_dev.temp_buffer, raw.data(), size);
+        legacy_status = legacyDecodeRangingData(&g_tof_dev, &legacy_results);
+        keepAlive(&legacy_results);
+    });
+    printRow("tof_unpack", "legacy_decode", size, t_legacy,
+             to_string(legacy_status) + "/" + to_string(legacy_results.distance_mm[0]));
+
+    // vl53l8cx_get_ranging_data()のRdMulti以降（使うブロックの入れ替え・展開、単位変換、フレームIDの確認）
+    auto t_decode = measureBatch(iterations, 100, [&]() {
+        memcpy(g_tof_dev.temp_buffer, raw.data(), size);
+        status = vl53l8cx_decode_ranging_data(&g_tof_dev, &g_tof_results);
+        keepAlive(&g_tof_results);
+    });
+    printRow("tof_unpack", "copy_decode", size, t_decode,
+             to_string(status) + "/" + to_string(g_tof_results.distance_mm[0]) + (same ? "" : " MISMATCH"));
+}
+
+// ---------------------------------------------------------------------------
+// Picoからの行の解析: UARTPico::feed()（行の切り出し + processLine）
+// ---------------------------------------------------------------------------
+
+static void benchUartParse(int iterations) {
+    UARTPico pico;   // init()しないのでシリアルポートには触れない
+    uint64_t parsed = 0;
+    pico.setIMUCallback([&](float, float, float, float, float, float) { parsed++; });
+    pico.setMotorCallback([&](int, int) { parsed++; });
+    pico.setAlertCallback([&](const string&) { parsed++; });
+
+    const string imu_line = "IMU,0.012,-0.034,9.801,0.120,-0.250,0.031\r\n";
+    const string motor_line = "MOTOR,30,-20\r\n";
+    // read()1回で届く量: 50HzのIMUの間にMOTORとALERTが混ざる
+    string burst;
+    for (int i = 0; i < 16; i++) {
+        burst += (i == 7) ? motor_line : (i == 15) ? string("ALERT,CLIFF\r\n") : imu_line;
+    }
+
+    printHeader("lines_parsed");
+    struct Variant { const char* name; const string* data; size_t lines; size_t chunk; };
+    const Variant kVariants[] = {
+        {"imu_line", &imu_line, 1, imu_line.size()},
+        {"motor_line", &motor_line, 1, motor_line.size()},
+        {"burst_16_lines", &burst, 16, burst.size()},
+        {"burst_16_lines_7byte_reads", &burst, 16, 7},   // 行がread()の境界で分かれる場合
+    };
+    for (const auto& v : kVariants) {
+        parsed = 0;
+        const string& data = *v.data;
+        auto t = measure(iterations, [&]() {
+            for (size_t off = 0; off < data.size(); off += v.chunk) {
+                pico.feed(data.data() + off, min(v.chunk, data.size() - off));
+            }
+        });
+        printRow("uart_parse", v.name, v.lines, t, to_string(parsed));
+    }
+}
+
+// ---------------------------------------------------------------------------
+// MJPEGのパート組み立て: std::stringで連結 vs JpegFrameにヘッダーを書式化してiovで並べる（送信は含まない）
+// ---------------------------------------------------------------------------
+
+static void benchMjpegFraming(int iterations) {
+    const size_t kJpegSizes[] = {12 * 1024, 60 * 1024};
+
+    printHeader("wire_bytes");
+    for (size_t jpeg_size : kJpegSizes) {
+        vector<unsigned char> jpeg(jpeg_size, 0x5A);
+
+        // 従来: ヘッダー・JPEG・CRLFを1つのstd::stringにまとめてから送る
+        size_t wire = 0;
+        auto t_concat = measure(iterations, [&]() {
+            string part = "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: " +
+                          to_string(jpeg.size()) + "\r\n\r\n";
+            part.append((const char*)jpeg.data(), jpeg.size());
+            part += "\r\n";
+            wire = part.size();
+            keepAlive(part.data());
+        });
+        printRow("mjpeg_framing", "string_concat", jpeg_size, t_concat, to_string(wire));
+
+        // MjpegBroadcaster: フレームごとにJpegFrameを作ってヘッダーを1回書式化し、
+        // クライアントはヘッダー・JPEG・CRLFをiovに並べるだけ（JPEGはエンコーダーが直接書くので複製しない）
+        auto t_iov = measure(iterations, [&]() {
+            auto frame = make_shared<JpegFrame>();
+            frame->part_header_size = (size_t)snprintf(
+                frame->part_header, sizeof(frame->part_header),
+                "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n", jpeg.size());
+            struct iovec iov[3] = {
+                {frame->part_header, frame->part_header_size},
+                {jpeg.data(), jpeg.size()},
+                {const_cast<char*>(kMjpegPartTrailer), kMjpegPartTrailerSize},
+            };
+            wire = iov[0].iov_len + iov[1].iov_len + iov[2].iov_len;
+            keepAlive(iov);
+        });
+        printRow("mjpeg_framing", "part_header_iov", jpeg_size, t_iov, to_string(wire));
+    }
+}
+
+static vector<BenchCase> allCases() {
+    return {
+        {"nms", "Non-maximum suppression (300/1000/3000 candidates)", benchNms},
+        {"tracker", "ObjectTracker::update (5/20/50 moving objects, 10% misses)", benchTracker},
+        {"darknet_parse", "Darknet output parsing (yolov4-tiny shapes, 80 classes)", benchDarknetParse},
+        {"mjpeg", "MJPEG fan-out to 1/5 clients (per-client encode vs encode once)", benchMjpeg},
+        {"jpeg_encode", "JPEG encode at 320x240 / 640x480 (imencode vs JpegEncoder BGR / I420)", benchJpegEncode},
+        {"mjpeg_send", "MJPEG part send: 3x send() vs one sendmsg vs MSG_ZEROCOPY (syscalls, CPU)", benchMjpegSend},
+        {"blackbox", "Black-box ring record cost (ToF, UART line, frame copy, frame encode)", benchBlackBox},
+        {"yolo_decode", "YOLOv8 output decoding (yolov8n 320/640, 80 classes, both layouts)", benchYoloDecode},
+        {"blob", "blobFromImage of the rotated 240x320 frame to 320/416 (new vs reused blob)", benchBlob},
+        {"depth_overlay", "ToF colormap overlay (calibrated blend / vconcat heatmap)", benchDepthOverlay},
+        {"tof_swap", "VL53L8CX_SwapBuffer over one 8x8 ranging frame (bytewise vs bswap32/NEON)", benchTofSwap},
+        {"tof_unpack", "Ranging frame decode after the I2C read (full swap + memcpy vs fused block swap)", benchTofUnpack},
+        {"uart_parse", "UARTPico line framing and parsing (IMU / MOTOR lines, 16-line bursts)", benchUartParse},
+        {"mjpeg_framing", "MJPEG part framing (string concat vs part header + iov)", benchMjpegFraming},
+    };
+}
+
+static void printUsage(const char* prog) {
+    cerr << "使い方: " << prog << " [--case <name>] [--iterations N] [--warmup N] [--list]" << endl;
+}
+
+int main(int argc, char** argv) {
+    string case_name;
+    int iterations = 200;
+
+    vector<BenchCase> cases = allCases();
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--case" && i + 1 < argc) {
+            case_name = argv[++i];
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = max(1, atoi(argv[++i]));
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            g_warmup = max(0, atoi(argv[++i]));
+        } else if (arg == "--list") {
+            for (const auto& c : cases) {
+                cout << c.name << "\t" << c.description << endl;
+            }
+            return 0;
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+
+    bool found = false;
+    for (const auto& c : cases) {
+        if (!case_name.empty() && case_name != c.name) {
+            continue;
+        }
+        found = true;
+        cout << "# " << c.name << ": " << c.description << " (iterations=" << iterations
+             << ", warmup=" << (g_warmup >= 0 ? to_string(g_warmup) : string("iterations/10")) << ")" << endl;
+        c.run(iterations);
+        cout << endl;
+    }
+
+    if (!found) {
+        cerr << "不明なケース: " << case_name << endl;
+        printUsage(argv[0]);
+        return -1;
+    }
+    return 0;
+}
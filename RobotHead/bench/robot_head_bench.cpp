@@ -0,0 +1,550 @@
+/**
+ * @file robot_head_bench.cpp
+ * @brief Offline full-pipeline replay benchmark for robot_head
+ * @author RobotC Project
+ * @date 2026-01-23
+ *
+ * 使い方:
+ *   ./robot_head_bench --session ./Data/session.rsl --model ./Data/models/yolov8n_320.onnx
+ *   ./robot_head_bench --source synthetic --frames 300               (カメラ・録画の無いホスト向け)
+ *   ./robot_head_bench --session s.rsl --json new.json --baseline old.json --fail-on-regression 10
+ *
+ * 記録したセッション（--record-session）のフレームとToFの測距結果を、robot_headと同じ処理
+ * （歪み補正 → 回転 → ToFゲート・物体検出 → 追跡・距離の対応付け → オーバーレイ → JPEG）に
+ * 待たずに流し、スループット、段階別の遅延（平均/p50/p95/p99/最大）、1フレームあたりのCPU時間、
+ * ピークRSSを求める。推論は毎フレーム同期で行う（動きゲートは使わない）ため、結果は入力だけで決まる。
+ * 結果は表形式で標準出力に、比較用のJSONを--jsonのパスに出力する。--baselineに以前のJSONを
+ * 渡すと差を表示し、--fail-on-regressionの割合を超えて遅くなった場合は終了コード2を返す。
+ */
+
+#include <opencv2/opencv.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sys/resource.h>
+#include "camera/frame_source.h"
+#include "network/jpeg_encoder.h"
+#include "platform/process_stats.h"
+#include "platform/session_log.h"
+#include "sensors/depth_overlay.h"
+
+#ifdef ENABLE_OBJECT_DETECTION
+#include "detection/object_detector.h"
+#include "detection/object_tracker.h"
+#include "detection/tof_gate.h"
+#endif
+
+#include "git_commit.h"   // ビルド時に生成（ROBOT_GIT_COMMIT）
+
+using namespace cv;
+using namespace std;
+
+// 計測する段階（totalはdecodeを含まない: 録画の展開はrobot_headには無い処理のため）
+enum Stage { kDecode, kUndistort, kRotate, kDetect, kFusion, kOverlay, kEncode, kTotal, kStageCount };
+static const char* kStageNames[kStageCount] = {
+    "decode", "undistort", "rotate", "detect", "fusion", "overlay", "encode", "total"
+};
+
+struct StageStats {
+    double mean_ms = 0.0;
+    double p50_ms = 0.0;
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;
+};
+
+struct BenchResult {
+    size_t frames = 0;
+    double wall_s = 0.0;
+    double fps = 0.0;
+    double cpu_ms_per_frame = 0.0;
+    double peak_rss_mb = 0.0;
+    size_t detect_runs = 0;
+    size_t detections = 0;
+    StageStats stages[kStageCount];
+};
+
+/** @brief 再生する1フレーム（セッションの記録番号、またはメモリ上の画像） */
+struct ReplayFrame {
+    size_t record = 0;
+    int tof = -1;               // robot_headがこのフレームに使ったToFの記録番号（無ければ-1）
+    uint64_t source_us = 0;     // 記録時刻（--sourceでは入力上の時刻）。追跡の時計に使う
+    Mat image;                  // --sourceの場合のみ
+};
+
+static double percentile(vector<double> values, double p) {
+    if (values.empty()) return 0.0;
+    sort(values.begin(), values.end());
+    size_t idx = (size_t)(p * (values.size() - 1));
+    return values[idx];
+}
+
+static StageStats summarize(const vector<double>& values) {
+    StageStats s;
+    if (values.empty()) return s;
+    double sum = 0.0;
+    for (double v : values) sum += v;
+    s.mean_ms = sum / values.size();
+    s.p50_ms = percentile(values, 0.50);
+    s.p95_ms = percentile(values, 0.95);
+    s.p99_ms = percentile(values, 0.99);
+    s.max_ms = *max_element(values.begin(), values.end());
+    return s;
+}
+
+static double processCpuMs() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+}
+
+static string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\t': out += "\\t"; break;
+            default: out += c; break;
+        }
+    }
+    return out;
+}
+
+static bool writeJson(const string& path, const string& input, const string& model, int iterations,
+                      const BenchResult& r) {
+    ofstream os(path);
+    if (!os.is_open()) {
+        cerr << "JSONファイルを開けません: " << path << endl;
+        return false;
+    }
+
+    time_t now = time(nullptr);
+    char timestamp[32];
+    strftime(timestamp, sizeof(timestamp), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+
+    os << "{\n"
+       << "  \"timestamp\": \"" << timestamp << "\",\n"
+       << "  \"commit\": \"" << ROBOT_GIT_COMMIT << "\",\n"
+       << "  \"input\": \"" << jsonEscape(input) << "\",\n"
+       << "  \"model\": \"" << jsonEscape(model) << "\",\n"
+       << "  \"iterations\": " << iterations << ",\n"
+       << "  \"frames\": " << r.frames << ",\n"
+       << "  \"fps\": " << r.fps << ",\n"
+       << "  \"cpu_ms_per_frame\": " << r.cpu_ms_per_frame << ",\n"
+       << "  \"peak_rss_mb\": " << r.peak_rss_mb << ",\n"
+       << "  \"detect_runs\": " << r.detect_runs << ",\n"
+       << "  \"detections\": " << r.detections << ",\n"
+       << "  \"stages\": {\n";
+    for (int i = 0; i < kStageCount; i++) {
+        const StageStats& s = r.stages[i];
+        os << "    \"" << kStageNames[i] << "\": {\"mean_ms\": " << s.mean_ms << ", \"p50_ms\": " << s.p50_ms
+           << ", \"p95_ms\": " << s.p95_ms << ", \"p99_ms\": " << s.p99_ms << ", \"max_ms\": " << s.max_ms << "}"
+           << (i + 1 < kStageCount ? ",\n" : "\n");
+    }
+    os << "  }\n}\n";
+    return true;
+}
+
+// 自分で書いたJSONから "key": 数値 を読む（scopeを指定するとその段階の中から探す）
+static bool findJsonNumber(const string& json, const string& scope, const string& key, double& value) {
+    size_t from = 0;
+    if (!scope.empty()) {
+        from = json.find("\"" + scope + "\": {");
+        if (from == string::npos) {
+            return false;
+        }
+    }
+    size_t pos = json.find("\"" + key + "\": ", from);
+    if (pos == string::npos) {
+        return false;
+    }
+    value = atof(json.c_str() + pos + key.size() + 4);
+    return true;
+}
+
+/**
+ * @brief 以前の結果との差を表示する
+ * @return 許容範囲を超えて遅くなった項目があればtrue
+ */
+static bool compareWithBaseline(const string& path, const BenchResult& r, double tolerance_percent) {
+    ifstream file(path);
+    if (!file.is_open()) {
+        cerr << "基準のJSONを開けません: " << path << endl;
+        return false;
+    }
+    stringstream buffer;
+    buffer << file.rdbuf();
+    string json = buffer.str();
+
+    bool regressed = false;
+    auto report = [&](const string& name, double before, double after, bool higher_is_better) {
+        if (before <= 0.0) {
+            return;
+        }
+        double change = (after - before) / before * 100.0;
+        double worse = higher_is_better ? -change : change;
+        bool flag = tolerance_percent > 0.0 && worse > tolerance_percent;
+        regressed = regressed || flag;
+        cout << "  " << setw(22) << left << name << right << setw(10) << before << " -> " << setw(10) << after
+             << "  (" << showpos << change << noshowpos << "%)" << (flag ? "  ← 悪化" : "") << endl;
+    };
+
+    string commit = "?";
+    size_t pos = json.find("\"commit\": \"");
+    if (pos != string::npos) {
+        commit = json.substr(pos + 11, json.find('"', pos + 11) - pos - 11);
+    }
+    cout << endl << "基準との比較（" << path << ", commit " << commit << " → " << ROBOT_GIT_COMMIT << "）" << endl;
+    cout << fixed << setprecision(3);
+    double value;
+    if (findJsonNumber(json, "", "fps", value)) report("fps", value, r.fps, true);
+    if (findJsonNumber(json, "", "cpu_ms_per_frame", value)) report("cpu_ms_per_frame", value, r.cpu_ms_per_frame, false);
+    if (findJsonNumber(json, "", "peak_rss_mb", value)) report("peak_rss_mb", value, r.peak_rss_mb, false);
+    for (int i = 0; i < kStageCount; i++) {
+        if (i == kDecode) {
+            continue;
+        }
+        if (findJsonNumber(json, kStageNames[i], "p50_ms", value)) {
+            report(string(kStageNames[i]) + ".p50_ms", value, r.stages[i].p50_ms, false);
+        }
+        if (findJsonNumber(json, kStageNames[i], "p95_ms", value)) {
+            report(string(kStageNames[i]) + ".p95_ms", value, r.stages[i].p95_ms, false);
+        }
+    }
+    return regressed;
+}
+
+static void printUsage(const char* prog) {
+    cerr << "使い方: " << prog << " (--session <file.rsl> | --source <spec> [--frames N])"
+         << " [--model <path>] [--labels <coco.names>] [--camera-calib <yaml>] [--depth-calib <yaml>]"
+         << " [--warmup N] [--iterations N] [--jpeg-quality N] [--json <path>]"
+         << " [--baseline <json>] [--fail-on-regression PERCENT]" << endl;
+}
+
+int main(int argc, char** argv) {
+    string session_path;
+    string source_spec;
+    string model_path;
+    string labels_path = "./Data/models/coco.names";
+    string camera_calib_path = "./Data/camera_calibration.yaml";
+    string depth_calib_path = "./Data/depth_calibration.yaml";
+    string json_path = "robot_head_bench_result.json";
+    string baseline_path;
+    double fail_percent = 0.0;
+    int source_frames = 300;
+    int warmup = 5;
+    int iterations = 1;
+    int jpeg_quality = 95;
+
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--session" && i + 1 < argc) {
+            session_path = argv[++i];
+        } else if (arg == "--source" && i + 1 < argc) {
+            source_spec = argv[++i];
+        } else if (arg == "--frames" && i + 1 < argc) {
+            source_frames = max(1, atoi(argv[++i]));
+        } else if (arg == "--model" && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (arg == "--labels" && i + 1 < argc) {
+            labels_path = argv[++i];
+        } else if (arg == "--camera-calib" && i + 1 < argc) {
+            camera_calib_path = argv[++i];
+        } else if (arg == "--depth-calib" && i + 1 < argc) {
+            depth_calib_path = argv[++i];
+        } else if (arg == "--warmup" && i + 1 < argc) {
+            warmup = max(0, atoi(argv[++i]));
+        } else if (arg == "--iterations" && i + 1 < argc) {
+            iterations = max(1, atoi(argv[++i]));
+        } else if (arg == "--jpeg-quality" && i + 1 < argc) {
+            jpeg_quality = atoi(argv[++i]);
+        } else if (arg == "--json" && i + 1 < argc) {
+            json_path = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            baseline_path = argv[++i];
+        } else if (arg == "--fail-on-regression" && i + 1 < argc) {
+            fail_percent = atof(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return -1;
+        }
+    }
+    if (session_path.empty() == source_spec.empty()) {
+        printUsage(argv[0]);
+        return -1;
+    }
+
+    // 入力の準備（計測対象外）
+    SessionReader session;
+    vector<ReplayFrame> replay;
+    string input_name;
+    if (!session_path.empty()) {
+        if (!session.open(session_path)) {
+            return -1;
+        }
+        if (session.header().tof_results_bytes != sizeof(VL53L8CX_ResultsData)) {
+            cerr << "セッションのToFの結果の形式がこのビルドと異なります（ToFなしで再生します）" << endl;
+        }
+        bool tof_usable = session.header().tof_results_bytes == sizeof(VL53L8CX_ResultsData);
+        int last_tof = -1;
+        for (size_t i = 0; i < session.size(); i++) {
+            SessionRecord record = session.record(i);
+            if (record.type == SessionRecordType::ToFResults && tof_usable) {
+                // robot_headはフレームを読んだ後に届いた測距結果をそのフレームに使って記録する
+                last_tof = (int)i;
+                if (!replay.empty()) {
+                    replay.back().tof = last_tof;
+                }
+            } else if (record.type == SessionRecordType::JpegFrame || record.type == SessionRecordType::RawFrame) {
+                ReplayFrame frame;
+                frame.record = i;
+                frame.tof = last_tof;
+                frame.source_us = record.timestamp_us;
+                replay.push_back(frame);
+            }
+        }
+        input_name = session_path;
+    } else {
+        // 回転前の320x240（robot_headのカメラと同じ）
+        unique_ptr<FrameSource> source = openFrameSource(source_spec, 320, 240);
+        if (!source) {
+            return -1;
+        }
+        source->setPacing(FramePacing::AsFastAsPossible);
+        ReplayFrame frame;
+        while ((int)replay.size() < source_frames && source->read(frame.image)) {
+            frame.source_us = source->lastSourceUs();
+            replay.push_back(frame);
+            frame.image = Mat();
+        }
+        input_name = source->name();
+    }
+    if (replay.empty()) {
+        cerr << "再生するフレームがありません" << endl;
+        return -1;
+    }
+    cout << "入力: " << input_name << "（" << replay.size() << "フレーム）" << endl;
+
+    // robot_headと同じキャリブレーションファイル
+    Mat camera_matrix, dist_coeffs;
+    bool use_camera_calib = false;
+    FileStorage fs_camera(camera_calib_path, FileStorage::READ);
+    if (fs_camera.isOpened()) {
+        fs_camera["camera_matrix"] >> camera_matrix;
+        fs_camera["distortion_coefficients"] >> dist_coeffs;
+        use_camera_calib = true;
+    }
+    DepthOverlayConfig depth_overlay;
+    FileStorage fs_depth(depth_calib_path, FileStorage::READ);
+    if (fs_depth.isOpened()) {
+        int x = 35, y = 60, w = 240, h = 240;
+        fs_depth["offset_x"] >> x;
+        fs_depth["offset_y"] >> y;
+        fs_depth["overlay_width"] >> w;
+        fs_depth["overlay_height"] >> h;
+        fs_depth["alpha"] >> depth_overlay.alpha;
+        depth_overlay.region = Rect(x, y, w, h);
+        depth_overlay.calibrated = true;
+    }
+    cout << "歪み補正: " << (use_camera_calib ? "あり" : "なし") << ", Depth重ね合わせ: "
+         << (depth_overlay.calibrated ? "キャリブレーション済み" : "縦結合") << endl;
+
+#ifdef ENABLE_OBJECT_DETECTION
+    // robot_headと同じく、検出器はトラッカーの2段目の下限まで候補を出す
+    TrackerConfig tracker_config;
+    unique_ptr<ObjectDetector> detector;
+    if (!model_path.empty()) {
+        try {
+            detector.reset(new ObjectDetector(model_path, labels_path, tracker_config.low_threshold));
+        } catch (const exception& e) {
+            cerr << "モデルの読み込みに失敗しました: " << model_path << " (" << e.what() << ")" << endl;
+            return -1;
+        }
+    }
+    ToFGate tof_gate;
+    tof_gate.setNearRange(1200);
+    ObjectTracker tracker(tracker_config);
+    vector<DetectedObject> detections;
+#else
+    if (!model_path.empty()) {
+        cerr << "物体検出なしでビルドされています（--modelは無視します）" << endl;
+    }
+#endif
+
+    JpegEncoder encoder(jpeg_quality);
+    vector<unsigned char> jpeg;
+    VL53L8CX_ResultsData results;
+    memset(&results, 0, sizeof(results));
+
+    vector<double> samples[kStageCount];
+    BenchResult r;
+    Mat frame, undistorted, display, blob;
+    size_t total_frames = (size_t)warmup + replay.size() * iterations;
+    double cpu_start = 0.0;
+    chrono::steady_clock::time_point wall_start;
+
+    // 追跡には再生速度ではなく記録上の時刻を渡す（先頭に戻る時は平均のフレーム間隔だけ進める）
+    uint64_t frame_interval_us = 1000000 / 15;
+    if (replay.size() > 1 && replay.back().source_us > replay.front().source_us) {
+        frame_interval_us = (replay.back().source_us - replay.front().source_us) / (replay.size() - 1);
+    }
+    uint64_t replay_clock_us = 0;
+    uint64_t prev_source_us = 0;
+#ifdef ENABLE_OBJECT_DETECTION
+    bool gate_configured = false;   // 最初に展開できたフレームの大きさでToFゲートを設定する
+#endif
+
+    for (size_t n = 0; n < total_frames; n++) {
+        bool measured = n >= (size_t)warmup;
+        if (n == (size_t)warmup) {
+            // ウォームアップの後から計測する（追跡の状態は引き継ぐ）
+            cpu_start = processCpuMs();
+            wall_start = chrono::steady_clock::now();
+        }
+        const ReplayFrame& item = replay[(measured ? n - warmup : n) % replay.size()];
+        replay_clock_us += (n > 0 && item.source_us > prev_source_us) ? item.source_us - prev_source_us
+                                                                       : frame_interval_us;
+        prev_source_us = item.source_us;
+#ifdef ENABLE_OBJECT_DETECTION
+        ObjectTracker::Clock::time_point frame_time{chrono::microseconds(replay_clock_us)};
+#endif
+        double stage_ms[kStageCount] = {0.0};
+        auto t = chrono::steady_clock::now();
+        auto lap = [&](Stage stage) {
+            auto now = chrono::steady_clock::now();
+            stage_ms[stage] = chrono::duration<double, milli>(now - t).count();
+            t = now;
+        };
+
+        // 入力（録画の展開）
+        bool has_depth = false;
+        if (!session_path.empty()) {
+            if (!SessionReader::decodeFrame(session.record(item.record), frame)) {
+                continue;
+            }
+            if (item.tof >= 0) {
+                has_depth = SessionReader::decodeToFResults(session.record((size_t)item.tof), results);
+            }
+        } else {
+            item.image.copyTo(frame);
+        }
+        lap(kDecode);
+        auto pipeline_start = t;
+
+        if (use_camera_calib) {
+            undistort(frame, undistorted, camera_matrix, dist_coeffs);
+            frame = undistorted;
+        }
+        lap(kUndistort);
+
+        rotate(frame, frame, ROTATE_90_COUNTERCLOCKWISE);
+        display = frame.clone();
+        lap(kRotate);
+
+#ifdef ENABLE_OBJECT_DETECTION
+        if (detector) {
+            if (!gate_configured) {
+                tof_gate.configure(depth_overlay.region, frame.size(), depth_overlay.calibrated);
+                gate_configured = true;
+            }
+            GateDecision gate = has_depth ? tof_gate.evaluate(results.distance_mm, results.target_status, 64)
+                                          : tof_gate.evaluateWithoutDepth();
+            detections.clear();
+            if (gate.run) {
+                // AsyncDetectorと同じく、切り出す場合は画素密度を保った入力サイズで推論する
+                Rect region = gate.cropped ? (gate.roi & Rect(0, 0, frame.cols, frame.rows)) : Rect();
+                if (region.area() > 0) {
+                    detector->preprocess(frame(region), blob, detector->inputSizeFor(region.size(), frame.size()));
+                    detections = detector->detectBlob(blob, region.size());
+                    for (auto& d : detections) {
+                        d.bbox.x += region.x;
+                        d.bbox.y += region.y;
+                    }
+                } else {
+                    detector->preprocess(frame, blob);
+                    detections = detector->detectBlob(blob, frame.size());
+                }
+                if (measured) {
+                    r.detect_runs++;
+                    r.detections += tracker.confidentDetections(detections).size();
+                }
+            }
+            lap(kDetect);
+
+            tracker.update(detections, frame_time, gate.cropped ? gate.roi : Rect());
+            if (has_depth) {
+                tracker.assignDistances([&](const Rect& region) {
+                    return tof_gate.nearestDistance(region, results.distance_mm, results.target_status, 64);
+                }, frame_time);
+            }
+            lap(kFusion);
+
+            detector->drawDetections(display, tracker.confidentDetections(detections));
+            tracker.drawTracks(display);
+        } else {
+            lap(kDetect);
+            lap(kFusion);
+        }
+#else
+        lap(kDetect);
+        lap(kFusion);
+#endif
+        if (has_depth) {
+            drawDepthOverlay(frame, results.distance_mm, depth_overlay, display);
+        }
+        lap(kOverlay);
+
+        encoder.encode(display, jpeg);
+        lap(kEncode);
+        stage_ms[kTotal] = chrono::duration<double, milli>(t - pipeline_start).count();
+
+        if (measured) {
+            for (int s = 0; s < kStageCount; s++) {
+                samples[s].push_back(stage_ms[s]);
+            }
+        }
+    }
+
+    r.frames = samples[kTotal].size();
+    r.wall_s = chrono::duration<double>(chrono::steady_clock::now() - wall_start).count();
+    r.fps = r.wall_s > 0.0 ? r.frames / r.wall_s : 0.0;
+    r.cpu_ms_per_frame = r.frames > 0 ? (processCpuMs() - cpu_start) / r.frames : 0.0;
+    r.peak_rss_mb = readPeakRssKb() / 1024.0;
+    for (int s = 0; s < kStageCount; s++) {
+        r.stages[s] = summarize(samples[s]);
+    }
+
+    cout << endl << fixed << setprecision(3)
+         << "フレーム: " << r.frames << "（" << iterations << "周）, 経過 " << r.wall_s << "秒, "
+         << r.fps << " fps（入力の展開を含む）" << endl
+         << "CPU時間: " << r.cpu_ms_per_frame << " ms/フレーム（全スレッド）, ピークRSS: " << r.peak_rss_mb << " MB" << endl;
+    if (r.detect_runs > 0) {
+        cout << "推論: " << r.detect_runs << "回, 検出 " << r.detections << "件" << endl;
+    }
+    cout << endl << "stage\tmean_ms\tp50_ms\tp95_ms\tp99_ms\tmax_ms" << endl;
+    for (int s = 0; s < kStageCount; s++) {
+        const StageStats& st = r.stages[s];
+        cout << kStageNames[s] << "\t" << st.mean_ms << "\t" << st.p50_ms << "\t" << st.p95_ms << "\t"
+             << st.p99_ms << "\t" << st.max_ms << endl;
+    }
+
+    if (writeJson(json_path, input_name, model_path, iterations, r)) {
+        cout << endl << "JSONを出力しました: " << json_path << endl;
+    }
+    if (!baseline_path.empty() && compareWithBaseline(baseline_path, r, fail_percent)) {
+        cerr << "基準より" << fail_percent << "%を超えて遅くなった項目があります" << endl;
+        return 2;
+    }
+    return 0;
+}
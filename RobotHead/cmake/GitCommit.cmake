@@ -0,0 +1,20 @@
+# ビルドのたびに実行し、現在のコミットをヘッダーに書き出す（robot_head_benchのJSONに残す）
+#   cmake -DSOURCE_DIR=<ソース> -DOUTPUT=<ヘッダー> -P GitCommit.cmake
+# 内容が変わった時だけ書き換えるので、コミットが同じなら再コンパイルは起きない
+execute_process(COMMAND git rev-parse --short HEAD
+  WORKING_DIRECTORY ${SOURCE_DIR}
+  OUTPUT_VARIABLE ROBOT_GIT_COMMIT
+  OUTPUT_STRIP_TRAILING_WHITESPACE
+  RESULT_VARIABLE GIT_RESULT
+  ERROR_QUIET)
+if(NOT GIT_RESULT EQUAL 0 OR NOT ROBOT_GIT_COMMIT)
+  set(ROBOT_GIT_COMMIT "unknown")
+endif()
+
+set(CONTENT "#ifndef GIT_COMMIT_H\n#define GIT_COMMIT_H\n#define ROBOT_GIT_COMMIT \"${ROBOT_GIT_COMMIT}\"\n#endif // GIT_COMMIT_H\n")
+if(EXISTS ${OUTPUT})
+  file(READ ${OUTPUT} OLD_CONTENT)
+endif()
+if(NOT CONTENT STREQUAL OLD_CONTENT)
+  file(WRITE ${OUTPUT} "${CONTENT}")
+endif()
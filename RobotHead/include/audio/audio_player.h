@@ -8,6 +8,7 @@
 #ifndef AUDIO_PLAYER_H
 #define AUDIO_PLAYER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -63,6 +64,12 @@ public:
      */
     bool isPlaying() const { return is_playing_; }
     
+    /**
+     * @brief Time the last playback was launched (UNIX time in microseconds, 0 if none)
+     * @note This is when aplay was started; ALSA device start-up is not included
+     */
+    uint64_t lastStartUs() const { return last_start_us_; }
+    
 private:
     /**
      * @brief Play a random file from a list
@@ -72,6 +79,7 @@ private:
     bool playRandomFromList(const std::vector<std::string>& files);
     
     bool is_playing_;                              ///< Playback status flag
+    uint64_t last_start_us_;                       ///< Launch time of the last playback (UNIX us)
     std::string device_;                           ///< ALSA device name
     std::vector<std::string> greeting_files_;      ///< List of greeting audio files
     std::vector<std::string> response_files_;      ///< List of response audio files
@@ -0,0 +1,54 @@
+/**
+ * @file frame_band.h
+ * @brief Machine-readable black/white bands painted into frames (frame counter, capture timecode)
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef FRAME_BAND_H
+#define FRAME_BAND_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+/*
+ * 帯: 32マス = 同期2マス（白, 黒）+ 値24ビット（上位から）+ 検査6ビット
+ * 白 = 1, 黒 = 0。1マスは画像の幅（左端の場合は高さ）の1/32。JPEGを通しても読める。
+ */
+
+/** @brief 帯の高さ（ピクセル） */
+static const int kFrameBandHeight = 8;
+/** @brief 帯に入る値のビット数（これを超える値は下位だけが入る） */
+static const int kFrameBandBits = 24;
+
+/** @brief 帯の位置 */
+enum class FrameBandEdge {
+    Top,      // 上端（先頭のマスが左）
+    Left,     // 左端（上端の帯を左90度回転した位置、先頭のマスが下）
+    Bottom,   // 下端（先頭のマスが左）
+};
+
+/** @brief 値を帯として描く */
+void drawFrameBand(cv::Mat& frame, uint32_t value, FrameBandEdge edge);
+
+/**
+ * @brief 帯の値を読む
+ * @return 同期マスと検査ビットが合った場合true
+ */
+bool readFrameBand(const cv::Mat& frame, FrameBandEdge edge, uint32_t& value);
+
+/**
+ * @brief 撮影時刻を下端の帯に描く（--latency-timecode）
+ *
+ * UNIX時刻のミリ秒の下位24ビット（約4.6時間で一周）を入れる。
+ */
+void drawCaptureTimecode(cv::Mat& frame, uint64_t capture_us);
+
+/**
+ * @brief 下端の帯から撮影時刻を読む
+ * @param reference_us 受信時刻など、撮影時刻より後で一周（約4.6時間）以内の時刻（一周分を補うのに使う）
+ * @param capture_us 撮影時刻（UNIX時刻、ミリ秒単位に丸めたもの）
+ */
+bool readCaptureTimecode(const cv::Mat& frame, uint64_t reference_us, uint64_t& capture_us);
+
+#endif // FRAME_BAND_H
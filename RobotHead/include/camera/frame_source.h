@@ -0,0 +1,195 @@
+/**
+ * @file frame_source.h
+ * @brief Common frame source interface with V4L2, image directory, video file and synthetic backends
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef FRAME_SOURCE_H
+#define FRAME_SOURCE_H
+
+#include <opencv2/core.hpp>
+#include <opencv2/videoio.hpp>
+#include "camera/frame_band.h"
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+/** @brief 記録済みの入力を流す速さ */
+enum class FramePacing {
+    RealTime,           // 記録時の間隔（またはfps）に合わせて待つ
+    AsFastAsPossible,   // 待たずに次のフレームを返す（ベンチマーク用）
+};
+
+bool parseFramePacing(const std::string& text, FramePacing& out);
+
+/**
+ * @class FrameSource
+ * @brief パイプラインへのフレームの入力（カメラ・ファイル・合成画像を同じように扱う）
+ *
+ * read()はBGRのフレームを返す。カメラ以外の入力はsetPacing()に従って待ち、
+ * 記録時の間隔を再現するか、待たずに次のフレームを返す。
+ */
+class FrameSource {
+public:
+    FrameSource();
+    virtual ~FrameSource() {}
+
+    FrameSource(const FrameSource&) = delete;
+    FrameSource& operator=(const FrameSource&) = delete;
+
+    virtual bool isOpened() const = 0;
+    virtual void release() = 0;
+    /** @brief ログ用の名前（"libcamera", "v4l2:/dev/video0"など） */
+    virtual std::string name() const = 0;
+    /** @brief カメラのように自分でフレームの間隔が決まる入力ならtrue（ペーシングしない） */
+    virtual bool isLive() const { return false; }
+
+    /**
+     * @brief 次のフレームを読む
+     * @return フレームを読めた場合true（ファイルの終わり・カメラの異常ではfalse）
+     */
+    bool read(cv::Mat& frame);
+
+    void setPacing(FramePacing pacing) { pacing_ = pacing; }
+    FramePacing pacing() const { return pacing_; }
+
+    /** @brief 直前のフレームをパイプラインに渡したUNIX時刻（マイクロ秒、撮影時刻として使う） */
+    uint64_t lastCaptureUs() const { return last_capture_us_; }
+    /** @brief 直前のフレームの入力上の時刻（マイクロ秒、記録時刻やfpsから求めた値） */
+    uint64_t lastSourceUs() const { return last_source_us_; }
+    uint64_t framesRead() const { return frames_; }
+
+protected:
+    /**
+     * @brief 派生クラスが実装する読み出し
+     * @param source_us 入力上の時刻（ペーシングに使う、先頭を0としてよい）
+     */
+    virtual bool readFrame(cv::Mat& frame, uint64_t& source_us) = 0;
+
+private:
+    FramePacing pacing_;
+    bool started_;
+    uint64_t first_source_us_;
+    std::chrono::steady_clock::time_point started_at_;
+    uint64_t last_capture_us_;
+    uint64_t last_source_us_;
+    uint64_t frames_;
+};
+
+/**
+ * @class V4L2FrameSource
+ * @brief USBカメラなどのV4L2デバイス（OpenCVのVideoCapture経由）
+ */
+class V4L2FrameSource : public FrameSource {
+public:
+    V4L2FrameSource(const std::string& device, int width, int height);
+
+    bool isOpened() const override { return capture_.isOpened(); }
+    void release() override { capture_.release(); }
+    std::string name() const override { return "v4l2:" + device_; }
+    bool isLive() const override { return true; }
+
+protected:
+    bool readFrame(cv::Mat& frame, uint64_t& source_us) override;
+
+private:
+    std::string device_;
+    cv::VideoCapture capture_;
+};
+
+/**
+ * @class ImageDirFrameSource
+ * @brief ディレクトリ内の画像（jpg / png）を名前順に読む
+ */
+class ImageDirFrameSource : public FrameSource {
+public:
+    /** @param fps RealTimeで流す時のフレームレート */
+    ImageDirFrameSource(const std::string& dir, double fps, bool loop = false);
+
+    bool isOpened() const override { return !files_.empty(); }
+    void release() override { files_.clear(); }
+    std::string name() const override { return "dir:" + dir_; }
+    size_t frameCount() const { return files_.size(); }
+
+protected:
+    bool readFrame(cv::Mat& frame, uint64_t& source_us) override;
+
+private:
+    std::string dir_;
+    std::vector<std::string> files_;
+    double fps_;
+    bool loop_;
+    size_t next_;
+    uint64_t index_;
+};
+
+/**
+ * @class VideoFileFrameSource
+ * @brief 動画ファイル（mp4 / aviなど、OpenCVで読めるもの）
+ */
+class VideoFileFrameSource : public FrameSource {
+public:
+    VideoFileFrameSource(const std::string& path, bool loop = false);
+
+    bool isOpened() const override { return capture_.isOpened(); }
+    void release() override { capture_.release(); }
+    std::string name() const override { return "video:" + path_; }
+
+protected:
+    bool readFrame(cv::Mat& frame, uint64_t& source_us) override;
+
+private:
+    std::string path_;
+    cv::VideoCapture capture_;
+    double fps_;
+    bool loop_;
+    uint64_t index_;
+};
+
+/**
+ * @class SyntheticFrameSource
+ * @brief 動く模様とフレーム番号を描いた合成画像（カメラの無いホストでの計測用）
+ *
+ * 上端の帯にフレーム番号を32個の白黒のマスで埋め込む（frame_band.h）。JPEGを通しても読めるので、
+ * 配信先で読み取った番号から、フレームの抜け・重複を数えられる（latency_tool）。
+ */
+class SyntheticFrameSource : public FrameSource {
+public:
+    SyntheticFrameSource(int width, int height, double fps);
+
+    bool isOpened() const override { return true; }
+    void release() override {}
+    std::string name() const override { return "synthetic"; }
+
+    /** @brief 埋め込むフレーム番号の帯の高さ（ピクセル） */
+    static const int kCounterBandHeight = kFrameBandHeight;
+    /** @brief 画像に描いたフレーム番号を読む（読めない場合false） */
+    static bool decodeFrameCounter(const cv::Mat& frame, uint32_t& counter);
+    static void drawFrameCounter(cv::Mat& frame, uint32_t counter);
+
+protected:
+    bool readFrame(cv::Mat& frame, uint64_t& source_us) override;
+
+private:
+    int width_;
+    int height_;
+    double fps_;
+    uint32_t counter_;
+};
+
+/**
+ * @brief 入力の指定からFrameSourceを作る（libcameraはmain側で作る）
+ *
+ *   v4l2:/dev/video0      V4L2デバイス
+ *   dir:<path>[@fps]      画像のディレクトリ（既定5fps）
+ *   video:<path>          動画ファイル
+ *   synthetic[:fps]       合成画像（既定30fps）
+ *
+ * @return 開けなかった場合nullptr
+ */
+std::unique_ptr<FrameSource> openFrameSource(const std::string& spec, int width, int height, bool loop = false);
+
+#endif // FRAME_SOURCE_H
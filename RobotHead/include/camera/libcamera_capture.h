@@ -1,20 +1,25 @@
 #ifndef LIBCAMERA_CAPTURE_H
 #define LIBCAMERA_CAPTURE_H
 
+#include "camera/frame_source.h"
 #include <libcamera/libcamera.h>
 #include <opencv2/opencv.hpp>
 #include <memory>
 #include <mutex>
 #include <condition_variable>
 
-class LibCameraCapture {
+class LibCameraCapture : public FrameSource {
 public:
     LibCameraCapture(int width = 320, int height = 240);
     ~LibCameraCapture();
     
-    bool isOpened() const { return camera_ != nullptr; }
-    bool read(cv::Mat &frame);
-    void release();
+    bool isOpened() const override { return camera_ != nullptr; }
+    void release() override;
+    std::string name() const override { return "libcamera"; }
+    bool isLive() const override { return true; }
+
+protected:
+    bool readFrame(cv::Mat &frame, uint64_t &source_us) override;
     
 private:
     void requestComplete(libcamera::Request *request);
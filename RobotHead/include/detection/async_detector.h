@@ -0,0 +1,165 @@
+/**
+ * @file async_detector.h
+ * @brief Asynchronous object detection with a dedicated inference worker
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef ASYNC_DETECTOR_H
+#define ASYNC_DETECTOR_H
+
+#include <opencv2/opencv.hpp>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <cstdint>
+#include <chrono>
+#include "detection/object_detector.h"
+
+/** @brief 1回の推論結果（投入時のフレーム番号付き） */
+struct DetectionResult {
+    uint64_t ticket = 0;                 ///< submit()が返したチケット
+    uint64_t frame_seq = 0;              ///< 投入時に指定したフレーム番号
+    std::chrono::steady_clock::time_point frame_time;  ///< submit()した時刻（トラッカーの予測に使用）
+    uint64_t capture_us = 0;             ///< 投入時に指定した撮影時刻（UNIX時刻マイクロ秒、遅延計測用）
+    std::vector<DetectedObject> objects; ///< 検出結果（投入フレーム全体の座標系）
+    cv::Rect roi;                        ///< 推論した領域（空ならフレーム全体）
+    double inference_ms = 0.0;           ///< 推論時間（前処理を除く）
+};
+
+/** @brief チケットの状態 */
+enum class TicketState {
+    Pending,    ///< 推論待ちまたは推論中
+    Done,       ///< 結果あり
+    Dropped,    ///< 新しいフレームに置き換えられた／結果が破棄済み
+};
+
+/** @brief モデル切り替えの状態 */
+struct ModelSwapStatus {
+    enum class State {
+        Idle,       ///< 切り替え要求なし
+        Loading,    ///< 新しいモデルを読み込み・ウォームアップ中
+        Ready,      ///< 読み込み完了、次のsubmit()で切り替え
+        Swapped,    ///< 切り替え済み
+        Failed,     ///< 読み込み失敗（旧モデルで継続）
+    };
+    State state = State::Idle;
+    std::string model_path;     ///< 要求されたモデル
+    std::string error;          ///< 失敗時のメッセージ
+    double load_ms = 0.0;       ///< モデル読み込み時間
+    double warmup_ms = 0.0;     ///< ダミー入力での初回推論時間
+    double swap_gap_ms = -1.0;  ///< 旧モデル最後の推論終了から新モデル最初の推論開始まで（未計測は-1）
+};
+
+const char* swapStateName(ModelSwapStatus::State state);
+
+/**
+ * @class AsyncDetector
+ * @brief ObjectDetectorを専用スレッドで実行する非同期ラッパー
+ *
+ * 入力blobを2面持ち、呼び出し側が片方に前処理を書き込む間にワーカーがもう片方で推論する。
+ * 推論待ちのフレームは常に最新1枚だけ保持し、古い待ちフレームは新しいsubmit()で置き換わる。
+ * ObjectDetector（cv::dnn::Net）の推論にはワーカースレッドだけが触れる。
+ *
+ * loadModelAsync()で別スレッドに新しいモデルを読み込み・ウォームアップさせ、準備ができたら
+ * 次のsubmit()で差し替える。各スロットは前処理に使った検出器を保持するため、切り替え前に
+ * 投入されたフレームは旧モデルで推論され、旧モデルは最後の推論が終わった時点で解放される。
+ */
+class AsyncDetector {
+public:
+    /** @param detector 推論に使う検出器（推論はstop()までワーカー専用になる） */
+    explicit AsyncDetector(std::shared_ptr<ObjectDetector> detector);
+    ~AsyncDetector();
+
+    void start();
+    void stop();
+
+    /**
+     * @brief フレームを推論キューに投入する（呼び出しは1スレッドからのみ）
+     * @param frame 入力画像（前処理は呼び出し側スレッドで行い、関数から戻った後は参照しない）
+     * @param frame_seq 結果と画像を対応付けるためのフレーム番号
+     * @param roi 推論する領域（空ならフレーム全体）。結果はフレーム全体の座標に戻して返す
+     * @param capture_us 撮影時刻（UNIX時刻マイクロ秒）。結果にそのまま入る
+     * @return チケット（0は投入失敗）
+     */
+    uint64_t submit(const cv::Mat& frame, uint64_t frame_seq, const cv::Rect& roi = cv::Rect(),
+                    uint64_t capture_us = 0);
+
+    /**
+     * @brief チケットの結果を確認する
+     * @param ticket submit()が返したチケット
+     * @param result Doneの場合に結果をコピー（nullptr可）
+     */
+    TicketState poll(uint64_t ticket, DetectionResult* result);
+
+    /**
+     * @brief 最新の推論結果を取得する
+     * @return 結果が1件以上ある場合true
+     */
+    bool latest(DetectionResult& result);
+
+    /** @brief 推論中または推論待ちのフレームがあるか */
+    bool isBusy();
+
+    /** @brief 推論待ち（未着手）のフレームがあるか */
+    bool hasPendingFrame();
+    
+    /**
+     * @brief 新しいモデルをバックグラウンドで読み込み、準備ができたら差し替える
+     * @return 読み込みを開始した場合true（読み込み中の要求があればfalse）
+     */
+    bool loadModelAsync(const std::string& model_path, const std::string& labels_path);
+    
+    ModelSwapStatus swapStatus();
+    
+    /** @brief 切り替え時のRSS予算（MB、0なら空きメモリのみ確認）。旧モデルが残った状態で判定する */
+    void setMemoryBudgetMb(size_t budget_mb) { memory_budget_mb_ = budget_mb; }
+    
+    /** @brief 現在submit()に使われる検出器（描画・設定参照用） */
+    std::shared_ptr<ObjectDetector> detector();
+
+private:
+    enum class SlotState { Free, Filling, Pending, Running };
+
+    struct Slot {
+        std::shared_ptr<ObjectDetector> detector;   ///< blobを作った検出器（推論もこれで行う）
+        uint64_t generation = 0;                    ///< その検出器の世代（切り替えごとに増える）
+        cv::Mat blob;
+        cv::Size frame_size;   ///< blob作成元の画像サイズ（roi指定時は切り出しサイズ）
+        cv::Rect roi;
+        uint64_t ticket = 0;
+        uint64_t frame_seq = 0;
+        std::chrono::steady_clock::time_point frame_time;
+        uint64_t capture_us = 0;
+        SlotState state = SlotState::Free;
+    };
+
+    void workerThread();
+    void loaderThread(std::string model_path, std::string labels_path);
+
+    static const size_t kResultHistory = 4;   ///< poll()用に保持する結果数
+
+    std::shared_ptr<ObjectDetector> detector_;
+    std::shared_ptr<ObjectDetector> pending_detector_;  ///< 読み込み済みで差し替え待ちの検出器
+    ModelSwapStatus swap_status_;
+    std::atomic<size_t> memory_budget_mb_;
+    std::chrono::steady_clock::time_point last_inference_end_;
+    uint64_t model_generation_;              ///< detector_の世代（切り替えのたびに1増やす）
+    uint64_t last_inference_generation_;     ///< 直前に推論したモデルの世代（0なら未推論）
+    std::thread loader_;
+    Slot slots_[2];
+    std::deque<DetectionResult> results_;
+    uint64_t next_ticket_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::atomic<bool> running_;
+    std::thread worker_;
+};
+
+#endif // ASYNC_DETECTOR_H
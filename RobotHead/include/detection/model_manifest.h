@@ -0,0 +1,71 @@
+/**
+ * @file model_manifest.h
+ * @brief Per-model manifest (input size, layout, quantization, measured cost) and memory budgeting
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef MODEL_MANIFEST_H
+#define MODEL_MANIFEST_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief モデルと同じディレクトリに置くマニフェスト（<モデル名から拡張子を除いたもの>.yaml）
+ *
+ * 例: yolov8n_320_int8.onnx → yolov8n_320_int8.yaml
+ * @code
+ * %YAML:1.0
+ * ---
+ * input_size: 320
+ * layout: yolov8            # 出力形式: yolov8 ([1, 4+C, N]) / darknet (Regionレイヤー)
+ * num_classes: 80
+ * labels: coco.names        # モデルからの相対パス
+ * quantization: int8_qdq    # fp32 / int8_qdq
+ * latency_ms: 180.0         # detector_benchの実測（0なら未計測）
+ * rss_mb: 42.0              # 読み込みによるRSS増加の実測（0なら未計測）
+ * fallback: yolov8n_320_int8.onnx   # メモリ予算を超える時に代わりに使うモデル
+ * @endcode
+ */
+struct ModelManifest {
+    int input_size = 0;
+    std::string layout;
+    int num_classes = 0;
+    std::string labels;
+    std::string quantization;
+    double latency_ms = 0.0;
+    double rss_mb = 0.0;
+    std::string fallback;
+
+    /** @brief モデルに対応するマニフェストのパス */
+    static std::string pathFor(const std::string& model_path);
+
+    /** @return マニフェストが存在し読み込めた場合true */
+    bool load(const std::string& model_path);
+
+    /** @return 書き込めた場合true */
+    bool save(const std::string& model_path) const;
+};
+
+/** @brief model_pathと同じディレクトリを基準に相対パスを解決 */
+std::string resolveModelRelative(const std::string& model_path, const std::string& relative);
+
+/**
+ * @brief モデル読み込みによるRSS増加の見積もり（MB）
+ *
+ * マニフェストに実測値があればそれを使い、無ければファイルサイズから保守的に見積もる。
+ */
+double estimateModelRssMb(const std::string& model_path, const ModelManifest* manifest);
+
+/**
+ * @brief メモリ予算内で読み込めるモデルを選ぶ
+ *
+ * 現在のRSS + 見積もりが予算を超える、または空きメモリ（MemAvailable）を使い切って
+ * スワップに入る見込みの場合、マニフェストのfallbackをたどって小さいモデルに切り替える。
+ * @param budget_mb RSSの上限（0なら空きメモリのみ確認）
+ * @return 読み込むモデルのパス（どれも収まらなければ空文字列）
+ */
+std::string selectModelWithinBudget(const std::string& model_path, size_t budget_mb);
+
+#endif // MODEL_MANIFEST_H
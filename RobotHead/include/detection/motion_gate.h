@@ -0,0 +1,90 @@
+/**
+ * @file motion_gate.h
+ * @brief Frame-differencing motion gate in front of object detection
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef MOTION_GATE_H
+#define MOTION_GATE_H
+
+#include <opencv2/core.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief 2つのバイト列の差分絶対値の総和（SAD）
+ *
+ * NEON（aarch64）/SSE2（x86_64）で16バイトずつ処理し、端数はスカラーで処理する。
+ */
+uint32_t sumAbsDiffU8(const uint8_t* a, const uint8_t* b, size_t n);
+
+/**
+ * @class MotionGate
+ * @brief 縮小輝度画像の連続フレーム差分で推論の要否を判定する
+ *
+ * 画像を4x4タイルに分け、タイルごとの平均差分の最大値をスコアとする（局所的な動きも拾う）。
+ * 静止時のスコアの平均・分散を指数移動平均で追跡し、しきい値をノイズに合わせて調整する。
+ * 変化を検出したら推論が行われるまでラッチし、一定時間推論が無ければ強制的に更新する。
+ * ロボット自身が動いている間（setEnabled(false)）は常に推論する。
+ */
+class MotionGate {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    MotionGate();
+
+    void setMaxStaleness(std::chrono::milliseconds staleness) { max_staleness_ = staleness; }
+    void setSensitivity(float sigma_k, float min_delta) { sigma_k_ = sigma_k; min_delta_ = min_delta; }
+
+    /** @brief 有効/無効（無効時は毎回推論。自己運動中など） */
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled_; }
+
+    /**
+     * @brief 新しいフレームで差分を更新（毎フレーム呼び出す）
+     * @return 今回のフレームで変化を検出したか
+     */
+    bool update(const cv::Mat& frame);
+
+    /** @brief 推論すべきか（変化ラッチ／期限切れ／無効時にtrue） */
+    bool shouldRun(Clock::time_point now);
+
+    /** @brief 推論を行った（またはゲート判定済み）ことを通知してラッチを解除 */
+    void markInferred(Clock::time_point now);
+
+    float lastScore() const { return last_score_; }
+    float threshold() const;
+    std::string statsSummary() const;
+
+private:
+    static const int kGrid = 4;       ///< タイル分割数（縦横）
+
+    cv::Mat small_;                   ///< 縮小カラー画像（作業用）
+    cv::Mat luma_[2];                 ///< 縮小輝度画像（前回/今回）
+    int current_;
+    bool has_previous_;
+
+    bool enabled_;
+    bool change_latched_;
+    bool has_inferred_;
+    Clock::time_point last_inference_;
+    std::chrono::milliseconds max_staleness_;
+
+    float sigma_k_;                   ///< しきい値 = 平均 + sigma_k * 標準偏差 + min_delta
+    float min_delta_;
+    float noise_mean_;
+    float noise_var_;
+    float last_score_;
+
+    // 統計
+    uint64_t frames_;
+    uint64_t runs_motion_;
+    uint64_t runs_stale_;
+    uint64_t runs_disabled_;
+    uint64_t skipped_;
+};
+
+#endif // MOTION_GATE_H
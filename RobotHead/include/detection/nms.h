@@ -0,0 +1,71 @@
+/**
+ * @file nms.h
+ * @brief Allocation-free non-maximum suppression on SoA candidate arrays
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef NMS_H
+#define NMS_H
+
+#include <opencv2/core.hpp>
+#include <vector>
+#include <cstddef>
+
+/** @brief 抑制の単位 */
+enum class NmsMode {
+    ClassAware,     ///< 同じクラスの候補どうしだけを抑制
+    ClassAgnostic,  ///< クラスに関係なく抑制
+};
+
+/** @brief NMSの設定 */
+struct NmsConfig {
+    float iou_threshold = 0.4f;         ///< このIoUを超えて重なる低スコア候補を削除
+    int top_k = 0;                      ///< スコア上位何件を対象にするか（0なら全件）
+    int max_detections = 100;           ///< 出力の最大件数（0なら無制限）
+    NmsMode mode = NmsMode::ClassAware;
+};
+
+/**
+ * @class NmsBuffer
+ * @brief NMS用の候補バッファ（座標・スコア・クラスを別配列で保持）
+ *
+ * 毎フレームclear()して再利用し、容量が足りる限りメモリ確保を行わない。
+ * run()はスコア順に（top_k指定時は部分ソートで）並べ、採用済みの箱に対するIoUを
+ * NEON/SSE2で4件ずつ判定する。IoUは除算を避けて inter * (1 + th) > th * (area_a + area_b) で比較する。
+ */
+class NmsBuffer {
+public:
+    NmsBuffer();
+
+    void reserve(size_t capacity);
+    void clear();
+
+    /** @brief 候補を追加（左上座標と幅・高さ、画像座標） */
+    void push(float left, float top, float width, float height, float score, int class_id);
+
+    size_t size() const { return score_.size(); }
+
+    /**
+     * @brief NMSを実行
+     * @return 残った候補のインデックス（スコアの降順、次のclear()まで有効）
+     */
+    const std::vector<int>& run(const NmsConfig& config);
+
+    float score(int i) const { return score_[i]; }
+    int classId(int i) const { return class_id_[i]; }
+    cv::Rect box(int i) const;
+
+private:
+    // 候補（push順）
+    std::vector<float> x1_, y1_, x2_, y2_, area_, score_;
+    std::vector<int> class_id_;
+    std::vector<int> order_;
+
+    // 採用済みの箱（SIMD用に4件単位でパディング）
+    std::vector<float> kx1_, ky1_, kx2_, ky2_, karea_;
+    std::vector<int> kclass_;
+    std::vector<int> keep_;
+};
+
+#endif // NMS_H
@@ -5,11 +5,21 @@
 #include <opencv2/dnn.hpp>
 #include <vector>
 #include <string>
+#include "detection/nms.h"
+#include "detection/model_manifest.h"
 
 using namespace cv;
 using namespace cv::dnn;
 using namespace std;
 
+// 1回の検出の段階別処理時間（ミリ秒）
+struct DetectionTiming {
+    double preprocess_ms = 0.0;   // blobFromImage（detect()経由の場合のみ）
+    double forward_ms = 0.0;      // Net::forward
+    double decode_ms = 0.0;       // 出力テンソルの解析（候補抽出）
+    double nms_ms = 0.0;          // 重複検出の削除
+};
+
 struct DetectedObject {
     int class_id;
     string class_name;
@@ -23,18 +33,77 @@ public:
     ~ObjectDetector();
     
     vector<DetectedObject> detect(const Mat& frame);
+    
+    // 前処理のみ（Netに触れないため推論スレッド以外から呼び出し可能）
+    // input_size: 0なら既定サイズ。可変入力モデル（Darknet）のみ変更可能
+    void preprocess(const Mat& frame, Mat& blob, int input_size = 0) const;
+    // 画像の一部（region）を推論する時の入力サイズ（画素密度を保って縮小、固定入力モデルは既定サイズ）
+    int inputSizeFor(const Size& region, const Size& frame) const;
+    // 前処理済みblobで推論（frame_sizeはblob作成元の画像サイズ）
+    vector<DetectedObject> detectBlob(const Mat& blob, Size frame_size);
     void drawDetections(Mat& frame, const vector<DetectedObject>& detections);
     
+    bool isQuantized() const { return is_quantized_; }
+    bool isYOLOv8() const { return is_yolov8_; }
+    size_t numClasses() const { return class_names_.size(); }
+    bool supportsVariableInput() const { return !is_yolov8_; }  // Darknetは出力が正規化座標のため入力サイズ可変
+    int inputSize() const { return input_size_; }
+    float confidenceThreshold() const { return confidence_threshold_; }
+    bool hasManifest() const { return has_manifest_; }
+    const ModelManifest& manifest() const { return manifest_; }
+    // 直前のdetect()/detectBlob()の段階別処理時間
+    const DetectionTiming& lastTiming() const { return timing_; }
+    
+    // 重複検出の削除（NMS）の設定（IoU閾値、top-k、クラス別/クラス無関係）
+    void setNmsConfig(const NmsConfig& config) { nms_config_ = config; }
+    const NmsConfig& nmsConfig() const { return nms_config_; }
+    
 private:
     Net net_;
     vector<string> class_names_;
     float confidence_threshold_;
     bool is_yolov8_;           // YOLOv8モデルかどうか
+    bool is_quantized_;        // INT8量子化モデル（QDQ/QOperator ONNX）かどうか
     int input_size_;           // 入力画像サイズ（320, 416, 640など）
+    bool has_manifest_;        // モデルのマニフェストがあったか
+    ModelManifest manifest_;
+    vector<String> output_names_;   // 出力レイヤー名（毎フレームの問い合わせを避けるためキャッシュ）
+    Mat blob_;                      // detect()用の入力blob（毎フレーム再利用）
+    
+    // INT8出力テンソルの逆量子化パラメータ（出力ごと）
+    vector<float> output_scales_;
+    vector<int> output_zero_points_;
+    
+    // YOLOv8デコード用の作業バッファ（アンカーごとの最大クラススコア）
+    vector<float> best_scores_f32_;
+    vector<int8_t> best_scores_s8_;
+    vector<int> best_classes_;
+    
+    // NMS用の候補バッファ（毎フレーム再利用）
+    NmsBuffer nms_;
+    NmsConfig nms_config_;
+    DetectionTiming timing_;
     
     void loadLabels(const string& labels_path);
+    void detectQuantization();
     vector<DetectedObject> parseYOLOv3v4Output(const vector<Mat>& outputs, int frame_width, int frame_height);
     vector<DetectedObject> parseYOLOv8Output(const vector<Mat>& outputs, int frame_width, int frame_height);
+    vector<DetectedObject> suppressCandidates();
 };
 
+// Darknet（YOLOv3/v4）出力テンソル1つから閾値を超えた候補をnmsに追加する
+// objectnessで先に棄却し、残った行だけクラススコアの最大値を求める（ベンチマークからも使用）
+void collectDarknetCandidates(const Mat& output, float conf_threshold, int frame_width, int frame_height,
+                              NmsBuffer& nms);
+
+// YOLOv8（FP32）出力テンソル（[1, C, N] または [N, C]）から閾値を超えた候補をnmsに追加する（ベンチマークからも使用）
+// scale_x / scale_y は入力サイズからフレームへの倍率、best_scores / best_classes は呼び出し側で再利用する作業バッファ
+void collectYOLOv8Candidates(const Mat& output, float conf_threshold, float scale_x, float scale_y,
+                             vector<float>& best_scores, vector<int>& best_classes, NmsBuffer& nms);
+
+// INT8（CV_8S）出力テンソル版。out_scale / out_zero_pointで逆量子化し、閾値判定は量子化ドメインで行う
+void collectYOLOv8Candidates(const Mat& output, float out_scale, int out_zero_point, float conf_threshold,
+                             float scale_x, float scale_y,
+                             vector<int8_t>& best_scores, vector<int>& best_classes, NmsBuffer& nms);
+
 #endif // OBJECT_DETECTOR_H
@@ -0,0 +1,138 @@
+/**
+ * @file object_tracker.h
+ * @brief Multi-object tracker (Kalman + greedy IoU association) with stable track ids
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef OBJECT_TRACKER_H
+#define OBJECT_TRACKER_H
+
+#include <opencv2/core.hpp>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "detection/object_detector.h"
+
+/** @brief トラッカーの設定 */
+struct TrackerConfig {
+    float high_threshold = 0.6f;     ///< この信頼度以上の検出で新規トラックを作る（1段目の対応付け）
+    float low_threshold = 0.3f;      ///< 2段目で使う検出の下限（検出器の信頼度閾値はこれに合わせる）
+    float match_iou = 0.3f;          ///< 1段目（高信頼度検出）の対応付けに必要なIoU
+    float low_match_iou = 0.5f;      ///< 2段目（低信頼度検出）の対応付けに必要なIoU
+    int min_hits = 2;                ///< この回数対応付けられたら確定トラック
+    int max_misses = 3;              ///< 連続でこの回数を超えて見失ったら削除
+    float position_noise_px = 8.0f;  ///< 検出位置の観測ノイズ（標準偏差）
+    float accel_noise = 300.0f;      ///< 中心位置の加速度ノイズ（px/s^2）
+    float size_accel_noise = 100.0f; ///< 幅・高さの変化の加速度ノイズ（px/s^2）
+};
+
+/** @brief 1つの追跡対象 */
+struct Track {
+    int id = 0;                      ///< 起動中に重複しないトラックID
+    int class_id = -1;
+    std::string class_name;
+    float confidence = 0.0f;         ///< 最後に対応付けた検出の信頼度
+    cv::Rect bbox;                   ///< フィルタ後の矩形（画像座標）
+    cv::Point2f velocity;            ///< 中心の速度（px/s）
+    int hits = 0;                    ///< 対応付けられた回数
+    int misses = 0;                  ///< 連続で見失った回数
+    bool confirmed = false;          ///< min_hits回以上対応付けられたか
+    std::chrono::steady_clock::time_point first_seen;
+    std::chrono::steady_clock::time_point last_seen;
+    int distance_mm = -1;            ///< 矩形内の最近傍ToF距離（不明なら-1）
+    float distance_rate_mm_s = 0.0f; ///< 距離の変化率（負なら接近中）
+    bool greeted = false;            ///< 挨拶済み（振る舞い側が設定）
+
+    double ageSeconds(std::chrono::steady_clock::time_point now) const {
+        return std::chrono::duration<double>(now - first_seen).count();
+    }
+    bool isApproaching(float min_rate_mm_s = 150.0f) const {
+        return distance_mm >= 0 && distance_rate_mm_s < -min_rate_mm_s;
+    }
+
+    // カルマンフィルタの状態（cx, cy, w, h ごとに [位置, 速度] と 2x2 共分散）
+    float state[4][2];
+    float cov[4][3];                 ///< P00, P01, P11
+    std::chrono::steady_clock::time_point state_time;     ///< 状態を予測した時刻
+    std::chrono::steady_clock::time_point distance_time;  ///< 距離を更新した時刻
+};
+
+/**
+ * @class ObjectTracker
+ * @brief SORT/ByteTrack型の多物体トラッカー
+ *
+ * 中心・幅・高さを独立した等速カルマンフィルタで予測し、同じクラスの検出とIoUの大きい順に
+ * 貪欲に対応付ける。高信頼度の検出を先に対応付け、残ったトラックを低信頼度の検出で補う。
+ * 推論結果が届いた時だけupdate()を呼ぶ（推論間隔が不定のため時刻で予測する）。
+ * 2段目が働くように、検出器はlow_thresholdまでの候補を出すこと（表示はconfidentDetections()で絞る）。
+ * 作業バッファは再利用し、数十トラックでも1回のupdate()はマイクロ秒オーダーで終わる。
+ */
+class ObjectTracker {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    explicit ObjectTracker(const TrackerConfig& config = TrackerConfig());
+
+    /**
+     * @brief 新しい検出結果でトラックを更新
+     * @param detections 検出結果（画像座標）
+     * @param frame_time 検出したフレームの時刻
+     * @param observed 推論した領域（空ならフレーム全体）。領域外のトラックは見失い扱いにしない
+     */
+    const std::vector<Track>& update(const std::vector<DetectedObject>& detections,
+                                     Clock::time_point frame_time,
+                                     const cv::Rect& observed = cv::Rect());
+
+    /**
+     * @brief 各トラックのToF距離を更新
+     * @param distance_of 矩形内の最近傍距離を返す関数（不明なら-1）
+     */
+    void assignDistances(const std::function<int(const cv::Rect&)>& distance_of, Clock::time_point now);
+
+    /** @brief high_threshold以上の検出だけを残す（表示・件数用。低信頼度の検出はトラックの継続にだけ使う） */
+    std::vector<DetectedObject> confidentDetections(const std::vector<DetectedObject>& detections) const;
+
+    const TrackerConfig& config() const { return config_; }
+
+    std::vector<Track>& tracks() { return tracks_; }
+    const std::vector<Track>& tracks() const { return tracks_; }
+
+    /** @brief 確定トラックのIDと距離を描画 */
+    void drawTracks(cv::Mat& frame) const;
+
+    void reset();
+    std::string statsSummary() const;
+
+private:
+    void predict(Track& track, float dt) const;
+    void correct(Track& track, const cv::Rect& box) const;
+    void initTrack(Track& track, const DetectedObject& det, Clock::time_point t);
+    void associate(const std::vector<DetectedObject>& detections, bool high_stage, float min_iou,
+                   Clock::time_point frame_time);
+
+    struct Pair {
+        float iou;
+        int track;
+        int detection;
+    };
+
+    TrackerConfig config_;
+    std::vector<Track> tracks_;
+    int next_id_;
+
+    // 作業バッファ（毎回再利用）
+    std::vector<cv::Rect> predicted_;
+    std::vector<char> track_matched_;
+    std::vector<char> det_matched_;
+    std::vector<Pair> pairs_;
+
+    // 統計
+    uint64_t updates_;
+    double update_us_total_;
+    double update_us_max_;
+    uint64_t tracks_created_;
+};
+
+#endif // OBJECT_TRACKER_H
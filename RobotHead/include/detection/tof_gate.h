@@ -0,0 +1,92 @@
+/**
+ * @file tof_gate.h
+ * @brief ToF (VL53L8CX) occupancy based gating of object detection
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef TOF_GATE_H
+#define TOF_GATE_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+#include <string>
+
+/** @brief ゲート判定結果 */
+struct GateDecision {
+    bool run = true;          ///< 推論を実行するか
+    bool cropped = false;     ///< roiに切り出して推論するか
+    cv::Rect roi;             ///< 推論領域（cropped時のみ有効、画像座標）
+    int near_zones = 0;       ///< 近距離と判定されたゾーン数
+};
+
+/**
+ * @class ToFGate
+ * @brief 8x8ゾーンの距離から推論のスキップ／切り出しを決める
+ *
+ * depth_calibration.yamlのオーバーレイ位置（回転後画像上の矩形）でゾーンを画像座標に対応付ける。
+ * 近距離ゾーンがなければ推論をスキップし、あればその周辺だけを切り出して推論する。
+ * スキップ率と推論時間の実測から節約できたCPU時間を集計する。
+ */
+class ToFGate {
+public:
+    ToFGate();
+
+    /**
+     * @brief ゾーン→画像座標の対応を設定
+     * @param overlay Depthオーバーレイ矩形（offset_x, offset_y, overlay_width, overlay_height）
+     * @param image_size 推論対象画像サイズ（回転後）
+     * @param calibrated キャリブレーション済みか（未済なら切り出しは行わずスキップ判定のみ）
+     */
+    void configure(const cv::Rect& overlay, const cv::Size& image_size, bool calibrated);
+
+    void setNearRange(int range_mm) { near_range_mm_ = range_mm; }
+    void setCropMargin(int margin_px) { crop_margin_px_ = margin_px; }
+    int nearRange() const { return near_range_mm_; }
+
+    /**
+     * @brief 最新の距離データから判定
+     * @param distance_mm ゾーンごとの距離（resolution個）
+     * @param target_status ゾーンごとのターゲットステータス
+     * @param resolution ゾーン数（16 or 64）
+     */
+    GateDecision evaluate(const int16_t* distance_mm, const uint8_t* target_status, int resolution);
+
+    /**
+     * @brief 画像上の領域に重なるゾーンの最近傍距離（トラックへの距離の対応付け用）
+     * @return 有効な距離が無い、または未キャリブレーションなら-1
+     */
+    int nearestDistance(const cv::Rect& region, const int16_t* distance_mm, const uint8_t* target_status,
+                        int resolution) const;
+
+    /** @brief 距離データが無い時の判定（常に全体推論） */
+    GateDecision evaluateWithoutDepth();
+
+    /** @brief 実行した推論の時間を記録（節約量の推定に使用） */
+    void recordInference(double inference_ms, bool cropped);
+
+    double skippedFraction() const;
+    double croppedFraction() const;
+    double cpuSavedMs() const;
+    std::string statsSummary() const;
+
+private:
+    cv::Rect zoneRect(int zone, int grid) const;
+
+    cv::Rect overlay_;
+    cv::Size image_size_;
+    bool calibrated_;
+    int near_range_mm_;
+    int crop_margin_px_;
+    int min_crop_px_;
+
+    // 統計
+    uint64_t decisions_;
+    uint64_t skipped_;
+    uint64_t cropped_;
+    uint64_t full_runs_;
+    double full_ms_avg_;         ///< 全体推論時間の移動平均
+    double crop_saved_ms_;       ///< 切り出し推論で節約した時間の累計
+};
+
+#endif // TOF_GATE_H
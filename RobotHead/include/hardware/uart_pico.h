@@ -22,11 +22,21 @@ public:
     
     bool sendCommand(const std::string& cmd);
     void update();  // 定期呼び出し用（受信処理）
+    // 受信したバイト列を行に分けて処理する（update()から呼ばれる。ベンチマークでは直接流し込む）
+    void feed(const char* data, size_t length);
     
     // コールバック設定
     void setIMUCallback(std::function<void(float ax, float ay, float az, float gx, float gy, float gz)> callback);
     void setAlertCallback(std::function<void(const std::string& reason)> callback);
     void setInfoCallback(std::function<void(const std::string& info)> callback);
+    void setMotorCallback(std::function<void(int rotation, int drive)> callback);
+    // 送受信した全ての行（改行なし、outgoing=trueは送信したコマンド）: ブラックボックスの記録用
+    void setLineCallback(std::function<void(bool outgoing, const std::string& line)> callback);
+    
+    // Picoが報告した現在のモーター速度（MOTOR,rot,drive）
+    int motorRotation() const { return motor_rotation_; }
+    int motorDrive() const { return motor_drive_; }
+    bool isBodyMoving() const { return motor_rotation_ != 0 || motor_drive_ != 0; }
     
     // コマンド送信ヘルパー
     bool setRotation(int8_t speed);  // -100 ~ 100
@@ -40,10 +50,14 @@ private:
     
     int fd_;
     std::string read_buffer_;
+    int motor_rotation_;
+    int motor_drive_;
     
     std::function<void(float, float, float, float, float, float)> imu_callback_;
     std::function<void(const std::string&)> alert_callback_;
     std::function<void(const std::string&)> info_callback_;
+    std::function<void(int, int)> motor_callback_;
+    std::function<void(bool, const std::string&)> line_callback_;
 };
 
 #endif // UART_PICO_H
@@ -0,0 +1,290 @@
+/**
+ * @file http_server.h
+ * @brief Single-threaded epoll HTTP router with keep-alive, non-blocking sockets and per-client write queues
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef HTTP_SERVER_H
+#define HTTP_SERVER_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief 受信したリクエスト（リクエスト行とヘッダーのみ、ボディは扱わない）
+ */
+struct HttpRequest {
+    std::string method;
+    std::string version;                         // "HTTP/1.1"など
+    std::string target;                          // パス + クエリ（例: /model/load?path=a.onnx）
+    std::string path;                            // クエリを除いたパス
+    std::string query;                           // '?'より後ろ
+    std::map<std::string, std::string> headers;  // ヘッダー名は小文字
+
+    /** @brief クエリパラメータ（URLデコード済み、無ければ空文字列） */
+    std::string param(const std::string& key) const;
+    /** @brief ヘッダー値（nameは小文字、無ければ空文字列） */
+    std::string header(const std::string& name) const;
+};
+
+/** @brief URLのパーセントエンコーディングを戻す */
+std::string urlDecode(const std::string& s);
+
+/**
+ * @brief 送信キューに積むデータ片
+ *
+ * ownerがデータの寿命を管理するため、同じバッファ（エンコード済みJPEGなど）を
+ * 複数の接続のキューにコピーせずに積める。
+ */
+struct HttpChunk {
+    std::shared_ptr<const void> owner;
+    const char* data;
+    size_t size;
+
+    HttpChunk(std::shared_ptr<const void> owner_, const void* data_, size_t size_)
+        : owner(std::move(owner_)), data(static_cast<const char*>(data_)), size(size_) {}
+
+    /** @brief 文字列をコピーしてチャンクにする（ヘッダーなど小さいデータ用） */
+    static HttpChunk copyOf(std::string s);
+};
+
+/**
+ * @brief ルートごとのリクエスト処理時間（リクエストを受け取ってからレスポンスを送り終えるまで）
+ */
+struct RouteLatencyStats {
+    std::string route;
+    uint64_t requests;
+    uint64_t reused;             // keep-aliveで再利用された接続でのリクエスト
+    uint64_t not_modified;       // ETagが一致して304を返した
+    double mean_ms;
+    double max_ms;
+};
+
+/**
+ * @brief ストリーム購読者ごとの送信状況
+ */
+struct StreamClientStats {
+    uint64_t id;
+    std::string peer;            // 接続元アドレス
+    double fps;                  // 送り終えたフレームのレート（指数移動平均）
+    uint64_t frames_sent;
+    uint64_t frames_dropped;     // 未送信のまま新しいフレームに置き換えられた数
+    size_t queued_bytes;         // サーバー側の送信キュー
+    int kernel_outq_bytes;       // カーネルの送信キューに残っているバイト数（SIOCOUTQ）
+    int rtt_us;                  // TCP_INFOの平滑化RTT
+};
+
+/**
+ * @class HttpServer
+ * @brief epollによる1スレッドのHTTPサーバー
+ *
+ * 全ソケットを非ブロッキングにして1つのイベントループで扱うため、
+ * 配信中のクライアントがいても他のリクエストが待たされず、stop()で確実に止まる。
+ * ハンドラはイベントループのスレッドで呼ばれるため、時間のかかる処理をしてはいけない。
+ *
+ * - 通常のレスポンス: sendResponse()で送信する。HTTP/1.1（keep-alive）のクライアントには接続を残し、
+ *   同じ接続で次のリクエストを受け付ける（ポーリングのたびに接続し直さない）
+ * - 静的なページ: addStaticRoute()で登録し、ETagが一致すれば304を返す
+ * - ストリーム（MJPEGなど）: beginStream()で登録し、broadcast()で全購読者のキューに積む
+ *
+ * ストリームは接続ごとに「送信中の1フレーム + 未送信の1フレーム」までしか持たず、
+ * 遅いクライアントでは新しいフレームが未送信のフレームを置き換える（古いフレームを捨てる）。
+ * カーネルの送信キュー（SIOCOUTQ）に前のフレームが残っている間も次のフレームは送り始めないため、
+ * 遅いクライアントの遅延は約1フレームに抑えられ、速いクライアントは影響を受けない。
+ *
+ * sendResponse() / beginStream() / broadcast() はどのスレッドからでも呼べる。
+ */
+class HttpServer {
+public:
+    using ConnectionId = uint64_t;
+    using Handler = std::function<void(ConnectionId, const HttpRequest&)>;
+
+    HttpServer();
+    ~HttpServer();
+
+    HttpServer(const HttpServer&) = delete;
+    HttpServer& operator=(const HttpServer&) = delete;
+
+    /**
+     * @param max_connections 同時接続数の上限（超えた接続には503を返して切断）
+     * @return 待ち受けを開始できた場合true
+     */
+    bool init(int port, size_t max_connections = 16);
+    void start();
+    /** @brief イベントループを止め、全接続を閉じる */
+    void stop();
+    bool isRunning() const { return running_; }
+    int port() const { return port_; }
+
+    /**
+     * @brief 大きな送信でMSG_ZEROCOPYを使う（start()より前に設定）
+     *
+     * 送信バッファをカーネルにコピーせずにピン留めして送り、完了通知（エラーキュー）が届くまで
+     * チャンクのownerを保持する。小さい送信は通知処理の方が高くつくためmin_bytes未満はコピーで送る。
+     */
+    void setZeroCopy(bool enable, size_t min_bytes = 16384);
+
+    /** @brief パスの前方一致でハンドラを登録（最も長く一致したものを使う。"/"は既定ハンドラ） */
+    void addRoute(const std::string& prefix, Handler handler);
+
+    /**
+     * @brief 変更されないページ（HTMLなど）を登録する
+     *
+     * ETagをあらかじめ計算しておき、If-None-Matchが一致すれば本文を送らずに304を返す。
+     * 本文はコピーせずに全リクエストで共有する。
+     */
+    void addStaticRoute(const std::string& path, const std::string& content_type, std::string body);
+
+    /** @brief レスポンスを送信する（keep-aliveでなければ送り終えたら切断する） */
+    void sendResponse(ConnectionId id, const std::string& status, const std::string& content_type,
+                      const std::string& body);
+
+    /**
+     * @brief 接続をストリームの購読者にする（headerを送信し、以降broadcast()のデータを送る）
+     * @param on_close 切断時に呼ばれる（イベントループのスレッド、stop()時も呼ばれる）
+     * @param on_input ストリーム中にクライアントから届いたデータを受け取る（イベントループのスレッド、
+     *                 falseを返すと切断する）。nullptrなら読み捨てる
+     * @return 接続が既に無い場合false
+     */
+    bool beginStream(ConnectionId id, const std::string& stream, const std::string& header,
+                     std::function<void()> on_close = nullptr,
+                     std::function<bool(const char*, size_t)> on_input = nullptr);
+
+    /**
+     * @brief ストリームの全購読者に1フレーム分のデータを渡す
+     *
+     * 送信キューが空いていれば積み、前のフレームを送信中なら未送信フレームとして保持する
+     * （既に未送信フレームがあれば置き換えて捨てる）。呼び出し側は待たされない。
+     * @return 渡した接続数
+     */
+    size_t broadcast(const std::string& stream, const std::vector<HttpChunk>& chunks);
+
+    /** @brief 送信キューを捨てて切断する */
+    void closeConnection(ConnectionId id);
+
+    size_t connectionCount();
+    size_t streamClientCount(const std::string& stream);
+    std::vector<StreamClientStats> streamClientStats(const std::string& stream);
+    std::vector<RouteLatencyStats> routeLatencyStats();
+    /** @brief ルートごとの処理時間（1ルート1行） */
+    std::string routeStatsSummary();
+    std::string statsSummary() const;
+
+private:
+    struct QueuedChunk {
+        HttpChunk chunk;
+        bool frame_end;                      // broadcast()で積んだフレームの最後のチャンク
+    };
+
+    struct RouteStats {
+        uint64_t requests = 0;
+        uint64_t reused = 0;
+        uint64_t not_modified = 0;
+        double total_ms = 0.0;
+        double max_ms = 0.0;
+    };
+
+    struct ZeroCopySend {
+        uint32_t seq;                                       // MSG_ZEROCOPY送信の通し番号（カーネルと同じ数え方）
+        std::vector<std::shared_ptr<const void>> owners;    // 完了まで保持するバッファ
+    };
+
+    struct Connection {
+        ConnectionId id;
+        int fd;
+        std::string peer;
+        std::string read_buffer;
+        std::deque<QueuedChunk> write_queue;
+        size_t write_offset;                 // write_queue先頭チャンクの送信済みバイト数
+        size_t queued_bytes;
+        bool request_done;                   // リクエストを受け取ってハンドラに渡した
+        bool close_after_flush;              // 送信キューが空になったら切断
+        bool keep_alive;                     // 処理中のリクエストがkeep-aliveを求めている
+        bool reset_after_flush;              // 送信キューが空になったら次のリクエストを待つ（keep-alive）
+        bool want_write;                     // EPOLLOUTを監視中
+        bool read_closed;                    // 相手が送信側を閉じた（half-close）: 応答を送り終えたら切断
+        bool want_read;                      // EPOLLINを監視中（half-close後は外す）
+        std::string stream;                  // 購読中のストリーム（空なら通常のレスポンス）
+        std::function<void()> on_close;
+        std::function<bool(const char*, size_t)> on_input;
+        std::chrono::steady_clock::time_point idle_since;      // 接続した時刻、または前のレスポンスを送り終えた時刻
+        std::chrono::steady_clock::time_point request_received;
+        std::string route;                   // 処理中のリクエストに対応したルート（処理時間の集計用）
+        uint64_t requests;                   // この接続で処理したリクエスト数
+        bool not_modified;                   // 処理中のリクエストに304を返した
+
+        // ストリームのバックプレッシャー
+        std::vector<HttpChunk> pending_frame;   // 未送信の最新フレーム（送信キューが空くまで待つ）
+        uint64_t frames_sent;
+        uint64_t frames_dropped;
+        double fps;
+        std::chrono::steady_clock::time_point last_frame_sent;
+
+        // MSG_ZEROCOPY
+        bool zerocopy;
+        uint32_t zc_next_seq;
+        std::deque<ZeroCopySend> zc_inflight;
+    };
+
+    void eventLoop();
+    void acceptClients();
+    void handleReadable(ConnectionId id);
+    void dispatchBuffered(ConnectionId id);
+    void finishRequestLocked(Connection& conn);
+    void queueResponseLocked(Connection& conn, const std::string& status, const std::string& headers,
+                             const HttpChunk& body);
+    void flushConnection(Connection& conn);
+    void drainErrorQueue(Connection& conn);
+    void dispatch(ConnectionId id, const HttpRequest& request);
+    void enqueueLocked(Connection& conn, const HttpChunk& chunk, bool frame_end = false);
+    bool promotePendingLocked(Connection& conn);
+    void updateInterestLocked(Connection& conn);
+    void closeLocked(ConnectionId id, std::vector<std::function<void()>>& callbacks);
+    void closeExpired();
+    void promoteAllPending();
+    void wake();
+    static bool parseRequest(const std::string& raw, HttpRequest& request);
+
+    int port_;
+    size_t max_connections_;
+    int listen_fd_;
+    int epoll_fd_;
+    int wake_fd_;                            // stop()でループを起こすeventfd
+    std::atomic<bool> running_;
+    std::thread loop_thread_;
+
+    std::vector<std::pair<std::string, Handler>> routes_;
+    std::map<std::string, RouteStats> route_stats_;   // mutex_で保護
+
+    std::mutex mutex_;                       // connections_と各Connectionを保護
+    std::map<ConnectionId, Connection> connections_;
+    ConnectionId next_id_;
+
+    // 統計
+    std::atomic<uint64_t> accepted_;
+    std::atomic<uint64_t> rejected_;         // 接続数上限で断った
+    std::atomic<uint64_t> timed_out_;        // リクエストが届かず切断
+    std::atomic<uint64_t> keep_alive_reuses_; // 同じ接続で2つ目以降のリクエスト
+    std::atomic<uint64_t> bytes_sent_;
+    std::atomic<uint64_t> frames_dropped_;   // 遅いクライアントで捨てたフレーム（全接続の合計）
+    std::atomic<uint64_t> frames_sent_;
+    std::atomic<uint64_t> send_calls_;       // sendmsgの呼び出し回数
+
+    bool zerocopy_enabled_;
+    size_t zerocopy_min_bytes_;
+    std::atomic<uint64_t> zerocopy_sends_;
+    std::atomic<uint64_t> zerocopy_copied_;
+};
+
+#endif // HTTP_SERVER_H
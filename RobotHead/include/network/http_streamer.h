@@ -2,12 +2,10 @@
 #define HTTP_STREAMER_H
 
 #include <string>
-#include <thread>
 #include <atomic>
-#include <mutex>
 #include <opencv2/opencv.hpp>
-#include <sys/socket.h>
-#include <netinet/in.h>
+#include "network/http_server.h"
+#include "network/mjpeg_broadcaster.h"
 
 class HTTPStreamer {
 public:
@@ -21,16 +19,16 @@ public:
     bool isRunning() const { return running_; }
     
 private:
-    void serverThread();
-    void handleClient(int client_socket);
+    void handleClient(HttpServer::ConnectionId id, const HttpRequest& request);
+    void broadcastFrame(const JpegFramePtr& jpeg);
     
     int port_;
-    int server_socket_;
     std::atomic<bool> running_;
-    std::thread server_thread_;
     
-    cv::Mat current_frame_;
-    std::mutex frame_mutex_;
+    // 接続はイベントループ1スレッドで処理（クライアントごとのスレッドは作らない）
+    HttpServer server_;
+    // 1フレームを1回だけエンコードし全クライアントで共有
+    MjpegBroadcaster broadcaster_;
 };
 
 #endif // HTTP_STREAMER_H
@@ -0,0 +1,78 @@
+/**
+ * @file jpeg_encoder.h
+ * @brief Reusable JPEG encoder (libjpeg-turbo TurboJPEG API, cv::imencode fallback)
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef JPEG_ENCODER_H
+#define JPEG_ENCODER_H
+
+#include <opencv2/core.hpp>
+#include <string>
+#include <vector>
+
+/** @brief 色差のサブサンプリング */
+enum class JpegSubsampling {
+    S444,   // 間引きなし（文字やヒートマップの境界がにじまない）
+    S422,   // 水平のみ1/2
+    S420,   // 水平・垂直とも1/2（imencodeの既定、最も小さく速い）
+};
+
+/** @brief "444" / "422" / "420" を解釈する（不明な場合false） */
+bool parseJpegSubsampling(const std::string& text, JpegSubsampling& out);
+const char* jpegSubsamplingName(JpegSubsampling subsampling);
+
+/**
+ * @class JpegEncoder
+ * @brief 圧縮器の状態と出力バッファを使い回すJPEGエンコーダー
+ *
+ * ENABLE_TURBOJPEGでビルドした場合はTurboJPEGのハンドルを1つ保持し、
+ * tjBufSize()で確保した出力バッファに直接圧縮する（フレームごとの確保・パラメータ解釈が無い）。
+ * 無効な場合はcv::imencodeで同じ結果を返す。
+ *
+ * スレッドセーフではない（エンコードスレッドごとに1つ持つ）。
+ */
+class JpegEncoder {
+public:
+    explicit JpegEncoder(int quality = 95, JpegSubsampling subsampling = JpegSubsampling::S420);
+    ~JpegEncoder();
+
+    JpegEncoder(const JpegEncoder&) = delete;
+    JpegEncoder& operator=(const JpegEncoder&) = delete;
+
+    void setQuality(int quality);
+    void setSubsampling(JpegSubsampling subsampling) { subsampling_ = subsampling; }
+    int quality() const { return quality_; }
+    JpegSubsampling subsampling() const { return subsampling_; }
+
+    /**
+     * @brief BGR画像（CV_8UC3）またはグレースケール画像（CV_8UC1）をエンコードしてoutに書き込む
+     * @return 成功した場合true
+     */
+    bool encode(const cv::Mat& image, std::vector<unsigned char>& out);
+
+    /**
+     * @brief I420（YUV 4:2:0 planar、OpenCVと同じくheight*3/2行 x width列のCV_8UC1）をエンコードする
+     *
+     * TurboJPEGでは色変換をせずにそのまま圧縮する（色差は入力のとおり4:2:0になる）。
+     * @param width, height 画像サイズ（偶数）
+     */
+    bool encodeI420(const cv::Mat& yuv, int width, int height, std::vector<unsigned char>& out);
+
+    /** @brief TurboJPEGを使っている場合true */
+    static bool usesTurboJpeg();
+
+private:
+    bool ensureBuffer(int width, int height, int tj_subsampling);
+
+    int quality_;
+    JpegSubsampling subsampling_;
+
+    void* handle_;                   // tjhandle（TurboJPEGが無い場合nullptr）
+    unsigned char* buffer_;          // tjAlloc()した出力バッファ
+    unsigned long buffer_size_;
+    std::vector<int> imencode_params_;
+};
+
+#endif // JPEG_ENCODER_H
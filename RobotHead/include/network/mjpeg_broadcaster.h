@@ -0,0 +1,138 @@
+/**
+ * @file mjpeg_broadcaster.h
+ * @brief Encode-once MJPEG frame broadcaster shared by all HTTP clients
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef MJPEG_BROADCASTER_H
+#define MJPEG_BROADCASTER_H
+
+#include "network/jpeg_encoder.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief エンコード済みJPEG（作成後は変更しない）
+ *
+ * shared_ptrで全クライアントが同じバッファを参照し、最後の参照が外れた時に解放される。
+ */
+struct JpegFrame {
+    std::vector<unsigned char> data;
+    uint64_t seq;                                       // 1から始まる通し番号
+    std::chrono::steady_clock::time_point submit_time;  // submit()された時刻
+    uint64_t capture_us;                                // 撮影時刻（UNIX時刻マイクロ秒、不明なら0）
+    uint64_t encoded_us;                                // エンコードが終わった時刻（UNIX時刻マイクロ秒）
+    // multipartのパートヘッダー（"--frame" + Content-Type + Content-Length、エンコード時に1回だけ作る）
+    // capture_usがあればX-Timestamp（撮影時刻）とX-Encoded-Timestamp（秒.マイクロ秒）も付ける
+    char part_header[192];
+    size_t part_header_size;
+    std::string metadata;                               // submit()で一緒に渡された付随データ（オーバーレイ用JSONなど）
+};
+
+/** @brief MJPEGのmultipart境界（Content-Typeのboundary=に指定する） */
+#define MJPEG_BOUNDARY "frame"
+/** @brief パートの終わり（JPEGの後ろのCRLF） */
+extern const char kMjpegPartTrailer[];
+extern const size_t kMjpegPartTrailerSize;
+
+using JpegFramePtr = std::shared_ptr<const JpegFrame>;
+
+/**
+ * @class MjpegBroadcaster
+ * @brief 1フレームを1回だけJPEGエンコードし、接続中の全クライアントに配る
+ *
+ * submit()はフレームをコピーしてすぐ戻り、専用のエンコードスレッドが最新フレームだけを
+ * エンコードする（エンコード中に来たフレームは上書きされ捨てられる）。
+ * クライアントはwaitForFrame()で新しいJPEGを待ち、同じバッファをそのまま送信する。
+ * 視聴者が0人の間はエンコードしない。
+ */
+class MjpegBroadcaster {
+public:
+    explicit MjpegBroadcaster(int jpeg_quality = 95, JpegSubsampling subsampling = JpegSubsampling::S420);
+    ~MjpegBroadcaster();
+
+    MjpegBroadcaster(const MjpegBroadcaster&) = delete;
+    MjpegBroadcaster& operator=(const MjpegBroadcaster&) = delete;
+
+    /** @brief JPEGの品質と色差サブサンプリングを設定（start()より前に設定する） */
+    void setJpegOptions(int quality, JpegSubsampling subsampling);
+
+    void start();
+    /** @brief エンコードスレッドを止め、waitForFrame()で待っているクライアントを起こす */
+    void stop();
+    bool isRunning() const { return running_; }
+
+    /**
+     * @brief 配信するフレームを渡す（コピーのみ、エンコードはエンコードスレッドで行う）
+     * @param metadata このフレームに対応する付随データ（JpegFrame::metadataにそのまま入る）
+     * @param capture_us 撮影時刻（UNIX時刻マイクロ秒、0ならパートヘッダーに時刻を付けない）
+     */
+    void submit(const cv::Mat& frame, std::string metadata = std::string(), uint64_t capture_us = 0);
+
+    /**
+     * @brief last_seqより新しいJPEGを待つ
+     * @return 新しいフレーム（タイムアウトまたは停止時はnullptr）
+     */
+    JpegFramePtr waitForFrame(uint64_t last_seq, int timeout_ms);
+    /** @brief 最新のJPEG（まだ無ければnullptr） */
+    JpegFramePtr latest();
+
+    /**
+     * @brief エンコードのたびに呼ばれる関数を設定（start()より前に設定する）
+     *
+     * エンコードスレッドから呼ばれる。イベントループ型のサーバーへ渡す用途で、
+     * waitForFrame()で待つスレッドが不要になる。
+     */
+    void setFrameListener(std::function<void(const JpegFramePtr&)> listener) { listener_ = std::move(listener); }
+
+    /** @brief 視聴者数の管理（0人の間はエンコードを省く） */
+    void addClient() { clients_++; }
+    void removeClient() { clients_--; }
+    int clientCount() const { return clients_; }
+
+    uint64_t encodeCount() const { return encodes_; }
+    double meanEncodeMs() const;
+    std::string statsSummary() const;
+
+private:
+    void encoderThread();
+
+    JpegEncoder encoder_;                  // エンコードスレッド専用（圧縮器と出力バッファを使い回す）
+
+    std::mutex mutex_;
+    std::condition_variable pending_cv_;   // 新しい入力フレームの通知
+    std::condition_variable frame_cv_;     // 新しいJPEGの通知
+    cv::Mat pending_;                      // submit()されたフレーム
+    cv::Mat encoding_;                     // エンコード中のフレーム（pending_と入れ替えて再利用）
+    bool has_pending_;
+    std::string pending_metadata_;
+    uint64_t pending_capture_us_;
+    std::chrono::steady_clock::time_point pending_time_;
+    JpegFramePtr latest_;
+    std::function<void(const JpegFramePtr&)> listener_;
+    uint64_t next_seq_;
+    size_t last_jpeg_size_;                // 次のバッファの確保量の目安
+
+    std::atomic<int> clients_;
+    std::atomic<bool> running_;
+    std::thread thread_;
+
+    // 統計
+    std::atomic<uint64_t> submitted_;
+    std::atomic<uint64_t> encodes_;
+    std::atomic<uint64_t> dropped_;        // エンコード前に上書きされたフレーム
+    std::atomic<uint64_t> idle_skips_;     // 視聴者0人でエンコードを省いたフレーム
+    std::atomic<uint64_t> encode_us_total_;
+};
+
+#endif // MJPEG_BROADCASTER_H
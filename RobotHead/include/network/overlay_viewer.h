@@ -0,0 +1,19 @@
+/**
+ * @file overlay_viewer.h
+ * @brief Browser page that draws detection and depth overlays on the raw WebSocket stream
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef OVERLAY_VIEWER_H
+#define OVERLAY_VIEWER_H
+
+/**
+ * @brief /viewで返すHTML
+ *
+ * /wsに接続し、テキストメッセージ（フレームのメタデータJSON）の次に届くバイナリメッセージ（JPEG）を
+ * canvasに描き、その上に検出枠・トラックID・8x8の距離マップをブラウザ側で重ねる。
+ */
+extern const char kOverlayViewerHtml[];
+
+#endif // OVERLAY_VIEWER_H
@@ -0,0 +1,71 @@
+/**
+ * @file websocket.h
+ * @brief Minimal server-side WebSocket (RFC 6455) helpers for HttpServer streams
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef WEBSOCKET_H
+#define WEBSOCKET_H
+
+#include "network/http_server.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/** @brief WebSocketのオペコード */
+enum class WebSocketOpcode : uint8_t {
+    Continuation = 0x0,
+    Text = 0x1,
+    Binary = 0x2,
+    Close = 0x8,
+    Ping = 0x9,
+    Pong = 0xA,
+};
+
+/** @brief サーバーから送るフレームヘッダーの最大長（FIN/opcode + 64bit長、マスクなし） */
+static const size_t kWebSocketMaxHeaderSize = 10;
+
+/** @brief Upgrade: websocketのリクエストか */
+bool isWebSocketUpgrade(const HttpRequest& request);
+
+/** @brief Sec-WebSocket-Keyに対するSec-WebSocket-Acceptの値（SHA-1 + base64） */
+std::string websocketAcceptKey(const std::string& client_key);
+
+/**
+ * @brief 101 Switching Protocolsのレスポンスヘッダーを作る
+ * @return キーが無いなど不正なリクエストの場合は空文字列
+ */
+std::string websocketHandshakeResponse(const HttpRequest& request);
+
+/**
+ * @brief サーバーからのフレームヘッダー（FIN=1、マスクなし）をoutに書き込む
+ * @return ヘッダーのバイト数（2, 4, 10のいずれか）
+ */
+size_t websocketFrameHeader(WebSocketOpcode opcode, uint64_t payload_size, unsigned char out[kWebSocketMaxHeaderSize]);
+
+/** @brief ヘッダー付きの1フレームをチャンクにする（メタデータなど小さいデータ用、コピーする） */
+HttpChunk websocketFrame(WebSocketOpcode opcode, const std::string& payload);
+
+/**
+ * @class WebSocketReader
+ * @brief クライアントから届くフレームを読み進め、Closeを検出する
+ *
+ * 配信専用のためクライアントからのメッセージ（テキスト・バイナリ・Pong）は読み捨てる。
+ */
+class WebSocketReader {
+public:
+    WebSocketReader() : closed_(false) {}
+
+    /**
+     * @brief 受信データを渡す
+     * @return 接続を続ける場合true（Closeフレームまたはプロトコル違反でfalse）
+     */
+    bool feed(const char* data, size_t size);
+
+private:
+    std::string buffer_;
+    bool closed_;
+};
+
+#endif // WEBSOCKET_H
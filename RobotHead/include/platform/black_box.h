@@ -0,0 +1,167 @@
+/**
+ * @file black_box.h
+ * @brief Always-on black-box recorder: fixed-size mmap segment ring of frames, ToF, UART lines and events
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef BLACK_BOX_H
+#define BLACK_BOX_H
+
+#include "network/jpeg_encoder.h"
+#include "sensors/depth_frame.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/** @brief 記録の種類 */
+enum class BlackBoxRecordType : uint8_t {
+    Frame = 1,      // カメラ画像（JPEG）
+    Depth = 2,      // ToFの測距結果（sensors/depth_frame.hの形式）
+    UartRx = 3,     // Picoから受信した1行（IMU, MOTOR, ALERTなど、改行なし）
+    UartTx = 4,     // Picoへ送信したコマンド（改行なし）
+    Event = 5,      // その他の出来事（テキスト）
+};
+
+/**
+ * @brief 1件の記録のヘッダー（リングとダンプファイルで共通、リトルエンディアン）
+ *
+ * ヘッダーの後にsizeバイトのデータが続き、次の記録は8バイト境界から始まる。
+ */
+struct BlackBoxRecordHeader {
+    uint32_t size;              // データのバイト数（ヘッダーを含まない）
+    uint8_t type;               // BlackBoxRecordType
+    uint8_t reserved[3];
+    uint64_t timestamp_us;      // UNIX時刻（マイクロ秒、DepthFrameと同じ）
+};
+
+/**
+ * @brief ダンプファイルの先頭（この後に記録が時刻順に並ぶ）
+ */
+struct BlackBoxDumpHeader {
+    char magic[8];              // "RBBXDUMP"
+    uint32_t version;           // 1
+    uint32_t record_count;
+    uint64_t trigger_us;        // ダンプを要求した時刻
+    uint64_t from_us;           // これより古い記録は含まない
+    char reason[32];            // "FALL", "LIFT", "http", "previous_run"など
+};
+
+/**
+ * @class BlackBoxRecorder
+ * @brief 直近の数分間を常に記録し、異常時にファイルへ書き出すリングレコーダー
+ *
+ * リングは固定長のセグメントに分かれたファイル（既定では/dev/shm、SDカードに書き込まない）を
+ * mmapしたもので、起動時に確保・プリフォルトしておく。記録はロックを取ってmemcpyするだけで、
+ * 記録中にメモリを確保しない。セグメントが一杯になると最も古いセグメントを上書きする。
+ *
+ * ダンプは別スレッドで行い、指定した秒数分の記録を時刻順に1つのファイルへ書き出す。
+ * プロセスが落ちてもリングのファイルは残るため、close()されなかったリングは次の起動時に
+ * "previous_run"として書き出す（Ctrl-Cで止めた場合も含む）。
+ */
+class BlackBoxRecorder {
+public:
+    BlackBoxRecorder();
+    ~BlackBoxRecorder();
+
+    BlackBoxRecorder(const BlackBoxRecorder&) = delete;
+    BlackBoxRecorder& operator=(const BlackBoxRecorder&) = delete;
+
+    /**
+     * @brief リングのファイルを作成（または再利用）してmmapする
+     * @param ring_path リングのファイル（tmpfs上を推奨）
+     * @param ring_bytes リング全体の大きさ（segment_count個のセグメントに分ける）
+     * @param dump_dir ダンプを書き出すディレクトリ（無ければ作る）
+     * @return 成功した場合true
+     */
+    bool open(const std::string& ring_path, size_t ring_bytes, const std::string& dump_dir,
+              size_t segment_count = 16);
+    void close();
+    bool isOpen() const { return base_ != nullptr; }
+
+    /** @brief ダンプに含める秒数（トリガーより前、前回分の書き出しにも使うのでopen()より前に設定する） */
+    void setDumpWindow(std::chrono::seconds window) { dump_window_ = window; }
+    /** @brief 記録するフレームの間隔とJPEG品質（フレームは間引いて記録する） */
+    void setFrameInterval(std::chrono::milliseconds interval) { frame_interval_ = interval; }
+    void setJpegQuality(int quality) { encoder_.setQuality(quality); }
+
+    /**
+     * @brief フレームをJPEGにして記録する（前回から間隔が空いていない場合は何もしない）
+     * @return 記録した場合true
+     * エンコードは呼び出したスレッドで行う（出力バッファは使い回す）。
+     */
+    bool recordFrame(const cv::Mat& frame, uint64_t timestamp_us);
+    void recordDepth(const DepthFrame& frame);
+    void recordUart(bool outgoing, const std::string& line);
+    void recordEvent(const std::string& text);
+    bool record(BlackBoxRecordType type, const void* data, size_t size, uint64_t timestamp_us);
+
+    /**
+     * @brief ダンプを要求する（トリガー後の様子も残すため少し待ってから書き出す）
+     * @return 受け付けた場合true（書き出し中・直前に書き出した場合はfalse）
+     */
+    bool requestDump(const std::string& reason);
+    bool isDumping() const { return dumping_; }
+    std::string lastDumpPath();
+
+    /** @brief 記録処理（エンコードを含む）に使った時間の割合（%、1コア換算） */
+    double overheadPercent() const;
+    /** @brief リングに残っている記録の時間幅（秒） */
+    double retainedSeconds();
+    std::string statsSummary();
+
+    /** @brief 現在のUNIX時刻（マイクロ秒） */
+    static uint64_t nowUs();
+
+private:
+    struct SegmentHeader {
+        uint64_t seq;           // 書き始めた順の通し番号（0は未使用）
+        uint32_t used;          // データ部の使用バイト数
+        uint32_t records;
+        uint64_t first_us;
+        uint64_t last_us;
+    };
+
+    SegmentHeader* segment(size_t index) const;
+    char* segmentData(size_t index) const;
+    bool recordLocked(BlackBoxRecordType type, const void* data, size_t size, uint64_t timestamp_us);
+    bool writeDump(const std::string& reason, uint64_t trigger_us, uint64_t from_us, std::string& path);
+    void addOverhead(std::chrono::steady_clock::time_point start);
+
+    std::mutex mutex_;          // リングへの書き込みとscratch_を保護
+    int fd_;
+    char* base_;
+    size_t mapped_bytes_;
+    size_t segment_count_;
+    size_t segment_bytes_;      // セグメント1つの大きさ（ヘッダーを含む）
+    size_t current_;
+    uint64_t next_seq_;
+    std::string dump_dir_;
+    std::chrono::seconds dump_window_;
+
+    JpegEncoder encoder_;
+    std::vector<unsigned char> jpeg_;       // 使い回す出力バッファ
+    std::vector<unsigned char> depth_;
+    std::chrono::milliseconds frame_interval_;
+    std::chrono::steady_clock::time_point last_frame_;
+    std::vector<char> scratch_;             // ダンプ時に1セグメントずつ写す（open時に確保）
+
+    std::thread dump_thread_;
+    std::atomic<bool> dumping_;
+    std::chrono::steady_clock::time_point last_dump_;
+    std::string last_dump_path_;
+
+    std::chrono::steady_clock::time_point opened_at_;
+    std::atomic<uint64_t> overhead_us_;
+    std::atomic<uint64_t> counts_[6];       // 種類ごとの記録数
+    std::atomic<uint64_t> too_large_;
+    std::atomic<uint64_t> dumps_;
+};
+
+#endif // BLACK_BOX_H
@@ -0,0 +1,70 @@
+/**
+ * @file latency_trace.h
+ * @brief Per-stage latency distributions measured from frame capture timestamps (--latency)
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef LATENCY_TRACE_H
+#define LATENCY_TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/** @brief 1つの区間の集計 */
+struct LatencyStageStats {
+    std::string stage;
+    uint64_t count = 0;       // 記録した回数（起動から）
+    double p50_ms = 0.0;      // 以下は直近window件の分布
+    double p95_ms = 0.0;
+    double p99_ms = 0.0;
+    double max_ms = 0.0;      // 起動からの最大
+};
+
+/**
+ * @class LatencyTrace
+ * @brief 撮影時刻から各段階（検出結果の反映、挨拶音声の開始、JPEGエンコード完了など）までの遅延を集める
+ *
+ * 時刻はすべてUNIX時刻のマイクロ秒（FrameSource::lastCaptureUs()と同じ）。
+ * record()は複数のスレッド（メインループ、JPEGのエンコードスレッド）から呼べる。
+ * 区間ごとに直近window件だけを残し、分布はそこから求める。
+ */
+class LatencyTrace {
+public:
+    explicit LatencyTrace(size_t window = 1024);
+
+    void setEnabled(bool enabled) { enabled_ = enabled; }
+    bool enabled() const { return enabled_; }
+
+    /**
+     * @brief 区間stageの1件を記録する（無効時、start_usが0、end_usが前の場合は何もしない）
+     * @param stage "capture_to_detect"などの区間名
+     */
+    void record(const std::string& stage, uint64_t start_us, uint64_t end_us);
+
+    /** @brief 区間名順の集計 */
+    std::vector<LatencyStageStats> stats() const;
+    std::string summary() const;
+    /** @brief {"stages": [{"stage", "count", "p50_ms", "p95_ms", "p99_ms", "max_ms"}]} */
+    std::string json() const;
+
+private:
+    struct Stage {
+        std::vector<double> samples_ms;   // リング
+        size_t next = 0;
+        uint64_t count = 0;
+        double max_ms = 0.0;
+    };
+
+    size_t window_;
+    std::atomic<bool> enabled_;
+    mutable std::mutex mutex_;
+    std::map<std::string, Stage> stages_;
+};
+
+#endif // LATENCY_TRACE_H
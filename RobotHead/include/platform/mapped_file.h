@@ -0,0 +1,45 @@
+/**
+ * @file mapped_file.h
+ * @brief Read-only memory mapped file
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class MappedFile
+ * @brief ファイルを読み取り専用でmmapする（モデル読み込み用）
+ *
+ * ファイル全体をヒープに読み込む代わりにページキャッシュを直接参照するため、
+ * 読み込み中の一時的なコピーが不要になり、close()後はページキャッシュとして回収可能になる。
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /** @return 成功した場合true */
+    bool open(const std::string& path);
+    void close();
+
+    const char* data() const { return static_cast<const char*>(data_); }
+    size_t size() const { return size_; }
+    bool isOpen() const { return data_ != nullptr; }
+
+private:
+    void* data_;
+    size_t size_;
+};
+
+/** @brief ファイルサイズ（バイト）、取得失敗時は0 */
+size_t fileSizeBytes(const std::string& path);
+
+#endif // MAPPED_FILE_H
@@ -154,6 +154,21 @@ uint8_t VL53L8CX_Reset_Sensor(
 void VL53L8CX_SwapBuffer(
 		uint8_t 		*buffer,
 		uint16_t 	 	 size);
+
+/**
+ * @brief Swap a buffer into another one: same bytes as copying src to dst
+ * then calling VL53L8CX_SwapBuffer() on the copy. Used by the ranging decode to
+ * unpack only the blocks it needs straight into the results. A size that is
+ * not a multiple of 4 still reads the whole last 4-byte word of src.
+ * @param (uint8_t*) dst : Destination (must not overlap src)
+ * @param (const uint8_t*) src : Buffer as read from the sensor
+ * @param (uint32_t) size : Number of bytes to write to dst
+ */
+
+void VL53L8CX_SwapCopy(
+		uint8_t			*dst,
+		const uint8_t		*src,
+		uint32_t		 size);
 /**
  * @brief Mandatory function, used to wait during an amount of time. It must be
  * filled as it's used into the API.
@@ -171,4 +186,4 @@ uint8_t VL53L8CX_WaitMs(
 }
 #endif
 
-#endif	// _PLATFORM_H_
\ No newline at end of file
+#endif	// _PLATFORM_H_
\ No newline at end of file
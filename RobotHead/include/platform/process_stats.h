@@ -0,0 +1,31 @@
+/**
+ * @file process_stats.h
+ * @brief Process memory / CPU statistics from /proc
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef PROCESS_STATS_H
+#define PROCESS_STATS_H
+
+#include <cstddef>
+
+/**
+ * @brief 現在の常駐メモリ量（VmRSS）を取得
+ * @return RSS（KB）、取得失敗時は0
+ */
+size_t readRssKb();
+
+/**
+ * @brief プロセス起動以降のピーク常駐メモリ量（VmHWM）を取得
+ * @return ピークRSS（KB）、取得失敗時は0
+ */
+size_t readPeakRssKb();
+
+/**
+ * @brief システム全体の利用可能メモリ量（MemAvailable）を取得
+ * @return 利用可能メモリ（KB）、取得失敗時は0
+ */
+size_t readMemAvailableKb();
+
+#endif // PROCESS_STATS_H
@@ -0,0 +1,243 @@
+/**
+ * @file session_log.h
+ * @brief Chunked binary session log (frames, ToF results, UART lines) with a trailing index and mmap reader
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef SESSION_LOG_H
+#define SESSION_LOG_H
+
+#include "platform/mapped_file.h"
+#include "network/jpeg_encoder.h"
+#include "sensors/vl53l8cx_api.h"
+#include <opencv2/core.hpp>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief 記録の種類（1〜5はBlackBoxRecordTypeと同じ値で、ブラックボックスのダンプをそのまま変換できる）
+ */
+enum class SessionRecordType : uint8_t {
+    JpegFrame = 1,      // カメラ画像（JPEG）
+    DepthFrame = 2,     // ToF（sensors/depth_frame.hの形式）
+    UartRx = 3,         // Picoから受信した1行
+    UartTx = 4,         // Picoへ送信したコマンド
+    Event = 5,          // テキスト
+    RawFrame = 6,       // カメラ画像（SessionRawFrameHeader + 詰めた画素）
+    ToFResults = 7,     // VL53L8CX_ResultsDataをそのままコピーしたもの（同じビルド設定でのみ読める）
+};
+
+const char* sessionRecordTypeName(SessionRecordType type);
+
+/*
+ * ファイルの形式（リトルエンディアン）
+ *
+ *   SessionFileHeader（64バイト）
+ *   チャンク: SessionChunkHeader + 記録（SessionRecordHeader + データ、8バイト境界に詰める）の並び
+ *   ...
+ *   索引: SessionIndexEntry x record_count
+ *   SessionFooter（ファイル末尾）
+ *
+ * 索引はclose()で書くため、途中で止まったファイルはチャンクを先頭から辿って索引を作り直す。
+ * チャンク内の記録は届いた順（時刻は前後しうる）、索引は時刻順に並べる。
+ */
+
+struct SessionFileHeader {
+    char magic[8];              // "RSESSION"
+    uint32_t version;           // 1
+    uint32_t header_bytes;      // sizeof(SessionFileHeader)
+    uint64_t created_us;        // UNIX時刻（マイクロ秒）
+    uint32_t tof_results_bytes; // 書いた側のsizeof(VL53L8CX_ResultsData)
+    char note[36];
+};
+
+struct SessionChunkHeader {
+    char magic[4];              // "CHNK"
+    uint32_t record_count;
+    uint32_t payload_bytes;     // このヘッダーの後に続くバイト数
+    uint32_t reserved;
+    uint64_t first_us;
+    uint64_t last_us;
+};
+
+/** @brief 記録のヘッダー（BlackBoxRecordHeaderと同じ配置） */
+struct SessionRecordHeader {
+    uint32_t size;
+    uint8_t type;               // SessionRecordType
+    uint8_t reserved[3];
+    uint64_t timestamp_us;      // UNIX時刻（マイクロ秒）
+};
+
+struct SessionRawFrameHeader {
+    uint16_t width;
+    uint16_t height;
+    uint8_t channels;           // 3 = BGR, 1 = グレースケール
+    uint8_t reserved[3];
+};
+
+struct SessionIndexEntry {
+    uint64_t offset;            // 記録のヘッダーのファイル内位置
+    uint64_t timestamp_us;
+    uint32_t size;
+    uint8_t type;
+    uint8_t reserved[3];
+};
+
+struct SessionFooter {
+    char magic[8];              // "RSLINDEX"
+    uint64_t index_offset;
+    uint64_t record_count;
+    uint64_t chunk_count;
+    uint64_t first_us;
+    uint64_t last_us;
+};
+
+/**
+ * @class SessionWriter
+ * @brief セッションログを書き込む（ファイルへの書き込みとJPEGエンコードは専用スレッドで行う）
+ *
+ * append系はデータをキューに写して戻るだけで、キューの要素は使い回す。
+ * 書き込みが追いつかずキューが一杯になった記録は捨てて数える（呼び出し側を待たせない）。
+ */
+class SessionWriter {
+public:
+    SessionWriter();
+    ~SessionWriter();
+
+    SessionWriter(const SessionWriter&) = delete;
+    SessionWriter& operator=(const SessionWriter&) = delete;
+
+    /**
+     * @param chunk_bytes このバイト数を超えたらチャンクを閉じて書き込む
+     * @return 成功した場合true
+     */
+    bool open(const std::string& path, const std::string& note = "", size_t chunk_bytes = 1024 * 1024);
+    /** @brief 残りを書き込み、索引を書いて閉じる */
+    void close();
+    bool isOpen() const { return running_; }
+
+    /** @brief フレームの記録形式（jpeg_quality <= 0 なら画素をそのまま記録する） */
+    void setFrameFormat(int jpeg_quality) { jpeg_quality_ = jpeg_quality; }
+    /** @brief trueならキューが一杯の時に捨てずに空くまで待つ（オフラインの変換ツール向け） */
+    void setBlocking(bool blocking) { blocking_ = blocking; }
+
+    bool appendFrame(const cv::Mat& frame, uint64_t timestamp_us);
+    bool appendJpeg(const void* data, size_t size, uint64_t timestamp_us);
+    bool appendToFResults(const VL53L8CX_ResultsData& results, uint64_t timestamp_us);
+    bool appendUart(bool outgoing, const std::string& line, uint64_t timestamp_us);
+    bool appendEvent(const std::string& text, uint64_t timestamp_us);
+    bool append(SessionRecordType type, const void* data, size_t size, uint64_t timestamp_us);
+
+    uint64_t recordCount() const { return records_; }
+    uint64_t droppedCount() const { return dropped_; }
+    std::string statsSummary() const;
+
+private:
+    struct Pending {
+        SessionRecordType type;
+        uint64_t timestamp_us;
+        std::vector<char> data;
+        cv::Mat frame;          // appendFrame: 書き込みスレッドでエンコード・詰める
+    };
+
+    std::unique_ptr<Pending> acquire();
+    bool push(std::unique_ptr<Pending> item);
+    void writerThread();
+    void writeRecord(SessionRecordType type, const void* data, size_t size, uint64_t timestamp_us);
+    void flushChunk();
+
+    FILE* fp_;
+    uint64_t file_offset_;
+    size_t chunk_bytes_;
+    std::vector<char> chunk_;               // 書き込みスレッドだけが触る
+    SessionChunkHeader chunk_header_;
+    std::vector<SessionIndexEntry> index_;
+    uint64_t chunk_count_;
+    uint64_t first_us_;
+    uint64_t last_us_;
+
+    JpegEncoder encoder_;
+    std::vector<unsigned char> jpeg_;
+    std::atomic<int> jpeg_quality_;
+
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::condition_variable space_cv_;
+    std::deque<std::unique_ptr<Pending>> queue_;
+    std::vector<std::unique_ptr<Pending>> free_;
+    size_t max_queued_;
+    bool blocking_;
+    std::atomic<bool> running_;     // append()はロックを取らずに参照する
+    std::thread thread_;
+
+    std::atomic<uint64_t> records_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<uint64_t> bytes_written_;
+};
+
+/** @brief 読み出した1件（dataはmmapした領域を直接指す） */
+struct SessionRecord {
+    SessionRecordType type;
+    uint64_t timestamp_us;
+    const char* data;
+    size_t size;
+};
+
+/**
+ * @class SessionReader
+ * @brief セッションログをmmapして読む（記録はコピーせずに参照する）
+ *
+ * 索引があれば記録番号でO(1)、時刻で二分探索により位置を決められる。
+ * 記録番号は時刻順（ファイル内の並びではない）。
+ */
+class SessionReader {
+public:
+    SessionReader();
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t size() const { return count_; }
+    SessionRecord record(size_t i) const;
+    /** @brief timestamp_us以降の最初の記録番号（無ければsize()） */
+    size_t lowerBound(uint64_t timestamp_us) const;
+
+    uint64_t firstUs() const { return count_ > 0 ? entry(0).timestamp_us : 0; }
+    uint64_t lastUs() const { return count_ > 0 ? entry(count_ - 1).timestamp_us : 0; }
+    size_t chunkCount() const { return chunk_count_; }
+    size_t fileBytes() const { return file_.size(); }
+    const SessionFileHeader& header() const { return header_; }
+    /** @brief 索引が無く（書き込み中に止まった）、チャンクを辿って作り直した場合true */
+    bool indexRecovered() const { return recovered_; }
+
+    /** @brief RawFrameを画素をコピーせずにMatで参照する（書き換えないこと） */
+    static bool rawFrameView(const SessionRecord& record, cv::Mat& out);
+    /** @brief JpegFrame / RawFrameをBGR画像にする */
+    static bool decodeFrame(const SessionRecord& record, cv::Mat& out);
+    static bool decodeToFResults(const SessionRecord& record, VL53L8CX_ResultsData& out);
+
+private:
+    const SessionIndexEntry& entry(size_t i) const { return index_ != nullptr ? index_[i] : rebuilt_[i]; }
+    bool rebuildIndex();
+    bool indexInBounds(const SessionIndexEntry* index, size_t count, uint64_t index_offset) const;
+
+    MappedFile file_;
+    SessionFileHeader header_;
+    const SessionIndexEntry* index_;        // ファイル内の索引（mmap）
+    std::vector<SessionIndexEntry> rebuilt_;
+    size_t count_;
+    size_t chunk_count_;
+    bool recovered_;
+};
+
+#endif // SESSION_LOG_H
@@ -0,0 +1,55 @@
+/**
+ * @file depth_frame.h
+ * @brief Compact little-endian binary encoding of one VL53L8CX ranging frame
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef DEPTH_FRAME_H
+#define DEPTH_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/** @brief 1フレームの最大ゾーン数（8x8） */
+static const int kDepthFrameMaxZones = 64;
+
+/**
+ * @brief ToFセンサーの1回分の測距結果（ゾーンごとの生の値）
+ */
+struct DepthFrame {
+    uint32_t seq;                                  // センサーから読んだ通し番号
+    uint64_t timestamp_us;                         // 読み取った時刻（UNIX時刻、マイクロ秒）
+    uint8_t zones;                                 // 16（4x4）または64（8x8）
+    int16_t distance_mm[kDepthFrameMaxZones];
+    uint16_t range_sigma_mm[kDepthFrameMaxZones];
+    uint8_t target_status[kDepthFrameMaxZones];    // 5と9が有効な測距
+};
+
+/*
+ * バイナリ形式（すべてリトルエンディアン、詰め物なし）
+ *   0  char[2]   'T' 'F'
+ *   2  uint8     バージョン（1）
+ *   3  uint8     ゾーン数 N（16または64）
+ *   4  uint32    seq
+ *   8  uint64    timestamp_us
+ *  16  int16[N]  distance_mm
+ *      uint16[N] range_sigma_mm
+ *      uint8[N]  target_status
+ * 8x8で336バイト、4x4で96バイト。
+ */
+
+/** @brief ゾーン数に対するエンコード後のバイト数 */
+size_t depthFrameEncodedSize(int zones);
+
+/** @brief outを上書きしてエンコードする */
+void encodeDepthFrame(const DepthFrame& frame, std::vector<unsigned char>& out);
+
+/**
+ * @brief エンコードされた1フレームを読む
+ * @return 形式・バージョン・長さが正しい場合true
+ */
+bool decodeDepthFrame(const unsigned char* data, size_t size, DepthFrame& frame);
+
+#endif // DEPTH_FRAME_H
@@ -0,0 +1,33 @@
+/**
+ * @file depth_overlay.h
+ * @brief Draw the 8x8 ToF distances over (or under) the camera frame
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef DEPTH_OVERLAY_H
+#define DEPTH_OVERLAY_H
+
+#include <opencv2/core.hpp>
+#include <cstdint>
+
+/**
+ * @brief 重ね方（./Data/depth_calibration.yamlの内容）
+ */
+struct DepthOverlayConfig {
+    bool calibrated = false;                    // falseなら画像の下にヒートマップを並べる
+    cv::Rect region = cv::Rect(35, 60, 240, 240);  // 回転後の画像上のToFの視野
+    float alpha = 0.5f;
+};
+
+/**
+ * @brief ToFの距離をカラーマップにして表示用の画像を作る
+ * @param frame 回転後のカメラ画像
+ * @param distance_mm 8x8の距離（VL53L8CX_ResultsData::distance_mmの先頭64個）
+ * @param display calibratedならframeを複製したものに重ねる（呼び出し側で用意する）。
+ *                そうでなければframeとヒートマップを縦に並べた画像で置き換える
+ */
+void drawDepthOverlay(const cv::Mat& frame, const int16_t* distance_mm, const DepthOverlayConfig& config,
+                      cv::Mat& display);
+
+#endif // DEPTH_OVERLAY_H
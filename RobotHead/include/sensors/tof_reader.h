@@ -0,0 +1,90 @@
+/**
+ * @file tof_reader.h
+ * @brief Background thread that reads the VL53L8CX at the sensor's own ranging rate
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#ifndef TOF_READER_H
+#define TOF_READER_H
+
+#include "sensors/vl53l8cx_api.h"
+#include "sensors/depth_frame.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @class ToFReader
+ * @brief 測距済みのVL53L8CXをセンサーの周期でポーリングし、最新の結果を保持する
+ *
+ * カメラのループ（約5fps）で読むとセンサーが15Hz（4x4なら60Hz）で測っていても
+ * 大半のフレームを取りこぼすため、専用スレッドでdata readyを2ms間隔で確認して読み出す。
+ * 読み出し開始後はI2Cをこのスレッドだけが使う（devに他から触れない）。
+ */
+class ToFReader {
+public:
+    /**
+     * @param dev 初期化・測距開始済みのセンサー
+     * @param zones 16（4x4）または64（8x8）、設定した解像度に合わせる
+     */
+    explicit ToFReader(VL53L8CX_Configuration* dev, int zones = 64);
+    ~ToFReader();
+
+    ToFReader(const ToFReader&) = delete;
+    ToFReader& operator=(const ToFReader&) = delete;
+
+    void start();
+    void stop();
+
+    /**
+     * @brief seqより新しい結果があればoutにコピーしてseqを更新する
+     * @return 新しい結果をコピーした場合true
+     */
+    bool latest(VL53L8CX_ResultsData& out, uint64_t& seq);
+
+    /**
+     * @brief センサーから読むたびに呼ばれる関数を設定（start()より前に設定する）
+     *
+     * 読み出しスレッドから呼ばれるため、時間のかかる処理をしてはいけない。
+     */
+    void setFrameListener(std::function<void(const DepthFrame&)> listener) { listener_ = std::move(listener); }
+
+    /** @brief I2Cの通信に失敗して読み出しを止めた（data readyの確認失敗、または読み出しの連続失敗） */
+    bool failed() const { return failed_; }
+    /** @brief 破損（ヘッダー・フッターのID不一致）などで捨てたフレーム数 */
+    uint64_t droppedFrames() const { return dropped_; }
+    /** @brief 実測の読み出しレート（指数移動平均） */
+    double rateHz() const { return rate_hz_; }
+    std::string statsSummary() const;
+
+private:
+    void readerThread();
+
+    VL53L8CX_Configuration* dev_;
+    int zones_;
+    std::function<void(const DepthFrame&)> listener_;
+
+    VL53L8CX_ResultsData scratch_;         // 読み出し先（数KBあるため読み出しスレッドで使い回す）
+
+    std::mutex mutex_;                     // latest_とseq_を保護
+    VL53L8CX_ResultsData latest_;
+    uint64_t seq_;
+
+    std::atomic<bool> running_;
+    std::atomic<bool> failed_;
+    std::thread thread_;
+
+    // 統計
+    std::atomic<uint64_t> frames_;
+    std::atomic<uint64_t> polls_;
+    std::atomic<uint64_t> dropped_;
+    std::atomic<double> rate_hz_;
+    std::chrono::steady_clock::time_point last_read_;
+};
+
+#endif // TOF_READER_H
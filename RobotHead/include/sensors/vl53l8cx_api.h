@@ -485,6 +485,20 @@ uint8_t vl53l8cx_get_ranging_data(
 		VL53L8CX_Configuration		*p_dev,
 		VL53L8CX_ResultsData		*p_results);
 
+/**
+ * @brief This function decodes a ranging frame already read into
+ * p_dev->temp_buffer (p_dev->data_read_size bytes, sensor byte order). It is
+ * the second half of vl53l8cx_get_ranging_data(), kept separate so that the
+ * unpack can be run on recorded or synthetic frames without I2C.
+ * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
+ * @param (VL53L8CX_ResultsData) *p_results : VL53L5 results structure.
+ * @return (uint8_t) status : 0 if the frame is valid.
+ */
+
+uint8_t vl53l8cx_decode_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results);
+
 /**
  * @brief This function gets the current resolution (4x4 or 8x8).
  * @param (VL53L8CX_Configuration) *p_dev : VL53L8CX configuration structure.
@@ -11,7 +11,7 @@
 #include <random>
 #include <chrono>
 
-AudioPlayer::AudioPlayer() : is_playing_(false) {
+AudioPlayer::AudioPlayer() : is_playing_(false), last_start_us_(0) {
     std::cout << "[AudioPlayer] Initializing audio player..." << std::endl;
     
     // 挨拶音声ファイルリスト（5個）
@@ -59,6 +59,8 @@ bool AudioPlayer::playFile(const std::string& filename) {
     
     if (ret == 0) {
         is_playing_ = true;
+        last_start_us_ = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
         std::cout << "[AudioPlayer] ✓ Audio playback started successfully" << std::endl;
         return true;
     } else {
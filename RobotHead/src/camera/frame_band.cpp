@@ -0,0 +1,110 @@
+/**
+ * @file frame_band.cpp
+ * @brief Implementation of the frame counter / timecode bands
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "camera/frame_band.h"
+#include <opencv2/imgproc.hpp>
+
+using namespace cv;
+using namespace std;
+
+static const int kBandCells = 32;
+static const uint32_t kBandMask = (1u << kFrameBandBits) - 1;
+
+static uint32_t bandCheck(uint32_t value) {
+    // 上位6ビット（真っ黒な帯を値0と読まないよう、0でも検査値が0にならない定数を混ぜる）
+    return ((value ^ 0x5A5A5Au) * 0x9E3779B1u) >> 26;
+}
+
+// i番目のマスの位置（Leftは上端の帯を左90度回転した位置なので、先頭のマスが下端に来る）
+static Rect cellRect(const Mat& frame, FrameBandEdge edge, int i) {
+    switch (edge) {
+    case FrameBandEdge::Left: {
+        int cell = frame.rows / kBandCells;
+        return Rect(0, frame.rows - (i + 1) * cell, kFrameBandHeight, cell);
+    }
+    case FrameBandEdge::Bottom: {
+        int cell = frame.cols / kBandCells;
+        return Rect(i * cell, frame.rows - kFrameBandHeight, cell, kFrameBandHeight);
+    }
+    case FrameBandEdge::Top:
+    default: {
+        int cell = frame.cols / kBandCells;
+        return Rect(i * cell, 0, cell, kFrameBandHeight);
+    }
+    }
+}
+
+static bool bandFits(const Mat& frame, FrameBandEdge edge) {
+    bool vertical = (edge == FrameBandEdge::Left);
+    int length = vertical ? frame.rows : frame.cols;
+    int across = vertical ? frame.cols : frame.rows;
+    return length / kBandCells >= 2 && across >= kFrameBandHeight;
+}
+
+void drawFrameBand(Mat& frame, uint32_t value, FrameBandEdge edge) {
+    if (frame.empty() || !bandFits(frame, edge)) {
+        return;
+    }
+    value &= kBandMask;
+    uint32_t check = bandCheck(value);
+    for (int i = 0; i < kBandCells; i++) {
+        bool white;
+        if (i < 2) {
+            white = (i == 0);
+        } else if (i < 2 + kFrameBandBits) {
+            white = ((value >> (kFrameBandBits - 1 - (i - 2))) & 1) != 0;
+        } else {
+            white = ((check >> (kBandCells - 1 - i)) & 1) != 0;
+        }
+        rectangle(frame, cellRect(frame, edge, i), white ? Scalar(255, 255, 255) : Scalar(0, 0, 0), FILLED);
+    }
+}
+
+bool readFrameBand(const Mat& frame, FrameBandEdge edge, uint32_t& value) {
+    if (frame.empty() || frame.depth() != CV_8U || !bandFits(frame, edge)) {
+        return false;
+    }
+    // マスの中心付近の明るさを読む
+    uint32_t bits = 0;
+    for (int i = 0; i < kBandCells; i++) {
+        Rect r = cellRect(frame, edge, i);
+        const uchar* p = frame.ptr(r.y + r.height / 2) + (size_t)(r.x + r.width / 2) * frame.channels();
+        int sum = 0;
+        for (int c = 0; c < frame.channels(); c++) {
+            sum += p[c];
+        }
+        bits = (bits << 1) | (sum / frame.channels() >= 128 ? 1u : 0u);
+    }
+    if ((bits >> 30) != 2) {
+        return false;   // 同期マス（白, 黒）が無い
+    }
+    uint32_t decoded = (bits >> 6) & kBandMask;
+    if ((bits & 0x3F) != bandCheck(decoded)) {
+        return false;
+    }
+    value = decoded;
+    return true;
+}
+
+void drawCaptureTimecode(Mat& frame, uint64_t capture_us) {
+    drawFrameBand(frame, (uint32_t)((capture_us / 1000) & kBandMask), FrameBandEdge::Bottom);
+}
+
+bool readCaptureTimecode(const Mat& frame, uint64_t reference_us, uint64_t& capture_us) {
+    uint32_t code;
+    if (!readFrameBand(frame, FrameBandEdge::Bottom, code)) {
+        return false;
+    }
+    // 基準時刻から遡って下位24ビットが一致する最初のミリ秒
+    uint64_t reference_ms = reference_us / 1000;
+    uint64_t behind = (reference_ms - code) & kBandMask;
+    if (behind > reference_ms) {
+        return false;
+    }
+    capture_us = (reference_ms - behind) * 1000;
+    return true;
+}
@@ -0,0 +1,229 @@
+/**
+ * @file frame_source.cpp
+ * @brief Implementation of the frame source backends and pacing
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "camera/frame_source.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+using namespace cv;
+using namespace std;
+
+static uint64_t wallClockUs() {
+    return (uint64_t)chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+}
+
+bool parseFramePacing(const string& text, FramePacing& out) {
+    if (text == "realtime") {
+        out = FramePacing::RealTime;
+    } else if (text == "fast") {
+        out = FramePacing::AsFastAsPossible;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// FrameSource
+// ---------------------------------------------------------------------------
+
+FrameSource::FrameSource()
+    : pacing_(FramePacing::RealTime), started_(false), first_source_us_(0), last_capture_us_(0),
+      last_source_us_(0), frames_(0) {}
+
+bool FrameSource::read(Mat& frame) {
+    uint64_t source_us = 0;
+    if (!readFrame(frame, source_us) || frame.empty()) {
+        return false;
+    }
+
+    if (!isLive() && pacing_ == FramePacing::RealTime) {
+        // 最初のフレームを基準に、入力上の時刻まで待つ（処理が遅れた分は詰めずにそのまま流す）
+        if (!started_ || source_us < first_source_us_) {
+            started_ = true;
+            first_source_us_ = source_us;
+            started_at_ = chrono::steady_clock::now();
+        }
+        this_thread::sleep_until(started_at_ + chrono::microseconds(source_us - first_source_us_));
+    }
+
+    last_source_us_ = source_us;
+    last_capture_us_ = wallClockUs();
+    frames_++;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// V4L2FrameSource
+// ---------------------------------------------------------------------------
+
+V4L2FrameSource::V4L2FrameSource(const string& device, int width, int height) : device_(device) {
+    if (!capture_.open(device, CAP_V4L2)) {
+        cerr << "[FrameSource] V4L2デバイスを開けません: " << device << endl;
+        return;
+    }
+    capture_.set(CAP_PROP_FRAME_WIDTH, width);
+    capture_.set(CAP_PROP_FRAME_HEIGHT, height);
+    capture_.set(CAP_PROP_BUFFERSIZE, 1);   // 古いフレームを溜めない
+}
+
+bool V4L2FrameSource::readFrame(Mat& frame, uint64_t& source_us) {
+    if (!capture_.read(frame)) {
+        return false;
+    }
+    source_us = wallClockUs();
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// ImageDirFrameSource
+// ---------------------------------------------------------------------------
+
+ImageDirFrameSource::ImageDirFrameSource(const string& dir, double fps, bool loop)
+    : dir_(dir), fps_(fps > 0.0 ? fps : 5.0), loop_(loop), next_(0), index_(0) {
+    vector<String> found;
+    for (const char* pattern : {"/*.jpg", "/*.jpeg", "/*.png"}) {
+        glob(dir + pattern, found, false);
+        files_.insert(files_.end(), found.begin(), found.end());
+    }
+    sort(files_.begin(), files_.end());
+    if (files_.empty()) {
+        cerr << "[FrameSource] 画像が見つかりません: " << dir << endl;
+    }
+}
+
+bool ImageDirFrameSource::readFrame(Mat& frame, uint64_t& source_us) {
+    // 前回読めた画像から一周してもどれも読めなければ終わる（--loopで空回りしない）
+    size_t failures = 0;
+    while ((next_ < files_.size() || (loop_ && !files_.empty())) && failures < files_.size()) {
+        if (next_ >= files_.size()) {
+            next_ = 0;
+        }
+        frame = imread(files_[next_++], IMREAD_COLOR);
+        if (!frame.empty()) {
+            source_us = (uint64_t)(index_++ * 1e6 / fps_);
+            return true;
+        }
+        cerr << "[FrameSource] 画像を読めません: " << files_[next_ - 1] << endl;
+        failures++;
+    }
+    return false;
+}
+
+// ---------------------------------------------------------------------------
+// VideoFileFrameSource
+// ---------------------------------------------------------------------------
+
+VideoFileFrameSource::VideoFileFrameSource(const string& path, bool loop)
+    : path_(path), fps_(0.0), loop_(loop), index_(0) {
+    if (!capture_.open(path)) {
+        cerr << "[FrameSource] 動画を開けません: " << path << endl;
+        return;
+    }
+    fps_ = capture_.get(CAP_PROP_FPS);
+    if (fps_ <= 0.0 || fps_ > 240.0) {
+        fps_ = 30.0;   // コンテナにfpsが無い場合
+    }
+}
+
+bool VideoFileFrameSource::readFrame(Mat& frame, uint64_t& source_us) {
+    if (!capture_.read(frame)) {
+        if (!loop_ || index_ == 0) {
+            return false;
+        }
+        capture_.set(CAP_PROP_POS_FRAMES, 0);
+        if (!capture_.read(frame)) {
+            return false;
+        }
+    }
+    // ループしても時刻は戻さない（ペーシングの基準を保つ）
+    source_us = (uint64_t)(index_++ * 1e6 / fps_);
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// SyntheticFrameSource
+// ---------------------------------------------------------------------------
+
+void SyntheticFrameSource::drawFrameCounter(Mat& frame, uint32_t counter) {
+    drawFrameBand(frame, counter, FrameBandEdge::Top);
+}
+
+bool SyntheticFrameSource::decodeFrameCounter(const Mat& frame, uint32_t& counter) {
+    // 回転前の上端、またはrobot_headで左90度回転した後の左端
+    return readFrameBand(frame, FrameBandEdge::Top, counter) || readFrameBand(frame, FrameBandEdge::Left, counter);
+}
+
+SyntheticFrameSource::SyntheticFrameSource(int width, int height, double fps)
+    : width_(width), height_(height), fps_(fps > 0.0 ? fps : 30.0), counter_(0) {}
+
+bool SyntheticFrameSource::readFrame(Mat& frame, uint64_t& source_us) {
+    frame.create(height_, width_, CV_8UC3);   // 同じサイズなら前回のバッファを使う
+
+    // 横に流れる縦縞（動き検出・エンコードに適度な負荷を与える）と、往復する円
+    int shift = (int)(counter_ * 4);
+    for (int y = kCounterBandHeight; y < height_; y++) {
+        Vec3b* row = frame.ptr<Vec3b>(y);
+        for (int x = 0; x < width_; x++) {
+            uchar v = (uchar)(((x + shift) & 63) * 4);
+            row[x] = Vec3b(v, (uchar)(y * 255 / height_), (uchar)(255 - v));
+        }
+    }
+    int period = max(2, width_ - 40);
+    int phase = (int)(counter_ * 3 % (2 * period));
+    int cx = 20 + (phase < period ? phase : 2 * period - phase);
+    circle(frame, Point(cx, height_ / 2), max(8, height_ / 8), Scalar(40, 40, 220), FILLED);
+    putText(frame, to_string(counter_), Point(4, height_ - 8), FONT_HERSHEY_SIMPLEX, 0.6,
+            Scalar(255, 255, 255), 2);
+    drawFrameCounter(frame, counter_);
+
+    source_us = (uint64_t)(counter_ * 1e6 / fps_);
+    counter_++;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// openFrameSource
+// ---------------------------------------------------------------------------
+
+// "path@fps" を分ける（@が無ければfpsは変えない）
+static string splitRate(const string& text, double& fps) {
+    size_t at = text.rfind('@');
+    if (at == string::npos) {
+        return text;
+    }
+    fps = atof(text.c_str() + at + 1);
+    return text.substr(0, at);
+}
+
+unique_ptr<FrameSource> openFrameSource(const string& spec, int width, int height, bool loop) {
+    unique_ptr<FrameSource> source;
+    if (spec.compare(0, 5, "v4l2:") == 0) {
+        source.reset(new V4L2FrameSource(spec.substr(5), width, height));
+    } else if (spec.compare(0, 4, "dir:") == 0) {
+        double fps = 5.0;
+        string dir = splitRate(spec.substr(4), fps);
+        source.reset(new ImageDirFrameSource(dir, fps, loop));
+    } else if (spec.compare(0, 6, "video:") == 0) {
+        source.reset(new VideoFileFrameSource(spec.substr(6), loop));
+    } else if (spec == "synthetic" || spec.compare(0, 10, "synthetic:") == 0) {
+        double fps = spec.size() > 10 ? atof(spec.c_str() + 10) : 30.0;
+        source.reset(new SyntheticFrameSource(width, height, fps));
+    } else {
+        cerr << "[FrameSource] 入力の指定が分かりません: " << spec << endl;
+        return nullptr;
+    }
+    if (!source->isOpened()) {
+        return nullptr;
+    }
+    return source;
+}
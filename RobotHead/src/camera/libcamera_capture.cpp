@@ -1,5 +1,6 @@
 #include "camera/libcamera_capture.h"
 #include <sys/mman.h>
+#include <chrono>
 #include <iostream>
 
 using namespace libcamera;
@@ -162,7 +163,7 @@ void LibCameraCapture::requestComplete(Request *request) {
     cv_.notify_one();
 }
 
-bool LibCameraCapture::read(Mat &frame) {
+bool LibCameraCapture::readFrame(Mat &frame, uint64_t &source_us) {
     if (!camera_ || !running_)
         return false;
     
@@ -207,5 +208,7 @@ bool LibCameraCapture::read(Mat &frame) {
     request->reuse(Request::ReuseBuffers);
     camera_->queueRequest(request);
     
+    source_us = (uint64_t)chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
     return !frame.empty();
 }
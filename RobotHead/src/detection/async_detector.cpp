@@ -0,0 +1,353 @@
+/**
+ * @file async_detector.cpp
+ * @brief Implementation of asynchronous object detection
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "detection/async_detector.h"
+#include "detection/model_manifest.h"
+#include "platform/process_stats.h"
+#include <iostream>
+#include <chrono>
+
+using namespace cv;
+using namespace std;
+
+const char* swapStateName(ModelSwapStatus::State state) {
+    switch (state) {
+        case ModelSwapStatus::State::Idle: return "idle";
+        case ModelSwapStatus::State::Loading: return "loading";
+        case ModelSwapStatus::State::Ready: return "ready";
+        case ModelSwapStatus::State::Swapped: return "swapped";
+        case ModelSwapStatus::State::Failed: return "failed";
+    }
+    return "unknown";
+}
+
+AsyncDetector::AsyncDetector(shared_ptr<ObjectDetector> detector)
+    : detector_(move(detector)), memory_budget_mb_(0), model_generation_(1), last_inference_generation_(0),
+      next_ticket_(1), running_(false) {}
+
+AsyncDetector::~AsyncDetector() {
+    stop();
+}
+
+void AsyncDetector::start() {
+    if (running_ || detector_ == nullptr) {
+        return;
+    }
+    
+    running_ = true;
+    worker_ = thread(&AsyncDetector::workerThread, this);
+}
+
+void AsyncDetector::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    // 読み込み中のモデルがあれば完了を待つ（cv::dnnの読み込みは中断できない）
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+}
+
+uint64_t AsyncDetector::submit(const Mat& frame, uint64_t frame_seq, const Rect& roi, uint64_t capture_us) {
+    if (!running_ || frame.empty()) {
+        return 0;
+    }
+    
+    Rect region = roi & Rect(0, 0, frame.cols, frame.rows);
+    bool use_roi = !roi.empty() && region.area() > 0;
+    
+    Slot* slot = nullptr;
+    uint64_t ticket = 0;
+    shared_ptr<ObjectDetector> detector;
+    {
+        lock_guard<mutex> lock(mutex_);
+        
+        // 新しいモデルの準備ができていればフレームの境目で差し替える
+        if (pending_detector_) {
+            detector_ = move(pending_detector_);
+            model_generation_++;
+            swap_status_.state = ModelSwapStatus::State::Swapped;
+            cout << "検出モデルを切り替えました: " << swap_status_.model_path << endl;
+        }
+        detector = detector_;
+        
+        for (auto& s : slots_) {
+            if (s.state == SlotState::Free) {
+                slot = &s;
+                break;
+            }
+        }
+        // 空きがなければ推論待ちの古い方を新しいフレームで置き換える
+        if (slot == nullptr) {
+            for (auto& s : slots_) {
+                if (s.state == SlotState::Pending && (slot == nullptr || s.ticket < slot->ticket)) {
+                    slot = &s;
+                }
+            }
+        }
+        if (slot == nullptr) {
+            return 0;
+        }
+        
+        ticket = next_ticket_++;
+        slot->ticket = ticket;
+        slot->frame_seq = frame_seq;
+        slot->frame_time = chrono::steady_clock::now();
+        slot->capture_us = capture_us;
+        slot->frame_size = use_roi ? region.size() : frame.size();
+        slot->roi = use_roi ? region : Rect();
+        slot->detector = detector;
+        slot->generation = model_generation_;
+        slot->state = SlotState::Filling;
+    }
+    
+    // 前処理はロック外で行う（ワーカーはもう一方のblobで推論を続けられる）
+    if (use_roi) {
+        detector->preprocess(frame(region), slot->blob, detector->inputSizeFor(region.size(), frame.size()));
+    } else {
+        detector->preprocess(frame, slot->blob);
+    }
+    
+    {
+        lock_guard<mutex> lock(mutex_);
+        slot->state = SlotState::Pending;
+    }
+    cv_.notify_one();
+    
+    return ticket;
+}
+
+TicketState AsyncDetector::poll(uint64_t ticket, DetectionResult* result) {
+    lock_guard<mutex> lock(mutex_);
+    
+    for (const auto& r : results_) {
+        if (r.ticket == ticket) {
+            if (result) {
+                *result = r;
+            }
+            return TicketState::Done;
+        }
+    }
+    
+    for (const auto& s : slots_) {
+        if (s.state != SlotState::Free && s.ticket == ticket) {
+            return TicketState::Pending;
+        }
+    }
+    
+    return TicketState::Dropped;
+}
+
+bool AsyncDetector::latest(DetectionResult& result) {
+    lock_guard<mutex> lock(mutex_);
+    if (results_.empty()) {
+        return false;
+    }
+    result = results_.back();
+    return true;
+}
+
+bool AsyncDetector::isBusy() {
+    lock_guard<mutex> lock(mutex_);
+    for (const auto& s : slots_) {
+        if (s.state != SlotState::Free) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool AsyncDetector::hasPendingFrame() {
+    lock_guard<mutex> lock(mutex_);
+    for (const auto& s : slots_) {
+        if (s.state == SlotState::Filling || s.state == SlotState::Pending) {
+            return true;
+        }
+    }
+    return false;
+}
+
+shared_ptr<ObjectDetector> AsyncDetector::detector() {
+    lock_guard<mutex> lock(mutex_);
+    return detector_;
+}
+
+ModelSwapStatus AsyncDetector::swapStatus() {
+    lock_guard<mutex> lock(mutex_);
+    return swap_status_;
+}
+
+bool AsyncDetector::loadModelAsync(const string& model_path, const string& labels_path) {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_ || swap_status_.state == ModelSwapStatus::State::Loading ||
+            swap_status_.state == ModelSwapStatus::State::Ready) {
+            return false;
+        }
+        swap_status_ = ModelSwapStatus();
+        swap_status_.state = ModelSwapStatus::State::Loading;
+        swap_status_.model_path = model_path;
+    }
+    
+    // 前回の読み込みスレッドは状態を更新し終えているので、ここでの待ちは一瞬
+    if (loader_.joinable()) {
+        loader_.join();
+    }
+    loader_ = thread(&AsyncDetector::loaderThread, this, model_path, labels_path);
+    return true;
+}
+
+void AsyncDetector::loaderThread(string model_path, string labels_path) {
+    shared_ptr<ObjectDetector> current = detector();
+    float conf_threshold = current ? current->confidenceThreshold() : 0.5f;
+    
+    // 旧モデルが常駐したまま読み込むので、その状態で予算に収まるモデルを選ぶ（収まらなければ軽いモデルへ）
+    string selected = selectModelWithinBudget(model_path, memory_budget_mb_);
+    if (selected.empty()) {
+        lock_guard<mutex> lock(mutex_);
+        swap_status_.state = ModelSwapStatus::State::Failed;
+        swap_status_.error = "memory budget exceeded";
+        return;
+    }
+    if (selected != model_path) {
+        lock_guard<mutex> lock(mutex_);
+        swap_status_.model_path = selected;
+    }
+    model_path = selected;
+    
+    shared_ptr<ObjectDetector> next;
+    double load_ms = 0.0;
+    double warmup_ms = 0.0;
+    try {
+        auto t0 = chrono::steady_clock::now();
+        size_t rss_before = readRssKb();
+        next = make_shared<ObjectDetector>(model_path, labels_path, conf_threshold);
+        cout << "モデル読み込みによるRSS増加: " << ((double)readRssKb() - (double)rss_before) / 1024.0 << "MB" << endl;
+        if (current) {
+            next->setNmsConfig(current->nmsConfig());
+        }
+        auto t1 = chrono::steady_clock::now();
+        
+        // ダミー入力で1回推論し、レイヤーのバッファ確保を切り替え前に済ませておく
+        Mat dummy(next->inputSize(), next->inputSize(), CV_8UC3, Scalar::all(0));
+        next->detect(dummy);
+        auto t2 = chrono::steady_clock::now();
+        
+        load_ms = chrono::duration<double, milli>(t1 - t0).count();
+        warmup_ms = chrono::duration<double, milli>(t2 - t1).count();
+    } catch (const exception& e) {
+        cerr << "モデルの読み込みに失敗しました（現在のモデルで継続）: " << model_path << " (" << e.what() << ")" << endl;
+        lock_guard<mutex> lock(mutex_);
+        swap_status_.state = ModelSwapStatus::State::Failed;
+        swap_status_.error = e.what();
+        return;
+    }
+    
+    cout << "検出モデルの準備ができました: " << model_path
+         << "（読み込み " << load_ms << "ms、ウォームアップ " << warmup_ms << "ms）" << endl;
+    
+    lock_guard<mutex> lock(mutex_);
+    swap_status_.load_ms = load_ms;
+    swap_status_.warmup_ms = warmup_ms;
+    if (!running_) {
+        swap_status_.state = ModelSwapStatus::State::Failed;
+        swap_status_.error = "stopped";
+        return;
+    }
+    pending_detector_ = move(next);
+    swap_status_.state = ModelSwapStatus::State::Ready;
+}
+
+void AsyncDetector::workerThread() {
+    while (true) {
+        Slot* slot = nullptr;
+        {
+            unique_lock<mutex> lock(mutex_);
+            cv_.wait(lock, [this] {
+                if (!running_) {
+                    return true;
+                }
+                for (const auto& s : slots_) {
+                    if (s.state == SlotState::Pending) {
+                        return true;
+                    }
+                }
+                return false;
+            });
+            
+            if (!running_) {
+                break;
+            }
+            
+            for (auto& s : slots_) {
+                if (s.state == SlotState::Pending && (slot == nullptr || s.ticket < slot->ticket)) {
+                    slot = &s;
+                }
+            }
+            slot->state = SlotState::Running;
+        }
+        
+        ObjectDetector* detector = slot->detector.get();
+        auto t0 = chrono::steady_clock::now();
+        
+        // 切り替え後に新しいモデルで最初に推論する時、旧モデルの最後の推論からの間隔を記録
+        // （旧モデルの解放後に同じアドレスへ新モデルが確保されることがあるため、ポインタではなく世代で比べる）
+        uint64_t generation = slot->generation;
+        if (last_inference_generation_ != 0 && generation != last_inference_generation_) {
+            lock_guard<mutex> lock(mutex_);
+            if (swap_status_.state == ModelSwapStatus::State::Swapped && swap_status_.swap_gap_ms < 0.0) {
+                swap_status_.swap_gap_ms = chrono::duration<double, milli>(t0 - last_inference_end_).count();
+                cout << "モデル切り替えの推論間隔: " << swap_status_.swap_gap_ms << "ms" << endl;
+            }
+        }
+        
+        DetectionResult result;
+        result.ticket = slot->ticket;
+        result.frame_seq = slot->frame_seq;
+        result.frame_time = slot->frame_time;
+        result.capture_us = slot->capture_us;
+        result.roi = slot->roi;
+        
+        try {
+            result.objects = detector->detectBlob(slot->blob, slot->frame_size);
+        } catch (const exception& e) {
+            cerr << "物体検出エラー: " << e.what() << endl;
+        }
+        
+        // 切り出し領域の座標をフレーム全体の座標に戻す
+        if (!result.roi.empty()) {
+            for (auto& obj : result.objects) {
+                obj.bbox.x += result.roi.x;
+                obj.bbox.y += result.roi.y;
+            }
+        }
+        last_inference_end_ = chrono::steady_clock::now();
+        last_inference_generation_ = generation;
+        result.inference_ms = chrono::duration<double, milli>(last_inference_end_ - t0).count();
+        
+        // 旧モデルはここで最後の参照が外れればロック外で解放される
+        shared_ptr<ObjectDetector> released;
+        {
+            lock_guard<mutex> lock(mutex_);
+            results_.push_back(move(result));
+            while (results_.size() > kResultHistory) {
+                results_.pop_front();
+            }
+            released = move(slot->detector);
+            slot->state = SlotState::Free;
+        }
+    }
+}
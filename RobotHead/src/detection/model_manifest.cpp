@@ -0,0 +1,134 @@
+/**
+ * @file model_manifest.cpp
+ * @brief Implementation of model manifests and memory-budgeted model selection
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "detection/model_manifest.h"
+#include "platform/mapped_file.h"
+#include "platform/process_stats.h"
+#include <opencv2/core.hpp>
+#include <iostream>
+#include <set>
+
+using namespace cv;
+using namespace std;
+
+// 見積もり: 重み（読み込み後にレイヤーへ展開・融合されるため約2倍）+ 中間バッファ
+static const double kWeightsFactor = 2.0;
+static const double kActivationMb = 16.0;
+// スワップを避けるため残しておく空きメモリ
+static const double kReserveMb = 32.0;
+
+string ModelManifest::pathFor(const string& model_path) {
+    size_t slash = model_path.find_last_of('/');
+    size_t dot = model_path.find_last_of('.');
+    if (dot == string::npos || (slash != string::npos && dot < slash)) {
+        return model_path + ".yaml";
+    }
+    return model_path.substr(0, dot) + ".yaml";
+}
+
+bool ModelManifest::load(const string& model_path) {
+    FileStorage fs;
+    try {
+        if (!fs.open(pathFor(model_path), FileStorage::READ)) {
+            return false;
+        }
+    } catch (const cv::Exception& e) {
+        cerr << "マニフェストの読み込みに失敗しました: " << pathFor(model_path) << " (" << e.what() << ")" << endl;
+        return false;
+    }
+
+    if (!fs["input_size"].empty()) fs["input_size"] >> input_size;
+    if (!fs["layout"].empty()) fs["layout"] >> layout;
+    if (!fs["num_classes"].empty()) fs["num_classes"] >> num_classes;
+    if (!fs["labels"].empty()) fs["labels"] >> labels;
+    if (!fs["quantization"].empty()) fs["quantization"] >> quantization;
+    if (!fs["latency_ms"].empty()) fs["latency_ms"] >> latency_ms;
+    if (!fs["rss_mb"].empty()) fs["rss_mb"] >> rss_mb;
+    if (!fs["fallback"].empty()) fs["fallback"] >> fallback;
+    fs.release();
+    return true;
+}
+
+bool ModelManifest::save(const string& model_path) const {
+    FileStorage fs;
+    try {
+        if (!fs.open(pathFor(model_path), FileStorage::WRITE)) {
+            return false;
+        }
+    } catch (const cv::Exception& e) {
+        cerr << "マニフェストを書き込めません: " << pathFor(model_path) << " (" << e.what() << ")" << endl;
+        return false;
+    }
+
+    fs << "input_size" << input_size;
+    fs << "layout" << layout;
+    fs << "num_classes" << num_classes;
+    fs << "labels" << labels;
+    fs << "quantization" << quantization;
+    fs << "latency_ms" << latency_ms;
+    fs << "rss_mb" << rss_mb;
+    fs << "fallback" << fallback;
+    fs.release();
+    return true;
+}
+
+string resolveModelRelative(const string& model_path, const string& relative) {
+    if (relative.empty() || relative[0] == '/') {
+        return relative;
+    }
+    size_t slash = model_path.find_last_of('/');
+    if (slash == string::npos) {
+        return relative;
+    }
+    return model_path.substr(0, slash + 1) + relative;
+}
+
+double estimateModelRssMb(const string& model_path, const ModelManifest* manifest) {
+    if (manifest != nullptr && manifest->rss_mb > 0.0) {
+        return manifest->rss_mb;
+    }
+
+    // Darknetは重みファイル（.weights）がサイズの大半
+    double file_mb = fileSizeBytes(model_path) / (1024.0 * 1024.0);
+    return file_mb * kWeightsFactor + kActivationMb;
+}
+
+string selectModelWithinBudget(const string& model_path, size_t budget_mb) {
+    set<string> visited;
+    string path = model_path;
+
+    while (!path.empty() && visited.insert(path).second) {
+        ModelManifest manifest;
+        bool has_manifest = manifest.load(path);
+        double estimate_mb = estimateModelRssMb(path, has_manifest ? &manifest : nullptr);
+        double rss_mb = readRssKb() / 1024.0;
+        double available_mb = readMemAvailableKb() / 1024.0;
+
+        bool over_budget = budget_mb > 0 && rss_mb + estimate_mb > (double)budget_mb;
+        bool swap_risk = available_mb > 0.0 && estimate_mb + kReserveMb > available_mb;
+
+        cout << "モデルのメモリ見積もり: " << path << " " << (int)estimate_mb << "MB"
+             << (has_manifest && manifest.rss_mb > 0.0 ? "（実測）" : "（ファイルサイズから推定）")
+             << " 現在RSS " << (int)rss_mb << "MB 空き " << (int)available_mb << "MB";
+        if (budget_mb > 0) {
+            cout << " 予算 " << budget_mb << "MB";
+        }
+        cout << endl;
+
+        if (!over_budget && !swap_risk) {
+            return path;
+        }
+
+        cerr << "メモリ" << (over_budget ? "予算" : "の空き") << "を超えるため読み込みません: " << path << endl;
+        path = (has_manifest && !manifest.fallback.empty()) ? resolveModelRelative(path, manifest.fallback) : "";
+        if (!path.empty()) {
+            cout << "代わりに軽いモデルを試します: " << path << endl;
+        }
+    }
+
+    return "";
+}
@@ -0,0 +1,163 @@
+/**
+ * @file motion_gate.cpp
+ * @brief Implementation of the frame-differencing motion gate
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "detection/motion_gate.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <sstream>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+uint32_t sumAbsDiffU8(const uint8_t* a, const uint8_t* b, size_t n) {
+    size_t i = 0;
+    uint32_t sum = 0;
+
+#if defined(__ARM_NEON)
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t d = vabdq_u8(vld1q_u8(a + i), vld1q_u8(b + i));
+        acc = vpadalq_u16(acc, vpaddlq_u8(d));
+    }
+#if defined(__aarch64__)
+    sum = vaddvq_u32(acc);
+#else
+    uint32x2_t acc2 = vadd_u32(vget_low_u32(acc), vget_high_u32(acc));
+    sum = vget_lane_u32(vpadd_u32(acc2, acc2), 0);
+#endif
+#elif defined(__SSE2__)
+    __m128i acc = _mm_setzero_si128();
+    for (; i + 16 <= n; i += 16) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(va, vb));
+    }
+    sum = (uint32_t)_mm_cvtsi128_si32(acc) + (uint32_t)_mm_cvtsi128_si32(_mm_srli_si128(acc, 8));
+#endif
+
+    for (; i < n; ++i) {
+        sum += (uint32_t)abs((int)a[i] - (int)b[i]);
+    }
+    return sum;
+}
+
+MotionGate::MotionGate()
+    : current_(0), has_previous_(false), enabled_(true), change_latched_(true),
+      has_inferred_(false), max_staleness_(3000), sigma_k_(3.0f), min_delta_(2.0f),
+      noise_mean_(0.0f), noise_var_(1.0f), last_score_(0.0f),
+      frames_(0), runs_motion_(0), runs_stale_(0), runs_disabled_(0), skipped_(0) {}
+
+void MotionGate::setEnabled(bool enabled) {
+    // 再有効化時は自己運動中のフレームとの差分を使わないよう参照をリセット
+    if (enabled && !enabled_) {
+        has_previous_ = false;
+    }
+    enabled_ = enabled;
+}
+
+float MotionGate::threshold() const {
+    return noise_mean_ + sigma_k_ * sqrt(noise_var_) + min_delta_;
+}
+
+bool MotionGate::update(const Mat& frame) {
+    frames_++;
+    if (frame.empty()) {
+        return false;
+    }
+
+    // 縦横比に合わせて縮小（回転後の縦長画像なら64x80）
+    Size small_size = (frame.cols < frame.rows) ? Size(64, 80) : Size(80, 64);
+    resize(frame, small_, small_size, 0, 0, INTER_AREA);
+
+    int next = current_ ^ 1;
+    if (small_.channels() == 3) {
+        cvtColor(small_, luma_[next], COLOR_BGR2GRAY);
+    } else {
+        small_.copyTo(luma_[next]);
+    }
+    current_ = next;
+
+    if (!has_previous_) {
+        has_previous_ = true;
+        change_latched_ = true;
+        return true;
+    }
+
+    const Mat& cur = luma_[current_];
+    const Mat& prev = luma_[current_ ^ 1];
+    int tile_w = cur.cols / kGrid;
+    int tile_h = cur.rows / kGrid;
+
+    // タイルごとの平均差分の最大値
+    float score = 0.0f;
+    for (int ty = 0; ty < kGrid; ++ty) {
+        for (int tx = 0; tx < kGrid; ++tx) {
+            uint32_t sad = 0;
+            for (int y = ty * tile_h; y < (ty + 1) * tile_h; ++y) {
+                sad += sumAbsDiffU8(cur.ptr<uint8_t>(y) + tx * tile_w, prev.ptr<uint8_t>(y) + tx * tile_w, tile_w);
+            }
+            score = max(score, (float)sad / (float)(tile_w * tile_h));
+        }
+    }
+    last_score_ = score;
+
+    bool changed = score > threshold();
+    if (changed) {
+        change_latched_ = true;
+    } else {
+        // 静止と判定したフレームでノイズの平均・分散を更新
+        float d = score - noise_mean_;
+        noise_mean_ += 0.05f * d;
+        noise_var_ = 0.95f * (noise_var_ + 0.05f * d * d);
+    }
+    return changed;
+}
+
+bool MotionGate::shouldRun(Clock::time_point now) {
+    if (!enabled_) {
+        runs_disabled_++;
+        return true;
+    }
+    if (change_latched_) {
+        runs_motion_++;
+        return true;
+    }
+    if (!has_inferred_ || now - last_inference_ >= max_staleness_) {
+        runs_stale_++;
+        return true;
+    }
+    skipped_++;
+    return false;
+}
+
+void MotionGate::markInferred(Clock::time_point now) {
+    change_latched_ = false;
+    has_inferred_ = true;
+    last_inference_ = now;
+}
+
+string MotionGate::statsSummary() const {
+    uint64_t decisions = runs_motion_ + runs_stale_ + runs_disabled_ + skipped_;
+    ostringstream oss;
+    oss.precision(1);
+    oss << fixed
+        << "動きゲート: フレーム" << frames_
+        << " 判定" << decisions << "回"
+        << " 変化" << runs_motion_ << " 期限切れ" << runs_stale_
+        << " 自己運動中" << runs_disabled_
+        << " スキップ" << (decisions ? skipped_ * 100.0 / decisions : 0.0) << "%"
+        << " しきい値" << threshold();
+    return oss.str();
+}
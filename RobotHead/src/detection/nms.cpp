@@ -0,0 +1,186 @@
+/**
+ * @file nms.cpp
+ * @brief Implementation of the SoA non-maximum suppression
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "detection/nms.h"
+#include <algorithm>
+#include <numeric>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+// 候補の箱が採用済みのいずれかと閾値を超えて重なるか（nkは4の倍数にパディング済みの件数まで読む）
+static bool overlapsKept(float x1, float y1, float x2, float y2, float area, int cls,
+                         const float* kx1, const float* ky1, const float* kx2, const float* ky2,
+                         const float* karea, const int* kclass, int nk,
+                         float iou_threshold, bool class_aware) {
+    const float k_inter = 1.0f + iou_threshold;
+    int j = 0;
+
+#if defined(__ARM_NEON)
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t bx1 = vdupq_n_f32(x1), by1 = vdupq_n_f32(y1);
+    const float32x4_t bx2 = vdupq_n_f32(x2), by2 = vdupq_n_f32(y2);
+    const float32x4_t barea = vdupq_n_f32(area);
+    const float32x4_t vk = vdupq_n_f32(k_inter), vth = vdupq_n_f32(iou_threshold);
+    const int32x4_t bcls = vdupq_n_s32(cls);
+    for (; j < nk; j += 4) {
+        float32x4_t iw = vmaxq_f32(vsubq_f32(vminq_f32(bx2, vld1q_f32(kx2 + j)), vmaxq_f32(bx1, vld1q_f32(kx1 + j))), zero);
+        float32x4_t ih = vmaxq_f32(vsubq_f32(vminq_f32(by2, vld1q_f32(ky2 + j)), vmaxq_f32(by1, vld1q_f32(ky1 + j))), zero);
+        float32x4_t inter = vmulq_f32(iw, ih);
+        uint32x4_t over = vcgtq_f32(vmulq_f32(inter, vk), vmulq_f32(vth, vaddq_f32(barea, vld1q_f32(karea + j))));
+        if (class_aware) {
+            over = vandq_u32(over, vceqq_s32(bcls, vld1q_s32(kclass + j)));
+        }
+#if defined(__aarch64__)
+        if (vmaxvq_u32(over) != 0) return true;
+#else
+        uint32x2_t m = vorr_u32(vget_low_u32(over), vget_high_u32(over));
+        if ((vget_lane_u32(m, 0) | vget_lane_u32(m, 1)) != 0) return true;
+#endif
+    }
+#elif defined(__SSE2__)
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 bx1 = _mm_set1_ps(x1), by1 = _mm_set1_ps(y1);
+    const __m128 bx2 = _mm_set1_ps(x2), by2 = _mm_set1_ps(y2);
+    const __m128 barea = _mm_set1_ps(area);
+    const __m128 vk = _mm_set1_ps(k_inter), vth = _mm_set1_ps(iou_threshold);
+    const __m128i bcls = _mm_set1_epi32(cls);
+    for (; j < nk; j += 4) {
+        __m128 iw = _mm_max_ps(_mm_sub_ps(_mm_min_ps(bx2, _mm_loadu_ps(kx2 + j)), _mm_max_ps(bx1, _mm_loadu_ps(kx1 + j))), zero);
+        __m128 ih = _mm_max_ps(_mm_sub_ps(_mm_min_ps(by2, _mm_loadu_ps(ky2 + j)), _mm_max_ps(by1, _mm_loadu_ps(ky1 + j))), zero);
+        __m128 inter = _mm_mul_ps(iw, ih);
+        __m128 over = _mm_cmpgt_ps(_mm_mul_ps(inter, vk), _mm_mul_ps(vth, _mm_add_ps(barea, _mm_loadu_ps(karea + j))));
+        if (class_aware) {
+            __m128i same = _mm_cmpeq_epi32(bcls, _mm_loadu_si128(reinterpret_cast<const __m128i*>(kclass + j)));
+            over = _mm_and_ps(over, _mm_castsi128_ps(same));
+        }
+        if (_mm_movemask_ps(over) != 0) return true;
+    }
+#else
+    for (; j < nk; ++j) {
+        if (class_aware && kclass[j] != cls) continue;
+        float iw = max(0.0f, min(x2, kx2[j]) - max(x1, kx1[j]));
+        float ih = max(0.0f, min(y2, ky2[j]) - max(y1, ky1[j]));
+        float inter = iw * ih;
+        if (inter * k_inter > iou_threshold * (area + karea[j])) return true;
+    }
+#endif
+
+    return false;
+}
+
+NmsBuffer::NmsBuffer() {
+    reserve(1024);
+}
+
+void NmsBuffer::reserve(size_t capacity) {
+    x1_.reserve(capacity);
+    y1_.reserve(capacity);
+    x2_.reserve(capacity);
+    y2_.reserve(capacity);
+    area_.reserve(capacity);
+    score_.reserve(capacity);
+    class_id_.reserve(capacity);
+    order_.reserve(capacity);
+    keep_.reserve(capacity);
+}
+
+void NmsBuffer::clear() {
+    // clear()は容量を保持するため、次フレームのpush()で再確保は起きない
+    x1_.clear();
+    y1_.clear();
+    x2_.clear();
+    y2_.clear();
+    area_.clear();
+    score_.clear();
+    class_id_.clear();
+    keep_.clear();
+}
+
+void NmsBuffer::push(float left, float top, float width, float height, float score, int class_id) {
+    x1_.push_back(left);
+    y1_.push_back(top);
+    x2_.push_back(left + width);
+    y2_.push_back(top + height);
+    area_.push_back(max(0.0f, width) * max(0.0f, height));
+    score_.push_back(score);
+    class_id_.push_back(class_id);
+}
+
+Rect NmsBuffer::box(int i) const {
+    return Rect((int)x1_[i], (int)y1_[i], (int)(x2_[i] - x1_[i]), (int)(y2_[i] - y1_[i]));
+}
+
+const vector<int>& NmsBuffer::run(const NmsConfig& config) {
+    keep_.clear();
+    int n = (int)size();
+    if (n == 0) {
+        return keep_;
+    }
+
+    // スコア降順（同点はpush順）に並べる。top_k指定時は上位だけを部分ソート
+    order_.resize(n);
+    iota(order_.begin(), order_.end(), 0);
+    auto by_score = [this](int a, int b) {
+        return score_[a] > score_[b] || (score_[a] == score_[b] && a < b);
+    };
+    int limit = (config.top_k > 0 && config.top_k < n) ? config.top_k : n;
+    if (limit < n) {
+        partial_sort(order_.begin(), order_.begin() + limit, order_.end(), by_score);
+    } else {
+        sort(order_.begin(), order_.end(), by_score);
+    }
+
+    size_t padded = ((size_t)limit + 3) & ~(size_t)3;
+    if (kx1_.size() < padded) {
+        kx1_.resize(padded);
+        ky1_.resize(padded);
+        kx2_.resize(padded);
+        ky2_.resize(padded);
+        karea_.resize(padded);
+        kclass_.resize(padded);
+    }
+
+    bool class_aware = (config.mode == NmsMode::ClassAware);
+    int nk = 0;
+    for (int r = 0; r < limit; ++r) {
+        int i = order_[r];
+        if (overlapsKept(x1_[i], y1_[i], x2_[i], y2_[i], area_[i], class_id_[i],
+                         kx1_.data(), ky1_.data(), kx2_.data(), ky2_.data(),
+                         karea_.data(), kclass_.data(), nk, config.iou_threshold, class_aware)) {
+            continue;
+        }
+
+        // 4件単位の新しいグループに入る時は残りを面積0・クラス-1で埋める（SIMDで読んでも重ならない）
+        if ((nk & 3) == 0) {
+            for (int p = nk; p < nk + 4; ++p) {
+                kx1_[p] = ky1_[p] = kx2_[p] = ky2_[p] = karea_[p] = 0.0f;
+                kclass_[p] = -1;
+            }
+        }
+        kx1_[nk] = x1_[i];
+        ky1_[nk] = y1_[i];
+        kx2_[nk] = x2_[i];
+        ky2_[nk] = y2_[i];
+        karea_[nk] = area_[i];
+        kclass_[nk] = class_id_[i];
+        nk++;
+        keep_.push_back(i);
+
+        if (config.max_detections > 0 && nk >= config.max_detections) {
+            break;
+        }
+    }
+
+    return keep_;
+}
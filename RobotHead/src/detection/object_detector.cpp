@@ -1,25 +1,49 @@
 #include "object_detector.h"
+#include "platform/mapped_file.h"
 #include <fstream>
 #include <iostream>
+#include <algorithm>
+#include <chrono>
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 // OpenCV 4.xのDNN名前空間を使用
 using namespace cv;
 using namespace cv::dnn;
 
 ObjectDetector::ObjectDetector(const string& model_path, const string& labels_path, float conf_threshold)
-    : confidence_threshold_(conf_threshold), is_yolov8_(false), input_size_(640) {
+    : confidence_threshold_(conf_threshold), is_yolov8_(false), is_quantized_(false), input_size_(640),
+      has_manifest_(false) {
     
     // モデルを読み込み
     cout << "物体検出モデルを読み込み中..." << endl;
     
+    // モデルと同じディレクトリのマニフェスト（入力サイズ・出力形式・量子化・実測コスト）
+    has_manifest_ = manifest_.load(model_path);
+    if (has_manifest_) {
+        cout << "マニフェストを読み込みました: " << ModelManifest::pathFor(model_path) << endl;
+    }
+    
     // 拡張子でモデルタイプを判定
     if (model_path.find(".onnx") != string::npos) {
         // ONNX (YOLOv8など) モデル
-        net_ = readNetFromONNX(model_path);
+        // mmapしたバッファから読み込む（ファイル全体のヒープへのコピーを避ける）
+        MappedFile file;
+        if (file.open(model_path)) {
+            net_ = readNetFromONNX(file.data(), file.size());
+        } else {
+            net_ = readNetFromONNX(model_path);
+        }
         is_yolov8_ = true;
         
-        // ファイル名から入力サイズを推定（例: yolov8n_320.onnxなら320）
-        if (model_path.find("_320") != string::npos) {
+        if (has_manifest_ && manifest_.input_size > 0) {
+            input_size_ = manifest_.input_size;
+        } else if (model_path.find("_320") != string::npos) {
+            // マニフェストが無ければファイル名から入力サイズを推定（例: yolov8n_320.onnxなら320）
             input_size_ = 320;
         } else if (model_path.find("_416") != string::npos) {
             input_size_ = 416;
@@ -28,13 +52,34 @@ ObjectDetector::ObjectDetector(const string& model_path, const string& labels_pa
         }
         cout << "YOLOv8 ONNXモデル検出（入力サイズ: " << input_size_ << "x" << input_size_ << "）" << endl;
         
+        // 固定入力のグラフなら入力層の形状（NCHW）とマニフェストのinput_sizeを比べる（可変入力は確認しない）
+        if (has_manifest_ && manifest_.input_size > 0) {
+            try {
+                vector<MatShape> in_shapes, out_shapes;
+                net_.getLayerShapes(MatShape(), 0, in_shapes, out_shapes);
+                if (!out_shapes.empty() && out_shapes[0].size() == 4 && out_shapes[0][2] > 0 && out_shapes[0][3] > 0 &&
+                    (out_shapes[0][2] != manifest_.input_size || out_shapes[0][3] != manifest_.input_size)) {
+                    cerr << "警告: マニフェストの入力サイズ（" << manifest_.input_size << "）とモデルの入力（"
+                         << out_shapes[0][3] << "x" << out_shapes[0][2] << "）が一致しません" << endl;
+                }
+            } catch (const cv::Exception&) {
+                // 入力形状を持たないグラフ
+            }
+        }
+        // INT8量子化モデル（export_yolov8_int8.pyの出力）の判定はバックエンド設定後に行う
+        
     } else if (model_path.find(".weights") != string::npos) {
         // Darknet (YOLOv3/v4) モデル
         string cfg = model_path;
         cfg.replace(cfg.find(".weights"), 8, ".cfg");
-        net_ = readNetFromDarknet(cfg, model_path);
+        MappedFile cfg_file, weights_file;
+        if (cfg_file.open(cfg) && weights_file.open(model_path)) {
+            net_ = readNetFromDarknet(cfg_file.data(), cfg_file.size(), weights_file.data(), weights_file.size());
+        } else {
+            net_ = readNetFromDarknet(cfg, model_path);
+        }
         is_yolov8_ = false;
-        input_size_ = 320;
+        input_size_ = (has_manifest_ && manifest_.input_size > 0) ? manifest_.input_size : 320;
         cout << "Darknet YOLOモデル検出" << endl;
         
     } else if (model_path.find(".tflite") != string::npos) {
@@ -65,8 +110,31 @@ ObjectDetector::ObjectDetector(const string& model_path, const string& labels_pa
     net_.setPreferableBackend(DNN_BACKEND_OPENCV);
     net_.setPreferableTarget(DNN_TARGET_CPU);
     
-    // ラベルを読み込み
-    loadLabels(labels_path);
+    // INT8量子化モデルの判定（OpenCVのInt8レイヤーはDNN_BACKEND_OPENCV/CPUで整数カーネル実行される）
+    detectQuantization();
+    if (is_quantized_) {
+        cout << "INT8量子化モデルを検出しました（整数カーネルで推論）" << endl;
+    }
+    if (has_manifest_ && !manifest_.quantization.empty() &&
+        (manifest_.quantization != "fp32") != is_quantized_) {
+        cerr << "警告: マニフェストの量子化（" << manifest_.quantization << "）とモデルの内容が一致しません" << endl;
+    }
+    if (has_manifest_ && !manifest_.layout.empty() && (manifest_.layout == "yolov8") != is_yolov8_) {
+        cerr << "警告: マニフェストの出力形式（" << manifest_.layout << "）はこの拡張子のモデルでは使えません" << endl;
+    }
+    
+    output_names_ = net_.getUnconnectedOutLayersNames();
+    
+    // ラベルを読み込み（指定ファイルが無ければマニフェストのラベルを使う）
+    string labels = labels_path;
+    if (has_manifest_ && !manifest_.labels.empty() && !ifstream(labels_path).good()) {
+        labels = resolveModelRelative(model_path, manifest_.labels);
+    }
+    loadLabels(labels);
+    if (has_manifest_ && manifest_.num_classes > 0 && manifest_.num_classes != (int)class_names_.size()) {
+        cerr << "警告: ラベル数（" << class_names_.size() << "）がマニフェストのクラス数（"
+             << manifest_.num_classes << "）と異なります" << endl;
+    }
     
     cout << "物体検出モデルの読み込みが完了しました（" << class_names_.size() << "クラス）" << endl;
 }
@@ -74,6 +142,34 @@ ObjectDetector::ObjectDetector(const string& model_path, const string& labels_pa
 ObjectDetector::~ObjectDetector() {
 }
 
+void ObjectDetector::detectQuantization() {
+    vector<String> layer_types;
+    net_.getLayerTypes(layer_types);
+    
+    // ONNXのQuantizeLinear/DequantizeLinear/QLinear*はQuantize/Dequantize/*Int8レイヤーとして取り込まれる
+    is_quantized_ = false;
+    for (const auto& type : layer_types) {
+        if (type == "Quantize" || type == "Dequantize" ||
+            (type.size() > 4 && type.compare(type.size() - 4, 4, "Int8") == 0)) {
+            is_quantized_ = true;
+            break;
+        }
+    }
+    
+    if (!is_quantized_) {
+        return;
+    }
+    
+    // 出力がINT8のまま返るモデル用に逆量子化パラメータを取得しておく
+    // （最終段がDequantizeLinearのモデルではFP32出力になるため不要）
+    try {
+        net_.getOutputDetails(output_scales_, output_zero_points_);
+    } catch (const cv::Exception&) {
+        output_scales_.clear();
+        output_zero_points_.clear();
+    }
+}
+
 void ObjectDetector::loadLabels(const string& labels_path) {
     ifstream file(labels_path);
     if (!file.is_open()) {
@@ -89,88 +185,296 @@ void ObjectDetector::loadLabels(const string& labels_path) {
 }
 
 vector<DetectedObject> ObjectDetector::detect(const Mat& frame) {
+    if (frame.empty()) {
+        return vector<DetectedObject>();
+    }
+    
+    auto t0 = chrono::steady_clock::now();
+    preprocess(frame, blob_);
+    double preprocess_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    
+    vector<DetectedObject> detections = detectBlob(blob_, frame.size());
+    timing_.preprocess_ms = preprocess_ms;
+    return detections;
+}
+
+void ObjectDetector::preprocess(const Mat& frame, Mat& blob, int input_size) const {
+    int size = (input_size > 0 && supportsVariableInput()) ? input_size : input_size_;
+    
+    // 入力画像の前処理（blobは同サイズなら再確保されない）
+    blobFromImage(frame, blob, 1/255.0, Size(size, size), Scalar(0, 0, 0), true, false);
+}
+
+int ObjectDetector::inputSizeFor(const Size& region, const Size& frame) const {
+    if (!supportsVariableInput() || frame.width <= 0 || frame.height <= 0) {
+        return input_size_;
+    }
+    
+    // 全体画像の長辺をinput_size_に縮小するのと同じ画素密度を保つ
+    // 入力形状の変化でネットワークの再確保が起きるため、サイズは少数の段階に丸める
+    static const int kBuckets[] = {160, 224};
+    int needed = (int)((double)max(region.width, region.height) * input_size_ / max(frame.width, frame.height));
+    for (int bucket : kBuckets) {
+        if (needed <= bucket && bucket < input_size_) {
+            return bucket;
+        }
+    }
+    return input_size_;
+}
+
+vector<DetectedObject> ObjectDetector::detectBlob(const Mat& blob, Size frame_size) {
     vector<DetectedObject> detections;
+    timing_ = DetectionTiming();
     
-    if (frame.empty()) {
+    if (blob.empty()) {
         return detections;
     }
     
-    // 入力画像の前処理
-    Mat blob = blobFromImage(frame, 1/255.0, Size(input_size_, input_size_), Scalar(0, 0, 0), true, false);
-    
     // モデルに入力
+    auto t0 = chrono::steady_clock::now();
     net_.setInput(blob);
     
     // 推論を実行
     vector<Mat> outputs;
-    net_.forward(outputs, net_.getUnconnectedOutLayersNames());
+    net_.forward(outputs, output_names_);
+    auto t1 = chrono::steady_clock::now();
+    timing_.forward_ms = chrono::duration<double, milli>(t1 - t0).count();
     
     if (is_yolov8_) {
         // YOLOv8の出力形式で解析
-        detections = parseYOLOv8Output(outputs, frame.cols, frame.rows);
+        detections = parseYOLOv8Output(outputs, frame_size.width, frame_size.height);
     } else {
         // YOLOv3/v4の出力形式で解析
-        detections = parseYOLOv3v4Output(outputs, frame.cols, frame.rows);
+        detections = parseYOLOv3v4Output(outputs, frame_size.width, frame_size.height);
     }
     
+    // 解析時間からNMS分（suppressCandidates()で計測）を除いたものをデコード時間とする
+    double parse_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t1).count();
+    timing_.decode_ms = max(0.0, parse_ms - timing_.nms_ms);
+    
     return detections;
 }
 
+// 最大値とその位置（同値なら先頭）。NEON/SSE2で4要素ずつ比較し、レーンごとの位置を保持する
+static int argmaxF32(const float* p, int n, float& best) {
+    int i = 0;
+    int best_i = 0;
+    best = p[0];
+
+#if defined(__ARM_NEON) || defined(__SSE2__)
+    if (n >= 8) {
+        alignas(16) float lane_max[4];
+        alignas(16) int32_t lane_idx[4];
+#if defined(__ARM_NEON)
+        float32x4_t vmax = vld1q_f32(p);
+        const int32_t init[4] = {0, 1, 2, 3};
+        int32x4_t vidx = vld1q_s32(init);
+        int32x4_t cur = vidx;
+        const int32x4_t four = vdupq_n_s32(4);
+        for (i = 4; i + 4 <= n; i += 4) {
+            cur = vaddq_s32(cur, four);
+            float32x4_t v = vld1q_f32(p + i);
+            uint32x4_t gt = vcgtq_f32(v, vmax);
+            vmax = vbslq_f32(gt, v, vmax);
+            vidx = vbslq_s32(gt, cur, vidx);
+        }
+        vst1q_f32(lane_max, vmax);
+        vst1q_s32(lane_idx, vidx);
+#else
+        __m128 vmax = _mm_loadu_ps(p);
+        __m128i vidx = _mm_setr_epi32(0, 1, 2, 3);
+        __m128i cur = vidx;
+        const __m128i four = _mm_set1_epi32(4);
+        for (i = 4; i + 4 <= n; i += 4) {
+            cur = _mm_add_epi32(cur, four);
+            __m128 v = _mm_loadu_ps(p + i);
+            __m128 gt = _mm_cmpgt_ps(v, vmax);
+            __m128i gti = _mm_castps_si128(gt);
+            vmax = _mm_or_ps(_mm_and_ps(gt, v), _mm_andnot_ps(gt, vmax));
+            vidx = _mm_or_si128(_mm_and_si128(gti, cur), _mm_andnot_si128(gti, vidx));
+        }
+        _mm_store_ps(lane_max, vmax);
+        _mm_store_si128(reinterpret_cast<__m128i*>(lane_idx), vidx);
+#endif
+        best = lane_max[0];
+        best_i = lane_idx[0];
+        for (int l = 1; l < 4; l++) {
+            if (lane_max[l] > best || (lane_max[l] == best && lane_idx[l] < best_i)) {
+                best = lane_max[l];
+                best_i = lane_idx[l];
+            }
+        }
+    }
+#endif
+
+    for (; i < n; i++) {
+        if (p[i] > best) {
+            best = p[i];
+            best_i = i;
+        }
+    }
+    return best_i;
+}
+
+void collectDarknetCandidates(const Mat& output, float conf_threshold, int frame_width, int frame_height,
+                              NmsBuffer& nms) {
+    int num_classes = output.cols - 5;
+    if (num_classes <= 0) {
+        return;
+    }
+    
+    // OpenCVのRegionレイヤーはクラス列に objectness × クラス確率 を出力する（閾値未満は0）
+    // クラス列の値は objectness 以下なので、objectness で先に棄却すればクラス走査はごく一部の行だけで済む
+    const float* data = output.ptr<float>();
+    for (int j = 0; j < output.rows; ++j, data += output.cols) {
+        if (data[4] <= conf_threshold) {
+            continue;
+        }
+        
+        float confidence;
+        int class_id = argmaxF32(data + 5, num_classes, confidence);
+        if (confidence <= conf_threshold) {
+            continue;
+        }
+        
+        float width = data[2] * frame_width;
+        float height = data[3] * frame_height;
+        float left = data[0] * frame_width - width / 2;
+        float top = data[1] * frame_height - height / 2;
+        nms.push(left, top, width, height, confidence, class_id);
+    }
+}
+
 vector<DetectedObject> ObjectDetector::parseYOLOv3v4Output(const vector<Mat>& outputs, int frame_width, int frame_height) {
-    vector<DetectedObject> detections;
-    vector<int> class_ids;
-    vector<float> confidences;
-    vector<Rect> boxes;
+    nms_.clear();
     
-    // YOLOv3/v4の結果を解析
+    // YOLOv3/v4の結果を解析（出力ごとに [アンカー数, 5 + クラス数]）
     for (size_t i = 0; i < outputs.size(); ++i) {
-        float* data = (float*)outputs[i].data;
-        for (int j = 0; j < outputs[i].rows; ++j, data += outputs[i].cols) {
-            Mat scores = outputs[i].row(j).colRange(5, outputs[i].cols);
-            Point class_id_point;
-            double confidence;
-            minMaxLoc(scores, 0, &confidence, 0, &class_id_point);
-            
-            if (confidence > confidence_threshold_) {
-                int center_x = (int)(data[0] * frame_width);
-                int center_y = (int)(data[1] * frame_height);
-                int width = (int)(data[2] * frame_width);
-                int height = (int)(data[3] * frame_height);
-                int left = center_x - width / 2;
-                int top = center_y - height / 2;
-                
-                class_ids.push_back(class_id_point.x);
-                confidences.push_back((float)confidence);
-                boxes.push_back(Rect(left, top, width, height));
-            }
-        }
+        collectDarknetCandidates(outputs[i], confidence_threshold_, frame_width, frame_height, nms_);
     }
     
+    return suppressCandidates();
+}
+
+vector<DetectedObject> ObjectDetector::suppressCandidates() {
+    vector<DetectedObject> detections;
+    
     // Non-Maximum Suppression（重複検出の削除）
-    vector<int> indices;
-    dnn::NMSBoxes(boxes, confidences, confidence_threshold_, 0.4, indices);
+    auto t0 = chrono::steady_clock::now();
+    const vector<int>& indices = nms_.run(nms_config_);
+    timing_.nms_ms = chrono::duration<double, milli>(chrono::steady_clock::now() - t0).count();
+    detections.reserve(indices.size());
     
     // 検出結果を追加
-    for (size_t i = 0; i < indices.size(); ++i) {
-        int idx = indices[i];
+    for (int idx : indices) {
         DetectedObject obj;
-        obj.class_id = class_ids[idx];
+        obj.class_id = nms_.classId(idx);
         obj.class_name = (obj.class_id >= 0 && obj.class_id < static_cast<int>(class_names_.size()))
                          ? class_names_[obj.class_id]
                          : "unknown";
-        obj.confidence = confidences[idx];
-        obj.bbox = boxes[idx];
+        obj.confidence = nms_.score(idx);
+        obj.bbox = nms_.box(idx);
         detections.push_back(obj);
     }
     
     return detections;
 }
 
+// YOLOv8出力からアンカーごとの最大クラススコアを求め、閾値を超えた候補を取り出す
+// T = float（FP32出力）または int8_t（INT8出力）。INT8の場合は量子化ドメインのまま
+// 閾値判定を行い、候補になったアンカーの座標だけを逆量子化する
+template <typename T>
+static void collectYOLOv8Candidates(const T* data, bool channel_major, int num_channels, int num_anchors,
+                                    float scale, float zero_point, float conf_threshold,
+                                    float scale_x, float scale_y,
+                                    vector<T>& best_scores, vector<int>& best_classes, NmsBuffer& nms) {
+    int num_classes = num_channels - 4;
+    best_scores.resize(num_anchors);
+    best_classes.assign(num_anchors, 0);
+    
+    if (channel_major) {
+        // [C, N]: クラスを外側に回してアンカー方向に連続アクセス
+        const T* row = data + 4 * num_anchors;
+        std::copy(row, row + num_anchors, best_scores.begin());
+        for (int c = 1; c < num_classes; ++c) {
+            row = data + (4 + c) * num_anchors;
+            for (int i = 0; i < num_anchors; ++i) {
+                if (row[i] > best_scores[i]) {
+                    best_scores[i] = row[i];
+                    best_classes[i] = c;
+                }
+            }
+        }
+    } else {
+        // [N, C]: 行ごとにクラススコアを走査
+        for (int i = 0; i < num_anchors; ++i) {
+            const T* row = data + i * num_channels + 4;
+            T best = row[0];
+            int best_c = 0;
+            for (int c = 1; c < num_classes; ++c) {
+                if (row[c] > best) {
+                    best = row[c];
+                    best_c = c;
+                }
+            }
+            best_scores[i] = best;
+            best_classes[i] = best_c;
+        }
+    }
+    
+    // 実数値 (q - zp) * scale > th  <=>  q > th / scale + zp
+    float threshold_q = conf_threshold / scale + zero_point;
+    auto value = [&](int ch, int i) -> float {
+        T v = channel_major ? data[ch * num_anchors + i] : data[i * num_channels + ch];
+        return (static_cast<float>(v) - zero_point) * scale;
+    };
+    
+    for (int i = 0; i < num_anchors; ++i) {
+        if (static_cast<float>(best_scores[i]) <= threshold_q) {
+            continue;
+        }
+        
+        // 座標取得（中心座標とサイズ）
+        float cx = value(0, i) * scale_x;
+        float cy = value(1, i) * scale_y;
+        float w  = value(2, i) * scale_x;
+        float h  = value(3, i) * scale_y;
+        
+        // 左上座標に変換
+        nms.push(cx - w / 2, cy - h / 2, w, h,
+                 (static_cast<float>(best_scores[i]) - zero_point) * scale, best_classes[i]);
+    }
+}
+
+void collectYOLOv8Candidates(const Mat& output, float conf_threshold, float scale_x, float scale_y,
+                             vector<float>& best_scores, vector<int>& best_classes, NmsBuffer& nms) {
+    bool channel_major = (output.dims == 3);
+    int num_channels = channel_major ? output.size[1] : output.cols;
+    int num_anchors  = channel_major ? output.size[2] : output.rows;
+    if (output.depth() != CV_32F || num_channels <= 4 || num_anchors <= 0) {
+        return;
+    }
+    collectYOLOv8Candidates<float>(output.ptr<float>(), channel_major, num_channels, num_anchors,
+                                   1.0f, 0.0f, conf_threshold, scale_x, scale_y, best_scores, best_classes, nms);
+}
+
+void collectYOLOv8Candidates(const Mat& output, float out_scale, int out_zero_point, float conf_threshold,
+                             float scale_x, float scale_y,
+                             vector<int8_t>& best_scores, vector<int>& best_classes, NmsBuffer& nms) {
+    bool channel_major = (output.dims == 3);
+    int num_channels = channel_major ? output.size[1] : output.cols;
+    int num_anchors  = channel_major ? output.size[2] : output.rows;
+    if (output.depth() != CV_8S || num_channels <= 4 || num_anchors <= 0 || out_scale <= 0.0f) {
+        return;
+    }
+    collectYOLOv8Candidates<int8_t>(output.ptr<int8_t>(), channel_major, num_channels, num_anchors,
+                                    out_scale, (float)out_zero_point, conf_threshold,
+                                    scale_x, scale_y, best_scores, best_classes, nms);
+}
+
 vector<DetectedObject> ObjectDetector::parseYOLOv8Output(const vector<Mat>& outputs, int frame_width, int frame_height) {
     vector<DetectedObject> detections;
-    vector<int> class_ids;
-    vector<float> confidences;
-    vector<Rect> boxes;
+    nms_.clear();
     
     // YOLOv8の出力は [1, 84, 8400] (COCO 80クラスの場合)
     // 形式: [x_center, y_center, width, height, class_scores...]
@@ -178,63 +482,26 @@ vector<DetectedObject> ObjectDetector::parseYOLOv8Output(const vector<Mat>& outp
         return detections;
     }
     
-    Mat output = outputs[0];
-    
-    // 出力を転置して扱いやすくする: [8400, 84]
-    if (output.dims == 3) {
-        // [1, 84, 8400] -> [8400, 84]
-        output = output.reshape(1, output.size[1]); // [84, 8400]
-        cv::transpose(output, output);               // [8400, 84]
-    }
+    const Mat& output = outputs[0];
     
-    int num_classes = output.cols - 4; // 最初の4列は座標、残りがクラススコア
+    // [1, 84, N]（チャネル優先）も [N, 84] も転置せずに走査する
     float scale_x = (float)frame_width / input_size_;
     float scale_y = (float)frame_height / input_size_;
     
-    // 各検出候補をループ
-    for (int i = 0; i < output.rows; ++i) {
-        // クラススコアの最大値を取得（5列目以降）
-        Mat scores = output.row(i).colRange(4, output.cols);
-        Point class_id_point;
-        double max_class_score;
-        minMaxLoc(scores, 0, &max_class_score, 0, &class_id_point);
-        
-        // 信頼度の閾値チェック
-        if (max_class_score > confidence_threshold_) {
-            // 座標取得（中心座標とサイズ）
-            float cx = output.at<float>(i, 0) * scale_x;
-            float cy = output.at<float>(i, 1) * scale_y;
-            float w  = output.at<float>(i, 2) * scale_x;
-            float h  = output.at<float>(i, 3) * scale_y;
-            
-            // 左上座標に変換
-            int left = (int)(cx - w / 2);
-            int top  = (int)(cy - h / 2);
-            
-            class_ids.push_back(class_id_point.x);
-            confidences.push_back((float)max_class_score);
-            boxes.push_back(Rect(left, top, (int)w, (int)h));
+    if (output.depth() == CV_8S) {
+        // 量子化出力: scale / zero_point で逆量子化
+        if (output_scales_.empty()) {
+            cerr << "エラー: INT8出力の逆量子化パラメータが取得できません" << endl;
+            return detections;
         }
+        collectYOLOv8Candidates(output, output_scales_[0], output_zero_points_[0], confidence_threshold_,
+                                scale_x, scale_y, best_scores_s8_, best_classes_, nms_);
+    } else {
+        collectYOLOv8Candidates(output, confidence_threshold_, scale_x, scale_y,
+                                best_scores_f32_, best_classes_, nms_);
     }
     
-    // Non-Maximum Suppression（重複検出の削除）
-    vector<int> indices;
-    dnn::NMSBoxes(boxes, confidences, confidence_threshold_, 0.4, indices);
-    
-    // 検出結果を追加
-    for (size_t i = 0; i < indices.size(); ++i) {
-        int idx = indices[i];
-        DetectedObject obj;
-        obj.class_id = class_ids[idx];
-        obj.class_name = (obj.class_id >= 0 && obj.class_id < static_cast<int>(class_names_.size()))
-                         ? class_names_[obj.class_id]
-                         : "unknown";
-        obj.confidence = confidences[idx];
-        obj.bbox = boxes[idx];
-        detections.push_back(obj);
-    }
-    
-    return detections;
+    return suppressCandidates();
 }
 
 void ObjectDetector::drawDetections(Mat& frame, const vector<DetectedObject>& detections) {
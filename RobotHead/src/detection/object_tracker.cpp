@@ -0,0 +1,301 @@
+/**
+ * @file object_tracker.cpp
+ * @brief Implementation of the multi-object tracker
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "detection/object_tracker.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+static const float kInitialVelocityVar = 200.0f * 200.0f;  // 初期速度の分散（(px/s)^2）
+static const float kMaxPredictSeconds = 1.0f;              // 推論が途切れた時の予測の上限
+
+static float boxIoU(const Rect& a, const Rect& b) {
+    int inter = (a & b).area();
+    if (inter <= 0) {
+        return 0.0f;
+    }
+    return (float)inter / (float)(a.area() + b.area() - inter);
+}
+
+static Rect stateBox(const Track& track) {
+    float cx = track.state[0][0];
+    float cy = track.state[1][0];
+    float w = max(1.0f, track.state[2][0]);
+    float h = max(1.0f, track.state[3][0]);
+    return Rect((int)lround(cx - w / 2), (int)lround(cy - h / 2), (int)lround(w), (int)lround(h));
+}
+
+ObjectTracker::ObjectTracker(const TrackerConfig& config)
+    : config_(config), next_id_(1),
+      updates_(0), update_us_total_(0.0), update_us_max_(0.0), tracks_created_(0) {
+    tracks_.reserve(32);
+    predicted_.reserve(32);
+    pairs_.reserve(256);
+}
+
+void ObjectTracker::reset() {
+    tracks_.clear();
+}
+
+void ObjectTracker::predict(Track& track, float dt) const {
+    for (int k = 0; k < 4; k++) {
+        float a = (k < 2) ? config_.accel_noise : config_.size_accel_noise;
+        float q = a * a;
+        float* x = track.state[k];
+        float* p = track.cov[k];
+
+        x[0] += x[1] * dt;
+
+        // P = F P F^T + Q（F = [1 dt; 0 1]、Qは加速度ノイズの離散化）
+        float dt2 = dt * dt;
+        float p00 = p[0] + 2.0f * dt * p[1] + dt2 * p[2] + q * dt2 * dt2 * 0.25f;
+        float p01 = p[1] + dt * p[2] + q * dt2 * dt * 0.5f;
+        float p11 = p[2] + q * dt2;
+        p[0] = p00;
+        p[1] = p01;
+        p[2] = p11;
+    }
+}
+
+void ObjectTracker::correct(Track& track, const Rect& box) const {
+    const float z[4] = {
+        box.x + box.width * 0.5f,
+        box.y + box.height * 0.5f,
+        (float)box.width,
+        (float)box.height,
+    };
+    float r = config_.position_noise_px * config_.position_noise_px;
+
+    for (int k = 0; k < 4; k++) {
+        float* x = track.state[k];
+        float* p = track.cov[k];
+
+        // 観測は位置のみ（H = [1 0]）
+        float s = p[0] + r;
+        float k0 = p[0] / s;
+        float k1 = p[1] / s;
+        float y = z[k] - x[0];
+        x[0] += k0 * y;
+        x[1] += k1 * y;
+
+        float p00 = (1.0f - k0) * p[0];
+        float p01 = (1.0f - k0) * p[1];
+        float p11 = p[2] - k1 * p[1];
+        p[0] = p00;
+        p[1] = p01;
+        p[2] = p11;
+    }
+}
+
+void ObjectTracker::initTrack(Track& track, const DetectedObject& det, Clock::time_point t) {
+    track.id = next_id_++;
+    track.class_id = det.class_id;
+    track.class_name = det.class_name;
+    track.confidence = det.confidence;
+    track.bbox = det.bbox;
+    track.velocity = Point2f(0.0f, 0.0f);
+    track.hits = 1;
+    track.misses = 0;
+    track.confirmed = (config_.min_hits <= 1);
+    track.first_seen = t;
+    track.last_seen = t;
+    track.state_time = t;
+
+    const float z[4] = {
+        det.bbox.x + det.bbox.width * 0.5f,
+        det.bbox.y + det.bbox.height * 0.5f,
+        (float)det.bbox.width,
+        (float)det.bbox.height,
+    };
+    float r = config_.position_noise_px * config_.position_noise_px;
+    for (int k = 0; k < 4; k++) {
+        track.state[k][0] = z[k];
+        track.state[k][1] = 0.0f;
+        track.cov[k][0] = r;
+        track.cov[k][1] = 0.0f;
+        track.cov[k][2] = kInitialVelocityVar;
+    }
+    tracks_created_++;
+}
+
+void ObjectTracker::associate(const vector<DetectedObject>& detections, bool high_stage, float min_iou,
+                              Clock::time_point frame_time) {
+    pairs_.clear();
+    for (size_t t = 0; t < tracks_.size(); t++) {
+        if (track_matched_[t]) {
+            continue;
+        }
+        // 低信頼度の検出は確定トラックの継続にだけ使う（誤検出から新規トラックを作らない）
+        if (!high_stage && !tracks_[t].confirmed) {
+            continue;
+        }
+        for (size_t d = 0; d < detections.size(); d++) {
+            const DetectedObject& det = detections[d];
+            if (det_matched_[d] || (det.confidence >= config_.high_threshold) != high_stage ||
+                det.confidence < config_.low_threshold) {
+                continue;
+            }
+            if (det.class_id != tracks_[t].class_id) {
+                continue;
+            }
+            float iou = boxIoU(predicted_[t], det.bbox);
+            if (iou >= min_iou) {
+                pairs_.push_back({iou, (int)t, (int)d});
+            }
+        }
+    }
+
+    // IoUの大きい組から貪欲に確定（少数のトラックではハンガリアン法とほぼ同じ結果で高速）
+    sort(pairs_.begin(), pairs_.end(), [](const Pair& a, const Pair& b) { return a.iou > b.iou; });
+    for (const Pair& p : pairs_) {
+        if (track_matched_[p.track] || det_matched_[p.detection]) {
+            continue;
+        }
+        track_matched_[p.track] = 1;
+        det_matched_[p.detection] = 1;
+
+        Track& track = tracks_[p.track];
+        const DetectedObject& det = detections[p.detection];
+        correct(track, det.bbox);
+        track.confidence = det.confidence;
+        track.hits++;
+        track.misses = 0;
+        track.last_seen = frame_time;
+        if (track.hits >= config_.min_hits) {
+            track.confirmed = true;
+        }
+    }
+}
+
+const vector<Track>& ObjectTracker::update(const vector<DetectedObject>& detections,
+                                           Clock::time_point frame_time, const Rect& observed) {
+    auto t0 = Clock::now();
+
+    // 全トラックを検出フレームの時刻まで予測
+    predicted_.resize(tracks_.size());
+    for (size_t t = 0; t < tracks_.size(); t++) {
+        Track& track = tracks_[t];
+        float dt = chrono::duration<float>(frame_time - track.state_time).count();
+        dt = max(0.0f, min(dt, kMaxPredictSeconds));
+        predict(track, dt);
+        track.state_time = frame_time;
+        predicted_[t] = stateBox(track);
+    }
+
+    // 高信頼度 → 低信頼度の2段階で対応付け
+    track_matched_.assign(tracks_.size(), 0);
+    det_matched_.assign(detections.size(), 0);
+    associate(detections, true, config_.match_iou, frame_time);
+    associate(detections, false, config_.low_match_iou, frame_time);
+
+    // 対応付けられなかったトラック（推論した領域の外にあるものは見えていないだけなので数えない）
+    for (size_t t = 0; t < tracks_.size(); t++) {
+        if (track_matched_[t]) {
+            continue;
+        }
+        if (observed.empty() || (predicted_[t] & observed).area() > 0) {
+            tracks_[t].misses++;
+        }
+    }
+
+    for (auto& track : tracks_) {
+        track.bbox = stateBox(track);
+        track.velocity = Point2f(track.state[0][1], track.state[1][1]);
+    }
+
+    // 未確定で見失ったもの、確定済みでも見失い続けたものを削除
+    int max_misses = config_.max_misses;
+    tracks_.erase(remove_if(tracks_.begin(), tracks_.end(), [max_misses](const Track& track) {
+        return (!track.confirmed && track.misses > 0) || track.misses > max_misses;
+    }), tracks_.end());
+
+    // 残った高信頼度の検出から新規トラック
+    for (size_t d = 0; d < detections.size(); d++) {
+        if (det_matched_[d] || detections[d].confidence < config_.high_threshold) {
+            continue;
+        }
+        tracks_.emplace_back();
+        initTrack(tracks_.back(), detections[d], frame_time);
+    }
+
+    double us = chrono::duration<double, micro>(Clock::now() - t0).count();
+    updates_++;
+    update_us_total_ += us;
+    update_us_max_ = max(update_us_max_, us);
+
+    return tracks_;
+}
+
+void ObjectTracker::assignDistances(const function<int(const Rect&)>& distance_of, Clock::time_point now) {
+    for (auto& track : tracks_) {
+        int distance = distance_of(track.bbox);
+        if (distance < 0) {
+            track.distance_mm = -1;
+            track.distance_rate_mm_s = 0.0f;
+            continue;
+        }
+
+        // 距離の変化率（接近判定用）を指数移動平均で平滑化
+        if (track.distance_mm >= 0) {
+            float dt = chrono::duration<float>(now - track.distance_time).count();
+            if (dt > 0.02f) {
+                float rate = (distance - track.distance_mm) / dt;
+                track.distance_rate_mm_s = 0.7f * track.distance_rate_mm_s + 0.3f * rate;
+            }
+        }
+        track.distance_mm = distance;
+        track.distance_time = now;
+    }
+}
+
+vector<DetectedObject> ObjectTracker::confidentDetections(const vector<DetectedObject>& detections) const {
+    vector<DetectedObject> out;
+    out.reserve(detections.size());
+    for (const auto& det : detections) {
+        if (det.confidence >= config_.high_threshold) {
+            out.push_back(det);
+        }
+    }
+    return out;
+}
+
+void ObjectTracker::drawTracks(Mat& frame) const {
+    for (const auto& track : tracks_) {
+        if (!track.confirmed) {
+            continue;
+        }
+
+        string label = "#" + to_string(track.id);
+        if (track.distance_mm >= 0) {
+            label += " " + to_string(track.distance_mm) + "mm";
+        }
+
+        // 矩形の下にIDと距離、中心から0.5秒後の予測位置へ速度ベクトル
+        Point label_pos(track.bbox.x, min(frame.rows - 2, track.bbox.y + track.bbox.height + 14));
+        putText(frame, label, label_pos, FONT_HERSHEY_SIMPLEX, 0.5, Scalar(0, 255, 255), 1);
+
+        Point center(track.bbox.x + track.bbox.width / 2, track.bbox.y + track.bbox.height / 2);
+        Point ahead(center.x + (int)(track.velocity.x * 0.5f), center.y + (int)(track.velocity.y * 0.5f));
+        line(frame, center, ahead, Scalar(0, 255, 255), 2);
+    }
+}
+
+string ObjectTracker::statsSummary() const {
+    ostringstream oss;
+    oss.precision(1);
+    oss << fixed
+        << "トラッカー: 更新" << updates_ << "回"
+        << " 平均" << (updates_ ? update_us_total_ / updates_ : 0.0) << "us"
+        << " 最大" << update_us_max_ << "us"
+        << " 生成" << tracks_created_
+        << " 追跡中" << tracks_.size();
+    return oss.str();
+}
@@ -0,0 +1,166 @@
+/**
+ * @file tof_gate.cpp
+ * @brief Implementation of ToF occupancy based detection gating
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "detection/tof_gate.h"
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+ToFGate::ToFGate()
+    : calibrated_(false), near_range_mm_(1200), crop_margin_px_(24), min_crop_px_(96),
+      decisions_(0), skipped_(0), cropped_(0), full_runs_(0),
+      full_ms_avg_(0.0), crop_saved_ms_(0.0) {}
+
+void ToFGate::configure(const Rect& overlay, const Size& image_size, bool calibrated) {
+    overlay_ = overlay;
+    image_size_ = image_size;
+    calibrated_ = calibrated;
+}
+
+Rect ToFGate::zoneRect(int zone, int grid) const {
+    // main.cppのオーバーレイと同じ対応（row = i / grid, col = i % grid、回転なし）
+    int row = zone / grid;
+    int col = zone % grid;
+    int x1 = overlay_.x + col * overlay_.width / grid;
+    int y1 = overlay_.y + row * overlay_.height / grid;
+    int x2 = overlay_.x + (col + 1) * overlay_.width / grid;
+    int y2 = overlay_.y + (row + 1) * overlay_.height / grid;
+    return Rect(x1, y1, x2 - x1, y2 - y1);
+}
+
+GateDecision ToFGate::evaluate(const int16_t* distance_mm, const uint8_t* target_status, int resolution) {
+    GateDecision decision;
+    decisions_++;
+
+    int grid = (resolution == 16) ? 4 : 8;
+    Rect image_rect(0, 0, image_size_.width, image_size_.height);
+    Rect near_box;
+    bool near_outside_view = false;
+
+    for (int i = 0; i < resolution; i++) {
+        // 有効なターゲット（5: 有効, 9: 有効(ウェイクアップ後)）のみ
+        if (target_status[i] != 5 && target_status[i] != 9) {
+            continue;
+        }
+        if (distance_mm[i] <= 0 || distance_mm[i] >= near_range_mm_) {
+            continue;
+        }
+        decision.near_zones++;
+
+        if (!calibrated_) {
+            continue;
+        }
+        Rect zone = zoneRect(i, grid) & image_rect;
+        if (zone.area() == 0) {
+            near_outside_view = true;
+            continue;
+        }
+        near_box = near_box.area() == 0 ? zone : (near_box | zone);
+    }
+
+    // 近距離に何もなければスキップ
+    if (decision.near_zones == 0) {
+        decision.run = false;
+        skipped_++;
+        return decision;
+    }
+
+    // 未キャリブレーション、または画角外に近距離物体がある場合は全体推論
+    if (!calibrated_ || near_outside_view || near_box.area() == 0) {
+        full_runs_++;
+        return decision;
+    }
+
+    // 余白を付けて正方形に広げる（ネットワーク入力は正方形のため縦横比を保つ）
+    Rect roi(near_box.x - crop_margin_px_, near_box.y - crop_margin_px_,
+             near_box.width + 2 * crop_margin_px_, near_box.height + 2 * crop_margin_px_);
+    int side = max(min_crop_px_, max(roi.width, roi.height));
+    side = min(side, min(image_size_.width, image_size_.height));
+    int cx = roi.x + roi.width / 2;
+    int cy = roi.y + roi.height / 2;
+    roi = Rect(cx - side / 2, cy - side / 2, side, side);
+    roi.x = max(0, min(roi.x, image_size_.width - side));
+    roi.y = max(0, min(roi.y, image_size_.height - side));
+    roi &= image_rect;
+
+    // 画像の大半を覆うなら切り出しの意味がないので全体推論
+    if (roi.area() * 10 >= image_rect.area() * 8) {
+        full_runs_++;
+        return decision;
+    }
+
+    decision.cropped = true;
+    decision.roi = roi;
+    cropped_++;
+    return decision;
+}
+
+int ToFGate::nearestDistance(const Rect& region, const int16_t* distance_mm, const uint8_t* target_status,
+                             int resolution) const {
+    if (!calibrated_ || region.area() == 0) {
+        return -1;
+    }
+
+    int grid = (resolution == 16) ? 4 : 8;
+    int nearest = -1;
+    for (int i = 0; i < resolution; i++) {
+        if (target_status[i] != 5 && target_status[i] != 9) {
+            continue;
+        }
+        if (distance_mm[i] <= 0 || (zoneRect(i, grid) & region).area() == 0) {
+            continue;
+        }
+        if (nearest < 0 || distance_mm[i] < nearest) {
+            nearest = distance_mm[i];
+        }
+    }
+    return nearest;
+}
+
+GateDecision ToFGate::evaluateWithoutDepth() {
+    decisions_++;
+    full_runs_++;
+    return GateDecision();
+}
+
+void ToFGate::recordInference(double inference_ms, bool cropped) {
+    if (cropped) {
+        if (full_ms_avg_ > 0.0) {
+            crop_saved_ms_ += max(0.0, full_ms_avg_ - inference_ms);
+        }
+    } else {
+        full_ms_avg_ = (full_ms_avg_ == 0.0) ? inference_ms : full_ms_avg_ * 0.9 + inference_ms * 0.1;
+    }
+}
+
+double ToFGate::skippedFraction() const {
+    return decisions_ ? (double)skipped_ / (double)decisions_ : 0.0;
+}
+
+double ToFGate::croppedFraction() const {
+    return decisions_ ? (double)cropped_ / (double)decisions_ : 0.0;
+}
+
+double ToFGate::cpuSavedMs() const {
+    return (double)skipped_ * full_ms_avg_ + crop_saved_ms_;
+}
+
+string ToFGate::statsSummary() const {
+    ostringstream oss;
+    oss.precision(1);
+    oss << fixed
+        << "ToFゲート: 判定" << decisions_ << "回"
+        << " スキップ" << skippedFraction() * 100.0 << "%"
+        << " 切り出し" << croppedFraction() * 100.0 << "%"
+        << " 全体" << full_runs_ << "回"
+        << " 全体推論平均" << full_ms_avg_ << "ms"
+        << " 節約CPU時間" << cpuSavedMs() / 1000.0 << "s";
+    return oss.str();
+}
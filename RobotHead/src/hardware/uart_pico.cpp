@@ -13,7 +13,7 @@
 #include <termios.h>
 #include <unistd.h>
 
-UARTPico::UARTPico() : fd_(-1) {}
+UARTPico::UARTPico() : fd_(-1), motor_rotation_(0), motor_drive_(0) {}
 
 UARTPico::~UARTPico() {
     close();
@@ -91,6 +91,9 @@ bool UARTPico::sendCommand(const std::string& cmd) {
     
     std::string full_cmd = cmd + "\n";
     ssize_t written = write(fd_, full_cmd.c_str(), full_cmd.length());
+    if (line_callback_) {
+        line_callback_(true, cmd);
+    }
     return (written == (ssize_t)full_cmd.length());
 }
 
@@ -98,21 +101,30 @@ void UARTPico::update() {
     if (fd_ < 0) return;
     
     char buffer[256];
-    ssize_t n = read(fd_, buffer, sizeof(buffer) - 1);
-    
-    if (n > 0) {
-        buffer[n] = '\0';
-        read_buffer_ += buffer;
-        
-        // 行ごとに処理
-        size_t pos;
-        while ((pos = read_buffer_.find('\n')) != std::string::npos) {
-            std::string line = read_buffer_.substr(0, pos);
-            read_buffer_.erase(0, pos + 1);
-            
-            if (!line.empty()) {
-                processLine(line);
+    ssize_t n;
+    // 前回の呼び出しから溜まった分（IMUの行など）を全て読む
+    while ((n = read(fd_, buffer, sizeof(buffer))) > 0) {
+        feed(buffer, (size_t)n);
+    }
+}
+
+void UARTPico::feed(const char* data, size_t length) {
+    read_buffer_.append(data, length);
+
+    // 行ごとに処理
+    size_t pos;
+    while ((pos = read_buffer_.find('\n')) != std::string::npos) {
+        std::string line = read_buffer_.substr(0, pos);
+        read_buffer_.erase(0, pos + 1);
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+
+        if (!line.empty()) {
+            if (line_callback_) {
+                line_callback_(false, line);
             }
+            processLine(line);
         }
     }
 }
@@ -132,6 +144,16 @@ void UARTPico::processLine(const std::string& line) {
                 imu_callback_(ax, ay, az, gx, gy, gz);
             }
         }
+    } else if (token == "MOTOR") {
+        // MOTOR,rotation,drive
+        int rotation, drive;
+        if (iss >> rotation && iss.ignore(1) && iss >> drive) {
+            motor_rotation_ = rotation;
+            motor_drive_ = drive;
+            if (motor_callback_) {
+                motor_callback_(rotation, drive);
+            }
+        }
     } else if (token == "ALERT") {
         // ALERT,reason
         std::string reason;
@@ -172,6 +194,14 @@ void UARTPico::setInfoCallback(std::function<void(const std::string&)> callback)
     info_callback_ = callback;
 }
 
+void UARTPico::setMotorCallback(std::function<void(int, int)> callback) {
+    motor_callback_ = callback;
+}
+
+void UARTPico::setLineCallback(std::function<void(bool, const std::string&)> callback) {
+    line_callback_ = callback;
+}
+
 bool UARTPico::setRotation(int8_t speed) {
     if (speed < -100) speed = -100;
     if (speed > 100) speed = 100;
@@ -7,10 +7,12 @@
  * Features:
  * - libcamera-based camera capture
  * - YOLOv8 object detection
- * - VL53L8CX ToF distance sensing
+ * - VL53L8CX ToF distance sensing (read at the sensor's rate, raw frames streamed at /depth/ws)
  * - Audio playback (startup sound, greetings)
  * - Voice detection (optional)
  * - HTTP MJPEG streaming (--stream mode)
+ * - WebSocket stream of raw frames + overlay metadata (browser-side drawing at /view)
+ * - Glass-to-glass latency mode (--latency, capture timestamps on every stage, measured by latency_tool)
  */
 
 #include <opencv2/opencv.hpp>
@@ -21,37 +23,74 @@
 #include <chrono>
 #include <mutex>
 #include <cstring>
-#include <sys/socket.h>
-#include <netinet/in.h>
+#include <sstream>
+#include <memory>
+#include <cstdlib>
 #include <unistd.h>
 #include "platform/i2c_dev.h"
 #include "platform/platform_wrapper.h"
 #include "sensors/vl53l8cx_api.h"
+#include "sensors/tof_reader.h"
+#include "sensors/depth_frame.h"
+#include "sensors/depth_overlay.h"
+#include "camera/frame_source.h"
+#include "camera/frame_band.h"
 #include "camera/libcamera_capture.h"
 #include "audio/audio_player.h"
 #include "audio/voice_detector.h"
+#include "hardware/uart_pico.h"
+#include "platform/process_stats.h"
+#include "platform/black_box.h"
+#include "platform/session_log.h"
+#include "platform/latency_trace.h"
+#include "network/mjpeg_broadcaster.h"
+#include "network/http_server.h"
+#include "network/websocket.h"
+#include "network/overlay_viewer.h"
 
 #ifdef ENABLE_OBJECT_DETECTION
 #include "detection/object_detector.h"
+#include "detection/async_detector.h"
+#include "detection/tof_gate.h"
+#include "detection/motion_gate.h"
+#include "detection/object_tracker.h"
 #endif
 
 using namespace cv;
 using namespace std;
 
 // グローバル変数（HTTPストリーミング用）
-Mat g_current_frame;
 bool g_stream_mode = false;
-bool g_frame_ready = false;
-std::mutex g_frame_mutex;
+// 1フレームを1回だけエンコードして全クライアントに配る
+MjpegBroadcaster g_mjpeg;
+// オーバーレイを描かない元のフレーム（WebSocket視聴者向け、描画はブラウザ側で行う）
+MjpegBroadcaster g_raw_jpeg;
+// MJPEG配信とモデル切り替えコマンドを1スレッドのイベントループで処理
+HttpServer g_http;
+// 直近のフレーム・ToF・UARTを常に記録し、ALERTやHTTPで書き出す
+BlackBoxRecorder g_blackbox;
+// --record-session: 全フレーム・ToFの測距結果・UARTをファイルに記録する（後で再生・解析する）
+SessionWriter g_session;
+// 撮影時刻から各段階までの遅延（--latency）
+LatencyTrace g_latency;
 
-// 挨拶音声管理用
-bool g_greeting_played = false;
-uint16_t g_min_distance = 4000;  // 最小距離（mm）
+#ifdef ENABLE_OBJECT_DETECTION
+// HTTPコマンド（モデル切り替え）用。終了時はロックしてnullptrにする
+AsyncDetector* g_async_detector = nullptr;
+std::mutex g_detector_cmd_mutex;
+string g_labels_path;
+string g_model_dir;     // /model/loadで読み込めるのはこのディレクトリ（起動時のモデルの場所）の下だけ
+#endif
 
-// HTTPレスポンスを送信する関数（MJPEGストリーミング、約5fps）
-void send_http_response(int client_sock) {
-    const char* boundary = "frame";
+// 最新のToFフレーム（エンコード済み、/depth/latest用）
+std::mutex g_depth_mutex;
+shared_ptr<const vector<unsigned char>> g_latest_depth;
 
+// 挨拶音声管理用（挨拶済みかどうかはトラックごとに管理）
+uint16_t g_min_distance = 4000;  // 最小距離（mm、トラックの距離が不明な時に使用）
+
+// MJPEGストリームの開始（以降のフレームはg_mjpegがエンコードするたびにbroadcast_jpeg()で送る）
+static void handle_stream_request(HttpServer::ConnectionId id, const HttpRequest& request) {
     string header =
         "HTTP/1.0 200 OK\r\n"
         "Connection: close\r\n"
@@ -59,110 +98,453 @@ void send_http_response(int client_sock) {
         "Expires: 0\r\n"
         "Cache-Control: no-cache, private\r\n"
         "Pragma: no-cache\r\n"
-        "Content-Type: multipart/x-mixed-replace; boundary=" + string(boundary) + "\r\n\r\n";
+        "Content-Type: multipart/x-mixed-replace; boundary=" MJPEG_BOUNDARY "\r\n\r\n";
 
-    if (send(client_sock, header.c_str(), header.length(), 0) < 0) {
+    g_mjpeg.addClient();
+    if (!g_http.beginStream(id, "mjpeg", header, []() { g_mjpeg.removeClient(); })) {
+        g_mjpeg.removeClient();
+    }
+}
+
+// エンコード済みJPEGを全ストリームクライアントの送信キューに積む（エンコードスレッドから呼ばれる）
+// パートヘッダー・JPEG・CRLFはどれもコピーせず、サーバーが1回のsendmsgでまとめて送る
+static void broadcast_jpeg(const JpegFramePtr& jpeg) {
+    g_latency.record("capture_to_mjpeg_encoded", jpeg->capture_us, jpeg->encoded_us);
+    g_http.broadcast("mjpeg", {HttpChunk(jpeg, jpeg->part_header, jpeg->part_header_size),
+                               HttpChunk(jpeg, jpeg->data.data(), jpeg->data.size()),
+                               HttpChunk(nullptr, kMjpegPartTrailer, kMjpegPartTrailerSize)});
+}
+
+// WebSocket配信の開始（フレームごとにメタデータJSONのテキストメッセージとJPEGのバイナリメッセージを送る）
+//   GET /ws（Upgrade: websocket）
+static void handle_ws_request(HttpServer::ConnectionId id, const HttpRequest& request) {
+    string header = websocketHandshakeResponse(request);
+    if (header.empty()) {
+        g_http.sendResponse(id, "400 Bad Request", "text/plain", "WebSocket upgrade required\n");
         return;
     }
 
-    // 約5fpsでフレームを送信
-    while (g_stream_mode) {
-        Mat local_frame;
-        {
-            lock_guard<mutex> lock(g_frame_mutex);
-            if (!g_frame_ready || g_current_frame.empty()) {
-                // まだフレームが用意されていなければ少し待って次へ
-                // ロックはすぐ解放する
-            } else {
-                local_frame = g_current_frame.clone();
-            }
-        }
+    // クライアントからはCloseフレームしか来ない想定（届いたら切断）
+    auto reader = make_shared<WebSocketReader>();
+    g_raw_jpeg.addClient();
+    if (!g_http.beginStream(id, "ws", header, []() { g_raw_jpeg.removeClient(); },
+                            [reader](const char* data, size_t size) { return reader->feed(data, size); })) {
+        g_raw_jpeg.removeClient();
+    }
+}
 
-        if (local_frame.empty()) {
-            this_thread::sleep_for(chrono::milliseconds(200));
-            continue;
-        }
+// メタデータとJPEGを同じフレームとして積む（遅いクライアントでは組ごと捨てられる）
+static void broadcast_ws(const JpegFramePtr& jpeg) {
+    unsigned char header[kWebSocketMaxHeaderSize];
+    size_t header_size = websocketFrameHeader(WebSocketOpcode::Binary, jpeg->data.size(), header);
+    if (jpeg->capture_us != 0 && !jpeg->metadata.empty() && jpeg->metadata.back() == '}') {
+        // 遅延計測中はエンコード完了時刻もメタデータに入れる（latency_toolが区間を分けて集計する）
+        g_latency.record("capture_to_ws_encoded", jpeg->capture_us, jpeg->encoded_us);
+        string metadata = jpeg->metadata;
+        metadata.pop_back();
+        metadata += ", \"t_enc_us\": " + to_string(jpeg->encoded_us) + "}";
+        g_http.broadcast("ws", {websocketFrame(WebSocketOpcode::Text, metadata),
+                                HttpChunk::copyOf(string(reinterpret_cast<const char*>(header), header_size)),
+                                HttpChunk(jpeg, jpeg->data.data(), jpeg->data.size())});
+        return;
+    }
+    g_http.broadcast("ws", {websocketFrame(WebSocketOpcode::Text, jpeg->metadata),
+                            HttpChunk::copyOf(string(reinterpret_cast<const char*>(header), header_size)),
+                            HttpChunk(jpeg, jpeg->data.data(), jpeg->data.size())});
+}
 
-        vector<uchar> buf;
-        if (!imencode(".jpg", local_frame, buf)) {
-            this_thread::sleep_for(chrono::milliseconds(200));
-            continue;
-        }
+// ToFの生データをセンサーの周期で配る（ToFReaderの読み出しスレッドから呼ばれる）
+static void broadcast_depth(const DepthFrame& frame) {
+    auto encoded = make_shared<vector<unsigned char>>();
+    encodeDepthFrame(frame, *encoded);
+    {
+        lock_guard<mutex> lock(g_depth_mutex);
+        g_latest_depth = encoded;
+    }
+    if (g_http.streamClientCount("depth") > 0) {
+        g_http.broadcast("depth", {websocketFrame(WebSocketOpcode::Binary, string(encoded->begin(), encoded->end()))});
+    }
+}
+
+// ToFReaderのスレッドから測距のたびに呼ばれる
+static void on_depth_frame(const DepthFrame& frame) {
+    g_blackbox.recordDepth(frame);
+    if (g_stream_mode) {
+        broadcast_depth(frame);
+    }
+}
 
-        string part_header =
-            "--" + string(boundary) + "\r\n"
-            "Content-Type: image/jpeg\r\n"
-            "Content-Length: " + to_string(buf.size()) + "\r\n\r\n";
+// ブラックボックス
+//   GET /blackbox/dump    直近の記録をファイルに書き出す（1秒後に書き出しを始める）
+//   GET /blackbox/status  記録数・保持秒数・記録の負荷・最後のダンプ
+static void handle_blackbox_request(HttpServer::ConnectionId id, const HttpRequest& request) {
+    if (!g_blackbox.isOpen()) {
+        g_http.sendResponse(id, "503 Service Unavailable", "application/json", "{\"error\": \"black box disabled\"}\n");
+        return;
+    }
+    ostringstream body;
+    if (request.path == "/blackbox/dump") {
+        body << "{\"accepted\": " << (g_blackbox.requestDump("http") ? "true" : "false") << "}\n";
+    } else if (request.path == "/blackbox/status") {
+        body << "{\"dumping\": " << (g_blackbox.isDumping() ? "true" : "false")
+             << ", \"retained_s\": " << g_blackbox.retainedSeconds()
+             << ", \"overhead_percent\": " << g_blackbox.overheadPercent()
+             << ", \"last_dump\": \"" << g_blackbox.lastDumpPath() << "\"}\n";
+    } else {
+        g_http.sendResponse(id, "404 Not Found", "text/plain", "Not Found\n");
+        return;
+    }
+    g_http.sendResponse(id, "200 OK", "application/json", body.str());
+}
 
-        if (send(client_sock, part_header.c_str(), part_header.length(), 0) < 0) {
-            break;
+// ToFの生データ（形式はsensors/depth_frame.h）
+//   GET /depth/ws      WebSocket、測距のたびに1フレームをバイナリメッセージで送る
+//   GET /depth/latest  最新の1フレーム
+static void handle_depth_request(HttpServer::ConnectionId id, const HttpRequest& request) {
+    if (request.path == "/depth/ws") {
+        string header = websocketHandshakeResponse(request);
+        if (header.empty()) {
+            g_http.sendResponse(id, "400 Bad Request", "text/plain", "WebSocket upgrade required\n");
+            return;
         }
-        if (send(client_sock, buf.data(), buf.size(), 0) < 0) {
-            break;
+        auto reader = make_shared<WebSocketReader>();
+        g_http.beginStream(id, "depth", header, nullptr,
+                           [reader](const char* data, size_t size) { return reader->feed(data, size); });
+    } else if (request.path == "/depth/latest") {
+        shared_ptr<const vector<unsigned char>> latest;
+        {
+            lock_guard<mutex> lock(g_depth_mutex);
+            latest = g_latest_depth;
+        }
+        if (latest) {
+            g_http.sendResponse(id, "200 OK", "application/octet-stream", string(latest->begin(), latest->end()));
+        } else {
+            g_http.sendResponse(id, "503 Service Unavailable", "text/plain", "No depth frame yet\n");
         }
+    } else {
+        g_http.sendResponse(id, "404 Not Found", "text/plain", "Not Found\n");
+    }
+}
 
-        const char* crlf = "\r\n";
-        if (send(client_sock, crlf, strlen(crlf), 0) < 0) {
-            break;
+// 8x8の距離と、サーバー側で描いていた時と同じ配置情報
+static void write_depth_json(ostream& os, const VL53L8CX_ResultsData& results, bool overlay,
+                             const Rect& rect, float alpha) {
+    os << ", \"depth\": {\"mm\": [";
+    for (int i = 0; i < 64; i++) {
+        os << (i > 0 ? "," : "") << results.distance_mm[i];
+    }
+    os << "]";
+    if (overlay) {
+        os << ", \"mode\": \"overlay\", \"rect\": [" << rect.x << "," << rect.y << "," << rect.width << ","
+           << rect.height << "], \"alpha\": " << alpha;
+    } else {
+        os << ", \"mode\": \"below\"";
+    }
+    os << "}";
+}
+
+#ifdef ENABLE_OBJECT_DETECTION
+static string jsonEscape(const string& s) {
+    string out;
+    for (char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", (unsigned)(unsigned char)c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+                break;
         }
+    }
+    return out;
+}
 
-        // 5fps 相当のウェイト
-        this_thread::sleep_for(chrono::milliseconds(200));
+// 検出結果と確定したトラック（drawDetections / drawTracksで描いていた内容）
+static void write_detections_json(ostream& os, const vector<DetectedObject>& detections,
+                                  const vector<Track>& tracks) {
+    os << ", \"detections\": [";
+    for (size_t i = 0; i < detections.size(); i++) {
+        const DetectedObject& d = detections[i];
+        os << (i > 0 ? ", " : "") << "{\"c\": \"" << jsonEscape(d.class_name) << "\", \"p\": " << d.confidence
+           << ", \"b\": [" << d.bbox.x << "," << d.bbox.y << "," << d.bbox.width << "," << d.bbox.height << "]}";
+    }
+    os << "], \"tracks\": [";
+    bool first = true;
+    for (const auto& t : tracks) {
+        if (!t.confirmed) {
+            continue;
+        }
+        os << (first ? "" : ", ") << "{\"id\": " << t.id << ", \"c\": \"" << jsonEscape(t.class_name) << "\""
+           << ", \"b\": [" << t.bbox.x << "," << t.bbox.y << "," << t.bbox.width << "," << t.bbox.height << "]"
+           << ", \"d\": " << t.distance_mm
+           << ", \"v\": [" << (int)t.velocity.x << "," << (int)t.velocity.y << "]}";
+        first = false;
     }
+    os << "]";
+}
+#endif
 
-    string end_marker = "--" + string(boundary) + "--\r\n";
-    send(client_sock, end_marker.c_str(), end_marker.length(), 0);
+// 配信中のクライアントごとの送信状況（実効fps、捨てたフレーム、送信キュー、RTT）
+//   GET /stream/stats
+static void handle_stream_stats(HttpServer::ConnectionId id, const HttpRequest& request) {
+    ostringstream body;
+    body << "{\"jpeg_encodes\": " << g_mjpeg.encodeCount()
+         << ", \"encode_ms\": " << g_mjpeg.meanEncodeMs()
+         << ", \"raw_jpeg_encodes\": " << g_raw_jpeg.encodeCount()
+         << ", \"ws_clients\": " << g_http.streamClientCount("ws")
+         << ", \"clients\": [";
+    vector<StreamClientStats> clients = g_http.streamClientStats("mjpeg");
+    for (size_t i = 0; i < clients.size(); i++) {
+        const StreamClientStats& c = clients[i];
+        body << (i > 0 ? ", " : "")
+             << "{\"peer\": \"" << c.peer << "\""
+             << ", \"fps\": " << c.fps
+             << ", \"frames_sent\": " << c.frames_sent
+             << ", \"frames_dropped\": " << c.frames_dropped
+             << ", \"queued_bytes\": " << c.queued_bytes
+             << ", \"kernel_outq_bytes\": " << c.kernel_outq_bytes
+             << ", \"rtt_us\": " << c.rtt_us << "}";
+    }
+    // ルートごとの処理時間（リクエストを受け取ってから送り終えるまで）
+    body << "], \"routes\": [";
+    vector<RouteLatencyStats> routes = g_http.routeLatencyStats();
+    for (size_t i = 0; i < routes.size(); i++) {
+        const RouteLatencyStats& r = routes[i];
+        body << (i > 0 ? ", " : "")
+             << "{\"route\": \"" << r.route << "\""
+             << ", \"requests\": " << r.requests
+             << ", \"keep_alive\": " << r.reused
+             << ", \"not_modified\": " << r.not_modified
+             << ", \"mean_ms\": " << r.mean_ms
+             << ", \"max_ms\": " << r.max_ms << "}";
+    }
+    body << "]}\n";
+    g_http.sendResponse(id, "200 OK", "application/json", body.str());
 }
 
-// HTTPサーバースレッド
-void http_server_thread() {
-    int server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_sock < 0) {
-        cerr << "ソケットの作成に失敗しました。" << endl;
-        return;
+// 撮影時刻から各段階までの遅延の分布（--latency時のみ記録される）
+//   GET /stream/latency
+static void handle_stream_latency(HttpServer::ConnectionId id, const HttpRequest& request) {
+    g_http.sendResponse(id, "200 OK", "application/json", g_latency.json());
+}
+
+// VL53L8CXの初期化と測距開始（失敗した段階を表示してfalse）
+static bool startToFSensor(VL53L8CX_Configuration& dev, int tof_hz) {
+    uint8_t alive = 0;
+    uint8_t st = vl53l8cx_is_alive(&dev, &alive);
+    if (st != VL53L8CX_STATUS_OK || !alive) {
+        cerr << "VL53L8CXセンサーが応答しません。" << endl;
+        return false;
     }
 
-    int opt = 1;
-    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (vl53l8cx_init(&dev) != VL53L8CX_STATUS_OK) {
+        cerr << "VL53L8CXセンサーの初期化に失敗しました。" << endl;
+        return false;
+    }
 
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(8080);
+    if (vl53l8cx_set_resolution(&dev, VL53L8CX_RESOLUTION_8X8) != VL53L8CX_STATUS_OK) {
+        cerr << "解像度の設定に失敗しました。" << endl;
+        return false;
+    }
 
-    if (bind(server_sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        cerr << "バインドに失敗しました。" << endl;
-        close(server_sock);
-        return;
+    if (vl53l8cx_set_ranging_frequency_hz(&dev, (uint8_t)max(1, min(15, tof_hz))) != VL53L8CX_STATUS_OK) {
+        cerr << "測距周期の設定に失敗しました。" << endl;
+        return false;
     }
 
-    if (listen(server_sock, 5) < 0) {
-        cerr << "リッスンに失敗しました。" << endl;
-        close(server_sock);
-        return;
+    if (vl53l8cx_start_ranging(&dev) != VL53L8CX_STATUS_OK) {
+        cerr << "レンジングの開始に失敗しました。" << endl;
+        return false;
     }
+    return true;
+}
 
-    cout << "HTTPサーバーがポート8080で起動しました" << endl;
+#ifdef ENABLE_OBJECT_DETECTION
+// HTTPで指定されたモデル・ラベルのパスを解決（モデルディレクトリの外、存在しないファイルはfalse）
+// ディレクトリを含まない名前はモデルディレクトリからの相対パスとして扱う
+static bool resolveModelDirPath(const string& requested, string& resolved) {
+    if (requested.empty() || g_model_dir.empty()) {
+        return false;
+    }
+    string candidate = requested.find('/') == string::npos ? g_model_dir + "/" + requested : requested;
+    char* real = realpath(candidate.c_str(), nullptr);
+    if (real == nullptr) {
+        return false;
+    }
+    resolved = real;
+    free(real);
+    // シンボリックリンクや..をたどった後の実体がモデルディレクトリの下にあること
+    return resolved.size() > g_model_dir.size() + 1 &&
+           resolved.compare(0, g_model_dir.size(), g_model_dir) == 0 &&
+           resolved[g_model_dir.size()] == '/';
+}
+#endif
 
-    while (g_stream_mode) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &client_len);
-        
-        if (client_sock >= 0) {
-            send_http_response(client_sock);
-            close(client_sock);
+// モデル切り替えコマンド
+//   GET /model/load?path=<モデル>[&labels=<ラベル>]  バックグラウンドで読み込み、準備ができたら切り替え
+//                                                     （起動時のモデルと同じディレクトリの下のファイルのみ）
+//   GET /model/status                                 切り替え状態と読み込み・ウォームアップ時間、切り替え間隔
+static void handle_model_command(HttpServer::ConnectionId id, const HttpRequest& request) {
+#ifdef ENABLE_OBJECT_DETECTION
+    lock_guard<mutex> lock(g_detector_cmd_mutex);
+    if (g_async_detector == nullptr) {
+        g_http.sendResponse(id, "503 Service Unavailable", "application/json", "{\"error\": \"detector disabled\"}\n");
+        return;
+    }
+    
+    if (request.path == "/model/load") {
+        string path = request.param("path");
+        string labels = request.param("labels");
+        if (path.empty()) {
+            g_http.sendResponse(id, "400 Bad Request", "application/json", "{\"error\": \"path is required\"}\n");
+            return;
+        }
+        string model_file;
+        if (!resolveModelDirPath(path, model_file)) {
+            g_http.sendResponse(id, "403 Forbidden", "application/json",
+                                "{\"error\": \"model must be a file under " + jsonEscape(g_model_dir) + "\"}\n");
+            return;
+        }
+        string labels_file = g_labels_path;
+        if (!labels.empty() && !resolveModelDirPath(labels, labels_file)) {
+            g_http.sendResponse(id, "403 Forbidden", "application/json",
+                                "{\"error\": \"labels must be a file under " + jsonEscape(g_model_dir) + "\"}\n");
+            return;
+        }
+        path = model_file;
+        bool started = g_async_detector->loadModelAsync(path, labels_file);
+        if (!started) {
+            g_http.sendResponse(id, "409 Conflict", "application/json", "{\"error\": \"another model is loading\"}\n");
+            return;
         }
+        cout << "モデルの切り替えを要求されました: " << path << endl;
+    } else if (request.path != "/model/status") {
+        g_http.sendResponse(id, "404 Not Found", "application/json", "{\"error\": \"unknown command\"}\n");
+        return;
     }
-
-    close(server_sock);
+    
+    ModelSwapStatus status = g_async_detector->swapStatus();
+    ostringstream body;
+    body << "{\"state\": \"" << swapStateName(status.state) << "\""
+         << ", \"model\": \"" << jsonEscape(status.model_path) << "\""
+         << ", \"load_ms\": " << status.load_ms
+         << ", \"warmup_ms\": " << status.warmup_ms
+         << ", \"swap_gap_ms\": " << status.swap_gap_ms;
+    if (!status.error.empty()) {
+        body << ", \"error\": \"" << jsonEscape(status.error) << "\"";
+    }
+    body << "}\n";
+    g_http.sendResponse(id, "200 OK", "application/json", body.str());
+#else
+    g_http.sendResponse(id, "503 Service Unavailable", "application/json", "{\"error\": \"detector disabled\"}\n");
+#endif
 }
 
 int main(int argc, char** argv) {
     // コマンドライン引数の確認
-    if (argc > 1 && string(argv[1]) == "--stream") {
-        g_stream_mode = true;
-        cout << "ストリーミングモードで起動します" << endl;
+    // YOLOv4-tinyモデルを既定とする（OpenCV DNNで確実に動作）
+    // INT8モデルは --model ./Data/models/yolov8n_320_int8.onnx のように指定する
+    string model_path = "./Data/models/yolov4-tiny.weights";
+    string labels_path = "./Data/models/coco.names";
+    bool tof_gate_enabled = true;
+    int tof_gate_range_mm = 1200;   // この距離より近いゾーンが無ければ推論を省略
+    bool motion_gate_enabled = true;
+    int motion_staleness_ms = 3000; // 静止していてもこの間隔で推論を更新
+    string uart_device = "/dev/ttyS0";
+    float nms_iou = 0.4f;           // NMSのIoU閾値
+    bool nms_class_agnostic = false; // trueならクラスをまたいで重複を削除
+    size_t rss_budget_mb = 320;     // プロセスRSSの上限（Zero 2Wの512MBでスワップさせない）
+    bool stream_zerocopy = false;   // MJPEG配信でMSG_ZEROCOPYを使う
+    int tof_hz = 15;                // ToFの測距周期（8x8の上限は15Hz）
+    int jpeg_quality = 95;          // MJPEG配信のJPEG品質
+    JpegSubsampling jpeg_subsampling = JpegSubsampling::S420;
+    bool blackbox_enabled = true;   // 直近の記録を常に残す（/dev/shmのリング、SDカードには書かない）
+    int blackbox_mb = 8;            // リングの大きさ（5fpsの半分のフレーム+ToF 15Hz+UARTで数分）
+    int blackbox_seconds = 30;      // ダンプに含める秒数
+    double blackbox_fps = 2.0;      // 記録するフレームのレート
+    string blackbox_dir = "./Data/blackbox";
+    string session_path;            // 空なら記録しない
+    bool session_raw = false;       // trueならフレームをJPEGにせず画素のまま記録する
+    string source_spec = "libcamera"; // 入力（v4l2:/dev/video0, dir:<path>[@fps], video:<path>, synthetic[:fps]）
+    FramePacing source_pacing = FramePacing::RealTime;
+    bool source_loop = false;       // ファイルの入力を繰り返す
+    bool tof_requested = true;      // --no-tofならToFセンサーを使わない（録画・合成画像の入力ではセンサーが無くても続行）
+    bool latency_timecode = false;  // 配信する画像の下端に撮影時刻の帯を描く（--latency-timecode）
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--stream") {
+            g_stream_mode = true;
+            cout << "ストリーミングモードで起動します" << endl;
+        } else if (arg == "--model" && i + 1 < argc) {
+            model_path = argv[++i];
+        } else if (arg == "--labels" && i + 1 < argc) {
+            labels_path = argv[++i];
+        } else if (arg == "--tof-gate-range" && i + 1 < argc) {
+            tof_gate_range_mm = atoi(argv[++i]);
+        } else if (arg == "--no-tof-gate") {
+            tof_gate_enabled = false;
+        } else if (arg == "--motion-staleness" && i + 1 < argc) {
+            motion_staleness_ms = atoi(argv[++i]);
+        } else if (arg == "--no-motion-gate") {
+            motion_gate_enabled = false;
+        } else if (arg == "--uart" && i + 1 < argc) {
+            uart_device = argv[++i];
+        } else if (arg == "--nms-iou" && i + 1 < argc) {
+            nms_iou = (float)atof(argv[++i]);
+        } else if (arg == "--nms-agnostic") {
+            nms_class_agnostic = true;
+        } else if (arg == "--rss-budget" && i + 1 < argc) {
+            rss_budget_mb = (size_t)atoi(argv[++i]);
+        } else if (arg == "--stream-zerocopy") {
+            stream_zerocopy = true;
+        } else if (arg == "--tof-hz" && i + 1 < argc) {
+            tof_hz = atoi(argv[++i]);
+        } else if (arg == "--jpeg-quality" && i + 1 < argc) {
+            jpeg_quality = atoi(argv[++i]);
+        } else if (arg == "--jpeg-subsampling" && i + 1 < argc) {
+            if (!parseJpegSubsampling(argv[++i], jpeg_subsampling)) {
+                cerr << "--jpeg-subsamplingは444 / 422 / 420のいずれかです" << endl;
+                return -1;
+            }
+        } else if (arg == "--no-blackbox") {
+            blackbox_enabled = false;
+        } else if (arg == "--blackbox-mb" && i + 1 < argc) {
+            blackbox_mb = max(1, atoi(argv[++i]));
+        } else if (arg == "--blackbox-seconds" && i + 1 < argc) {
+            blackbox_seconds = max(1, atoi(argv[++i]));
+        } else if (arg == "--blackbox-fps" && i + 1 < argc) {
+            blackbox_fps = atof(argv[++i]);
+        } else if (arg == "--blackbox-dir" && i + 1 < argc) {
+            blackbox_dir = argv[++i];
+        } else if (arg == "--record-session" && i + 1 < argc) {
+            session_path = argv[++i];
+        } else if (arg == "--record-raw") {
+            session_raw = true;
+        } else if (arg == "--source" && i + 1 < argc) {
+            source_spec = argv[++i];
+        } else if (arg == "--pacing" && i + 1 < argc) {
+            if (!parseFramePacing(argv[++i], source_pacing)) {
+                cerr << "--pacingはrealtime / fastのいずれかです" << endl;
+                return -1;
+            }
+        } else if (arg == "--loop") {
+            source_loop = true;
+        } else if (arg == "--no-tof") {
+            tof_requested = false;
+        } else if (arg == "--latency") {
+            g_latency.setEnabled(true);
+        } else if (arg == "--latency-timecode") {
+            g_latency.setEnabled(true);
+            latency_timecode = true;
+        }
     }
 
     // 起動音を再生
@@ -229,29 +611,133 @@ int main(int argc, char** argv) {
     } else {
         cout << "Depthキャリブレーションデータが見つかりません（デフォルト表示）" << endl;
     }
+    DepthOverlayConfig depth_overlay;
+    depth_overlay.calibrated = use_depth_calib;
+    depth_overlay.region = Rect(depth_offset_x, depth_offset_y, depth_width, depth_height);
+    depth_overlay.alpha = depth_alpha;
 
     // 物体検出器の初期化
 #ifdef ENABLE_OBJECT_DETECTION
-    ObjectDetector* detector = nullptr;
+    // 検出器はトラッカーの2段目（低信頼度の検出で確定トラックをつなぐ）の下限まで候補を出し、
+    // 新規トラック・表示・配信するのはhigh_threshold以上の検出だけにする
+    TrackerConfig tracker_config;
+    shared_ptr<ObjectDetector> detector;
     try {
-        // YOLOv4-tinyモデルを使用（OpenCV DNNで確実に動作）
-        detector = new ObjectDetector(
-            "./Data/models/yolov4-tiny.weights",
-            "./Data/models/coco.names",
-            0.6  // 信頼度閾値（高めに設定してメモリ節約）
+        // メモリ予算に収まらなければマニフェストのfallback（軽いモデル）に切り替える
+        string selected_model = selectModelWithinBudget(model_path, rss_budget_mb);
+        if (selected_model.empty()) {
+            throw runtime_error("メモリ予算内で読み込めるモデルがありません");
+        }
+        size_t rss_before = readRssKb();
+        detector = make_shared<ObjectDetector>(
+            selected_model,
+            labels_path,
+            tracker_config.low_threshold
         );
+        cout << "モデル読み込みによるRSS増加: " << ((double)readRssKb() - (double)rss_before) / 1024.0
+             << "MB（見積もり " << estimateModelRssMb(selected_model, detector->hasManifest() ? &detector->manifest() : nullptr)
+             << "MB）" << endl;
+        NmsConfig nms_config;
+        nms_config.iou_threshold = nms_iou;
+        nms_config.mode = nms_class_agnostic ? NmsMode::ClassAgnostic : NmsMode::ClassAware;
+        detector->setNmsConfig(nms_config);
     } catch (const exception& e) {
         cerr << "物体検出器の初期化に失敗しました: " << e.what() << endl;
         cerr << "物体検出なしで続行します" << endl;
     }
+    
+    // 推論は専用スレッドで実行し、メインループは撮影・オーバーレイ・配信を続ける
+    // モデルはHTTPコマンド（/model/load）で再起動せずに切り替えられる
+    AsyncDetector* async_detector = nullptr;
+    if (detector) {
+        async_detector = new AsyncDetector(detector);
+        async_detector->setMemoryBudgetMb(rss_budget_mb);
+        async_detector->start();
+        detector.reset();   // 以降はasync_detector->detector()で現在のモデルを参照
+        
+        lock_guard<mutex> lock(g_detector_cmd_mutex);
+        g_async_detector = async_detector;
+        g_labels_path = labels_path;
+        char* model_dir = realpath(resolveModelRelative(model_path, ".").c_str(), nullptr);
+        if (model_dir != nullptr) {
+            g_model_dir = model_dir;
+            free(model_dir);
+        }
+    }
+    vector<DetectedObject> latest_detections;  // 最後に完了した推論結果
+    uint64_t last_result_ticket = 0;
+    uint64_t last_submitted_ticket = 0;
+    uint64_t skipped_after_ticket = 0;         // ゲートで省略した時点で投入済みだったチケット（これ以前の結果は捨てる）
+    uint64_t last_result_capture_us = 0;       // 最後に反映した推論結果の撮影時刻（遅延計測用）
+    uint64_t last_result_us = 0;               // 最後に推論結果を反映した時刻
+    
+    // ToFゲート（近距離に何もなければ推論省略、あればその周辺だけ推論）
+    ToFGate tof_gate;
+    tof_gate.setNearRange(tof_gate_range_mm);
+    
+    // 動きゲート（静止シーンでは推論を省略、自己運動中は無効）
+    MotionGate motion_gate;
+    motion_gate.setMaxStaleness(chrono::milliseconds(motion_staleness_ms));
+    
+    // 検出結果を追跡してトラックIDを付ける（挨拶・接近判定はトラック単位で行う）
+    ObjectTracker tracker(tracker_config);
 #endif
 
-    // カメラの初期化（libcamera使用）
-    LibCameraCapture cap(320, 240);
-    if (!cap.isOpened()) {
+    // ブラックボックス（前回のプロセスが残したリングはここで書き出される）
+    if (blackbox_enabled) {
+        g_blackbox.setDumpWindow(chrono::seconds(blackbox_seconds));
+        if (g_blackbox.open("/dev/shm/robot_head.blackbox", (size_t)blackbox_mb * 1024 * 1024, blackbox_dir)) {
+            g_blackbox.setFrameInterval(chrono::milliseconds(blackbox_fps > 0.0 ? (int)(1000.0 / blackbox_fps) : 1000000));
+            g_blackbox.recordEvent("START");
+        } else {
+            cerr << "ブラックボックスを開けませんでした（記録なしで続行）" << endl;
+        }
+    }
+
+    if (!session_path.empty()) {
+        g_session.setFrameFormat(session_raw ? 0 : 90);
+        if (g_session.open(session_path, session_raw ? "robot_head raw" : "robot_head")) {
+            cout << "セッションを記録します: " << session_path << endl;
+            g_session.appendEvent("START", BlackBoxRecorder::nowUs());
+        } else {
+            cerr << "セッションの記録を開始できませんでした（記録なしで続行）" << endl;
+        }
+    }
+
+    // Pico（RobotBody）とのUART通信（モーター状態・IMU・異常通知）
+    UARTPico uart_pico;
+    bool uart_enabled = uart_pico.init(uart_device);
+    if (!uart_enabled) {
+        cout << "UARTを開けませんでした（モーター状態なしで続行）" << endl;
+    }
+    // 送受信した行（IMU・MOTOR・コマンド）は全てブラックボックスに残し、転倒・持ち上げで書き出す
+    uart_pico.setLineCallback([](bool outgoing, const string& line) {
+        g_blackbox.recordUart(outgoing, line);
+        if (g_session.isOpen()) {
+            g_session.appendUart(outgoing, line, BlackBoxRecorder::nowUs());
+        }
+    });
+    uart_pico.setAlertCallback([](const string& reason) {
+        cout << "Picoから異常通知: " << reason << endl;
+        // ダンプするのは転倒・持ち上げだけ（CLIFFなどの日常的な通知はUARTの行として記録に残る）
+        if (reason == "FALL" || reason == "LIFT") {
+            g_blackbox.requestDump(reason);
+        }
+    });
+
+    // カメラの初期化（既定はlibcamera、--sourceで録画・合成画像に切り替える）
+    unique_ptr<FrameSource> cap;
+    if (source_spec == "libcamera") {
+        cap.reset(new LibCameraCapture(320, 240));
+    } else {
+        cap = openFrameSource(source_spec, 320, 240, source_loop);
+    }
+    if (!cap || !cap->isOpened()) {
         cerr << "カメラが見つかりません。" << endl;
         return -1;
     }
+    cap->setPacing(source_pacing);
+    cout << "入力: " << cap->name() << endl;
 
     // VL53L8CXセンサーの初期化
     const string i2c_device = "/dev/i2c-1";
@@ -263,55 +749,84 @@ int main(int argc, char** argv) {
     memset(&dev, 0, sizeof(dev));
     dev.platform.address = 0x52;
 
-    uint8_t alive = 0;
-    uint8_t st = vl53l8cx_is_alive(&dev, &alive);
-    if (st != VL53L8CX_STATUS_OK || !alive) {
-        cerr << "VL53L8CXセンサーが応答しません。" << endl;
-        return -1;
-    }
-
-    if (vl53l8cx_init(&dev) != VL53L8CX_STATUS_OK) {
-        cerr << "VL53L8CXセンサーの初期化に失敗しました。" << endl;
-        return -1;
-    }
-
-    if (vl53l8cx_set_resolution(&dev, VL53L8CX_RESOLUTION_8X8) != VL53L8CX_STATUS_OK) {
-        cerr << "解像度の設定に失敗しました。" << endl;
-        return -1;
-    }
-
-    if (vl53l8cx_start_ranging(&dev) != VL53L8CX_STATUS_OK) {
-        cerr << "レンジングの開始に失敗しました。" << endl;
-        return -1;
+    // 録画・合成画像の入力ではセンサーが無くても深度なしで続ける（ビルド機・CIでの実行用）
+    bool tof_enabled = tof_requested && startToFSensor(dev, tof_hz);
+    if (!tof_enabled) {
+        if (tof_requested && cap->isLive()) {
+            return -1;
+        }
+        cout << "ToFセンサーなしで続行します（深度オーバーレイ・ToFゲートは無効）" << endl;
+    } else {
+        cout << "8x8レンジングを開始しました (Ctrl-Cで停止)" << endl;
     }
-
-    cout << "8x8レンジングを開始しました (Ctrl-Cで停止)" << endl;
     VL53L8CX_ResultsData results;
     bool has_depth = false; // 少なくとも1回は有効なDepthを受信したか
+    uint64_t tof_seq = 0;   // 最後に受け取ったToFReaderの結果
 
-    // HTTPサーバースレッドを開始
-    thread http_thread;
+    // HTTPサーバー（イベントループのスレッド）を開始
     if (g_stream_mode) {
-        http_thread = thread(http_server_thread);
+        g_mjpeg.setJpegOptions(jpeg_quality, jpeg_subsampling);
+        g_mjpeg.setFrameListener(broadcast_jpeg);
+        g_mjpeg.start();
+        g_raw_jpeg.setJpegOptions(jpeg_quality, jpeg_subsampling);
+        g_raw_jpeg.setFrameListener(broadcast_ws);
+        g_raw_jpeg.start();
+        g_http.addRoute("/", handle_stream_request);
+        g_http.addRoute("/ws", handle_ws_request);
+        g_http.addStaticRoute("/view", "text/html; charset=utf-8", kOverlayViewerHtml);   // ブラウザ側でオーバーレイを描くビューア
+        g_http.addRoute("/depth/", handle_depth_request);
+        g_http.addRoute("/model/", handle_model_command);
+        g_http.addRoute("/stream/stats", handle_stream_stats);
+        g_http.addRoute("/stream/latency", handle_stream_latency);
+        g_http.addRoute("/blackbox/", handle_blackbox_request);
+        g_http.setZeroCopy(stream_zerocopy);
+        if (g_http.init(8080)) {
+            g_http.start();
+        } else {
+            cerr << "HTTPサーバーを起動できません（配信なしで続行）" << endl;
+        }
+    }
+
+    // ToFはカメラのループとは別に、センサーの周期で読み出す（以降devにはToFReaderだけが触れる）
+    ToFReader tof_reader(&dev);
+    tof_reader.setFrameListener(on_depth_frame);
+    if (tof_enabled) {
+        tof_reader.start();
     }
 
     // カメラ側もおおよそ5fpsになるようにレート制御
     auto last_frame_time = chrono::steady_clock::now();
+    uint64_t frame_seq = 0;
 
     while (true) {
-        // 5fps目安のウェイト（前フレームから200ms経つまで待つ）
+        // 5fps目安のウェイト（前フレームから200ms経つまで待つ、--pacing fastの録画入力では待たない）
         auto now = chrono::steady_clock::now();
         auto elapsed = chrono::duration_cast<chrono::milliseconds>(now - last_frame_time);
-        if (elapsed < chrono::milliseconds(200)) {
+        bool throttle = cap->isLive() || cap->pacing() == FramePacing::RealTime;
+        if (throttle && elapsed < chrono::milliseconds(200)) {
             this_thread::sleep_for(chrono::milliseconds(200) - elapsed);
         }
         last_frame_time = chrono::steady_clock::now();
 
+        // Picoからの受信処理（モーター状態の更新）
+        if (uart_enabled) {
+            uart_pico.update();
+        }
+
         Mat frame;
-        if (!cap.read(frame) || frame.empty()) {
-            cerr << "カメラ画像の取得に失敗しました。" << endl;
+        if (!cap->read(frame) || frame.empty()) {
+            if (cap->isLive()) {
+                cerr << "カメラ画像の取得に失敗しました。" << endl;
+            } else {
+                cout << "入力の終わりに達しました（" << cap->framesRead() << "フレーム）" << endl;
+            }
             break;
         }
+        auto capture_time = chrono::system_clock::time_point(chrono::microseconds(cap->lastCaptureUs()));
+        // セッションにはカメラから来たままの画像を残す（robot_head_benchで歪み補正から再生する）
+        if (g_session.isOpen()) {
+            g_session.appendFrame(frame, cap->lastCaptureUs());
+        }
 
         // カメラ歪み補正を適用
         Mat undistorted;
@@ -320,23 +835,26 @@ int main(int argc, char** argv) {
             frame = undistorted;
         }
 
-        uint8_t ready = 0;
-        if (vl53l8cx_check_data_ready(&dev, &ready) != VL53L8CX_STATUS_OK) {
-            cerr << "データ準備状態の確認に失敗しました。" << endl;
+        // 読み出しスレッドが受け取った最新の測距結果を使う
+        bool depth_updated = false;
+        if (tof_reader.failed()) {
+            cerr << "ToFセンサーの読み出しに失敗しました。" << endl;
             break;
         }
 
-        if (ready) {
-            if (vl53l8cx_get_ranging_data(&dev, &results) == VL53L8CX_STATUS_OK) {
-                has_depth = true;
-
-                // 最小距離を計算（人検出時の距離判定用）
-                g_min_distance = 4000;
-                for (int i = 0; i < 64; i++) {
-                    if (results.target_status[i] == 5 || results.target_status[i] == 9) {
-                        if (results.distance_mm[i] < g_min_distance) {
-                            g_min_distance = results.distance_mm[i];
-                        }
+        if (tof_reader.latest(results, tof_seq)) {
+            has_depth = true;
+            depth_updated = true;
+            if (g_session.isOpen()) {
+                g_session.appendToFResults(results, BlackBoxRecorder::nowUs());
+            }
+
+            // 最小距離を計算（人検出時の距離判定用）
+            g_min_distance = 4000;
+            for (int i = 0; i < 64; i++) {
+                if (results.target_status[i] == 5 || results.target_status[i] == 9) {
+                    if (results.distance_mm[i] < g_min_distance) {
+                        g_min_distance = results.distance_mm[i];
                     }
                 }
             }
@@ -345,119 +863,162 @@ int main(int argc, char** argv) {
         // 画面を左90度回転（反時計回り）して縦長にする
         rotate(frame, frame, ROTATE_90_COUNTERCLOCKWISE);
 
+        // オーバーレイを描く前のフレームを間引いてブラックボックスに残す
+        uint64_t capture_us = (uint64_t)chrono::duration_cast<chrono::microseconds>(
+            capture_time.time_since_epoch()).count();
+        g_blackbox.recordFrame(frame, capture_us);
+
+        // サーバー側でオーバーレイを描くのはMJPEG視聴者かローカル表示がある時だけ
+        // （WebSocket視聴者だけならブラウザが描くため、描画・合成を丸ごと省く）
+        bool draw_overlays = !g_stream_mode || g_mjpeg.clientCount() > 0;
+        bool ws_viewers = g_stream_mode && g_raw_jpeg.clientCount() > 0;
+
         // カメラ画像をベースにDepthマップをオーバーレイ
-        Mat display = frame.clone();
+        Mat display;
+        if (draw_overlays) {
+            display = frame.clone();
+        }
         
         
-        // 物体検出を実行（回転後の画像に対して）
+        frame_seq++;
+        
+        // 物体検出（回転後の画像に対して非同期に実行）
 #ifdef ENABLE_OBJECT_DETECTION
-        if (detector != nullptr) {
-            try {
-                vector<DetectedObject> detections = detector->detect(display);
-                detector->drawDetections(display, detections);
-                
-                // 人を検出したら距離判定して挨拶音声を再生
-                bool person_detected = false;
-                for (const auto& det : detections) {
-                    if (det.class_name == "person") {
-                        person_detected = true;
-                        break;
-                    }
+        if (async_detector != nullptr) {
+            if (frame_seq == 1) {
+                tof_gate.configure(Rect(depth_offset_x, depth_offset_y, depth_width, depth_height),
+                                   frame.size(), use_depth_calib);
+            }
+            
+            // 連続フレーム差分は毎フレーム更新する（推論中に起きた変化もラッチされる）
+            if (motion_gate_enabled) {
+                motion_gate.setEnabled(!(uart_enabled && uart_pico.isBodyMoving()));
+                motion_gate.update(frame);
+            }
+            
+            // 推論待ちのフレームがなければ投入（推論中でももう一方のblobに前処理しておく）
+            auto gate_time = chrono::steady_clock::now();
+            if (!async_detector->hasPendingFrame() &&
+                (!motion_gate_enabled || motion_gate.shouldRun(gate_time))) {
+                GateDecision gate;
+                if (tof_gate_enabled) {
+                    gate = has_depth ? tof_gate.evaluate(results.distance_mm, results.target_status, 64)
+                                     : tof_gate.evaluateWithoutDepth();
                 }
                 
-                if (person_detected && g_min_distance < 400 && !g_greeting_played && !audio_player.isPlaying()) {
-                    cout << "人を検出しました（距離: " << g_min_distance << "mm） - 挨拶音声を再生します" << endl;
-                    audio_player.playRandomGreeting();
-                    g_greeting_played = true;
+                if (gate.run) {
+                    uint64_t ticket = async_detector->submit(frame, frame_seq, gate.cropped ? gate.roi : Rect(), capture_us);
+                    if (ticket != 0) {
+                        last_submitted_ticket = ticket;
+                    }
+                } else {
+                    // 近距離に何もない: 推論を省略し、何も検出されなかったものとして扱う
+                    skipped_after_ticket = last_submitted_ticket;
+                    latest_detections.clear();
+                    tracker.update(latest_detections, gate_time);
                 }
-                
-                // 人がいなくなったらフラグをリセット（次回検出時に再生できるように）
-                if (!person_detected) {
-                    g_greeting_played = false;
+                if (motion_gate_enabled) {
+                    motion_gate.markInferred(gate_time);
                 }
-            } catch (const exception& e) {
-                cerr << "物体検出エラー: " << e.what() << endl;
             }
-        }
-#endif
-        
-        if (has_depth && use_depth_calib) {
-            // 8x8 depthデータの取得と変換
-            Mat depth_map = Mat::zeros(8, 8, CV_16UC1);
-            for (int i = 0; i < 64; i++) {
-                int row = i / 8;
-                int col = i % 8;
-                depth_map.at<uint16_t>(row, col) = results.distance_mm[i];
-            }
-
-            // Depthマップの正規化（200mm〜2000mmの範囲、近いほど赤）
-            Mat depth_norm = Mat::zeros(8, 8, CV_8UC1);
-            for (int i = 0; i < 8; i++) {
-                for (int j = 0; j < 8; j++) {
-                    uint16_t dist = depth_map.at<uint16_t>(i, j);
-                    // 近いほど高い値（赤）、遠いほど低い値（青）
-                    int val = (int)((2000.0 - dist) * 255.0 / 1800.0);
-                    val = max(0, min(255, val));  // 0-255にクリップ
-                    depth_norm.at<uint8_t>(i, j) = (uint8_t)val;
+            
+            // 新しい推論結果が届いていれば反映（結果はframe_seqのフレームに対するもの）
+            DetectionResult result;
+            if (async_detector->latest(result) && result.ticket != last_result_ticket) {
+                last_result_ticket = result.ticket;
+                tof_gate.recordInference(result.inference_ms, !result.roi.empty());
+                // ゲートで省略する前に投入したフレームの結果は反映しない（消した検出を古い結果で復活させない）
+                if (result.ticket > skipped_after_ticket) {
+                    latest_detections = tracker.confidentDetections(result.objects);
+                    tracker.update(result.objects, result.frame_time, result.roi);
+                    last_result_capture_us = result.capture_us;
+                    last_result_us = BlackBoxRecorder::nowUs();
+                    g_latency.record("capture_to_detect", last_result_capture_us, last_result_us);
                 }
             }
-
-            // キャリブレーションサイズにリサイズ
-            Mat depth_resized;
-            resize(depth_norm, depth_resized, Size(depth_width, depth_height), 0, 0, INTER_NEAREST);
             
-            // カラーマップ適用
-            Mat depth_colored;
-            applyColorMap(depth_resized, depth_colored, COLORMAP_JET);
-
-            // オーバーレイ範囲を計算
-            int x1 = max(0, depth_offset_x);
-            int y1 = max(0, depth_offset_y);
-            int x2 = min(display.cols, depth_offset_x + depth_width);
-            int y2 = min(display.rows, depth_offset_y + depth_height);
+            // 新しい距離データが届いたらトラックごとの距離（と接近速度）を更新
+            if (depth_updated) {
+                tracker.assignDistances([&](const Rect& region) {
+                    return tof_gate.nearestDistance(region, results.distance_mm, results.target_status, 64);
+                }, chrono::steady_clock::now());
+            }
             
-            int dx1 = max(0, -depth_offset_x);
-            int dy1 = max(0, -depth_offset_y);
-            int dx2 = dx1 + (x2 - x1);
-            int dy2 = dy1 + (y2 - y1);
+            // 確定した人のトラックが近く（または近づいてきて）いれば、トラックごとに1回だけ挨拶
+            // 1フレームの検出漏れではトラックが消えないため、同じ人に挨拶を繰り返さない
+            for (auto& track : tracker.tracks()) {
+                if (!track.confirmed || track.greeted || track.class_name != "person") {
+                    continue;
+                }
+                int distance = track.distance_mm >= 0 ? track.distance_mm : g_min_distance;
+                bool near = distance < 400 || (track.isApproaching() && distance < 800);
+                if (near && !audio_player.isPlaying()) {
+                    cout << "人を検出しました（トラック#" << track.id << "、距離: " << distance
+                         << "mm） - 挨拶音声を再生します" << endl;
+                    if (audio_player.playRandomGreeting()) {
+                        // 挨拶の根拠になった推論結果の撮影時刻から、aplayを起動した時刻まで
+                        g_latency.record("capture_to_audio", last_result_capture_us, audio_player.lastStartUs());
+                        g_latency.record("detect_to_audio", last_result_us, audio_player.lastStartUs());
+                    }
+                    track.greeted = true;
+                }
+            }
             
-            // 有効な範囲かチェック
-            if (x2 > x1 && y2 > y1 && dx2 > dx1 && dy2 > dy1 &&
-                dx2 <= depth_colored.cols && dy2 <= depth_colored.rows) {
-                Mat roi = display(Rect(x1, y1, x2 - x1, y2 - y1));
-                Mat depth_roi = depth_colored(Rect(dx1, dy1, dx2 - dx1, dy2 - dy1));
-                addWeighted(roi, 1.0 - depth_alpha, depth_roi, depth_alpha, 0, roi);
+            // 最新フレームには直近の推論結果を重ねる
+            if (draw_overlays) {
+                async_detector->detector()->drawDetections(display, latest_detections);
+                tracker.drawTracks(display);
             }
-        } else if (has_depth) {
-            // キャリブレーションデータがない場合は従来の縦結合方式
-            Mat heatmap_raw(8, 8, CV_16UC1, results.distance_mm);
-            Mat heatmap = heatmap_raw.clone();
-            rotate(heatmap, heatmap, ROTATE_180);
-
-            Mat heatmap_norm, heatmap_resized, heatmap_color;
-            double minVal = 0.0, maxVal = 0.0;
-            minMaxLoc(heatmap, &minVal, &maxVal, nullptr, nullptr);
-
-            if (maxVal > minVal) {
-                Mat heatmap_f32;
-                heatmap.convertTo(heatmap_f32, CV_32F);
-                heatmap_f32 = (heatmap_f32 - static_cast<float>(minVal)) * (255.0f / static_cast<float>(maxVal - minVal));
-                heatmap_f32.convertTo(heatmap_norm, CV_8UC1);
-            } else {
-                heatmap_norm = Mat::zeros(heatmap.size(), CV_8UC1);
+            
+            // 約1分ごとにゲートの統計を出力
+            if (frame_seq % 300 == 0) {
+                if (tof_gate_enabled) cout << tof_gate.statsSummary() << endl;
+                if (motion_gate_enabled) cout << motion_gate.statsSummary() << endl;
+                cout << tracker.statsSummary() << endl;
+                if (g_latency.enabled()) cout << g_latency.summary() << endl;
             }
-
-            int cam_w = frame.cols;
-            resize(heatmap_norm, heatmap_resized, Size(cam_w, cam_w), 0, 0, INTER_NEAREST);
-            applyColorMap(heatmap_resized, heatmap_color, COLORMAP_JET);
-            vconcat(frame, heatmap_color, display);
+        }
+#endif
+        
+        if (draw_overlays && has_depth) {
+            drawDepthOverlay(frame, results.distance_mm, depth_overlay, display);
         }
 
         if (g_stream_mode) {
-            {
-                lock_guard<mutex> lock(g_frame_mutex);
-                g_current_frame = display.clone();
-                g_frame_ready = true;
+            // 撮影時刻を画素に焼き込む（ヘッダーを経由しない、画面を撮影して読む場合にも使える）
+            if (latency_timecode) {
+                if (draw_overlays) {
+                    drawCaptureTimecode(display, capture_us);
+                }
+                if (ws_viewers) {
+                    drawCaptureTimecode(frame, capture_us);
+                }
+            }
+            uint64_t stamp_us = g_latency.enabled() ? capture_us : 0;
+            if (draw_overlays) {
+                g_mjpeg.submit(display, string(), stamp_us);
+            }
+            if (ws_viewers) {
+                // 描画前のフレームと、ブラウザで重ねるための検出結果・距離・撮影時刻
+                ostringstream meta;
+                meta << "{\"seq\": " << frame_seq
+                     << ", \"t_ms\": " << chrono::duration_cast<chrono::milliseconds>(
+                            capture_time.time_since_epoch()).count()
+                     << ", \"width\": " << frame.cols << ", \"height\": " << frame.rows;
+                if (stamp_us != 0) {
+                    meta << ", \"t_us\": " << stamp_us;
+                }
+#ifdef ENABLE_OBJECT_DETECTION
+                if (async_detector != nullptr) {
+                    write_detections_json(meta, latest_detections, tracker.tracks());
+                }
+#endif
+                if (has_depth) {
+                    write_depth_json(meta, results, use_depth_calib,
+                                     Rect(depth_offset_x, depth_offset_y, depth_width, depth_height), depth_alpha);
+                }
+                meta << "}";
+                g_raw_jpeg.submit(frame, meta.str(), stamp_us);
             }
         } else {
             imshow("Camera with Heatmap and Depth Map", display);
@@ -474,18 +1035,58 @@ int main(int argc, char** argv) {
     }
 
     g_stream_mode = false;
-    if (http_thread.joinable()) {
-        http_thread.join();
+    tof_reader.stop();
+    cout << tof_reader.statsSummary() << endl;
+    if (g_http.isRunning()) {
+        g_http.stop();
+        cout << g_http.statsSummary() << endl;
+        cout << g_http.routeStatsSummary();
+    }
+    if (g_mjpeg.isRunning()) {
+        g_mjpeg.stop();
+        cout << g_mjpeg.statsSummary() << endl;
+    }
+    if (g_raw_jpeg.isRunning()) {
+        g_raw_jpeg.stop();
+        cout << "WebSocket " << g_raw_jpeg.statsSummary() << endl;
+    }
+
+    if (g_blackbox.isOpen()) {
+        g_blackbox.recordEvent("STOP");
+        cout << g_blackbox.statsSummary() << endl;
+        g_blackbox.close();
+    }
+    if (g_session.isOpen()) {
+        g_session.appendEvent("STOP", BlackBoxRecorder::nowUs());
+        g_session.close();
+        cout << g_session.statsSummary() << endl;
+    }
+    if (g_latency.enabled()) {
+        cout << g_latency.summary() << endl;
     }
 
-    cap.release();
+    cap->release();
     destroyAllWindows();
-    vl53l8cx_stop_ranging(&dev);
+    if (tof_enabled) {
+        vl53l8cx_stop_ranging(&dev);
+    }
     
-    // 物体検出器のクリーンアップ
+    // 物体検出器のクリーンアップ（推論スレッドを先に止める）
 #ifdef ENABLE_OBJECT_DETECTION
-    if (detector != nullptr) {
-        delete detector;
+    if (tof_gate_enabled) {
+        cout << tof_gate.statsSummary() << endl;
+    }
+    if (motion_gate_enabled) {
+        cout << motion_gate.statsSummary() << endl;
+    }
+    cout << tracker.statsSummary() << endl;
+    {
+        lock_guard<mutex> lock(g_detector_cmd_mutex);
+        g_async_detector = nullptr;
+    }
+    if (async_detector != nullptr) {
+        async_detector->stop();
+        delete async_detector;
     }
 #endif
 
@@ -0,0 +1,1012 @@
+/**
+ * @file http_server.cpp
+ * @brief Implementation of the epoll HTTP server and router
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "network/http_server.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <linux/sockios.h>
+#include <linux/errqueue.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// 古いglibcのヘッダー向け（Linux 4.14以降のカーネルで有効）
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+#ifndef SO_EE_ORIGIN_ZEROCOPY
+#define SO_EE_ORIGIN_ZEROCOPY 5
+#endif
+#ifndef SO_EE_CODE_ZEROCOPY_COPIED
+#define SO_EE_CODE_ZEROCOPY_COPIED 1
+#endif
+
+// epollのdata.u64で接続と区別するための特別なID（接続IDは1から）
+static const uint64_t kListenId = 0;
+static const uint64_t kWakeId = UINT64_MAX;
+
+static const size_t kMaxRequestBytes = 8192;    // リクエスト行+ヘッダーの上限
+static const int kRequestTimeoutMs = 5000;      // 接続してからリクエストが揃うまでの上限
+static const int kKeepAliveIdleMs = 15000;      // keep-aliveで次のリクエストを待つ上限
+static const int kMaxEvents = 32;
+// カーネルの送信キューがこれ以下になるまで次のフレームを送り始めない（遅いクライアントの遅延を約1フレームに抑える）
+static const int kMaxKernelOutqBytes = 32 * 1024;
+// 未送信フレームの送信再開を確認する間隔（カーネルの送信キューが減ってもepollは通知しないため）
+static const int kLoopTickMs = 50;
+// 1回のsendmsgでまとめるチャンク数の上限
+static const int kMaxIov = 16;
+
+string urlDecode(const string& s) {
+    string out;
+    for (size_t i = 0; i < s.size(); i++) {
+        if (s[i] == '%' && i + 2 < s.size()) {
+            out += (char)strtol(s.substr(i + 1, 2).c_str(), nullptr, 16);
+            i += 2;
+        } else if (s[i] == '+') {
+            out += ' ';
+        } else {
+            out += s[i];
+        }
+    }
+    return out;
+}
+
+string HttpRequest::param(const string& key) const {
+    size_t pos = 0;
+    while (pos < query.size()) {
+        size_t end = query.find('&', pos);
+        if (end == string::npos) end = query.size();
+        size_t eq = query.find('=', pos);
+        if (eq != string::npos && eq < end && query.compare(pos, eq - pos, key) == 0 && eq - pos == key.size()) {
+            return urlDecode(query.substr(eq + 1, end - eq - 1));
+        }
+        pos = end + 1;
+    }
+    return "";
+}
+
+string HttpRequest::header(const string& name) const {
+    auto it = headers.find(name);
+    return it != headers.end() ? it->second : "";
+}
+
+// カーネルの送信キューに残っているバイト数
+static int kernelOutq(int fd) {
+    int bytes = 0;
+    if (ioctl(fd, SIOCOUTQ, &bytes) != 0) {
+        return 0;
+    }
+    return bytes;
+}
+
+static string toLower(string s) {
+    transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return s;
+}
+
+// 同じ接続で次のリクエストを受けてよいか（ボディ付きのリクエストは読まないので接続を閉じる）
+static bool wantsKeepAlive(const HttpRequest& request) {
+    string connection = toLower(request.header("connection"));
+    if (!request.header("transfer-encoding").empty() || atol(request.header("content-length").c_str()) > 0) {
+        return false;
+    }
+    if (request.version == "HTTP/1.1") {
+        return connection.find("close") == string::npos;
+    }
+    return request.version == "HTTP/1.0" && connection.find("keep-alive") != string::npos;
+}
+
+// 静的なページのETag（本文のFNV-1aハッシュ）
+static string computeEtag(const string& body) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : body) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+    char etag[24];
+    snprintf(etag, sizeof(etag), "\"%016" PRIx64 "\"", hash);
+    return etag;
+}
+
+static double elapsedMs(chrono::steady_clock::time_point since, chrono::steady_clock::time_point now) {
+    return chrono::duration<double, milli>(now - since).count();
+}
+
+HttpChunk HttpChunk::copyOf(string s) {
+    auto owner = make_shared<const string>(move(s));
+    return HttpChunk(owner, owner->data(), owner->size());
+}
+
+HttpServer::HttpServer()
+    : port_(8080), max_connections_(16), listen_fd_(-1), epoll_fd_(-1), wake_fd_(-1),
+      running_(false), next_id_(1), accepted_(0), rejected_(0), timed_out_(0), keep_alive_reuses_(0), bytes_sent_(0),
+      frames_dropped_(0), frames_sent_(0), send_calls_(0), zerocopy_enabled_(false),
+      zerocopy_min_bytes_(16384), zerocopy_sends_(0), zerocopy_copied_(0) {}
+
+HttpServer::~HttpServer() {
+    stop();
+    if (listen_fd_ >= 0) close(listen_fd_);
+    if (wake_fd_ >= 0) close(wake_fd_);
+    if (epoll_fd_ >= 0) close(epoll_fd_);
+}
+
+bool HttpServer::init(int port, size_t max_connections) {
+    port_ = port;
+    max_connections_ = max(max_connections, (size_t)1);
+
+    listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listen_fd_ < 0) {
+        cerr << "[HttpServer] ソケットの作成に失敗しました" << endl;
+        return false;
+    }
+
+    int opt = 1;
+    setsockopt(listen_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port_);
+
+    if (bind(listen_fd_, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        cerr << "[HttpServer] ポート" << port_ << "にバインドできません: " << strerror(errno) << endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+    if (listen(listen_fd_, 16) < 0) {
+        cerr << "[HttpServer] リッスンに失敗しました: " << strerror(errno) << endl;
+        close(listen_fd_);
+        listen_fd_ = -1;
+        return false;
+    }
+
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    wake_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (epoll_fd_ < 0 || wake_fd_ < 0) {
+        cerr << "[HttpServer] epoll/eventfdの作成に失敗しました" << endl;
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.u64 = kListenId;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev);
+    ev.data.u64 = kWakeId;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &ev);
+
+    cout << "[HttpServer] ポート" << port_ << "で待ち受けます（同時接続 最大" << max_connections_ << "）" << endl;
+    return true;
+}
+
+void HttpServer::start() {
+    if (running_ || epoll_fd_ < 0) {
+        return;
+    }
+    running_ = true;
+    loop_thread_ = thread(&HttpServer::eventLoop, this);
+}
+
+void HttpServer::stop() {
+    if (!running_) {
+        return;
+    }
+    running_ = false;
+    wake();
+    if (loop_thread_.joinable()) {
+        loop_thread_.join();
+    }
+}
+
+void HttpServer::wake() {
+    uint64_t one = 1;
+    if (wake_fd_ >= 0) {
+        ssize_t r = write(wake_fd_, &one, sizeof(one));
+        (void)r;
+    }
+}
+
+void HttpServer::setZeroCopy(bool enable, size_t min_bytes) {
+    zerocopy_enabled_ = enable;
+    zerocopy_min_bytes_ = min_bytes;
+}
+
+void HttpServer::addRoute(const string& prefix, Handler handler) {
+    routes_.push_back(make_pair(prefix, move(handler)));
+}
+
+void HttpServer::addStaticRoute(const string& path, const string& content_type, string body) {
+    // ヘッダーとETagは登録時に1度だけ作り、本文は全リクエストで共有する
+    auto shared_body = make_shared<const string>(move(body));
+    string etag = computeEtag(*shared_body);
+    string headers = "Cache-Control: no-cache\r\n"
+                     "ETag: " + etag + "\r\n"
+                     "Content-Type: " + content_type + "\r\n";
+    addRoute(path, [this, path, shared_body, etag, headers](ConnectionId id, const HttpRequest& request) {
+        if (request.path != path) {
+            sendResponse(id, "404 Not Found", "text/plain", "Not Found\n");
+            return;
+        }
+        lock_guard<mutex> lock(mutex_);
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            return;
+        }
+        Connection& conn = it->second;
+        if (request.header("if-none-match") == etag) {
+            // ブラウザのキャッシュが最新: 本文を送らない
+            conn.not_modified = true;
+            queueResponseLocked(conn, "304 Not Modified", "ETag: " + etag + "\r\n",
+                                HttpChunk(nullptr, nullptr, 0));
+            return;
+        }
+        queueResponseLocked(conn, "200 OK", headers, HttpChunk(shared_body, shared_body->data(), shared_body->size()));
+    });
+}
+
+void HttpServer::eventLoop() {
+    struct epoll_event events[kMaxEvents];
+
+    while (running_) {
+        int n = epoll_wait(epoll_fd_, events, kMaxEvents, kLoopTickMs);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            cerr << "[HttpServer] epoll_waitに失敗しました: " << strerror(errno) << endl;
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            uint64_t id = events[i].data.u64;
+            uint32_t mask = events[i].events;
+
+            if (id == kListenId) {
+                acceptClients();
+                continue;
+            }
+            if (id == kWakeId) {
+                uint64_t value;
+                ssize_t r = read(wake_fd_, &value, sizeof(value));
+                (void)r;
+                continue;
+            }
+
+            if (mask & EPOLLIN) {
+                handleReadable(id);
+            }
+            if (mask & (EPOLLOUT | EPOLLERR | EPOLLHUP)) {
+                vector<function<void()>> callbacks;
+                bool pipelined = false;
+                {
+                    lock_guard<mutex> lock(mutex_);
+                    auto it = connections_.find(id);
+                    if (it != connections_.end()) {
+                        Connection& conn = it->second;
+                        bool failed = (mask & EPOLLHUP) != 0;
+                        if (mask & EPOLLERR) {
+                            // MSG_ZEROCOPYの完了通知もEPOLLERRで届くため、ソケットエラーの時だけ閉じる
+                            if (conn.zerocopy) {
+                                drainErrorQueue(conn);
+                            }
+                            int so_error = 0;
+                            socklen_t len = sizeof(so_error);
+                            getsockopt(conn.fd, SOL_SOCKET, SO_ERROR, &so_error, &len);
+                            failed = failed || so_error != 0 || !conn.zerocopy;
+                        }
+                        if (failed) {
+                            closeLocked(id, callbacks);
+                        } else if (mask & EPOLLOUT) {
+                            flushConnection(conn);
+                            if (conn.write_queue.empty() && conn.close_after_flush) {
+                                finishRequestLocked(conn);
+                                closeLocked(id, callbacks);
+                            } else if (conn.write_queue.empty() && conn.reset_after_flush) {
+                                // keep-alive: 続けて届いていたリクエストがあれば処理する
+                                finishRequestLocked(conn);
+                                pipelined = !conn.read_buffer.empty();
+                            }
+                        }
+                    }
+                }
+                for (auto& cb : callbacks) cb();
+                if (pipelined) {
+                    dispatchBuffered(id);
+                }
+            }
+        }
+
+        closeExpired();
+        promoteAllPending();
+    }
+
+    // 残っている接続を全て閉じる
+    vector<function<void()>> callbacks;
+    {
+        lock_guard<mutex> lock(mutex_);
+        while (!connections_.empty()) {
+            closeLocked(connections_.begin()->first, callbacks);
+        }
+    }
+    for (auto& cb : callbacks) cb();
+}
+
+void HttpServer::acceptClients() {
+    while (true) {
+        struct sockaddr_in addr;
+        socklen_t addr_len = sizeof(addr);
+        int fd = accept4(listen_fd_, (struct sockaddr*)&addr, &addr_len, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                cerr << "[HttpServer] acceptに失敗しました: " << strerror(errno) << endl;
+            }
+            return;
+        }
+
+        lock_guard<mutex> lock(mutex_);
+        if (connections_.size() >= max_connections_) {
+            // 次のリクエストを待っているだけのkeep-alive接続があれば、最も長く待っているものを閉じて空ける
+            auto idle = connections_.end();
+            for (auto c = connections_.begin(); c != connections_.end(); ++c) {
+                const Connection& other = c->second;
+                if (other.requests > 0 && !other.request_done && other.read_buffer.empty() &&
+                    (idle == connections_.end() || other.idle_since < idle->second.idle_since)) {
+                    idle = c;
+                }
+            }
+            if (idle != connections_.end()) {
+                vector<function<void()>> unused;   // keep-alive接続にon_closeは無い
+                closeLocked(idle->first, unused);
+            }
+        }
+        if (connections_.size() >= max_connections_) {
+            // 上限を超えた接続は待たせずに断る（送れなくても閉じるだけ）
+            static const char kBusy[] =
+                "HTTP/1.0 503 Service Unavailable\r\n"
+                "Connection: close\r\n"
+                "Content-Length: 0\r\n\r\n";
+            ssize_t r = send(fd, kBusy, sizeof(kBusy) - 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+            (void)r;
+            close(fd);
+            rejected_++;
+            continue;
+        }
+
+        // MJPEGの各パートをすぐ送るためNagleを無効化
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+        ConnectionId id = next_id_++;
+        Connection& conn = connections_[id];
+        conn.id = id;
+        conn.fd = fd;
+        char peer[INET_ADDRSTRLEN] = {0};
+        inet_ntop(AF_INET, &addr.sin_addr, peer, sizeof(peer));
+        conn.peer = string(peer) + ":" + to_string(ntohs(addr.sin_port));
+        conn.write_offset = 0;
+        conn.queued_bytes = 0;
+        conn.request_done = false;
+        conn.close_after_flush = false;
+        conn.keep_alive = false;
+        conn.reset_after_flush = false;
+        conn.want_write = false;
+        conn.read_closed = false;
+        conn.want_read = true;
+        conn.idle_since = chrono::steady_clock::now();
+        conn.requests = 0;
+        conn.not_modified = false;
+        conn.frames_sent = 0;
+        conn.frames_dropped = 0;
+        conn.fps = 0.0;
+        conn.zerocopy = false;
+        conn.zc_next_seq = 0;
+        if (zerocopy_enabled_) {
+            conn.zerocopy = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = id;
+        epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev);
+        accepted_++;
+    }
+}
+
+void HttpServer::handleReadable(ConnectionId id) {
+    vector<function<void()>> callbacks;
+    string input;
+    function<bool(const char*, size_t)> on_input;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = connections_.find(id);
+        if (it == connections_.end()) {
+            return;
+        }
+        Connection& conn = it->second;
+
+        char buf[2048];
+        bool peer_closed = false;
+        bool peer_eof = false;
+        while (true) {
+            ssize_t n = recv(conn.fd, buf, sizeof(buf), 0);
+            if (n > 0) {
+                // リクエスト後に届いたデータはストリームの受け手に渡す
+                // keep-aliveなら次のリクエストとして取っておく（どちらでもなければ読み捨てる）
+                if (!conn.request_done || (conn.keep_alive && conn.stream.empty())) {
+                    conn.read_buffer.append(buf, (size_t)n);
+                } else if (conn.on_input) {
+                    input.append(buf, (size_t)n);
+                }
+                continue;
+            }
+            if (n == 0) {
+                peer_eof = true;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                peer_closed = true;
+            }
+            break;
+        }
+
+        if (peer_eof) {
+            // 送信側だけ閉じた（shutdown(SHUT_WR)、nc -N）: 受け取ったリクエストには応答してから切断する
+            bool buffered_request = !conn.request_done && conn.read_buffer.find("\r\n\r\n") != string::npos;
+            bool answering = conn.request_done && conn.stream.empty();
+            if (buffered_request || answering) {
+                conn.read_closed = true;
+                if (!conn.write_queue.empty()) {
+                    conn.reset_after_flush = false;
+                    conn.close_after_flush = true;
+                }
+                updateInterestLocked(conn);
+            } else {
+                peer_closed = true;
+            }
+        }
+
+        if (!input.empty() && !peer_closed) {
+            on_input = conn.on_input;
+        }
+        if (conn.request_done && conn.read_buffer.size() > kMaxRequestBytes) {
+            peer_closed = true;   // 応答を待たずに送り続けてくる
+        }
+        if (peer_closed) {
+            closeLocked(id, callbacks);
+        }
+    }
+    for (auto& cb : callbacks) cb();
+
+    if (on_input && !on_input(input.data(), input.size())) {
+        closeConnection(id);
+        return;
+    }
+    dispatchBuffered(id);
+}
+
+void HttpServer::dispatchBuffered(ConnectionId id) {
+    HttpRequest request;
+    bool dispatch_request = false;
+    {
+        lock_guard<mutex> lock(mutex_);
+        auto it = connections_.find(id);
+        if (it == connections_.end() || it->second.request_done) {
+            return;
+        }
+        Connection& conn = it->second;
+
+        size_t end = conn.read_buffer.find("\r\n\r\n");
+        if (end == string::npos && conn.read_buffer.size() > kMaxRequestBytes) {
+            conn.request_done = true;
+            enqueueLocked(conn, HttpChunk::copyOf(
+                "HTTP/1.0 431 Request Header Fields Too Large\r\nConnection: close\r\nContent-Length: 0\r\n\r\n"));
+            conn.close_after_flush = true;
+            updateInterestLocked(conn);
+        } else if (end != string::npos) {
+            conn.request_done = true;
+            if (parseRequest(conn.read_buffer.substr(0, end), request)) {
+                dispatch_request = true;
+                conn.keep_alive = wantsKeepAlive(request);
+                conn.request_received = chrono::steady_clock::now();
+                if (conn.requests > 0) {
+                    keep_alive_reuses_++;
+                }
+            } else {
+                enqueueLocked(conn, HttpChunk::copyOf(
+                    "HTTP/1.0 400 Bad Request\r\nConnection: close\r\nContent-Length: 0\r\n\r\n"));
+                conn.close_after_flush = true;
+                updateInterestLocked(conn);
+            }
+            // パイプラインで続けて届いたリクエストは残しておく
+            conn.read_buffer.erase(0, end + 4);
+            if (!conn.keep_alive) {
+                conn.read_buffer.shrink_to_fit();
+            }
+        }
+    }
+
+    // ハンドラはロックの外で呼ぶ（sendResponse()などがロックを取るため）
+    if (dispatch_request) {
+        dispatch(id, request);
+    }
+}
+
+void HttpServer::dispatch(ConnectionId id, const HttpRequest& request) {
+    const Handler* best = nullptr;
+    size_t best_len = 0;
+    for (const auto& route : routes_) {
+        const string& prefix = route.first;
+        if (request.path.compare(0, prefix.size(), prefix) == 0 && (best == nullptr || prefix.size() > best_len)) {
+            best = &route.second;
+            best_len = prefix.size();
+        }
+    }
+
+    {
+        // 処理時間をルートごとに集計する
+        lock_guard<mutex> lock(mutex_);
+        auto it = connections_.find(id);
+        if (it != connections_.end()) {
+            it->second.route = best != nullptr ? request.path.substr(0, best_len) : "(404)";
+        }
+    }
+    if (best == nullptr) {
+        sendResponse(id, "404 Not Found", "text/plain", "Not Found\n");
+        return;
+    }
+    (*best)(id, request);
+}
+
+bool HttpServer::parseRequest(const string& raw, HttpRequest& request) {
+    size_t line_end = raw.find("\r\n");
+    string line = raw.substr(0, line_end);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = (sp1 == string::npos) ? string::npos : line.find(' ', sp1 + 1);
+    if (sp2 == string::npos) {
+        return false;
+    }
+    request.method = line.substr(0, sp1);
+    request.target = line.substr(sp1 + 1, sp2 - sp1 - 1);
+    request.version = line.substr(sp2 + 1);
+    size_t q = request.target.find('?');
+    request.path = request.target.substr(0, q);
+    request.query = (q == string::npos) ? "" : request.target.substr(q + 1);
+
+    size_t pos = (line_end == string::npos) ? raw.size() : line_end + 2;
+    while (pos < raw.size()) {
+        size_t end = raw.find("\r\n", pos);
+        if (end == string::npos) end = raw.size();
+        size_t colon = raw.find(':', pos);
+        if (colon != string::npos && colon < end) {
+            string name = raw.substr(pos, colon - pos);
+            transform(name.begin(), name.end(), name.begin(), ::tolower);
+            size_t value_start = raw.find_first_not_of(" \t", colon + 1);
+            string value = (value_start == string::npos || value_start >= end) ? "" : raw.substr(value_start, end - value_start);
+            request.headers[name] = value;
+        }
+        pos = end + 2;
+    }
+    return true;
+}
+
+void HttpServer::enqueueLocked(Connection& conn, const HttpChunk& chunk, bool frame_end) {
+    if (chunk.size == 0) {
+        return;
+    }
+    conn.write_queue.push_back(QueuedChunk{chunk, frame_end});
+    conn.queued_bytes += chunk.size;
+}
+
+bool HttpServer::promotePendingLocked(Connection& conn) {
+    if (conn.pending_frame.empty() || !conn.write_queue.empty() || conn.close_after_flush) {
+        return false;
+    }
+    if (kernelOutq(conn.fd) > kMaxKernelOutqBytes) {
+        return false;   // 前のフレームがまだ届いていない
+    }
+    for (size_t i = 0; i < conn.pending_frame.size(); i++) {
+        enqueueLocked(conn, conn.pending_frame[i], i + 1 == conn.pending_frame.size());
+    }
+    conn.pending_frame.clear();
+    updateInterestLocked(conn);
+    return true;
+}
+
+void HttpServer::promoteAllPending() {
+    lock_guard<mutex> lock(mutex_);
+    for (auto& entry : connections_) {
+        promotePendingLocked(entry.second);
+    }
+}
+
+void HttpServer::updateInterestLocked(Connection& conn) {
+    // 送信はイベントループのスレッドでだけ行う（EPOLLOUTで起こす）
+    bool want_write = !conn.write_queue.empty() || conn.close_after_flush;
+    bool want_read = !conn.read_closed;   // half-close後の読み出し可能（EOF）を繰り返し受け取らない
+    if ((want_write == conn.want_write && want_read == conn.want_read) || conn.fd < 0) {
+        return;
+    }
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = (want_read ? (uint32_t)EPOLLIN : 0u) | (want_write ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.u64 = conn.id;
+    epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+    conn.want_write = want_write;
+    conn.want_read = want_read;
+}
+
+void HttpServer::flushConnection(Connection& conn) {
+    // 送信キューのチャンク（パートヘッダー + JPEG + CRLFなど）をまとめて1回のsendmsgで送る
+    bool allow_zerocopy = conn.zerocopy;
+    while (!conn.write_queue.empty()) {
+        struct iovec iov[kMaxIov];
+        int iov_count = 0;
+        size_t total = 0;
+        for (auto it = conn.write_queue.begin(); it != conn.write_queue.end() && iov_count < kMaxIov; ++it) {
+            size_t offset = (iov_count == 0) ? conn.write_offset : 0;
+            iov[iov_count].iov_base = const_cast<char*>(it->chunk.data + offset);
+            iov[iov_count].iov_len = it->chunk.size - offset;
+            total += iov[iov_count].iov_len;
+            iov_count++;
+        }
+
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+        bool zerocopy = allow_zerocopy && total >= zerocopy_min_bytes_;
+        int flags = MSG_NOSIGNAL | MSG_DONTWAIT | (zerocopy ? MSG_ZEROCOPY : 0);
+
+        ssize_t n = sendmsg(conn.fd, &msg, flags);
+        send_calls_++;
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;   // 送信バッファが空くのを待つ
+            }
+            if (zerocopy && errno == ENOBUFS) {
+                allow_zerocopy = false;   // ピン留めできるメモリ（optmem）の上限: 今回はコピーで送る
+                continue;
+            }
+            // 相手が切断した: 呼び出し側で閉じる
+            conn.write_queue.clear();
+            conn.queued_bytes = 0;
+            conn.close_after_flush = true;
+            conn.reset_after_flush = false;
+            conn.route.clear();   // 送れなかったレスポンスは処理時間に数えない
+            return;
+        }
+        bytes_sent_ += (uint64_t)n;
+
+        if (zerocopy) {
+            // 完了通知（エラーキュー）が届くまで送信したバッファを解放しない
+            ZeroCopySend pending;
+            pending.seq = conn.zc_next_seq++;
+            size_t covered = 0;
+            for (auto it = conn.write_queue.begin(); it != conn.write_queue.end() && covered < (size_t)n; ++it) {
+                pending.owners.push_back(it->chunk.owner);
+                covered += it->chunk.size - (it == conn.write_queue.begin() ? conn.write_offset : 0);
+            }
+            conn.zc_inflight.push_back(move(pending));
+            zerocopy_sends_++;
+        }
+
+        // 送れたバイト数だけキューを進める
+        size_t remaining = (size_t)n;
+        while (remaining > 0 && !conn.write_queue.empty()) {
+            const QueuedChunk& front = conn.write_queue.front();
+            size_t left = front.chunk.size - conn.write_offset;
+            if (remaining < left) {
+                conn.write_offset += remaining;
+                break;
+            }
+            remaining -= left;
+            if (front.frame_end) {
+                // 送り終えたフレームの間隔からクライアントごとの実効fpsを求める
+                auto now = chrono::steady_clock::now();
+                if (conn.frames_sent > 0) {
+                    double dt = chrono::duration<double>(now - conn.last_frame_sent).count();
+                    double fps = dt > 0.0 ? 1.0 / dt : 0.0;
+                    conn.fps = conn.frames_sent == 1 ? fps : conn.fps * 0.8 + fps * 0.2;
+                }
+                conn.last_frame_sent = now;
+                conn.frames_sent++;
+                frames_sent_++;
+            }
+            conn.queued_bytes -= front.chunk.size;
+            conn.write_queue.pop_front();
+            conn.write_offset = 0;
+        }
+    }
+    if (!promotePendingLocked(conn)) {
+        updateInterestLocked(conn);
+    }
+}
+
+void HttpServer::drainErrorQueue(Connection& conn) {
+    // MSG_ZEROCOPYの完了通知: 送信番号の範囲[lo, hi]のバッファはもう参照されない
+    while (true) {
+        char control[128];
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        if (recvmsg(conn.fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0) {
+            return;
+        }
+        for (struct cmsghdr* cm = CMSG_FIRSTHDR(&msg); cm != nullptr; cm = CMSG_NXTHDR(&msg, cm)) {
+            if (!((cm->cmsg_level == SOL_IP && cm->cmsg_type == IP_RECVERR) ||
+                  (cm->cmsg_level == SOL_IPV6 && cm->cmsg_type == IPV6_RECVERR))) {
+                continue;
+            }
+            const struct sock_extended_err* err = (const struct sock_extended_err*)CMSG_DATA(cm);
+            if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) {
+                continue;
+            }
+            uint32_t hi = err->ee_data;
+            if (err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) {
+                zerocopy_copied_++;   // カーネルがコピーにフォールバックした（ループバックなど）
+            }
+            while (!conn.zc_inflight.empty() && (int32_t)(conn.zc_inflight.front().seq - hi) <= 0) {
+                conn.zc_inflight.pop_front();
+            }
+        }
+    }
+}
+
+void HttpServer::closeLocked(ConnectionId id, vector<function<void()>>& callbacks) {
+    auto it = connections_.find(id);
+    if (it == connections_.end()) {
+        return;
+    }
+    Connection& conn = it->second;
+    if (conn.fd >= 0) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+        close(conn.fd);
+        conn.fd = -1;
+    }
+    if (conn.on_close) {
+        callbacks.push_back(move(conn.on_close));
+    }
+    connections_.erase(it);
+}
+
+void HttpServer::finishRequestLocked(Connection& conn) {
+    if (!conn.route.empty()) {
+        double ms = elapsedMs(conn.request_received, chrono::steady_clock::now());
+        RouteStats& stats = route_stats_[conn.route];
+        stats.requests++;
+        stats.reused += conn.requests > 0 ? 1 : 0;
+        stats.not_modified += conn.not_modified ? 1 : 0;
+        stats.total_ms += ms;
+        stats.max_ms = max(stats.max_ms, ms);
+        conn.requests++;
+        conn.route.clear();
+    }
+    conn.not_modified = false;
+    if (conn.reset_after_flush) {
+        conn.reset_after_flush = false;
+        conn.keep_alive = false;
+        conn.request_done = false;
+        conn.idle_since = chrono::steady_clock::now();
+    }
+}
+
+void HttpServer::closeExpired() {
+    auto now = chrono::steady_clock::now();
+    vector<function<void()>> callbacks;
+    {
+        lock_guard<mutex> lock(mutex_);
+        vector<ConnectionId> expired;
+        for (const auto& entry : connections_) {
+            const Connection& conn = entry.second;
+            int limit_ms = conn.requests > 0 ? kKeepAliveIdleMs : kRequestTimeoutMs;
+            if (!conn.request_done &&
+                chrono::duration_cast<chrono::milliseconds>(now - conn.idle_since).count() > limit_ms) {
+                expired.push_back(entry.first);
+                if (conn.requests == 0) {
+                    timed_out_++;   // keep-aliveの待ち時間切れは正常な終了なので数えない
+                }
+            }
+        }
+        for (ConnectionId id : expired) {
+            closeLocked(id, callbacks);
+        }
+    }
+    for (auto& cb : callbacks) cb();
+}
+
+void HttpServer::queueResponseLocked(Connection& conn, const string& status, const string& headers,
+                                     const HttpChunk& body) {
+    bool keep_alive = conn.keep_alive && conn.stream.empty() && !conn.read_closed;
+    string head;
+    if (keep_alive) {
+        head = "HTTP/1.1 " + status + "\r\n"
+               "Connection: keep-alive\r\n"
+               "Keep-Alive: timeout=" + to_string(kKeepAliveIdleMs / 1000) + "\r\n";
+    } else {
+        head = "HTTP/1.0 " + status + "\r\n"
+               "Connection: close\r\n";
+    }
+    head += headers;
+    if (status.compare(0, 3, "304") != 0) {
+        head += "Content-Length: " + to_string(body.size) + "\r\n";
+    }
+    head += "\r\n";
+
+    enqueueLocked(conn, HttpChunk::copyOf(move(head)));
+    enqueueLocked(conn, body);
+    if (keep_alive) {
+        conn.reset_after_flush = true;
+    } else {
+        conn.close_after_flush = true;
+    }
+    updateInterestLocked(conn);
+}
+
+void HttpServer::sendResponse(ConnectionId id, const string& status, const string& content_type, const string& body) {
+    lock_guard<mutex> lock(mutex_);
+    auto it = connections_.find(id);
+    if (it == connections_.end()) {
+        return;
+    }
+    queueResponseLocked(it->second, status,
+                        "Cache-Control: no-cache\r\nContent-Type: " + content_type + "\r\n",
+                        HttpChunk::copyOf(body));
+}
+
+bool HttpServer::beginStream(ConnectionId id, const string& stream, const string& header,
+                             function<void()> on_close, function<bool(const char*, size_t)> on_input) {
+    lock_guard<mutex> lock(mutex_);
+    auto it = connections_.find(id);
+    if (it == connections_.end()) {
+        return false;
+    }
+    Connection& conn = it->second;
+    conn.stream = stream;
+    conn.on_close = move(on_close);
+    conn.on_input = move(on_input);
+    enqueueLocked(conn, HttpChunk::copyOf(header));
+    updateInterestLocked(conn);
+    return true;
+}
+
+size_t HttpServer::broadcast(const string& stream, const vector<HttpChunk>& chunks) {
+    size_t count = 0;
+    lock_guard<mutex> lock(mutex_);
+    for (auto& entry : connections_) {
+        Connection& conn = entry.second;
+        if (conn.stream != stream || conn.close_after_flush) {
+            continue;
+        }
+        // 未送信のフレームは新しいフレームで置き換える（送信中のフレームは途中で切らない）
+        if (!conn.pending_frame.empty()) {
+            conn.frames_dropped++;
+            frames_dropped_++;
+        }
+        conn.pending_frame = chunks;
+        promotePendingLocked(conn);
+        count++;
+    }
+    return count;
+}
+
+void HttpServer::closeConnection(ConnectionId id) {
+    vector<function<void()>> callbacks;
+    {
+        lock_guard<mutex> lock(mutex_);
+        closeLocked(id, callbacks);
+    }
+    for (auto& cb : callbacks) cb();
+}
+
+size_t HttpServer::connectionCount() {
+    lock_guard<mutex> lock(mutex_);
+    return connections_.size();
+}
+
+size_t HttpServer::streamClientCount(const string& stream) {
+    lock_guard<mutex> lock(mutex_);
+    size_t count = 0;
+    for (const auto& entry : connections_) {
+        if (entry.second.stream == stream) {
+            count++;
+        }
+    }
+    return count;
+}
+
+vector<StreamClientStats> HttpServer::streamClientStats(const string& stream) {
+    vector<StreamClientStats> stats;
+    auto now = chrono::steady_clock::now();
+    lock_guard<mutex> lock(mutex_);
+    for (const auto& entry : connections_) {
+        const Connection& conn = entry.second;
+        if (conn.stream != stream) {
+            continue;
+        }
+        StreamClientStats s;
+        s.id = conn.id;
+        s.peer = conn.peer;
+        s.fps = conn.fps;
+        if (conn.frames_sent > 0) {
+            // 止まっているクライアントは最後のフレームからの経過時間でfpsを下げる
+            double idle = chrono::duration<double>(now - conn.last_frame_sent).count();
+            if (idle > 0.0 && 1.0 / idle < s.fps) {
+                s.fps = 1.0 / idle;
+            }
+        }
+        s.frames_sent = conn.frames_sent;
+        s.frames_dropped = conn.frames_dropped;
+        s.queued_bytes = conn.queued_bytes;
+        s.kernel_outq_bytes = kernelOutq(conn.fd);
+        struct tcp_info info;
+        socklen_t len = sizeof(info);
+        s.rtt_us = getsockopt(conn.fd, IPPROTO_TCP, TCP_INFO, &info, &len) == 0 ? (int)info.tcpi_rtt : -1;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+vector<RouteLatencyStats> HttpServer::routeLatencyStats() {
+    vector<RouteLatencyStats> stats;
+    lock_guard<mutex> lock(mutex_);
+    for (const auto& entry : route_stats_) {
+        const RouteStats& r = entry.second;
+        RouteLatencyStats s;
+        s.route = entry.first;
+        s.requests = r.requests;
+        s.reused = r.reused;
+        s.not_modified = r.not_modified;
+        s.mean_ms = r.requests > 0 ? r.total_ms / r.requests : 0.0;
+        s.max_ms = r.max_ms;
+        stats.push_back(s);
+    }
+    return stats;
+}
+
+string HttpServer::routeStatsSummary() {
+    ostringstream os;
+    for (const RouteLatencyStats& s : routeLatencyStats()) {
+        os << "  " << s.route << ": " << s.requests << "リクエスト（keep-alive " << s.reused << ", 304 "
+           << s.not_modified << "）, 平均 " << s.mean_ms << "ms, 最大 " << s.max_ms << "ms\n";
+    }
+    return os.str();
+}
+
+string HttpServer::statsSummary() const {
+    ostringstream os;
+    os << "HTTPサーバー: 接続 " << accepted_ << "件（keep-aliveで再利用 " << keep_alive_reuses_
+       << "リクエスト）, 上限超過で拒否 " << rejected_
+       << "件, リクエスト待ちタイムアウト " << timed_out_ << "件, 送信 " << bytes_sent_ / 1024
+       << "KB, 遅いクライアントで捨てたフレーム " << frames_dropped_;
+    uint64_t frames = frames_sent_;
+    if (frames > 0) {
+        os << ", 送信syscall " << (double)send_calls_ / frames << "回/フレーム";
+    }
+    if (zerocopy_enabled_) {
+        os << ", MSG_ZEROCOPY " << zerocopy_sends_ << "回（コピーにフォールバック " << zerocopy_copied_ << "回）";
+    }
+    return os.str();
+}
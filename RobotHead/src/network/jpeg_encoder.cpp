@@ -0,0 +1,167 @@
+/**
+ * @file jpeg_encoder.cpp
+ * @brief Implementation of the reusable JPEG encoder
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "network/jpeg_encoder.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <iostream>
+
+#ifdef ENABLE_TURBOJPEG
+#include <turbojpeg.h>
+#endif
+
+using namespace cv;
+using namespace std;
+
+bool parseJpegSubsampling(const string& text, JpegSubsampling& out) {
+    if (text == "444") {
+        out = JpegSubsampling::S444;
+    } else if (text == "422") {
+        out = JpegSubsampling::S422;
+    } else if (text == "420") {
+        out = JpegSubsampling::S420;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* jpegSubsamplingName(JpegSubsampling subsampling) {
+    switch (subsampling) {
+        case JpegSubsampling::S444: return "444";
+        case JpegSubsampling::S422: return "422";
+        default: return "420";
+    }
+}
+
+#ifdef ENABLE_TURBOJPEG
+static int toTjSubsampling(JpegSubsampling subsampling) {
+    switch (subsampling) {
+        case JpegSubsampling::S444: return TJSAMP_444;
+        case JpegSubsampling::S422: return TJSAMP_422;
+        default: return TJSAMP_420;
+    }
+}
+#endif
+
+JpegEncoder::JpegEncoder(int quality, JpegSubsampling subsampling)
+    : quality_(95), subsampling_(subsampling), handle_(nullptr), buffer_(nullptr), buffer_size_(0) {
+    setQuality(quality);
+#ifdef ENABLE_TURBOJPEG
+    handle_ = tjInitCompress();
+    if (handle_ == nullptr) {
+        cerr << "[JpegEncoder] TurboJPEGの初期化に失敗しました: " << tjGetErrorStr() << endl;
+    }
+#endif
+}
+
+JpegEncoder::~JpegEncoder() {
+#ifdef ENABLE_TURBOJPEG
+    if (buffer_ != nullptr) {
+        tjFree(buffer_);
+    }
+    if (handle_ != nullptr) {
+        tjDestroy(static_cast<tjhandle>(handle_));
+    }
+#endif
+}
+
+bool JpegEncoder::usesTurboJpeg() {
+#ifdef ENABLE_TURBOJPEG
+    return true;
+#else
+    return false;
+#endif
+}
+
+void JpegEncoder::setQuality(int quality) {
+    quality_ = std::max(1, std::min(100, quality));
+}
+
+bool JpegEncoder::ensureBuffer(int width, int height, int tj_subsampling) {
+#ifdef ENABLE_TURBOJPEG
+    // 最悪の場合の圧縮サイズを確保しておき、以降はTJFLAG_NOREALLOCでそのまま使う
+    unsigned long needed = tjBufSize(width, height, tj_subsampling);
+    if (needed == (unsigned long)-1) {
+        return false;
+    }
+    if (needed > buffer_size_) {
+        if (buffer_ != nullptr) {
+            tjFree(buffer_);
+        }
+        buffer_ = tjAlloc((int)needed);
+        buffer_size_ = buffer_ != nullptr ? needed : 0;
+    }
+    return buffer_ != nullptr;
+#else
+    (void)width;
+    (void)height;
+    (void)tj_subsampling;
+    return false;
+#endif
+}
+
+bool JpegEncoder::encode(const Mat& image, vector<unsigned char>& out) {
+    if (image.empty() || (image.type() != CV_8UC3 && image.type() != CV_8UC1)) {
+        cerr << "[JpegEncoder] BGR（CV_8UC3）またはグレースケール（CV_8UC1）の画像が必要です" << endl;
+        return false;
+    }
+
+#ifdef ENABLE_TURBOJPEG
+    bool gray = image.type() == CV_8UC1;
+    int tj_subsampling = gray ? TJSAMP_GRAY : toTjSubsampling(subsampling_);
+    if (handle_ != nullptr && ensureBuffer(image.cols, image.rows, tj_subsampling)) {
+        unsigned char* jpeg = buffer_;
+        unsigned long jpeg_size = buffer_size_;
+        if (tjCompress2(static_cast<tjhandle>(handle_), image.data, image.cols, (int)image.step[0], image.rows,
+                        gray ? TJPF_GRAY : TJPF_BGR, &jpeg, &jpeg_size, tj_subsampling, quality_,
+                        TJFLAG_NOREALLOC) != 0) {
+            cerr << "[JpegEncoder] 圧縮に失敗しました: " << tjGetErrorStr2(static_cast<tjhandle>(handle_)) << endl;
+            return false;
+        }
+        out.assign(jpeg, jpeg + jpeg_size);
+        return true;
+    }
+#endif
+
+    // TurboJPEGが無い場合: パラメータだけは毎回作らずに使い回す
+    int sampling_factor = subsampling_ == JpegSubsampling::S444 ? IMWRITE_JPEG_SAMPLING_FACTOR_444
+                        : subsampling_ == JpegSubsampling::S422 ? IMWRITE_JPEG_SAMPLING_FACTOR_422
+                        : IMWRITE_JPEG_SAMPLING_FACTOR_420;
+    if (imencode_params_.size() != 4 || imencode_params_[1] != quality_ || imencode_params_[3] != sampling_factor) {
+        imencode_params_ = {IMWRITE_JPEG_QUALITY, quality_, IMWRITE_JPEG_SAMPLING_FACTOR, sampling_factor};
+    }
+    return imencode(".jpg", image, out, imencode_params_);
+}
+
+bool JpegEncoder::encodeI420(const Mat& yuv, int width, int height, vector<unsigned char>& out) {
+    if (yuv.type() != CV_8UC1 || !yuv.isContinuous() || yuv.cols != width || yuv.rows != height * 3 / 2 ||
+        width % 2 != 0 || height % 2 != 0) {
+        cerr << "[JpegEncoder] I420画像の形式が不正です" << endl;
+        return false;
+    }
+
+#ifdef ENABLE_TURBOJPEG
+    if (handle_ != nullptr && ensureBuffer(width, height, TJSAMP_420)) {
+        unsigned char* jpeg = buffer_;
+        unsigned long jpeg_size = buffer_size_;
+        // pad=1: 各プレーンの行に詰め物が無い（Y: width, U/V: width/2）
+        if (tjCompressFromYUV(static_cast<tjhandle>(handle_), yuv.data, width, 1, height, TJSAMP_420,
+                              &jpeg, &jpeg_size, quality_, TJFLAG_NOREALLOC) != 0) {
+            cerr << "[JpegEncoder] YUVの圧縮に失敗しました: " << tjGetErrorStr2(static_cast<tjhandle>(handle_)) << endl;
+            return false;
+        }
+        out.assign(jpeg, jpeg + jpeg_size);
+        return true;
+    }
+#endif
+
+    Mat bgr;
+    cvtColor(yuv, bgr, COLOR_YUV2BGR_I420);
+    return encode(bgr, out);
+}
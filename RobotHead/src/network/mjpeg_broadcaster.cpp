@@ -0,0 +1,181 @@
+/**
+ * @file mjpeg_broadcaster.cpp
+ * @brief Implementation of the encode-once MJPEG frame broadcaster
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "network/mjpeg_broadcaster.h"
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+const char kMjpegPartTrailer[] = "\r\n";
+const size_t kMjpegPartTrailerSize = sizeof(kMjpegPartTrailer) - 1;
+
+MjpegBroadcaster::MjpegBroadcaster(int jpeg_quality, JpegSubsampling subsampling)
+    : encoder_(jpeg_quality, subsampling), has_pending_(false), pending_capture_us_(0), next_seq_(1), last_jpeg_size_(0),
+      clients_(0), running_(false), submitted_(0), encodes_(0), dropped_(0),
+      idle_skips_(0), encode_us_total_(0) {}
+
+MjpegBroadcaster::~MjpegBroadcaster() {
+    stop();
+}
+
+void MjpegBroadcaster::setJpegOptions(int quality, JpegSubsampling subsampling) {
+    if (running_) {
+        cerr << "[MjpegBroadcaster] JPEGの設定はstart()より前に行ってください" << endl;
+        return;
+    }
+    encoder_.setQuality(quality);
+    encoder_.setSubsampling(subsampling);
+}
+
+void MjpegBroadcaster::start() {
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    thread_ = thread(&MjpegBroadcaster::encoderThread, this);
+}
+
+void MjpegBroadcaster::stop() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    pending_cv_.notify_all();
+    frame_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void MjpegBroadcaster::submit(const Mat& frame, string metadata, uint64_t capture_us) {
+    if (frame.empty()) {
+        return;
+    }
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (has_pending_) {
+            dropped_++;
+        }
+        frame.copyTo(pending_);   // 同じサイズなら既存のバッファを再利用
+        pending_time_ = chrono::steady_clock::now();
+        pending_metadata_ = move(metadata);
+        pending_capture_us_ = capture_us;
+        has_pending_ = true;
+    }
+    submitted_++;
+    pending_cv_.notify_one();
+}
+
+JpegFramePtr MjpegBroadcaster::waitForFrame(uint64_t last_seq, int timeout_ms) {
+    unique_lock<mutex> lock(mutex_);
+    frame_cv_.wait_for(lock, chrono::milliseconds(timeout_ms), [&]() {
+        return !running_ || (latest_ && latest_->seq > last_seq);
+    });
+    if (latest_ && latest_->seq > last_seq) {
+        return latest_;
+    }
+    return nullptr;
+}
+
+JpegFramePtr MjpegBroadcaster::latest() {
+    lock_guard<mutex> lock(mutex_);
+    return latest_;
+}
+
+void MjpegBroadcaster::encoderThread() {
+    while (true) {
+        chrono::steady_clock::time_point submit_time;
+        uint64_t capture_us = 0;
+        string metadata;
+        {
+            unique_lock<mutex> lock(mutex_);
+            pending_cv_.wait(lock, [this]() { return has_pending_ || !running_; });
+            if (!running_) {
+                break;
+            }
+            swap(pending_, encoding_);
+            submit_time = pending_time_;
+            metadata.swap(pending_metadata_);
+            capture_us = pending_capture_us_;
+            has_pending_ = false;
+        }
+
+        if (clients_ <= 0) {
+            // 次に接続したクライアントに古いフレームを送らないよう破棄しておく
+            lock_guard<mutex> lock(mutex_);
+            latest_.reset();
+            idle_skips_++;
+            continue;
+        }
+
+        // 送信中のクライアントがバッファを参照し続けるため、JPEGは毎回新しいバッファに作る
+        auto frame = make_shared<JpegFrame>();
+        frame->data.reserve(last_jpeg_size_ + last_jpeg_size_ / 4);
+        frame->submit_time = submit_time;
+        frame->capture_us = capture_us;
+        frame->metadata = move(metadata);
+
+        auto t0 = chrono::steady_clock::now();
+        if (!encoder_.encode(encoding_, frame->data)) {
+            cerr << "[MjpegBroadcaster] JPEGエンコードに失敗しました" << endl;
+            continue;
+        }
+        encode_us_total_ += (uint64_t)chrono::duration_cast<chrono::microseconds>(
+            chrono::steady_clock::now() - t0).count();
+        encodes_++;
+        last_jpeg_size_ = frame->data.size();
+        frame->encoded_us = (uint64_t)chrono::duration_cast<chrono::microseconds>(
+            chrono::system_clock::now().time_since_epoch()).count();
+        int header_size;
+        if (capture_us != 0) {
+            // 遅延計測用（latency_tool）: mjpg-streamerと同じ秒.マイクロ秒の形式
+            header_size = snprintf(frame->part_header, sizeof(frame->part_header),
+                                   "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n"
+                                   "X-Timestamp: %llu.%06llu\r\nX-Encoded-Timestamp: %llu.%06llu\r\n\r\n",
+                                   frame->data.size(),
+                                   (unsigned long long)(capture_us / 1000000), (unsigned long long)(capture_us % 1000000),
+                                   (unsigned long long)(frame->encoded_us / 1000000),
+                                   (unsigned long long)(frame->encoded_us % 1000000));
+        } else {
+            header_size = snprintf(frame->part_header, sizeof(frame->part_header),
+                                   "--" MJPEG_BOUNDARY "\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\n\r\n",
+                                   frame->data.size());
+        }
+        frame->part_header_size = (size_t)header_size;
+
+        {
+            lock_guard<mutex> lock(mutex_);
+            frame->seq = next_seq_++;
+            latest_ = frame;
+        }
+        frame_cv_.notify_all();
+        if (listener_) {
+            listener_(frame);
+        }
+    }
+}
+
+double MjpegBroadcaster::meanEncodeMs() const {
+    uint64_t n = encodes_;
+    return n > 0 ? (double)encode_us_total_ / n / 1000.0 : 0.0;
+}
+
+string MjpegBroadcaster::statsSummary() const {
+    ostringstream os;
+    os << "MJPEG配信: 入力 " << submitted_ << "フレーム, エンコード " << encodes_
+       << "回 (" << (JpegEncoder::usesTurboJpeg() ? "TurboJPEG" : "imencode")
+       << " 品質" << encoder_.quality() << " " << jpegSubsamplingName(encoder_.subsampling())
+       << ", 平均 " << meanEncodeMs() << "ms), 上書き " << dropped_
+       << ", 視聴者なしで省略 " << idle_skips_;
+    return os.str();
+}
@@ -0,0 +1,141 @@
+/**
+ * @file overlay_viewer.cpp
+ * @brief Browser page that draws detection and depth overlays on the raw WebSocket stream
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "network/overlay_viewer.h"
+
+// メタデータの形式（main.cppで作成）:
+//   {"seq", "t_ms"（撮影時刻、UNIX時刻ms）, "width", "height",
+//    "detections": [{"c": クラス名, "p": 信頼度, "b": [x, y, w, h]}],
+//    "tracks": [{"id", "c": クラス名, "b": [x, y, w, h], "d": 距離mm（不明なら-1）, "v": [vx, vy]（px/s）}],
+//    "depth": {"mm": [64], "mode": "overlay"（キャリブレーション済み、"rect"と"alpha"あり）/ "below"}}
+//   --latency時は "t_us"（撮影時刻、UNIX時刻us）と "t_enc_us"（エンコード完了時刻）も付く（latency_tool用）
+// 描画はこれまでサーバー側で行っていたdrawDetections / drawTracks / 距離マップと同じ見た目にする
+const char kOverlayViewerHtml[] = R"HTML(<!DOCTYPE html>
+<html>
+<head>
+<meta charset="utf-8">
+<title>RobotHead</title>
+<style>
+body { margin: 0; background: #111; color: #ccc; font: 12px monospace; }
+canvas { display: block; max-width: 100vw; max-height: 94vh; }
+</style>
+</head>
+<body>
+<canvas id="view"></canvas>
+<div id="status">connecting...</div>
+<script>
+const canvas = document.getElementById('view');
+const ctx = canvas.getContext('2d');
+const status = document.getElementById('status');
+let meta = null, busy = false, frames = 0, fps = 0, fpsStart = performance.now();
+
+function jet(v) {
+  const f = x => Math.round(255 * Math.max(0, Math.min(1, 1.5 - Math.abs(x))));
+  return `rgb(${f(4 * v - 3)},${f(4 * v - 2)},${f(4 * v - 1)})`;
+}
+
+function drawDepth(depth, w, h) {
+  const mm = depth.mm;
+  if (depth.mode === 'overlay') {
+    // 200mm〜2000mm、近いほど赤（キャリブレーションした範囲に半透明で重ねる）
+    const [x, y, dw, dh] = depth.rect;
+    ctx.globalAlpha = depth.alpha;
+    for (let i = 0; i < 64; i++) {
+      const r = i >> 3, c = i & 7;
+      const x0 = x + Math.floor(c * dw / 8), x1 = x + Math.floor((c + 1) * dw / 8);
+      const y0 = y + Math.floor(r * dh / 8), y1 = y + Math.floor((r + 1) * dh / 8);
+      ctx.fillStyle = jet(Math.max(0, Math.min(1, (2000 - mm[i]) / 1800)));
+      ctx.fillRect(x0, y0, x1 - x0, y1 - y0);
+    }
+    ctx.globalAlpha = 1;
+  } else {
+    // キャリブレーションなし: 画像の下に180度回転したヒートマップ（最小〜最大で正規化）
+    const lo = Math.min(...mm), hi = Math.max(...mm);
+    for (let i = 0; i < 64; i++) {
+      const r = 7 - (i >> 3), c = 7 - (i & 7);
+      const x0 = Math.floor(c * w / 8), x1 = Math.floor((c + 1) * w / 8);
+      const y0 = h + Math.floor(r * w / 8), y1 = h + Math.floor((r + 1) * w / 8);
+      ctx.fillStyle = jet(hi > lo ? (mm[i] - lo) / (hi - lo) : 0);
+      ctx.fillRect(x0, y0, x1 - x0, y1 - y0);
+    }
+  }
+}
+
+function draw(m, image) {
+  const below = m && m.depth && m.depth.mode === 'below';
+  const w = image.width, h = image.height;
+  if (canvas.width !== w || canvas.height !== h + (below ? w : 0)) {
+    canvas.width = w;
+    canvas.height = h + (below ? w : 0);
+  }
+  ctx.drawImage(image, 0, 0);
+  if (!m) return;
+  if (m.depth) drawDepth(m.depth, w, h);
+
+  ctx.font = '13px sans-serif';
+  ctx.textBaseline = 'top';
+  for (const d of m.detections || []) {
+    const [x, y, bw, bh] = d.b;
+    ctx.strokeStyle = '#0f0';
+    ctx.lineWidth = 2;
+    ctx.strokeRect(x, y, bw, bh);
+    const label = `${d.c}: ${Math.floor(d.p * 100)}%`;
+    const ly = Math.max(0, y - 5);
+    ctx.fillStyle = '#0f0';
+    ctx.fillRect(x, ly, ctx.measureText(label).width, 16);
+    ctx.fillStyle = '#000';
+    ctx.fillText(label, x, ly + 1);
+  }
+  for (const t of m.tracks || []) {
+    const [x, y, bw, bh] = t.b;
+    ctx.fillStyle = ctx.strokeStyle = '#ff0';
+    ctx.fillText(`#${t.id}` + (t.d >= 0 ? ` ${t.d}mm` : ''), x, Math.min(h - 14, y + bh + 2));
+    const cx = x + bw / 2, cy = y + bh / 2;
+    ctx.beginPath();
+    ctx.moveTo(cx, cy);
+    ctx.lineTo(cx + t.v[0] * 0.5, cy + t.v[1] * 0.5);
+    ctx.stroke();
+  }
+}
+
+function connect() {
+  const ws = new WebSocket(`ws://${location.host}/ws`);
+  ws.binaryType = 'blob';
+  ws.onmessage = e => {
+    if (typeof e.data === 'string') {
+      meta = JSON.parse(e.data);
+      return;
+    }
+    if (busy) return;   // 前のフレームをデコード中なら捨てる
+    busy = true;
+    const m = meta;
+    createImageBitmap(e.data).then(image => {
+      draw(m, image);
+      image.close();
+      busy = false;
+      frames++;
+      const now = performance.now();
+      if (now - fpsStart >= 1000) {
+        fps = frames * 1000 / (now - fpsStart);
+        frames = 0;
+        fpsStart = now;
+      }
+      status.textContent = `frame ${m ? m.seq : '-'}  ${fps.toFixed(1)} fps  ` +
+                           (m ? `capture→draw ${Date.now() - m.t_ms} ms` : '');
+    }).catch(() => { busy = false; });
+  };
+  ws.onopen = () => { status.textContent = 'connected'; };
+  ws.onclose = () => {
+    status.textContent = 'disconnected, retrying...';
+    setTimeout(connect, 1000);
+  };
+}
+connect();
+</script>
+</body>
+</html>
+)HTML";
@@ -0,0 +1,200 @@
+/**
+ * @file websocket.cpp
+ * @brief Implementation of the minimal server-side WebSocket helpers
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "network/websocket.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+using namespace std;
+
+// RFC 6455で決められたGUID（キーに連結してSHA-1を取る）
+static const char kWebSocketGuid[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+// クライアントからのフレームはCloseを見つけるためだけに読むので、大きなものは受け付けない
+static const uint64_t kMaxClientPayload = 64 * 1024;
+
+static uint32_t rotl32(uint32_t x, int n) {
+    return (x << n) | (x >> (32 - n));
+}
+
+// SHA-1（ハンドシェイクのキー計算のみに使う。ライブラリを追加しないため自前で実装）
+static void sha1(const string& message, unsigned char digest[20]) {
+    uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    string data = message;
+    uint64_t bit_length = (uint64_t)message.size() * 8;
+    data.push_back((char)0x80);
+    while (data.size() % 64 != 56) {
+        data.push_back('\0');
+    }
+    for (int i = 7; i >= 0; i--) {
+        data.push_back((char)((bit_length >> (i * 8)) & 0xFF));
+    }
+
+    for (size_t block = 0; block < data.size(); block += 64) {
+        uint32_t w[80];
+        for (int i = 0; i < 16; i++) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(data.data() + block + i * 4);
+            w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+        }
+        for (int i = 16; i < 80; i++) {
+            w[i] = rotl32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+
+        uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (int i = 0; i < 80; i++) {
+            uint32_t f, k;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDC;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6;
+            }
+            uint32_t temp = rotl32(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotl32(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+
+    for (int i = 0; i < 5; i++) {
+        digest[i * 4] = (unsigned char)(h[i] >> 24);
+        digest[i * 4 + 1] = (unsigned char)(h[i] >> 16);
+        digest[i * 4 + 2] = (unsigned char)(h[i] >> 8);
+        digest[i * 4 + 3] = (unsigned char)h[i];
+    }
+}
+
+static string base64Encode(const unsigned char* data, size_t size) {
+    static const char kTable[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    string out;
+    out.reserve((size + 2) / 3 * 4);
+    for (size_t i = 0; i < size; i += 3) {
+        uint32_t n = (uint32_t)data[i] << 16;
+        if (i + 1 < size) n |= (uint32_t)data[i + 1] << 8;
+        if (i + 2 < size) n |= data[i + 2];
+        out.push_back(kTable[(n >> 18) & 0x3F]);
+        out.push_back(kTable[(n >> 12) & 0x3F]);
+        out.push_back(i + 1 < size ? kTable[(n >> 6) & 0x3F] : '=');
+        out.push_back(i + 2 < size ? kTable[n & 0x3F] : '=');
+    }
+    return out;
+}
+
+static string toLower(string s) {
+    transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)tolower(c); });
+    return s;
+}
+
+bool isWebSocketUpgrade(const HttpRequest& request) {
+    return toLower(request.header("upgrade")) == "websocket" &&
+           toLower(request.header("connection")).find("upgrade") != string::npos;
+}
+
+string websocketAcceptKey(const string& client_key) {
+    unsigned char digest[20];
+    sha1(client_key + kWebSocketGuid, digest);
+    return base64Encode(digest, sizeof(digest));
+}
+
+string websocketHandshakeResponse(const HttpRequest& request) {
+    string key = request.header("sec-websocket-key");
+    if (!isWebSocketUpgrade(request) || key.empty() || request.header("sec-websocket-version") != "13") {
+        return "";
+    }
+    return "HTTP/1.1 101 Switching Protocols\r\n"
+           "Upgrade: websocket\r\n"
+           "Connection: Upgrade\r\n"
+           "Sec-WebSocket-Accept: " + websocketAcceptKey(key) + "\r\n\r\n";
+}
+
+size_t websocketFrameHeader(WebSocketOpcode opcode, uint64_t payload_size, unsigned char out[kWebSocketMaxHeaderSize]) {
+    out[0] = 0x80 | (unsigned char)opcode;   // FIN
+    if (payload_size < 126) {
+        out[1] = (unsigned char)payload_size;
+        return 2;
+    }
+    if (payload_size <= 0xFFFF) {
+        out[1] = 126;
+        out[2] = (unsigned char)(payload_size >> 8);
+        out[3] = (unsigned char)payload_size;
+        return 4;
+    }
+    out[1] = 127;
+    for (int i = 0; i < 8; i++) {
+        out[2 + i] = (unsigned char)(payload_size >> ((7 - i) * 8));
+    }
+    return 10;
+}
+
+HttpChunk websocketFrame(WebSocketOpcode opcode, const string& payload) {
+    unsigned char header[kWebSocketMaxHeaderSize];
+    size_t header_size = websocketFrameHeader(opcode, payload.size(), header);
+    string frame;
+    frame.reserve(header_size + payload.size());
+    frame.append(reinterpret_cast<const char*>(header), header_size);
+    frame.append(payload);
+    return HttpChunk::copyOf(std::move(frame));
+}
+
+bool WebSocketReader::feed(const char* data, size_t size) {
+    if (closed_) {
+        return false;
+    }
+    buffer_.append(data, size);
+
+    while (buffer_.size() >= 2) {
+        const unsigned char* p = reinterpret_cast<const unsigned char*>(buffer_.data());
+        uint8_t opcode = p[0] & 0x0F;
+        bool masked = (p[1] & 0x80) != 0;
+        uint64_t payload_size = p[1] & 0x7F;
+        size_t header_size = 2;
+        if (payload_size == 126) {
+            if (buffer_.size() < 4) break;
+            payload_size = ((uint64_t)p[2] << 8) | p[3];
+            header_size = 4;
+        } else if (payload_size == 127) {
+            if (buffer_.size() < 10) break;
+            payload_size = 0;
+            for (int i = 0; i < 8; i++) {
+                payload_size = (payload_size << 8) | p[2 + i];
+            }
+            header_size = 10;
+        }
+
+        // クライアントからのフレームは必ずマスクされる（RFC 6455 5.1）
+        if (!masked || payload_size > kMaxClientPayload) {
+            closed_ = true;
+            return false;
+        }
+        size_t frame_size = header_size + 4 + (size_t)payload_size;
+        if (buffer_.size() < frame_size) {
+            break;
+        }
+        if (opcode == (uint8_t)WebSocketOpcode::Close) {
+            closed_ = true;
+            return false;
+        }
+        buffer_.erase(0, frame_size);
+    }
+    return true;
+}
@@ -0,0 +1,426 @@
+/**
+ * @file black_box.cpp
+ * @brief Implementation of the mmap segment-ring black-box recorder
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "platform/black_box.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+static const char kRingMagic[8] = {'R', 'B', 'B', 'X', 'R', 'I', 'N', 'G'};
+static const char kDumpMagic[8] = {'R', 'B', 'B', 'X', 'D', 'U', 'M', 'P'};
+static const uint32_t kVersion = 1;
+static const size_t kRingHeaderBytes = 4096;        // リングのファイル先頭（セグメントはページ境界から）
+static const size_t kMinSegmentBytes = 64 * 1024;
+static const int kPostTriggerMs = 1000;             // トリガー後もこの時間は記録してから書き出す
+static const int kDumpCooldownMs = 5000;            // ALERTが続けて届いても書き出しは1回にする
+
+// リングのファイル先頭
+struct RingHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t segment_count;
+    uint64_t segment_bytes;
+};
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static bool makeDirectories(const string& path) {
+    for (size_t pos = 1; pos <= path.size(); pos++) {
+        if (pos == path.size() || path[pos] == '/') {
+            string dir = path.substr(0, pos);
+            if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+BlackBoxRecorder::BlackBoxRecorder()
+    : fd_(-1), base_(nullptr), mapped_bytes_(0), segment_count_(0), segment_bytes_(0), current_(0),
+      next_seq_(1), dump_window_(30), encoder_(70), frame_interval_(500), dumping_(false),
+      overhead_us_(0), too_large_(0), dumps_(0) {
+    for (auto& c : counts_) {
+        c = 0;
+    }
+}
+
+BlackBoxRecorder::~BlackBoxRecorder() {
+    close();
+}
+
+uint64_t BlackBoxRecorder::nowUs() {
+    return (uint64_t)chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+}
+
+BlackBoxRecorder::SegmentHeader* BlackBoxRecorder::segment(size_t index) const {
+    return reinterpret_cast<SegmentHeader*>(base_ + kRingHeaderBytes + index * segment_bytes_);
+}
+
+char* BlackBoxRecorder::segmentData(size_t index) const {
+    return reinterpret_cast<char*>(segment(index)) + sizeof(SegmentHeader);
+}
+
+bool BlackBoxRecorder::open(const string& ring_path, size_t ring_bytes, const string& dump_dir,
+                            size_t segment_count) {
+    close();
+    segment_count_ = max(segment_count, (size_t)2);
+    segment_bytes_ = max(alignUp(ring_bytes / segment_count_, 4096), kMinSegmentBytes);
+    mapped_bytes_ = kRingHeaderBytes + segment_count_ * segment_bytes_;
+    dump_dir_ = dump_dir;
+
+    fd_ = ::open(ring_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        cerr << "[BlackBox] リングのファイルを開けません: " << ring_path << " (" << strerror(errno) << ")" << endl;
+        return false;
+    }
+
+    struct stat st;
+    bool same_size = fstat(fd_, &st) == 0 && (size_t)st.st_size == mapped_bytes_;
+    if (!same_size && ftruncate(fd_, (off_t)mapped_bytes_) != 0) {
+        cerr << "[BlackBox] リングの確保に失敗しました: " << strerror(errno) << endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    // 記録中にページフォルトしないよう、全ページを先に割り当てておく
+    void* mapped = mmap(nullptr, mapped_bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd_, 0);
+    if (mapped == MAP_FAILED) {
+        cerr << "[BlackBox] mmapに失敗しました: " << strerror(errno) << endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    base_ = static_cast<char*>(mapped);
+    scratch_.resize(segment_bytes_);
+
+    // 前回のプロセスがclose()せずに終わった（落ちた・killされた）リングは、消す前に最後のdump_window_秒を書き出す
+    RingHeader* header = reinterpret_cast<RingHeader*>(base_);
+    if (same_size && memcmp(header->magic, kRingMagic, sizeof(kRingMagic)) == 0 && header->version == kVersion &&
+        header->segment_count == segment_count_ && header->segment_bytes == segment_bytes_) {
+        uint64_t newest = 0;
+        for (size_t i = 0; i < segment_count_; i++) {
+            if (segment(i)->seq != 0 && segment(i)->records > 0) {
+                newest = max(newest, segment(i)->last_us);
+            }
+        }
+        uint64_t window_us = (uint64_t)dump_window_.count() * 1000000ULL;
+        string path;
+        if (newest > 0 && writeDump("previous_run", newest, newest > window_us ? newest - window_us : 0, path)) {
+            cout << "[BlackBox] 前回の記録を書き出しました: " << path << endl;
+        }
+    }
+
+    memset(base_, 0, kRingHeaderBytes);
+    memcpy(header->magic, kRingMagic, sizeof(kRingMagic));
+    header->version = kVersion;
+    header->segment_count = (uint32_t)segment_count_;
+    header->segment_bytes = segment_bytes_;
+    for (size_t i = 0; i < segment_count_; i++) {
+        memset(segment(i), 0, sizeof(SegmentHeader));
+    }
+    current_ = 0;
+    next_seq_ = 1;
+    segment(0)->seq = next_seq_++;
+
+    opened_at_ = chrono::steady_clock::now();
+    last_frame_ = chrono::steady_clock::time_point();
+    last_dump_ = chrono::steady_clock::time_point();
+    cout << "[BlackBox] " << ring_path << " に " << mapped_bytes_ / (1024 * 1024) << "MBのリングを確保しました（"
+         << segment_count_ << "セグメント、ダンプ先 " << dump_dir_ << "）" << endl;
+    return true;
+}
+
+void BlackBoxRecorder::close() {
+    if (dump_thread_.joinable()) {
+        dump_thread_.join();
+    }
+    lock_guard<mutex> lock(mutex_);
+    if (base_ != nullptr) {
+        // 正常に閉じた印（次の起動時に書き出さない）
+        memset(base_, 0, sizeof(RingHeader));
+        munmap(base_, mapped_bytes_);
+        base_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void BlackBoxRecorder::addOverhead(chrono::steady_clock::time_point start) {
+    overhead_us_ += (uint64_t)chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - start).count();
+}
+
+bool BlackBoxRecorder::recordLocked(BlackBoxRecordType type, const void* data, size_t size, uint64_t timestamp_us) {
+    if (base_ == nullptr) {
+        return false;
+    }
+    size_t capacity = segment_bytes_ - sizeof(SegmentHeader);
+    size_t needed = alignUp(sizeof(BlackBoxRecordHeader) + size, 8);
+    if (needed > capacity) {
+        too_large_++;
+        return false;
+    }
+
+    SegmentHeader* seg = segment(current_);
+    if (seg->used + needed > capacity) {
+        // 次のセグメント（最も古い記録）を上書きする
+        current_ = (current_ + 1) % segment_count_;
+        seg = segment(current_);
+        seg->seq = next_seq_++;
+        seg->used = 0;
+        seg->records = 0;
+        seg->first_us = timestamp_us;
+        seg->last_us = 0;
+    }
+    if (seg->records == 0) {
+        seg->first_us = timestamp_us;
+    }
+
+    // データを書いてからusedを進める（プロセスが途中で落ちても読める範囲が壊れない）
+    char* p = segmentData(current_) + seg->used;
+    BlackBoxRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.size = (uint32_t)size;
+    header.type = (uint8_t)type;
+    header.timestamp_us = timestamp_us;
+    memcpy(p, &header, sizeof(header));
+    if (size > 0) {
+        memcpy(p + sizeof(header), data, size);
+    }
+    seg->used += (uint32_t)needed;
+    seg->records++;
+    seg->last_us = max(seg->last_us, timestamp_us);
+    counts_[(size_t)type]++;
+    return true;
+}
+
+bool BlackBoxRecorder::record(BlackBoxRecordType type, const void* data, size_t size, uint64_t timestamp_us) {
+    auto t0 = chrono::steady_clock::now();
+    bool ok;
+    {
+        lock_guard<mutex> lock(mutex_);
+        ok = recordLocked(type, data, size, timestamp_us);
+    }
+    addOverhead(t0);
+    return ok;
+}
+
+bool BlackBoxRecorder::recordFrame(const cv::Mat& frame, uint64_t timestamp_us) {
+    auto t0 = chrono::steady_clock::now();
+    if (!isOpen() || frame.empty() ||
+        (last_frame_ != chrono::steady_clock::time_point() && t0 - last_frame_ < frame_interval_)) {
+        return false;
+    }
+    last_frame_ = t0;
+
+    // エンコーダーと出力バッファはフレームを記録するスレッド（メインループ）だけが使う
+    if (!encoder_.encode(frame, jpeg_)) {
+        return false;
+    }
+    bool ok;
+    {
+        lock_guard<mutex> lock(mutex_);
+        ok = recordLocked(BlackBoxRecordType::Frame, jpeg_.data(), jpeg_.size(), timestamp_us);
+    }
+    addOverhead(t0);
+    return ok;
+}
+
+void BlackBoxRecorder::recordDepth(const DepthFrame& frame) {
+    auto t0 = chrono::steady_clock::now();
+    {
+        lock_guard<mutex> lock(mutex_);
+        encodeDepthFrame(frame, depth_);   // 同じ大きさなので2回目以降は確保しない
+        recordLocked(BlackBoxRecordType::Depth, depth_.data(), depth_.size(), frame.timestamp_us);
+    }
+    addOverhead(t0);
+}
+
+void BlackBoxRecorder::recordUart(bool outgoing, const string& line) {
+    record(outgoing ? BlackBoxRecordType::UartTx : BlackBoxRecordType::UartRx, line.data(), line.size(), nowUs());
+}
+
+void BlackBoxRecorder::recordEvent(const string& text) {
+    record(BlackBoxRecordType::Event, text.data(), text.size(), nowUs());
+}
+
+bool BlackBoxRecorder::requestDump(const string& reason) {
+    bool idle = false;
+    if (!isOpen() || !dumping_.compare_exchange_strong(idle, true)) {
+        return false;   // 書き出し中
+    }
+    auto now = chrono::steady_clock::now();
+    if (last_dump_ != chrono::steady_clock::time_point() &&
+        now - last_dump_ < chrono::milliseconds(kDumpCooldownMs)) {
+        dumping_ = false;
+        return false;
+    }
+    last_dump_ = now;
+    recordEvent("DUMP," + reason);
+
+    if (dump_thread_.joinable()) {
+        dump_thread_.join();   // 前回の書き出しは終わっている
+    }
+    uint64_t trigger_us = nowUs();
+    uint64_t window_us = (uint64_t)dump_window_.count() * 1000000ULL;
+    uint64_t from_us = trigger_us > window_us ? trigger_us - window_us : 0;
+    dump_thread_ = thread([this, reason, trigger_us, from_us]() {
+        this_thread::sleep_for(chrono::milliseconds(kPostTriggerMs));
+        string path;
+        if (writeDump(reason, trigger_us, from_us, path)) {
+            cout << "[BlackBox] " << reason << ": 直近" << dump_window_.count() << "秒を書き出しました: " << path << endl;
+            lock_guard<mutex> lock(mutex_);
+            last_dump_path_ = path;
+        }
+        dumping_ = false;
+    });
+    return true;
+}
+
+string BlackBoxRecorder::lastDumpPath() {
+    lock_guard<mutex> lock(mutex_);
+    return last_dump_path_;
+}
+
+bool BlackBoxRecorder::writeDump(const string& reason, uint64_t trigger_us, uint64_t from_us, string& path) {
+    if (!makeDirectories(dump_dir_)) {
+        cerr << "[BlackBox] ダンプ先を作成できません: " << dump_dir_ << endl;
+        return false;
+    }
+    time_t seconds = (time_t)(trigger_us / 1000000);
+    struct tm local;
+    localtime_r(&seconds, &local);
+    char name[64];
+    strftime(name, sizeof(name), "blackbox_%Y%m%d-%H%M%S_", &local);
+    path = dump_dir_ + "/" + name + reason + ".rbb";
+
+    FILE* fp = fopen(path.c_str(), "wb");
+    if (fp == nullptr) {
+        cerr << "[BlackBox] ダンプを作成できません: " << path << " (" << strerror(errno) << ")" << endl;
+        return false;
+    }
+
+    BlackBoxDumpHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kDumpMagic, sizeof(kDumpMagic));
+    header.version = kVersion;
+    header.trigger_us = trigger_us;
+    header.from_us = from_us;
+    strncpy(header.reason, reason.c_str(), sizeof(header.reason) - 1);
+    fwrite(&header, sizeof(header), 1, fp);
+
+    // 書き始めた順にセグメントを並べる
+    vector<pair<uint64_t, size_t>> order;
+    {
+        lock_guard<mutex> lock(mutex_);
+        for (size_t i = 0; i < segment_count_; i++) {
+            const SegmentHeader* seg = segment(i);
+            if (seg->seq != 0 && seg->records > 0 && seg->last_us >= from_us) {
+                order.push_back(make_pair(seg->seq, i));
+            }
+        }
+    }
+    sort(order.begin(), order.end());
+
+    // 1セグメントずつロックを取って写し、ファイルへの書き込みはロックの外で行う
+    for (const auto& entry : order) {
+        size_t used;
+        {
+            lock_guard<mutex> lock(mutex_);
+            const SegmentHeader* seg = segment(entry.second);
+            if (seg->seq != entry.first) {
+                continue;   // 書き出し中に上書きされた
+            }
+            used = seg->used;
+            if (used > segment_bytes_ - sizeof(SegmentHeader)) {
+                // 壊れたセグメントヘッダー（前回のプロセスのリング）: 写さずに飛ばす
+                cerr << "[BlackBox] セグメントの使用量が不正なため省きます: " << used << endl;
+                continue;
+            }
+            memcpy(scratch_.data(), segmentData(entry.second), used);
+        }
+        size_t offset = 0;
+        while (offset + sizeof(BlackBoxRecordHeader) <= used) {
+            BlackBoxRecordHeader record;
+            memcpy(&record, scratch_.data() + offset, sizeof(record));
+            size_t record_bytes = alignUp(sizeof(record) + (size_t)record.size, 8);
+            if (record_bytes > used - offset) {
+                // 書きかけで止まった記録（前回のプロセスのリング）: このセグメントの残りは読まない
+                cerr << "[BlackBox] 壊れた記録を検出したためセグメントの残りを省きます" << endl;
+                break;
+            }
+            if (record.timestamp_us >= from_us) {
+                fwrite(scratch_.data() + offset, record_bytes, 1, fp);
+                header.record_count++;
+            }
+            offset += record_bytes;
+        }
+    }
+
+    // 転倒直後に電源が落ちても残るよう、閉じる前にディスクへ書き込む
+    fseek(fp, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fp);
+    fflush(fp);
+    fsync(fileno(fp));
+    bool ok = !ferror(fp);
+    fclose(fp);
+    if (ok) {
+        dumps_++;
+    }
+    return ok;
+}
+
+double BlackBoxRecorder::overheadPercent() const {
+    double elapsed_us = (double)chrono::duration_cast<chrono::microseconds>(
+        chrono::steady_clock::now() - opened_at_).count();
+    return elapsed_us > 0.0 ? 100.0 * (double)overhead_us_ / elapsed_us : 0.0;
+}
+
+double BlackBoxRecorder::retainedSeconds() {
+    lock_guard<mutex> lock(mutex_);
+    if (base_ == nullptr) {
+        return 0.0;
+    }
+    uint64_t oldest = UINT64_MAX, newest = 0;
+    for (size_t i = 0; i < segment_count_; i++) {
+        const SegmentHeader* seg = segment(i);
+        if (seg->seq != 0 && seg->records > 0) {
+            oldest = min(oldest, seg->first_us);
+            newest = max(newest, seg->last_us);
+        }
+    }
+    return newest > oldest ? (double)(newest - oldest) / 1e6 : 0.0;
+}
+
+string BlackBoxRecorder::statsSummary() {
+    ostringstream os;
+    os << "ブラックボックス: フレーム " << counts_[(size_t)BlackBoxRecordType::Frame]
+       << ", ToF " << counts_[(size_t)BlackBoxRecordType::Depth]
+       << ", UART受信 " << counts_[(size_t)BlackBoxRecordType::UartRx]
+       << ", UART送信 " << counts_[(size_t)BlackBoxRecordType::UartTx]
+       << ", イベント " << counts_[(size_t)BlackBoxRecordType::Event]
+       << "件（大きすぎて破棄 " << too_large_ << "）, 保持 " << retainedSeconds()
+       << "秒, 記録の負荷 " << overheadPercent() << "%（1コア換算）, ダンプ " << dumps_ << "件";
+    return os.str();
+}
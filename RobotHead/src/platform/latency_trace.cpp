@@ -0,0 +1,92 @@
+/**
+ * @file latency_trace.cpp
+ * @brief Implementation of the per-stage latency distributions
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "platform/latency_trace.h"
+#include <algorithm>
+#include <cstdio>
+#include <sstream>
+
+using namespace std;
+
+LatencyTrace::LatencyTrace(size_t window) : window_(max<size_t>(window, 1)), enabled_(false) {}
+
+void LatencyTrace::record(const string& stage, uint64_t start_us, uint64_t end_us) {
+    if (!enabled_ || start_us == 0 || end_us < start_us) {
+        return;
+    }
+    double ms = (end_us - start_us) / 1000.0;
+
+    lock_guard<mutex> lock(mutex_);
+    Stage& s = stages_[stage];
+    if (s.samples_ms.size() < window_) {
+        s.samples_ms.push_back(ms);
+    } else {
+        s.samples_ms[s.next] = ms;
+        s.next = (s.next + 1) % window_;
+    }
+    s.count++;
+    s.max_ms = max(s.max_ms, ms);
+}
+
+static double percentileOf(const vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    return sorted[(size_t)(p * (sorted.size() - 1))];
+}
+
+vector<LatencyStageStats> LatencyTrace::stats() const {
+    vector<LatencyStageStats> out;
+    lock_guard<mutex> lock(mutex_);
+    for (const auto& entry : stages_) {
+        vector<double> sorted = entry.second.samples_ms;
+        sort(sorted.begin(), sorted.end());
+        LatencyStageStats st;
+        st.stage = entry.first;
+        st.count = entry.second.count;
+        st.p50_ms = percentileOf(sorted, 0.50);
+        st.p95_ms = percentileOf(sorted, 0.95);
+        st.p99_ms = percentileOf(sorted, 0.99);
+        st.max_ms = entry.second.max_ms;
+        out.push_back(st);
+    }
+    return out;
+}
+
+string LatencyTrace::summary() const {
+    ostringstream os;
+    os << "区間ごとの遅延（ms）:";
+    vector<LatencyStageStats> all = stats();
+    if (all.empty()) {
+        os << " 記録なし";
+    }
+    for (const auto& st : all) {
+        char line[192];
+        snprintf(line, sizeof(line), "\n  %-28s n=%-7llu p50 %7.1f  p95 %7.1f  p99 %7.1f  max %7.1f",
+                 st.stage.c_str(), (unsigned long long)st.count, st.p50_ms, st.p95_ms, st.p99_ms, st.max_ms);
+        os << line;
+    }
+    return os.str();
+}
+
+string LatencyTrace::json() const {
+    ostringstream os;
+    os << "{\"enabled\": " << (enabled_ ? "true" : "false") << ", \"stages\": [";
+    vector<LatencyStageStats> all = stats();
+    for (size_t i = 0; i < all.size(); i++) {
+        const LatencyStageStats& st = all[i];
+        os << (i > 0 ? ", " : "")
+           << "{\"stage\": \"" << st.stage << "\""
+           << ", \"count\": " << st.count
+           << ", \"p50_ms\": " << st.p50_ms
+           << ", \"p95_ms\": " << st.p95_ms
+           << ", \"p99_ms\": " << st.p99_ms
+           << ", \"max_ms\": " << st.max_ms << "}";
+    }
+    os << "]}\n";
+    return os.str();
+}
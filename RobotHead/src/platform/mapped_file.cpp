@@ -0,0 +1,66 @@
+/**
+ * @file mapped_file.cpp
+ * @brief Implementation of the read-only memory mapped file
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "platform/mapped_file.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <iostream>
+
+using namespace std;
+
+MappedFile::MappedFile() : data_(nullptr), size_(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const string& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+
+    void* addr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);   // マッピングはfdを閉じても有効
+    if (addr == MAP_FAILED) {
+        cerr << "mmapに失敗しました: " << path << endl;
+        return false;
+    }
+
+    // モデルのパースは先頭から順に読むため先読みを促す
+    madvise(addr, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+    data_ = addr;
+    size_ = (size_t)st.st_size;
+    return true;
+}
+
+void MappedFile::close() {
+    if (data_ != nullptr) {
+        munmap(data_, size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+size_t fileSizeBytes(const string& path) {
+    struct stat st;
+    if (stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return (size_t)st.st_size;
+}
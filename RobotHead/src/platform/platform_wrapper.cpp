@@ -7,6 +7,9 @@
 #include <chrono>
 #include <thread>
 #include <string>
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#endif
 
 #include "platform.h"
 #include "vl53l8cx_api.h"
@@ -118,16 +121,37 @@ extern "C" uint8_t VL53L8CX_Reset_Sensor(VL53L8CX_Platform *p_platform)
     return (uint8_t)VL53L8CX_STATUS_OK;
 }
 
+// Swap every 4 bytes of whole words (dst may be src): 16 bytes per vrev32 on NEON,
+// otherwise one __builtin_bswap32 per word. Returns the number of bytes swapped.
+static inline uint32_t swapWords(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+    uint32_t i = 0;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+    for (; i + 16 <= size; i += 16) {
+        vst1q_u8(dst + i, vrev32q_u8(vld1q_u8(src + i)));
+    }
+#endif
+    for (; i + 4 <= size; i += 4) {
+        uint32_t word;
+        memcpy(&word, src + i, 4);
+        word = __builtin_bswap32(word);
+        memcpy(dst + i, &word, 4);
+    }
+    return i;
+}
+
 extern "C" void VL53L8CX_SwapBuffer(uint8_t *buffer, uint16_t size)
 {
     // Swap every 4 bytes (endian conversion used by API)
-    for (uint16_t i = 0; i + 3 < size; i += 4) {
-        uint8_t b0 = buffer[i];
-        buffer[i] = buffer[i+3];
-        buffer[i+3] = b0;
-        uint8_t b1 = buffer[i+1];
-        buffer[i+1] = buffer[i+2];
-        buffer[i+2] = b1;
+    swapWords(buffer, buffer, size);
+}
+
+extern "C" void VL53L8CX_SwapCopy(uint8_t *dst, const uint8_t *src, uint32_t size)
+{
+    uint32_t i = swapWords(dst, src, size);
+    // Partial last word: the bytes that land first after the swap
+    for (uint32_t k = 0; i + k < size; k++) {
+        dst[i + k] = src[i + 3 - k];
     }
 }
 
@@ -0,0 +1,45 @@
+/**
+ * @file process_stats.cpp
+ * @brief Implementation of /proc based process statistics
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "platform/process_stats.h"
+#include <cstdio>
+#include <cstring>
+
+// "/proc/..."の "Key:   1234 kB" 形式の行から値を取り出す
+static size_t readProcField(const char* path, const char* key) {
+    FILE* fp = fopen(path, "r");
+    if (!fp) {
+        return 0;
+    }
+
+    size_t key_len = strlen(key);
+    size_t value = 0;
+    char line[256];
+    while (fgets(line, sizeof(line), fp)) {
+        if (strncmp(line, key, key_len) == 0 && line[key_len] == ':') {
+            unsigned long v = 0;
+            if (sscanf(line + key_len + 1, "%lu", &v) == 1) {
+                value = v;
+            }
+            break;
+        }
+    }
+    fclose(fp);
+    return value;
+}
+
+size_t readRssKb() {
+    return readProcField("/proc/self/status", "VmRSS");
+}
+
+size_t readPeakRssKb() {
+    return readProcField("/proc/self/status", "VmHWM");
+}
+
+size_t readMemAvailableKb() {
+    return readProcField("/proc/meminfo", "MemAvailable");
+}
@@ -0,0 +1,486 @@
+/**
+ * @file session_log.cpp
+ * @brief Implementation of the session log writer and mmap reader
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "platform/session_log.h"
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace cv;
+using namespace std;
+
+static const char kFileMagic[8] = {'R', 'S', 'E', 'S', 'S', 'I', 'O', 'N'};
+static const char kChunkMagic[4] = {'C', 'H', 'N', 'K'};
+static const char kFooterMagic[8] = {'R', 'S', 'L', 'I', 'N', 'D', 'E', 'X'};
+static const uint32_t kVersion = 1;
+static const size_t kMaxQueued = 64;    // 書き込み待ちの上限（5fpsの生フレームで約10秒分）
+
+static size_t alignUp(size_t value, size_t alignment) {
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+// 索引の並び（時刻順、同じ時刻なら記録した順のままにするためstable_sortで使う）
+static bool entryBefore(const SessionIndexEntry& a, const SessionIndexEntry& b) {
+    return a.timestamp_us < b.timestamp_us;
+}
+
+const char* sessionRecordTypeName(SessionRecordType type) {
+    switch (type) {
+        case SessionRecordType::JpegFrame: return "jpeg";
+        case SessionRecordType::DepthFrame: return "depth";
+        case SessionRecordType::UartRx: return "uart_rx";
+        case SessionRecordType::UartTx: return "uart_tx";
+        case SessionRecordType::Event: return "event";
+        case SessionRecordType::RawFrame: return "raw";
+        case SessionRecordType::ToFResults: return "tof";
+        default: return "unknown";
+    }
+}
+
+// ---------------------------------------------------------------------------
+// SessionWriter
+// ---------------------------------------------------------------------------
+
+SessionWriter::SessionWriter()
+    : fp_(nullptr), file_offset_(0), chunk_bytes_(1024 * 1024), chunk_count_(0), first_us_(0), last_us_(0),
+      encoder_(90), jpeg_quality_(90), max_queued_(kMaxQueued), blocking_(false), running_(false), records_(0), dropped_(0),
+      bytes_written_(0) {
+    memset(&chunk_header_, 0, sizeof(chunk_header_));
+}
+
+SessionWriter::~SessionWriter() {
+    close();
+}
+
+bool SessionWriter::open(const string& path, const string& note, size_t chunk_bytes) {
+    close();
+    fp_ = fopen(path.c_str(), "wb");
+    if (fp_ == nullptr) {
+        cerr << "[SessionWriter] ファイルを作成できません: " << path << endl;
+        return false;
+    }
+
+    SessionFileHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kFileMagic, sizeof(kFileMagic));
+    header.version = kVersion;
+    header.header_bytes = sizeof(SessionFileHeader);
+    header.created_us = (uint64_t)chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+    header.tof_results_bytes = sizeof(VL53L8CX_ResultsData);
+    strncpy(header.note, note.c_str(), sizeof(header.note) - 1);
+    fwrite(&header, sizeof(header), 1, fp_);
+
+    file_offset_ = sizeof(header);
+    chunk_bytes_ = max(chunk_bytes, (size_t)4096);
+    chunk_.clear();
+    chunk_.reserve(chunk_bytes_ + 64 * 1024);
+    index_.clear();
+    chunk_count_ = 0;
+    first_us_ = 0;
+    last_us_ = 0;
+    records_ = 0;
+    dropped_ = 0;
+    bytes_written_ = sizeof(header);
+    memset(&chunk_header_, 0, sizeof(chunk_header_));
+
+    running_ = true;
+    thread_ = thread(&SessionWriter::writerThread, this);
+    return true;
+}
+
+void SessionWriter::close() {
+    {
+        lock_guard<mutex> lock(mutex_);
+        if (!running_) {
+            return;
+        }
+        running_ = false;
+    }
+    cv_.notify_all();
+    space_cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();   // キューに残った記録は書き込んでから終わる
+    }
+
+    flushChunk();
+    // 記録は届いた順に並ぶが、フレームは撮影時刻（少し前）、ToFやUARTは受け取った時刻で記録するため
+    // 時刻は前後する。索引は時刻順に並べ替えて書く（同じ時刻なら届いた順）
+    stable_sort(index_.begin(), index_.end(), entryBefore);
+    SessionFooter footer;
+    memset(&footer, 0, sizeof(footer));
+    memcpy(footer.magic, kFooterMagic, sizeof(kFooterMagic));
+    footer.index_offset = file_offset_;
+    footer.record_count = index_.size();
+    footer.chunk_count = chunk_count_;
+    footer.first_us = first_us_;
+    footer.last_us = last_us_;
+    if (!index_.empty()) {
+        fwrite(index_.data(), sizeof(SessionIndexEntry), index_.size(), fp_);
+    }
+    fwrite(&footer, sizeof(footer), 1, fp_);
+    bytes_written_ += index_.size() * sizeof(SessionIndexEntry) + sizeof(footer);
+    fclose(fp_);
+    fp_ = nullptr;
+}
+
+unique_ptr<SessionWriter::Pending> SessionWriter::acquire() {
+    lock_guard<mutex> lock(mutex_);
+    if (!free_.empty()) {
+        unique_ptr<Pending> item = move(free_.back());
+        free_.pop_back();
+        return item;
+    }
+    return unique_ptr<Pending>(new Pending());
+}
+
+bool SessionWriter::push(unique_ptr<Pending> item) {
+    {
+        unique_lock<mutex> lock(mutex_);
+        if (blocking_) {
+            space_cv_.wait(lock, [this]() { return !running_ || queue_.size() < max_queued_; });
+        }
+        if (!running_ || queue_.size() >= max_queued_) {
+            dropped_++;
+            free_.push_back(move(item));
+            return false;
+        }
+        queue_.push_back(move(item));
+    }
+    cv_.notify_one();
+    return true;
+}
+
+bool SessionWriter::append(SessionRecordType type, const void* data, size_t size, uint64_t timestamp_us) {
+    if (!running_) {
+        return false;
+    }
+    unique_ptr<Pending> item = acquire();
+    item->type = type;
+    item->timestamp_us = timestamp_us;
+    item->data.assign(static_cast<const char*>(data), static_cast<const char*>(data) + size);
+    item->frame.release();
+    return push(move(item));
+}
+
+bool SessionWriter::appendFrame(const Mat& frame, uint64_t timestamp_us) {
+    if (!running_ || frame.empty() || (frame.type() != CV_8UC3 && frame.type() != CV_8UC1)) {
+        return false;
+    }
+    unique_ptr<Pending> item = acquire();
+    item->type = jpeg_quality_ > 0 ? SessionRecordType::JpegFrame : SessionRecordType::RawFrame;
+    item->timestamp_us = timestamp_us;
+    item->data.clear();
+    frame.copyTo(item->frame);   // 使い回す要素なら同じサイズのバッファに上書きされる
+    return push(move(item));
+}
+
+bool SessionWriter::appendJpeg(const void* data, size_t size, uint64_t timestamp_us) {
+    return append(SessionRecordType::JpegFrame, data, size, timestamp_us);
+}
+
+bool SessionWriter::appendToFResults(const VL53L8CX_ResultsData& results, uint64_t timestamp_us) {
+    return append(SessionRecordType::ToFResults, &results, sizeof(results), timestamp_us);
+}
+
+bool SessionWriter::appendUart(bool outgoing, const string& line, uint64_t timestamp_us) {
+    return append(outgoing ? SessionRecordType::UartTx : SessionRecordType::UartRx, line.data(), line.size(),
+                  timestamp_us);
+}
+
+bool SessionWriter::appendEvent(const string& text, uint64_t timestamp_us) {
+    return append(SessionRecordType::Event, text.data(), text.size(), timestamp_us);
+}
+
+void SessionWriter::writerThread() {
+    vector<unique_ptr<Pending>> batch;
+    while (true) {
+        {
+            unique_lock<mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return !queue_.empty() || !running_; });
+            if (queue_.empty() && !running_) {
+                break;
+            }
+            while (!queue_.empty()) {
+                batch.push_back(move(queue_.front()));
+                queue_.pop_front();
+            }
+        }
+        space_cv_.notify_all();
+
+        for (auto& item : batch) {
+            if (item->frame.empty()) {
+                writeRecord(item->type, item->data.data(), item->data.size(), item->timestamp_us);
+            } else if (item->type == SessionRecordType::JpegFrame) {
+                encoder_.setQuality(jpeg_quality_);
+                if (encoder_.encode(item->frame, jpeg_)) {
+                    writeRecord(item->type, jpeg_.data(), jpeg_.size(), item->timestamp_us);
+                }
+            } else {
+                // 生の画素: 行の詰め物を除いて並べる
+                const Mat& frame = item->frame;
+                SessionRawFrameHeader raw;
+                memset(&raw, 0, sizeof(raw));
+                raw.width = (uint16_t)frame.cols;
+                raw.height = (uint16_t)frame.rows;
+                raw.channels = (uint8_t)frame.channels();
+                size_t row_bytes = (size_t)frame.cols * frame.channels();
+                item->data.resize(sizeof(raw) + row_bytes * frame.rows);
+                memcpy(item->data.data(), &raw, sizeof(raw));
+                for (int y = 0; y < frame.rows; y++) {
+                    memcpy(item->data.data() + sizeof(raw) + row_bytes * y, frame.ptr(y), row_bytes);
+                }
+                writeRecord(item->type, item->data.data(), item->data.size(), item->timestamp_us);
+            }
+        }
+
+        lock_guard<mutex> lock(mutex_);
+        for (auto& item : batch) {
+            free_.push_back(move(item));
+        }
+        batch.clear();
+    }
+}
+
+void SessionWriter::writeRecord(SessionRecordType type, const void* data, size_t size, uint64_t timestamp_us) {
+    if (chunk_.empty() || timestamp_us < chunk_header_.first_us) {
+        chunk_header_.first_us = timestamp_us;
+    }
+
+    SessionRecordHeader header;
+    memset(&header, 0, sizeof(header));
+    header.size = (uint32_t)size;
+    header.type = (uint8_t)type;
+    header.timestamp_us = timestamp_us;
+
+    SessionIndexEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.offset = file_offset_ + sizeof(SessionChunkHeader) + chunk_.size();
+    entry.timestamp_us = timestamp_us;
+    entry.size = (uint32_t)size;
+    entry.type = (uint8_t)type;
+    index_.push_back(entry);
+
+    size_t record_bytes = alignUp(sizeof(header) + size, 8);
+    size_t start = chunk_.size();
+    chunk_.resize(start + record_bytes, 0);
+    memcpy(chunk_.data() + start, &header, sizeof(header));
+    memcpy(chunk_.data() + start + sizeof(header), data, size);
+    chunk_header_.record_count++;
+    chunk_header_.last_us = max(chunk_header_.last_us, timestamp_us);
+
+    if (first_us_ == 0 || timestamp_us < first_us_) {
+        first_us_ = timestamp_us;
+    }
+    last_us_ = max(last_us_, timestamp_us);
+    records_++;
+
+    if (chunk_.size() >= chunk_bytes_) {
+        flushChunk();
+    }
+}
+
+void SessionWriter::flushChunk() {
+    if (chunk_.empty() || fp_ == nullptr) {
+        return;
+    }
+    memcpy(chunk_header_.magic, kChunkMagic, sizeof(kChunkMagic));
+    chunk_header_.payload_bytes = (uint32_t)chunk_.size();
+    fwrite(&chunk_header_, sizeof(chunk_header_), 1, fp_);
+    fwrite(chunk_.data(), 1, chunk_.size(), fp_);
+    fflush(fp_);   // 途中で止まってもチャンク単位で読めるようにする
+
+    file_offset_ += sizeof(chunk_header_) + chunk_.size();
+    bytes_written_ += sizeof(chunk_header_) + chunk_.size();
+    chunk_count_++;
+    chunk_.clear();
+    memset(&chunk_header_, 0, sizeof(chunk_header_));
+}
+
+string SessionWriter::statsSummary() const {
+    ostringstream os;
+    os << "セッション記録: " << records_ << "件, 書き込み " << bytes_written_ / 1024
+       << "KB, キューが一杯で破棄 " << dropped_ << "件";
+    return os.str();
+}
+
+// ---------------------------------------------------------------------------
+// SessionReader
+// ---------------------------------------------------------------------------
+
+SessionReader::SessionReader() : index_(nullptr), count_(0), chunk_count_(0), recovered_(false) {
+    memset(&header_, 0, sizeof(header_));
+}
+
+bool SessionReader::open(const string& path) {
+    close();
+    if (!file_.open(path)) {
+        cerr << "[SessionReader] ファイルを開けません: " << path << endl;
+        return false;
+    }
+    if (file_.size() < sizeof(SessionFileHeader)) {
+        cerr << "[SessionReader] セッションログではありません: " << path << endl;
+        file_.close();
+        return false;
+    }
+    memcpy(&header_, file_.data(), sizeof(header_));
+    if (memcmp(header_.magic, kFileMagic, sizeof(kFileMagic)) != 0 || header_.version != kVersion) {
+        cerr << "[SessionReader] セッションログではありません: " << path << endl;
+        file_.close();
+        return false;
+    }
+
+    // 末尾の索引をそのまま使う（無ければチャンクを辿る）
+    if (file_.size() >= sizeof(SessionFileHeader) + sizeof(SessionFooter)) {
+        SessionFooter footer;
+        memcpy(&footer, file_.data() + file_.size() - sizeof(footer), sizeof(footer));
+        if (memcmp(footer.magic, kFooterMagic, sizeof(kFooterMagic)) == 0 &&
+            footer.index_offset >= sizeof(SessionFileHeader) && footer.index_offset <= file_.size() &&
+            footer.record_count <= (file_.size() - footer.index_offset) / sizeof(SessionIndexEntry) &&
+            footer.index_offset + footer.record_count * sizeof(SessionIndexEntry) + sizeof(footer) == file_.size()) {
+            const SessionIndexEntry* index = reinterpret_cast<const SessionIndexEntry*>(file_.data() + footer.index_offset);
+            size_t count = (size_t)footer.record_count;
+            if (indexInBounds(index, count, footer.index_offset)) {
+                index_ = index;
+                count_ = count;
+                chunk_count_ = (size_t)footer.chunk_count;
+                return true;
+            }
+            cerr << "[SessionReader] 索引がファイルの外を指しています" << endl;
+        }
+    }
+    return rebuildIndex();
+}
+
+void SessionReader::close() {
+    file_.close();
+    index_ = nullptr;
+    rebuilt_.clear();
+    count_ = 0;
+    chunk_count_ = 0;
+    recovered_ = false;
+}
+
+bool SessionReader::indexInBounds(const SessionIndexEntry* index, size_t count, uint64_t index_offset) const {
+    // 記録は先頭のヘッダーと索引の間に収まっていること
+    for (size_t i = 0; i < count; i++) {
+        const SessionIndexEntry& e = index[i];
+        if (e.offset < sizeof(SessionFileHeader) || e.offset > index_offset ||
+            index_offset - e.offset < sizeof(SessionRecordHeader) + (uint64_t)e.size) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SessionReader::rebuildIndex() {
+    recovered_ = true;
+    size_t offset = sizeof(SessionFileHeader);
+    while (offset + sizeof(SessionChunkHeader) <= file_.size()) {
+        SessionChunkHeader chunk;
+        memcpy(&chunk, file_.data() + offset, sizeof(chunk));
+        size_t payload_start = offset + sizeof(chunk);
+        if (memcmp(chunk.magic, kChunkMagic, sizeof(kChunkMagic)) != 0 ||
+            payload_start + chunk.payload_bytes > file_.size()) {
+            break;   // 書きかけのチャンク
+        }
+        size_t pos = payload_start;
+        size_t end = payload_start + chunk.payload_bytes;
+        while (pos + sizeof(SessionRecordHeader) <= end) {
+            SessionRecordHeader header;
+            memcpy(&header, file_.data() + pos, sizeof(header));
+            if (pos + sizeof(header) + header.size > end) {
+                break;
+            }
+            SessionIndexEntry entry;
+            memset(&entry, 0, sizeof(entry));
+            entry.offset = pos;
+            entry.timestamp_us = header.timestamp_us;
+            entry.size = header.size;
+            entry.type = header.type;
+            rebuilt_.push_back(entry);
+            pos += alignUp(sizeof(header) + header.size, 8);
+        }
+        chunk_count_++;
+        offset = end;
+    }
+    stable_sort(rebuilt_.begin(), rebuilt_.end(), entryBefore);
+    count_ = rebuilt_.size();
+    cerr << "[SessionReader] 索引が無いためチャンクから作り直しました（" << count_ << "件）" << endl;
+    return true;
+}
+
+SessionRecord SessionReader::record(size_t i) const {
+    const SessionIndexEntry& e = entry(i);
+    SessionRecord record;
+    record.type = (SessionRecordType)e.type;
+    record.timestamp_us = e.timestamp_us;
+    record.data = file_.data() + e.offset + sizeof(SessionRecordHeader);
+    record.size = e.size;
+    return record;
+}
+
+size_t SessionReader::lowerBound(uint64_t timestamp_us) const {
+    size_t lo = 0, hi = count_;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (entry(mid).timestamp_us < timestamp_us) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+bool SessionReader::rawFrameView(const SessionRecord& record, Mat& out) {
+    SessionRawFrameHeader raw;
+    if (record.type != SessionRecordType::RawFrame || record.size < sizeof(raw)) {
+        return false;
+    }
+    memcpy(&raw, record.data, sizeof(raw));
+    if ((raw.channels != 1 && raw.channels != 3) ||
+        record.size != sizeof(raw) + (size_t)raw.width * raw.height * raw.channels) {
+        return false;
+    }
+    out = Mat(raw.height, raw.width, raw.channels == 3 ? CV_8UC3 : CV_8UC1,
+              const_cast<char*>(record.data + sizeof(raw)));
+    return true;
+}
+
+bool SessionReader::decodeFrame(const SessionRecord& record, Mat& out) {
+    if (record.type == SessionRecordType::RawFrame) {
+        Mat view;
+        if (!rawFrameView(record, view)) {
+            return false;
+        }
+        if (view.channels() == 1) {
+            cvtColor(view, out, COLOR_GRAY2BGR);
+        } else {
+            view.copyTo(out);
+        }
+        return true;
+    }
+    if (record.type == SessionRecordType::JpegFrame) {
+        Mat encoded(1, (int)record.size, CV_8UC1, const_cast<char*>(record.data));
+        out = imdecode(encoded, IMREAD_COLOR);
+        return !out.empty();
+    }
+    return false;
+}
+
+bool SessionReader::decodeToFResults(const SessionRecord& record, VL53L8CX_ResultsData& out) {
+    if (record.type != SessionRecordType::ToFResults || record.size != sizeof(VL53L8CX_ResultsData)) {
+        return false;
+    }
+    memcpy(&out, record.data, sizeof(out));
+    return true;
+}
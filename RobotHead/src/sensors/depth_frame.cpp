@@ -0,0 +1,81 @@
+/**
+ * @file depth_frame.cpp
+ * @brief Implementation of the depth frame binary codec
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "sensors/depth_frame.h"
+
+using namespace std;
+
+static const unsigned char kDepthFrameVersion = 1;
+static const size_t kDepthFrameHeaderSize = 16;
+
+// ホストのバイト順に依存しないよう1バイトずつ読み書きする
+static void putLE(unsigned char* p, uint64_t value, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (unsigned char)(value >> (i * 8));
+    }
+}
+
+static uint64_t getLE(const unsigned char* p, int bytes) {
+    uint64_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--) {
+        value = (value << 8) | p[i];
+    }
+    return value;
+}
+
+size_t depthFrameEncodedSize(int zones) {
+    return kDepthFrameHeaderSize + (size_t)zones * (2 + 2 + 1);
+}
+
+void encodeDepthFrame(const DepthFrame& frame, vector<unsigned char>& out) {
+    int zones = frame.zones <= 16 ? 16 : kDepthFrameMaxZones;
+    out.resize(depthFrameEncodedSize(zones));
+    unsigned char* p = out.data();
+
+    p[0] = 'T';
+    p[1] = 'F';
+    p[2] = kDepthFrameVersion;
+    p[3] = (unsigned char)zones;
+    putLE(p + 4, frame.seq, 4);
+    putLE(p + 8, frame.timestamp_us, 8);
+    p += kDepthFrameHeaderSize;
+
+    for (int i = 0; i < zones; i++, p += 2) {
+        putLE(p, (uint16_t)frame.distance_mm[i], 2);
+    }
+    for (int i = 0; i < zones; i++, p += 2) {
+        putLE(p, frame.range_sigma_mm[i], 2);
+    }
+    for (int i = 0; i < zones; i++) {
+        *p++ = frame.target_status[i];
+    }
+}
+
+bool decodeDepthFrame(const unsigned char* data, size_t size, DepthFrame& frame) {
+    if (size < kDepthFrameHeaderSize || data[0] != 'T' || data[1] != 'F' || data[2] != kDepthFrameVersion) {
+        return false;
+    }
+    int zones = data[3];
+    if ((zones != 16 && zones != kDepthFrameMaxZones) || size != depthFrameEncodedSize(zones)) {
+        return false;
+    }
+
+    frame.zones = (uint8_t)zones;
+    frame.seq = (uint32_t)getLE(data + 4, 4);
+    frame.timestamp_us = getLE(data + 8, 8);
+    const unsigned char* p = data + kDepthFrameHeaderSize;
+    for (int i = 0; i < zones; i++, p += 2) {
+        frame.distance_mm[i] = (int16_t)getLE(p, 2);
+    }
+    for (int i = 0; i < zones; i++, p += 2) {
+        frame.range_sigma_mm[i] = (uint16_t)getLE(p, 2);
+    }
+    for (int i = 0; i < zones; i++) {
+        frame.target_status[i] = *p++;
+    }
+    return true;
+}
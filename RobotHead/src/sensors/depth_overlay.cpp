@@ -0,0 +1,88 @@
+/**
+ * @file depth_overlay.cpp
+ * @brief Implementation of the ToF depth overlay
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "sensors/depth_overlay.h"
+#include <opencv2/imgproc.hpp>
+#include <algorithm>
+
+using namespace cv;
+using namespace std;
+
+void drawDepthOverlay(const Mat& frame, const int16_t* distance_mm, const DepthOverlayConfig& config, Mat& display) {
+    if (config.calibrated) {
+        // 8x8 depthデータの取得と変換
+        Mat depth_map = Mat::zeros(8, 8, CV_16UC1);
+        for (int i = 0; i < 64; i++) {
+            int row = i / 8;
+            int col = i % 8;
+            depth_map.at<uint16_t>(row, col) = distance_mm[i];
+        }
+
+        // Depthマップの正規化（200mm〜2000mmの範囲、近いほど赤）
+        Mat depth_norm = Mat::zeros(8, 8, CV_8UC1);
+        for (int i = 0; i < 8; i++) {
+            for (int j = 0; j < 8; j++) {
+                uint16_t dist = depth_map.at<uint16_t>(i, j);
+                // 近いほど高い値（赤）、遠いほど低い値（青）
+                int val = (int)((2000.0 - dist) * 255.0 / 1800.0);
+                val = max(0, min(255, val));  // 0-255にクリップ
+                depth_norm.at<uint8_t>(i, j) = (uint8_t)val;
+            }
+        }
+
+        // キャリブレーションサイズにリサイズ
+        Mat depth_resized;
+        resize(depth_norm, depth_resized, config.region.size(), 0, 0, INTER_NEAREST);
+
+        // カラーマップ適用
+        Mat depth_colored;
+        applyColorMap(depth_resized, depth_colored, COLORMAP_JET);
+
+        // オーバーレイ範囲を計算
+        int x1 = max(0, config.region.x);
+        int y1 = max(0, config.region.y);
+        int x2 = min(display.cols, config.region.x + config.region.width);
+        int y2 = min(display.rows, config.region.y + config.region.height);
+
+        int dx1 = max(0, -config.region.x);
+        int dy1 = max(0, -config.region.y);
+        int dx2 = dx1 + (x2 - x1);
+        int dy2 = dy1 + (y2 - y1);
+
+        // 有効な範囲かチェック
+        if (x2 > x1 && y2 > y1 && dx2 > dx1 && dy2 > dy1 &&
+            dx2 <= depth_colored.cols && dy2 <= depth_colored.rows) {
+            Mat roi = display(Rect(x1, y1, x2 - x1, y2 - y1));
+            Mat depth_roi = depth_colored(Rect(dx1, dy1, dx2 - dx1, dy2 - dy1));
+            addWeighted(roi, 1.0 - config.alpha, depth_roi, config.alpha, 0, roi);
+        }
+        return;
+    }
+
+    // キャリブレーションデータがない場合は従来の縦結合方式
+    Mat heatmap_raw(8, 8, CV_16UC1, const_cast<int16_t*>(distance_mm));
+    Mat heatmap = heatmap_raw.clone();
+    rotate(heatmap, heatmap, ROTATE_180);
+
+    Mat heatmap_norm, heatmap_resized, heatmap_color;
+    double minVal = 0.0, maxVal = 0.0;
+    minMaxLoc(heatmap, &minVal, &maxVal, nullptr, nullptr);
+
+    if (maxVal > minVal) {
+        Mat heatmap_f32;
+        heatmap.convertTo(heatmap_f32, CV_32F);
+        heatmap_f32 = (heatmap_f32 - static_cast<float>(minVal)) * (255.0f / static_cast<float>(maxVal - minVal));
+        heatmap_f32.convertTo(heatmap_norm, CV_8UC1);
+    } else {
+        heatmap_norm = Mat::zeros(heatmap.size(), CV_8UC1);
+    }
+
+    int cam_w = frame.cols;
+    resize(heatmap_norm, heatmap_resized, Size(cam_w, cam_w), 0, 0, INTER_NEAREST);
+    applyColorMap(heatmap_resized, heatmap_color, COLORMAP_JET);
+    vconcat(frame, heatmap_color, display);
+}
@@ -0,0 +1,125 @@
+/**
+ * @file tof_reader.cpp
+ * @brief Implementation of the VL53L8CX background reader
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "sensors/tof_reader.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+
+using namespace std;
+
+// data readyの確認間隔（60Hzの1周期16.7msに対して十分短く、I2Cを占有しない程度）
+static const chrono::milliseconds kPollInterval(2);
+// 測距データの読み出しがこの回数続けて失敗したら止める（1回の破損フレームでは止めない）
+static const int kMaxConsecutiveReadErrors = 10;
+
+ToFReader::ToFReader(VL53L8CX_Configuration* dev, int zones)
+    : dev_(dev), zones_(zones <= 16 ? 16 : kDepthFrameMaxZones), seq_(0), running_(false), failed_(false),
+      frames_(0), polls_(0), dropped_(0), rate_hz_(0.0) {
+    memset(&latest_, 0, sizeof(latest_));
+}
+
+ToFReader::~ToFReader() {
+    stop();
+}
+
+void ToFReader::start() {
+    if (running_) {
+        return;
+    }
+    running_ = true;
+    failed_ = false;
+    thread_ = thread(&ToFReader::readerThread, this);
+}
+
+void ToFReader::stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+bool ToFReader::latest(VL53L8CX_ResultsData& out, uint64_t& seq) {
+    lock_guard<mutex> lock(mutex_);
+    if (seq_ == seq) {
+        return false;
+    }
+    memcpy(&out, &latest_, sizeof(out));
+    seq = seq_;
+    return true;
+}
+
+void ToFReader::readerThread() {
+    VL53L8CX_ResultsData& results = scratch_;
+    DepthFrame frame;
+    memset(&frame, 0, sizeof(frame));
+    frame.zones = (uint8_t)zones_;
+    int consecutive_errors = 0;
+
+    while (running_) {
+        uint8_t ready = 0;
+        polls_++;
+        if (vl53l8cx_check_data_ready(dev_, &ready) != VL53L8CX_STATUS_OK) {
+            cerr << "[ToFReader] データ準備状態の確認に失敗しました" << endl;
+            failed_ = true;
+            break;
+        }
+        if (!ready) {
+            this_thread::sleep_for(kPollInterval);
+            continue;
+        }
+        uint8_t status = vl53l8cx_get_ranging_data(dev_, &results);
+        if (status != VL53L8CX_STATUS_OK) {
+            // ヘッダーとフッターのIDが合わないフレーム（CORRUPTED_FRAME）などは捨てて次を待つ
+            dropped_++;
+            if (++consecutive_errors >= kMaxConsecutiveReadErrors) {
+                cerr << "[ToFReader] 測距データの読み出しに" << consecutive_errors
+                     << "回続けて失敗しました (status " << (int)status << ")" << endl;
+                failed_ = true;
+                break;
+            }
+            continue;
+        }
+        consecutive_errors = 0;
+
+        auto now = chrono::steady_clock::now();
+        uint64_t seq;
+        {
+            lock_guard<mutex> lock(mutex_);
+            memcpy(&latest_, &results, sizeof(latest_));
+            seq = ++seq_;
+        }
+        if (frames_++ > 0) {
+            double hz = 1.0 / max(1e-6, chrono::duration<double>(now - last_read_).count());
+            rate_hz_ = rate_hz_ > 0.0 ? rate_hz_ * 0.9 + hz * 0.1 : hz;
+        }
+        last_read_ = now;
+
+        if (listener_) {
+            frame.seq = (uint32_t)seq;
+            frame.timestamp_us = (uint64_t)chrono::duration_cast<chrono::microseconds>(
+                chrono::system_clock::now().time_since_epoch()).count();
+            for (int i = 0; i < zones_; i++) {
+                frame.distance_mm[i] = results.distance_mm[i];
+#ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
+                frame.range_sigma_mm[i] = results.range_sigma_mm[i];
+#endif
+                frame.target_status[i] = results.target_status[i];
+            }
+            listener_(frame);
+        }
+    }
+}
+
+string ToFReader::statsSummary() const {
+    ostringstream os;
+    os << "ToF読み出し: " << frames_ << "フレーム (" << rate_hz_ << "Hz), data ready確認 " << polls_ << "回"
+       << ", 破棄 " << dropped_ << "フレーム"
+       << (failed_ ? ", I2Cエラーで停止" : "");
+    return os.str();
+}
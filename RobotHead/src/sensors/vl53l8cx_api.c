@@ -746,87 +746,102 @@ uint8_t vl53l8cx_get_ranging_data(
 		VL53L8CX_ResultsData		*p_results)
 {
 	uint8_t status = VL53L8CX_STATUS_OK;
-	uint16_t header_id, footer_id;
-	union Block_header *bh_ptr;
-	uint32_t i, j, msize;
+
 	status |= VL53L8CX_RdMulti(&(p_dev->platform), 0x0,
 			p_dev->temp_buffer, p_dev->data_read_size);
+	status |= vl53l8cx_decode_ranging_data(p_dev, p_results);
+
+	return status;
+}
+
+uint8_t vl53l8cx_decode_ranging_data(
+		VL53L8CX_Configuration		*p_dev,
+		VL53L8CX_ResultsData		*p_results)
+{
+	uint8_t status = VL53L8CX_STATUS_OK;
+	uint16_t header_id, footer_id;
+	union Block_header bh;
+	uint32_t i, j, msize;
+	const uint8_t *raw = p_dev->temp_buffer;
+
 	p_dev->streamcount = p_dev->temp_buffer[0];
-	VL53L8CX_SwapBuffer(p_dev->temp_buffer, (uint16_t)p_dev->data_read_size);
 
-	/* Start conversion at position 16 to avoid headers */
+	/* temp_buffer is left as read from the sensor: each block header is
+	 * swapped on its own and only the blocks kept in the results are swapped,
+	 * straight into the results (offsets below are those after a swap) */
 	for (i = (uint32_t)16; i 
              < (uint32_t)p_dev->data_read_size; i+=(uint32_t)4)
 	{
-		bh_ptr = (union Block_header *)&(p_dev->temp_buffer[i]);
-		if ((bh_ptr->type > (uint32_t)0x1) 
-                    && (bh_ptr->type < (uint32_t)0xd))
+		VL53L8CX_SwapCopy((uint8_t *)&bh.bytes, &raw[i], 4);
+		if ((bh.type > (uint32_t)0x1) 
+                    && (bh.type < (uint32_t)0xd))
 		{
-			msize = bh_ptr->type * bh_ptr->size;
+			msize = bh.type * bh.size;
 		}
 		else
 		{
-			msize = bh_ptr->size;
+			msize = bh.size;
 		}
 
-		switch(bh_ptr->idx){
+		switch(bh.idx){
 			case VL53L8CX_METADATA_IDX:
+				/* Byte 12 after the swap */
 				p_results->silicon_temp_degc =
-						(int8_t)p_dev->temp_buffer[i + (uint32_t)12];
+						(int8_t)raw[i + (uint32_t)15];
 				break;
 
 #ifndef VL53L8CX_DISABLE_AMBIENT_PER_SPAD
 			case VL53L8CX_AMBIENT_RATE_IDX:
-				(void)memcpy(p_results->ambient_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy((uint8_t *)p_results->ambient_per_spad,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_NB_SPADS_ENABLED
 			case VL53L8CX_SPAD_COUNT_IDX:
-				(void)memcpy(p_results->nb_spads_enabled,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy((uint8_t *)p_results->nb_spads_enabled,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_NB_TARGET_DETECTED
 			case VL53L8CX_NB_TARGET_DETECTED_IDX:
-				(void)memcpy(p_results->nb_target_detected,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy(p_results->nb_target_detected,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_SIGNAL_PER_SPAD
 			case VL53L8CX_SIGNAL_RATE_IDX:
-				(void)memcpy(p_results->signal_per_spad,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy((uint8_t *)p_results->signal_per_spad,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_RANGE_SIGMA_MM
 			case VL53L8CX_RANGE_SIGMA_MM_IDX:
-				(void)memcpy(p_results->range_sigma_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy((uint8_t *)p_results->range_sigma_mm,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_DISTANCE_MM
 			case VL53L8CX_DISTANCE_IDX:
-				(void)memcpy(p_results->distance_mm,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy((uint8_t *)p_results->distance_mm,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_REFLECTANCE_PERCENT
 			case VL53L8CX_REFLECTANCE_EST_PC_IDX:
-				(void)memcpy(p_results->reflectance,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy(p_results->reflectance,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_TARGET_STATUS
 			case VL53L8CX_TARGET_STATUS_IDX:
-				(void)memcpy(p_results->target_status,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy(p_results->target_status,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 #ifndef VL53L8CX_DISABLE_MOTION_INDICATOR
 			case VL53L8CX_MOTION_DETEC_IDX:
-				(void)memcpy(&p_results->motion_indicator,
-				&(p_dev->temp_buffer[i + (uint32_t)4]), msize);
+				VL53L8CX_SwapCopy((uint8_t *)&p_results->motion_indicator,
+				&raw[i + (uint32_t)4], msize);
 				break;
 #endif
 			default:
@@ -890,14 +905,14 @@ uint8_t vl53l8cx_get_ranging_data(
 #endif
 
 	/* Check if footer id and header id are matching. This allows to detect
-	 * corrupted frames */
-	header_id = ((uint16_t)(p_dev->temp_buffer[0x8])<<8) & 0xFF00U;
-	header_id |= ((uint16_t)(p_dev->temp_buffer[0x9])) & 0x00FFU;
-
-	footer_id = ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
-		- (uint32_t)4]) << 8) & 0xFF00U;
-	footer_id |= ((uint16_t)(p_dev->temp_buffer[p_dev->data_read_size
-		- (uint32_t)3])) & 0xFFU;
+	 * corrupted frames (bytes 0x8/0x9 and size-4/size-3 after a swap) */
+	header_id = ((uint16_t)(raw[0xB])<<8) & 0xFF00U;
+	header_id |= ((uint16_t)(raw[0xA])) & 0x00FFU;
+
+	footer_id = ((uint16_t)(raw[p_dev->data_read_size
+		- (uint32_t)1]) << 8) & 0xFF00U;
+	footer_id |= ((uint16_t)(raw[p_dev->data_read_size
+		- (uint32_t)2])) & 0xFFU;
 
 	if(header_id != footer_id)
 	{
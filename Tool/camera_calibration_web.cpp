@@ -3,10 +3,8 @@
 #include <vector>
 #include <thread>
 #include <mutex>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <unistd.h>
 #include <sstream>
+#include "network/http_server.h"
 
 using namespace cv;
 using namespace std;
@@ -21,24 +19,19 @@ bool g_calibration_done = false;
 string g_message = "チェッカーボードを様々な角度から撮影してください";
 bool g_capture_requested = false;
 bool g_calibrate_requested = false;
+HttpServer g_http;
 
 // チェッカーボードのサイズ（内部コーナー数）
 const Size BOARD_SIZE(6, 9); // 7x10チェッカーボードの内部コーナー
 const float SQUARE_SIZE = 25.0f; // 正方形のサイズ（mm）
 
-// HTTPレスポンスを送信
-void send_http_response(int client_sock, const string& content_type, const vector<uchar>& data) {
-    string header = 
-        "HTTP/1.0 200 OK\r\n"
-        "Content-Type: " + content_type + "\r\n"
-        "Content-Length: " + to_string(data.size()) + "\r\n"
-        "Connection: close\r\n\r\n";
-    send(client_sock, header.c_str(), header.length(), 0);
-    send(client_sock, data.data(), data.size(), 0);
+// HTTPレスポンスを送信（送信はHTTPサーバーのイベントループが行う）
+void send_http_response(HttpServer::ConnectionId client, const string& content_type, const vector<uchar>& data) {
+    g_http.sendResponse(client, "200 OK", content_type, string(data.begin(), data.end()));
 }
 
-void send_html(int client_sock) {
-    string html = R"HTML(
+// 変わらないページなのでETag付きの静的ルートで返す（再読み込みは304）
+const char kIndexHtml[] = R"HTML(
 <!DOCTYPE html>
 <html>
 <head>
@@ -48,22 +41,40 @@ void send_html(int client_sock) {
         img { max-width: 90%; border: 2px solid #333; }
         button { font-size: 20px; margin: 10px; padding: 15px 30px; }
         .status { font-size: 18px; margin: 20px; }
+        .latency { font-size: 12px; color: #666; }
     </style>
 </head>
 <body>
     <h1>Camera Calibration Tool</h1>
     <div class="status" id="status">Loading...</div>
+    <div class="latency" id="latency"></div>
     <img id="frame" src="/stream.jpg" alt="camera">
     <br>
     <button onclick="capture()">Capture (Count: <span id="count">0</span>)</button>
     <button onclick="calibrate()">Run Calibration</button>
     <button onclick="reset()">Reset</button>
     <script>
+        // ポーリングの往復時間（keep-aliveで接続し直さないため数ms程度になる）
+        const latency = {};
+        function recordLatency(path, ms) {
+            latency[path] = latency[path] === undefined ? ms : latency[path] * 0.8 + ms * 0.2;
+            document.getElementById("latency").innerText =
+                Object.keys(latency).map(k => `${k} ${latency[k].toFixed(1)} ms`).join("  ");
+        }
+        function timedFetch(url) {
+            const t0 = performance.now();
+            return fetch(url).then(r => { recordLatency(url.split("?")[0], performance.now() - t0); return r; });
+        }
+        let frameStart = 0;
+        document.getElementById("frame").onload = () => {
+            if (frameStart > 0) recordLatency("/stream.jpg", performance.now() - frameStart);
+        };
         function updateFrame() {
+            frameStart = performance.now();
             document.getElementById("frame").src = "/stream.jpg?" + new Date().getTime();
         }
         function updateStatus() {
-            fetch("/status").then(r => r.text()).then(text => {
+            timedFetch("/status").then(r => r.text()).then(text => {
                 const parts = text.split("|");
                 document.getElementById("status").innerText = parts[0];
                 document.getElementById("count").innerText = parts[1];
@@ -98,75 +109,49 @@ void send_html(int client_sock) {
 </body>
 </html>
 )HTML";
-    vector<uchar> data(html.begin(), html.end());
-    send_http_response(client_sock, "text/html", data);
-}
-
-void http_server_thread() {
-    int server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    int opt = 1;
-    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(8080);
-
-    bind(server_sock, (struct sockaddr*)&server_addr, sizeof(server_addr));
-    listen(server_sock, 5);
-
-    cout << "HTTPサーバー起動: http://0.0.0.0:8080/" << endl;
-
-    while (g_running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &client_len);
-        
-        if (client_sock < 0) continue;
-
-        char buffer[1024] = {0};
-        read(client_sock, buffer, sizeof(buffer));
-        string request(buffer);
 
-        if (request.find("GET / ") == 0 || request.find("GET /index.html") == 0) {
-            send_html(client_sock);
-        } else if (request.find("GET /stream.jpg") == 0) {
-            lock_guard<mutex> lock(g_frame_mutex);
-            if (!g_current_frame.empty()) {
-                vector<uchar> buf;
-                imencode(".jpg", g_current_frame, buf);
-                send_http_response(client_sock, "image/jpeg", buf);
-            }
-        } else if (request.find("GET /status") == 0) {
-            string status_text = g_message + "|" + to_string(g_capture_count);
-            vector<uchar> data(status_text.begin(), status_text.end());
-            send_http_response(client_sock, "text/plain", data);
-        } else if (request.find("GET /capture") == 0) {
-            // キャプチャ処理をリクエスト
-            g_capture_requested = true;
-            string response = "撮影リクエストを受け付けました";
-            vector<uchar> data(response.begin(), response.end());
-            send_http_response(client_sock, "text/plain", data);
-        } else if (request.find("GET /calibrate") == 0) {
-            // キャリブレーション処理をリクエスト
-            g_calibrate_requested = true;
-            string response = "キャリブレーションリクエストを受け付けました";
-            vector<uchar> data(response.begin(), response.end());
-            send_http_response(client_sock, "text/plain", data);
-        } else if (request.find("GET /reset") == 0) {
-            lock_guard<mutex> lock(g_frame_mutex);
-            g_image_points.clear();
-            g_capture_count = 0;
-            g_message = "リセットしました";
-            string response = "OK";
-            vector<uchar> data(response.begin(), response.end());
-            send_http_response(client_sock, "text/plain", data);
+// HTTPのルートを登録（ハンドラはイベントループのスレッドで呼ばれる）
+void setup_http_routes() {
+    g_http.addStaticRoute("/", "text/html; charset=utf-8", kIndexHtml);
+    g_http.addStaticRoute("/index.html", "text/html; charset=utf-8", kIndexHtml);
+    g_http.addRoute("/stream.jpg", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        lock_guard<mutex> lock(g_frame_mutex);
+        if (!g_current_frame.empty()) {
+            vector<uchar> buf;
+            imencode(".jpg", g_current_frame, buf);
+            send_http_response(client, "image/jpeg", buf);
+        } else {
+            g_http.sendResponse(client, "503 Service Unavailable", "text/plain", "No frame yet\n");
         }
-
-        close(client_sock);
-    }
-
-    close(server_sock);
+    });
+    g_http.addRoute("/status", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        string status_text = g_message + "|" + to_string(g_capture_count);
+        vector<uchar> data(status_text.begin(), status_text.end());
+        send_http_response(client, "text/plain", data);
+    });
+    g_http.addRoute("/capture", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        // キャプチャ処理をリクエスト
+        g_capture_requested = true;
+        string response = "撮影リクエストを受け付けました";
+        vector<uchar> data(response.begin(), response.end());
+        send_http_response(client, "text/plain", data);
+    });
+    g_http.addRoute("/calibrate", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        // キャリブレーション処理をリクエスト
+        g_calibrate_requested = true;
+        string response = "キャリブレーションリクエストを受け付けました";
+        vector<uchar> data(response.begin(), response.end());
+        send_http_response(client, "text/plain", data);
+    });
+    g_http.addRoute("/reset", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        lock_guard<mutex> lock(g_frame_mutex);
+        g_image_points.clear();
+        g_capture_count = 0;
+        g_message = "リセットしました";
+        string response = "OK";
+        vector<uchar> data(response.begin(), response.end());
+        send_http_response(client, "text/plain", data);
+    });
 }
 
 int main() {
@@ -179,7 +164,12 @@ int main() {
     cap.set(CAP_PROP_FRAME_WIDTH, 640);
     cap.set(CAP_PROP_FRAME_HEIGHT, 480);
 
-    thread http_thread(http_server_thread);
+    setup_http_routes();
+    if (!g_http.init(8080)) {
+        return -1;
+    }
+    g_http.start();
+    cout << "HTTPサーバー起動: http://0.0.0.0:8080/" << endl;
     cout << "ブラウザで http://<RaspberryPiのIP>:8080/ を開いてください" << endl;
 
     while (g_running) {
@@ -261,7 +251,9 @@ int main() {
     }
 
     g_running = false;
-    http_thread.join();
+    g_http.stop();
+    cout << g_http.statsSummary() << endl;
+    cout << g_http.routeStatsSummary();
     cap.release();
 
     return 0;
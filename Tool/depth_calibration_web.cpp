@@ -3,11 +3,13 @@
 #include <vector>
 #include <thread>
 #include <mutex>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <unistd.h>
 #include <sstream>
 #include <cstring>
+#include <memory>
+#include "network/http_server.h"
+#include "network/websocket.h"
+#include "sensors/tof_reader.h"
+#include "sensors/depth_frame.h"
 
 // VL53L8CXヘッダー
 extern "C" {
@@ -23,6 +25,7 @@ using namespace std;
 Mat g_current_frame;
 mutex g_frame_mutex;
 bool g_running = true;
+HttpServer g_http;
 
 // キャリブレーションパラメータ
 int g_offset_x = 0;
@@ -32,36 +35,33 @@ int g_overlay_height = 240;
 float g_alpha = 0.5f;
 string g_message = "Depthセンサーがカメラ画角外でもOK。位置を調整してください";
 
-// HTTPレスポンスを送信
-void send_http_response(int client_sock, const string& content_type, const vector<uchar>& data) {
-    string header = 
-        "HTTP/1.0 200 OK\r\n"
-        "Content-Type: " + content_type + "\r\n"
-        "Content-Length: " + to_string(data.size()) + "\r\n"
-        "Connection: close\r\n\r\n";
-    send(client_sock, header.c_str(), header.length(), 0);
-    send(client_sock, data.data(), data.size(), 0);
+// HTTPレスポンスを送信（送信はHTTPサーバーのイベントループが行う）
+void send_http_response(HttpServer::ConnectionId client, const string& content_type, const vector<uchar>& data) {
+    g_http.sendResponse(client, "200 OK", content_type, string(data.begin(), data.end()));
 }
 
-void send_html(int client_sock) {
-    string html = R"HTML(
+// 変わらないページなのでETag付きの静的ルートで返す（再読み込みは304）
+const char kIndexHtml[] = R"HTML(
 <!DOCTYPE html>
 <html>
 <head>
     <title>Depth Calibration</title>
     <style>
         body { font-family: Arial; text-align: center; padding: 20px; background: #222; color: white; }
-        img { max-width: 90%; border: 2px solid #666; }
+        canvas { max-width: 90%; border: 2px solid #666; }
         button { font-size: 16px; margin: 5px; padding: 10px 20px; }
         .controls { margin: 20px; }
         .status { font-size: 16px; margin: 20px; color: #4CAF50; }
         .param { display: inline-block; margin: 10px; }
+        .latency { font-size: 12px; color: #aaa; }
     </style>
 </head>
 <body>
     <h1>Depth Overlay Calibration</h1>
     <div class="status" id="status">Loading...</div>
-    <img id="frame" src="/stream.jpg" alt="camera">
+    <div class="latency" id="latency"></div>
+    <canvas id="frame"></canvas>
+    <div id="depth_status">depth: connecting...</div>
     <div class="controls">
         <div class="param">
             <button onclick="adjust('offset_x', -5)">← X</button>
@@ -94,12 +94,98 @@ void send_html(int client_sock) {
     <button onclick="save()" style="font-size: 20px; padding: 15px 40px;">Save Calibration</button>
     <button onclick="reset()">Reset</button>
     <script>
+        // カメラ画像はJPEG、距離は/depth/wsの生データ（sensors/depth_frame.hの形式）を受け取り、
+        // オーバーレイは現在のパラメータでブラウザが描く
+        const canvas = document.getElementById("frame");
+        const ctx = canvas.getContext("2d");
+        let image = null, depth = null, depthCount = 0, depthRate = 0, rateStart = performance.now();
+        let params = {x: 0, y: 0, w: 240, h: 240, alpha: 0.5};
+
+        function decodeDepthFrame(buffer) {
+            const v = new DataView(buffer);
+            if (buffer.byteLength < 16 || v.getUint8(0) !== 84 || v.getUint8(1) !== 70 || v.getUint8(2) !== 1) return null;
+            const n = v.getUint8(3);
+            if ((n !== 16 && n !== 64) || buffer.byteLength !== 16 + 5 * n) return null;
+            const f = {seq: v.getUint32(4, true), timestamp_us: Number(v.getBigUint64(8, true)), zones: n,
+                       distance_mm: new Int16Array(n), range_sigma_mm: new Uint16Array(n), target_status: new Uint8Array(n)};
+            let o = 16;
+            for (let i = 0; i < n; i++, o += 2) f.distance_mm[i] = v.getInt16(o, true);
+            for (let i = 0; i < n; i++, o += 2) f.range_sigma_mm[i] = v.getUint16(o, true);
+            for (let i = 0; i < n; i++, o += 1) f.target_status[i] = v.getUint8(o);
+            return f;
+        }
+        function jet(v) {
+            const f = x => Math.round(255 * Math.max(0, Math.min(1, 1.5 - Math.abs(x))));
+            return `rgb(${f(4 * v - 3)},${f(4 * v - 2)},${f(4 * v - 1)})`;
+        }
+        function draw() {
+            if (!image) return;
+            if (canvas.width !== image.width || canvas.height !== image.height) {
+                canvas.width = image.width;
+                canvas.height = image.height;
+            }
+            ctx.drawImage(image, 0, 0);
+            if (depth) {
+                // 200mm〜2000mm、近いほど赤（回転なし）
+                const side = Math.round(Math.sqrt(depth.zones));
+                ctx.globalAlpha = params.alpha;
+                for (let i = 0; i < depth.zones; i++) {
+                    const r = Math.floor(i / side), c = i % side;
+                    const x0 = params.x + Math.floor(c * params.w / side), x1 = params.x + Math.floor((c + 1) * params.w / side);
+                    const y0 = params.y + Math.floor(r * params.h / side), y1 = params.y + Math.floor((r + 1) * params.h / side);
+                    ctx.fillStyle = jet(Math.max(0, Math.min(1, (2000 - depth.distance_mm[i]) / 1800)));
+                    ctx.fillRect(x0, y0, x1 - x0, y1 - y0);
+                }
+                ctx.globalAlpha = 1;
+            }
+            ctx.strokeStyle = "#0f0";
+            ctx.lineWidth = 2;
+            ctx.strokeRect(params.x, params.y, params.w, params.h);
+        }
+        // ポーリングの往復時間（keep-aliveで接続し直さないため数ms程度になる）
+        const latency = {};
+        function recordLatency(path, ms) {
+            latency[path] = latency[path] === undefined ? ms : latency[path] * 0.8 + ms * 0.2;
+            document.getElementById("latency").innerText =
+                Object.keys(latency).map(k => `${k} ${latency[k].toFixed(1)} ms`).join("  ");
+        }
+        function timedFetch(url) {
+            const t0 = performance.now();
+            return fetch(url).then(r => { recordLatency(url.split("?")[0], performance.now() - t0); return r; });
+        }
         function updateFrame() {
-            document.getElementById("frame").src = "/stream.jpg?" + new Date().getTime();
+            timedFetch("/stream.jpg?" + new Date().getTime())
+                .then(r => r.ok ? r.blob() : Promise.reject())
+                .then(blob => createImageBitmap(blob))
+                .then(bitmap => { if (image) image.close(); image = bitmap; draw(); })
+                .catch(() => {});
+        }
+        function connectDepth() {
+            const ws = new WebSocket(`ws://${location.host}/depth/ws`);
+            ws.binaryType = "arraybuffer";
+            ws.onmessage = e => {
+                const f = decodeDepthFrame(e.data);
+                if (!f) return;
+                depth = f;
+                depthCount++;
+                const now = performance.now();
+                if (now - rateStart >= 1000) {
+                    depthRate = depthCount * 1000 / (now - rateStart);
+                    depthCount = 0;
+                    rateStart = now;
+                }
+                document.getElementById("depth_status").innerText =
+                    `depth: #${f.seq} ${f.zones} zones ${depthRate.toFixed(1)} Hz`;
+                draw();
+            };
+            ws.onclose = () => setTimeout(connectDepth, 1000);
         }
+        connectDepth();
         function updateStatus() {
-            fetch("/status").then(r => r.text()).then(text => {
+            timedFetch("/status").then(r => r.text()).then(text => {
                 const parts = text.split("|");
+                params = {x: parseInt(parts[1]), y: parseInt(parts[2]), w: parseInt(parts[3]), h: parseInt(parts[4]),
+                          alpha: parseFloat(parts[5])};
                 document.getElementById("status").innerText = parts[0];
                 document.getElementById("offset_x").innerText = parts[1];
                 document.getElementById("offset_y").innerText = parts[2];
@@ -109,7 +195,7 @@ void send_html(int client_sock) {
             });
         }
         function adjust(param, delta) {
-            fetch("/adjust?param=" + param + "&delta=" + delta)
+            timedFetch("/adjust?param=" + param + "&delta=" + delta)
                 .then(r => r.text())
                 .then(() => updateStatus());
         }
@@ -131,96 +217,78 @@ void send_html(int client_sock) {
 </body>
 </html>
 )HTML";
-    vector<uchar> data(html.begin(), html.end());
-    send_http_response(client_sock, "text/html", data);
-}
-
-void http_server_thread() {
-    int server_sock = socket(AF_INET, SOCK_STREAM, 0);
-    int opt = 1;
-    setsockopt(server_sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(8081);
-
-    bind(server_sock, (struct sockaddr*)&server_addr, sizeof(server_addr));
-    listen(server_sock, 5);
 
-    cout << "HTTPサーバー起動: http://0.0.0.0:8081/" << endl;
-
-    while (g_running) {
-        struct sockaddr_in client_addr;
-        socklen_t client_len = sizeof(client_addr);
-        int client_sock = accept(server_sock, (struct sockaddr*)&client_addr, &client_len);
-        
-        if (client_sock < 0) continue;
-
-        char buffer[1024] = {0};
-        read(client_sock, buffer, sizeof(buffer));
-        string request(buffer);
-
-        if (request.find("GET / ") == 0 || request.find("GET /index.html") == 0) {
-            send_html(client_sock);
-        } else if (request.find("GET /stream.jpg") == 0) {
-            lock_guard<mutex> lock(g_frame_mutex);
-            if (!g_current_frame.empty()) {
-                vector<uchar> buf;
-                imencode(".jpg", g_current_frame, buf);
-                send_http_response(client_sock, "image/jpeg", buf);
-            }
-        } else if (request.find("GET /status") == 0) {
-            string status_text = g_message + "|" + 
-                to_string(g_offset_x) + "|" + to_string(g_offset_y) + "|" +
-                to_string(g_overlay_width) + "|" + to_string(g_overlay_height) + "|" +
-                to_string(g_alpha);
-            vector<uchar> data(status_text.begin(), status_text.end());
-            send_http_response(client_sock, "text/plain", data);
-        } else if (request.find("GET /adjust?") == 0) {
-            size_t param_pos = request.find("param=");
-            size_t delta_pos = request.find("delta=");
-            if (param_pos != string::npos && delta_pos != string::npos) {
-                string param = request.substr(param_pos + 6, request.find("&", param_pos) - param_pos - 6);
-                string delta_str = request.substr(delta_pos + 6, request.find(" ", delta_pos) - delta_pos - 6);
-                float delta = stof(delta_str);
-                
-                if (param == "offset_x") g_offset_x += (int)delta;
-                else if (param == "offset_y") g_offset_y += (int)delta;
-                else if (param == "width") g_overlay_width = max(50, g_overlay_width + (int)delta);
-                else if (param == "height") g_overlay_height = max(50, g_overlay_height + (int)delta);
-                else if (param == "alpha") g_alpha = max(0.0f, min(1.0f, g_alpha + delta));
-            }
-            string response = "OK";
-            vector<uchar> data(response.begin(), response.end());
-            send_http_response(client_sock, "text/plain", data);
-        } else if (request.find("GET /save") == 0) {
-            FileStorage fs("../Data/depth_calibration.yaml", FileStorage::WRITE);
-            fs << "offset_x" << g_offset_x;
-            fs << "offset_y" << g_offset_y;
-            fs << "overlay_width" << g_overlay_width;
-            fs << "overlay_height" << g_overlay_height;
-            fs << "alpha" << g_alpha;
-            fs.release();
+// HTTPのルートを登録（ハンドラはイベントループのスレッドで呼ばれる）
+void setup_http_routes() {
+    g_http.addStaticRoute("/", "text/html; charset=utf-8", kIndexHtml);
+    g_http.addStaticRoute("/index.html", "text/html; charset=utf-8", kIndexHtml);
+    g_http.addRoute("/stream.jpg", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        lock_guard<mutex> lock(g_frame_mutex);
+        if (!g_current_frame.empty()) {
+            vector<uchar> buf;
+            imencode(".jpg", g_current_frame, buf);
+            send_http_response(client, "image/jpeg", buf);
+        } else {
+            g_http.sendResponse(client, "503 Service Unavailable", "text/plain", "No frame yet\n");
+        }
+    });
+    g_http.addRoute("/depth/ws", [](HttpServer::ConnectionId client, const HttpRequest& request) {
+        string header = websocketHandshakeResponse(request);
+        if (header.empty()) {
+            g_http.sendResponse(client, "400 Bad Request", "text/plain", "WebSocket upgrade required\n");
+            return;
+        }
+        auto reader = make_shared<WebSocketReader>();
+        g_http.beginStream(client, "depth", header, nullptr,
+                           [reader](const char* data, size_t size) { return reader->feed(data, size); });
+    });
+    g_http.addRoute("/status", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        string status_text = g_message + "|" + 
+            to_string(g_offset_x) + "|" + to_string(g_offset_y) + "|" +
+            to_string(g_overlay_width) + "|" + to_string(g_overlay_height) + "|" +
+            to_string(g_alpha);
+        vector<uchar> data(status_text.begin(), status_text.end());
+        send_http_response(client, "text/plain", data);
+    });
+    g_http.addRoute("/adjust", [](HttpServer::ConnectionId client, const HttpRequest& request) {
+        string param = request.param("param");
+        string delta_str = request.param("delta");
+        if (!param.empty() && !delta_str.empty()) {
+            float delta = (float)atof(delta_str.c_str());   // 不正な値で例外を投げてループを止めない
             
-            string response = "Calibration saved successfully!";
-            vector<uchar> data(response.begin(), response.end());
-            send_http_response(client_sock, "text/plain", data);
-        } else if (request.find("GET /reset") == 0) {
-            g_offset_x = 0;
-            g_offset_y = 0;
-            g_overlay_width = 240;
-            g_overlay_height = 240;
-            g_alpha = 0.5f;
-            string response = "OK";
-            vector<uchar> data(response.begin(), response.end());
-            send_http_response(client_sock, "text/plain", data);
+            if (param == "offset_x") g_offset_x += (int)delta;
+            else if (param == "offset_y") g_offset_y += (int)delta;
+            else if (param == "width") g_overlay_width = max(50, g_overlay_width + (int)delta);
+            else if (param == "height") g_overlay_height = max(50, g_overlay_height + (int)delta);
+            else if (param == "alpha") g_alpha = max(0.0f, min(1.0f, g_alpha + delta));
         }
-
-        close(client_sock);
-    }
-
-    close(server_sock);
+        string response = "OK";
+        vector<uchar> data(response.begin(), response.end());
+        send_http_response(client, "text/plain", data);
+    });
+    g_http.addRoute("/save", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        FileStorage fs("../Data/depth_calibration.yaml", FileStorage::WRITE);
+        fs << "offset_x" << g_offset_x;
+        fs << "offset_y" << g_offset_y;
+        fs << "overlay_width" << g_overlay_width;
+        fs << "overlay_height" << g_overlay_height;
+        fs << "alpha" << g_alpha;
+        fs.release();
+        
+        string response = "Calibration saved successfully!";
+        vector<uchar> data(response.begin(), response.end());
+        send_http_response(client, "text/plain", data);
+    });
+    g_http.addRoute("/reset", [](HttpServer::ConnectionId client, const HttpRequest&) {
+        g_offset_x = 0;
+        g_offset_y = 0;
+        g_overlay_width = 240;
+        g_overlay_height = 240;
+        g_alpha = 0.5f;
+        string response = "OK";
+        vector<uchar> data(response.begin(), response.end());
+        send_http_response(client, "text/plain", data);
+    });
 }
 
 int main() {
@@ -231,7 +299,6 @@ int main() {
     memset(&sensor, 0, sizeof(sensor));
     sensor.platform.address = 0x52;
     
-    VL53L8CX_ResultsData results;
     uint8_t status, isAlive;
 
     status = vl53l8cx_is_alive(&sensor, &isAlive);
@@ -252,6 +319,13 @@ int main() {
         return -1;
     }
 
+    // 8x8の上限の15Hzで測り、プレビューにはそのまま全フレーム送る
+    status = vl53l8cx_set_ranging_frequency_hz(&sensor, 15);
+    if (status) {
+        cerr << "測距周期の設定に失敗しました。" << endl;
+        return -1;
+    }
+
     status = vl53l8cx_start_ranging(&sensor);
 
     // カメラ初期化
@@ -264,12 +338,23 @@ int main() {
     cap.set(CAP_PROP_FRAME_WIDTH, 320);
     cap.set(CAP_PROP_FRAME_HEIGHT, 240);
 
-    thread http_thread(http_server_thread);
+    setup_http_routes();
+    if (!g_http.init(8081)) {
+        return -1;
+    }
+    g_http.start();
+    cout << "HTTPサーバー起動: http://0.0.0.0:8081/" << endl;
 
     cout << "ブラウザで http://<RaspberryPiのIP>:8081/ を開いてください" << endl;
 
-    // Depthマップを保持（データが来ない時も前回のを表示し続ける）
-    Mat depth_map = Mat::zeros(8, 8, CV_16UC1);
+    // 距離はセンサーの周期で読み、生データのままブラウザへ送る（色付け・合成はブラウザ側）
+    ToFReader tof_reader(&sensor);
+    tof_reader.setFrameListener([](const DepthFrame& frame) {
+        vector<unsigned char> encoded;
+        encodeDepthFrame(frame, encoded);
+        g_http.broadcast("depth", {websocketFrame(WebSocketOpcode::Binary, string(encoded.begin(), encoded.end()))});
+    });
+    tof_reader.start();
     
     while (g_running) {
         Mat frame;
@@ -279,76 +364,20 @@ int main() {
         // カメラを左90度回転
         rotate(frame, frame, ROTATE_90_COUNTERCLOCKWISE);
 
-        // Depth データ取得（新しいデータがあれば更新）
-        uint8_t isReady = 0;
-        vl53l8cx_check_data_ready(&sensor, &isReady);
-        
-        if (isReady) {
-            vl53l8cx_get_ranging_data(&sensor, &results);
-            for (int i = 0; i < 64; i++) {
-                int row = i / 8;
-                int col = i % 8;
-                depth_map.at<uint16_t>(row, col) = results.distance_mm[i];
-            }
-        }
-        // データが来なくても前回のdepth_mapをそのまま使う
-
-        // Depthマップを色付け（回転なし）
-        // 固定範囲で正規化（200mm～2000mm）
-        // 近い=赤(255)、遠い=青(0)になるように逆変換
-        Mat depth_normalized = Mat::zeros(8, 8, CV_8UC1);
-        for (int i = 0; i < 8; i++) {
-            for (int j = 0; j < 8; j++) {
-                uint16_t dist = depth_map.at<uint16_t>(i, j);
-                // 近いほど高い値（赤）、遠いほど低い値（青）
-                int val = (int)((2000.0 - dist) * 255.0 / 1800.0);
-                val = max(0, min(255, val));  // 0-255にクリップ
-                depth_normalized.at<uint8_t>(i, j) = (uint8_t)val;
-            }
-        }
-        
-        Mat depth_colored;
-        applyColorMap(depth_normalized, depth_colored, COLORMAP_JET);
-        
-        // Depthマップをリサイズして重ね合わせ
-        Mat depth_resized;
-        resize(depth_colored, depth_resized, Size(g_overlay_width, g_overlay_height), 0, 0, INTER_NEAREST);
-        
-        Mat display = frame.clone();
-        
-        // オーバーレイ範囲を計算（範囲チェックを厳密に）
-        int x1 = max(0, g_offset_x);
-        int y1 = max(0, g_offset_y);
-        int x2 = min(display.cols, g_offset_x + g_overlay_width);
-        int y2 = min(display.rows, g_offset_y + g_overlay_height);
-        
-        int dx1 = max(0, -g_offset_x);
-        int dy1 = max(0, -g_offset_y);
-        int dx2 = dx1 + (x2 - x1);
-        int dy2 = dy1 + (y2 - y1);
-        
-        // 有効な範囲かチェック（depthマップの範囲も確認）
-        if (x2 > x1 && y2 > y1 && dx2 > dx1 && dy2 > dy1 &&
-            dx2 <= depth_resized.cols && dy2 <= depth_resized.rows) {
-            Mat roi = display(Rect(x1, y1, x2 - x1, y2 - y1));
-            Mat depth_roi = depth_resized(Rect(dx1, dy1, dx2 - dx1, dy2 - dy1));
-            addWeighted(roi, 1.0 - g_alpha, depth_roi, g_alpha, 0, roi);
-        }
-        
-        // 枠を描画
-        rectangle(display, Point(x1, y1), Point(x2, y2), Scalar(0, 255, 0), 2);
-        
         {
             lock_guard<mutex> lock(g_frame_mutex);
-            g_current_frame = display;
+            g_current_frame = frame;
         }
 
         this_thread::sleep_for(chrono::milliseconds(100));
     }
 
+    tof_reader.stop();
     vl53l8cx_stop_ranging(&sensor);
     g_running = false;
-    http_thread.join();
+    g_http.stop();
+    cout << g_http.statsSummary() << endl;
+    cout << g_http.routeStatsSummary();
     cap.release();
 
     return 0;
@@ -0,0 +1,493 @@
+/**
+ * @file latency_tool.cpp
+ * @brief Glass-to-glass latency measurement for the RobotHead streams (--latency / --latency-timecode)
+ * @author RobotC Project
+ * @date 2026-01-23
+ *
+ * MJPEG（http://host:8080/）またはWebSocket（ws://host:8080/ws）に接続し、フレームごとに
+ *   - パートヘッダー（X-Timestamp / X-Encoded-Timestamp）またはメタデータ（t_us / t_enc_us）の撮影・エンコード時刻
+ *   - 画像の下端に焼き込まれた撮影時刻（--latency-timecode）
+ *   - 合成入力（--source synthetic）のフレーム番号の帯（取りこぼし・重複の検出）
+ * を読んで、撮影から受信・デコードまでの遅延の分布を出す。最後にロボット側の区間（/stream/latency）も表示する。
+ *
+ * 時刻はロボットとこのPCの時計の差をそのまま含む。ロボット上で実行するか、chronyなどで同期しておくこと
+ * （ずれが分かっていれば --clock-offset-ms で補正する）。
+ */
+
+#include "camera/frame_band.h"
+#include "platform/latency_trace.h"
+#include <opencv2/imgcodecs.hpp>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <netdb.h>
+#include <strings.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+using namespace std;
+
+static void printUsage(const char* prog) {
+    cout << "使い方:\n"
+         << "  " << prog << " --url http://host:8080/ [--frames N] [--csv out.csv] [--clock-offset-ms MS]\n"
+         << "  " << prog << " --url ws://host:8080/ws  [--frames N] [--csv out.csv] [--clock-offset-ms MS]\n"
+         << "\n"
+         << "  robot_head を --stream --latency（画素の撮影時刻も読むなら --latency-timecode）で起動しておく。\n"
+         << "  --source synthetic の入力ならフレーム番号の帯から取りこぼし・重複も数える。\n"
+         << "  --clock-offset-ms はロボットの時計がこのPCより進んでいる量（ミリ秒）。\n";
+}
+
+static uint64_t nowUs() {
+    return (uint64_t)chrono::duration_cast<chrono::microseconds>(
+        chrono::system_clock::now().time_since_epoch()).count();
+}
+
+// "秒.マイクロ秒" → マイクロ秒
+static uint64_t parseTimestamp(const string& text) {
+    size_t dot = text.find('.');
+    uint64_t sec = strtoull(text.c_str(), nullptr, 10);
+    uint64_t usec = 0;
+    if (dot != string::npos) {
+        string frac = text.substr(dot + 1, 6);
+        frac.resize(6, '0');
+        usec = strtoull(frac.c_str(), nullptr, 10);
+    }
+    return sec * 1000000 + usec;
+}
+
+// JSONの数値フィールドを取り出す（メタデータは平らなオブジェクトの先頭部分しか見ない）
+static uint64_t jsonNumber(const string& json, const char* key) {
+    string pattern = string("\"") + key + "\":";
+    size_t pos = json.find(pattern);
+    if (pos == string::npos) {
+        return 0;
+    }
+    return strtoull(json.c_str() + pos + pattern.size(), nullptr, 10);
+}
+
+struct Url {
+    bool websocket = false;
+    string host;
+    string port = "80";
+    string path = "/";
+};
+
+static bool parseUrl(const string& text, Url& url) {
+    string rest;
+    if (text.compare(0, 7, "http://") == 0) {
+        rest = text.substr(7);
+    } else if (text.compare(0, 5, "ws://") == 0) {
+        url.websocket = true;
+        rest = text.substr(5);
+    } else {
+        return false;
+    }
+    size_t slash = rest.find('/');
+    string authority = rest.substr(0, slash);
+    if (slash != string::npos) {
+        url.path = rest.substr(slash);
+    }
+    size_t colon = authority.find(':');
+    url.host = authority.substr(0, colon);
+    if (colon != string::npos) {
+        url.port = authority.substr(colon + 1);
+    }
+    return !url.host.empty();
+}
+
+/** @brief 受信バッファ付きのTCP接続（行単位・バイト数指定で読む） */
+class Connection {
+public:
+    ~Connection() {
+        if (fd_ >= 0) {
+            ::close(fd_);
+        }
+    }
+
+    bool connect(const Url& url) {
+        struct addrinfo hints;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        struct addrinfo* res = nullptr;
+        if (getaddrinfo(url.host.c_str(), url.port.c_str(), &hints, &res) != 0 || res == nullptr) {
+            cerr << "名前を解決できません: " << url.host << endl;
+            return false;
+        }
+        for (struct addrinfo* ai = res; ai != nullptr; ai = ai->ai_next) {
+            fd_ = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+            if (fd_ < 0) {
+                continue;
+            }
+            if (::connect(fd_, ai->ai_addr, ai->ai_addrlen) == 0) {
+                break;
+            }
+            ::close(fd_);
+            fd_ = -1;
+        }
+        freeaddrinfo(res);
+        if (fd_ < 0) {
+            cerr << "接続できません: " << url.host << ":" << url.port << endl;
+            return false;
+        }
+        // フレームが止まったら諦める
+        struct timeval tv;
+        tv.tv_sec = 10;
+        tv.tv_usec = 0;
+        setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        return true;
+    }
+
+    bool sendAll(const string& data) {
+        size_t sent = 0;
+        while (sent < data.size()) {
+            ssize_t n = send(fd_, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                return false;
+            }
+            sent += (size_t)n;
+        }
+        return true;
+    }
+
+    /** @brief CRLF（またはLF）までの1行（改行は含まない） */
+    bool readLine(string& line) {
+        size_t pos;
+        while ((pos = buffer_.find('\n', offset_)) == string::npos) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        line.assign(buffer_, offset_, pos - offset_);
+        offset_ = pos + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        return true;
+    }
+
+    bool readExact(size_t size, string& out) {
+        while (buffer_.size() - offset_ < size) {
+            if (!fill()) {
+                return false;
+            }
+        }
+        out.assign(buffer_, offset_, size);
+        offset_ += size;
+        return true;
+    }
+
+    /** @brief 接続が閉じるまで全て読む */
+    string readToEnd() {
+        while (fill()) {
+        }
+        string rest = buffer_.substr(offset_);
+        offset_ = buffer_.size();
+        return rest;
+    }
+
+private:
+    bool fill() {
+        // 読み終えた部分を詰めてから追記する
+        if (offset_ > 0 && offset_ == buffer_.size()) {
+            buffer_.clear();
+            offset_ = 0;
+        } else if (offset_ > (1 << 20)) {
+            buffer_.erase(0, offset_);
+            offset_ = 0;
+        }
+        char chunk[65536];
+        ssize_t n = recv(fd_, chunk, sizeof(chunk), 0);
+        if (n <= 0) {
+            return false;
+        }
+        buffer_.append(chunk, (size_t)n);
+        return true;
+    }
+
+    int fd_ = -1;
+    string buffer_;
+    size_t offset_ = 0;
+};
+
+// レスポンスヘッダーを空行まで読み、ステータス行を返す
+static bool readResponseHeader(Connection& conn, string& status) {
+    if (!conn.readLine(status)) {
+        return false;
+    }
+    string line;
+    while (conn.readLine(line)) {
+        if (line.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/** @brief 受信した1フレーム */
+struct ReceivedFrame {
+    string jpeg;
+    uint64_t capture_us = 0;    // ヘッダー／メタデータの撮影時刻
+    uint64_t encoded_us = 0;    // ヘッダー／メタデータのエンコード完了時刻
+    uint64_t received_us = 0;   // 最後のバイトを受け取った時刻
+};
+
+static bool readMjpegFrame(Connection& conn, ReceivedFrame& frame) {
+    string line;
+    // 境界行まで読み飛ばす（前のパートのCRLFを含む）
+    do {
+        if (!conn.readLine(line)) {
+            return false;
+        }
+    } while (line.compare(0, 2, "--") != 0);
+
+    size_t content_length = 0;
+    frame.capture_us = 0;
+    frame.encoded_us = 0;
+    while (conn.readLine(line) && !line.empty()) {
+        size_t colon = line.find(':');
+        if (colon == string::npos) {
+            continue;
+        }
+        string name = line.substr(0, colon);
+        string value = line.substr(colon + 1);
+        value.erase(0, value.find_first_not_of(' '));
+        if (strcasecmp(name.c_str(), "Content-Length") == 0) {
+            content_length = (size_t)strtoull(value.c_str(), nullptr, 10);
+        } else if (strcasecmp(name.c_str(), "X-Timestamp") == 0) {
+            frame.capture_us = parseTimestamp(value);
+        } else if (strcasecmp(name.c_str(), "X-Encoded-Timestamp") == 0) {
+            frame.encoded_us = parseTimestamp(value);
+        }
+    }
+    if (content_length == 0 || !conn.readExact(content_length, frame.jpeg)) {
+        return false;
+    }
+    frame.received_us = nowUs();
+    return true;
+}
+
+// WebSocketのフレームを1つ読む（サーバーからのフレームはマスクなし、分割なし）
+static bool readWebSocketMessage(Connection& conn, int& opcode, string& payload) {
+    string header;
+    if (!conn.readExact(2, header)) {
+        return false;
+    }
+    opcode = (unsigned char)header[0] & 0x0F;
+    bool masked = ((unsigned char)header[1] & 0x80) != 0;
+    uint64_t length = (unsigned char)header[1] & 0x7F;
+    string extended;
+    if (length == 126) {
+        if (!conn.readExact(2, extended)) {
+            return false;
+        }
+        length = ((uint64_t)(unsigned char)extended[0] << 8) | (unsigned char)extended[1];
+    } else if (length == 127) {
+        if (!conn.readExact(8, extended)) {
+            return false;
+        }
+        length = 0;
+        for (int i = 0; i < 8; i++) {
+            length = (length << 8) | (unsigned char)extended[i];
+        }
+    }
+    string mask;
+    if (masked && !conn.readExact(4, mask)) {
+        return false;
+    }
+    if (!conn.readExact((size_t)length, payload)) {
+        return false;
+    }
+    if (masked) {
+        for (size_t i = 0; i < payload.size(); i++) {
+            payload[i] ^= mask[i % 4];
+        }
+    }
+    return true;
+}
+
+// メタデータ（テキスト）→ JPEG（バイナリ）の組を1フレームとして読む
+static bool readWebSocketFrame(Connection& conn, ReceivedFrame& frame) {
+    string metadata;
+    while (true) {
+        int opcode;
+        string payload;
+        if (!readWebSocketMessage(conn, opcode, payload)) {
+            return false;
+        }
+        if (opcode == 0x1) {
+            metadata.swap(payload);
+        } else if (opcode == 0x2) {
+            frame.received_us = nowUs();
+            frame.jpeg.swap(payload);
+            frame.capture_us = jsonNumber(metadata, "t_us");
+            frame.encoded_us = jsonNumber(metadata, "t_enc_us");
+            return true;
+        } else if (opcode == 0x8) {
+            return false;
+        }
+    }
+}
+
+// ロボット側の区間（検出、挨拶音声）を取得して表示する
+static void printServerLatency(const Url& stream_url) {
+    Url url = stream_url;
+    url.websocket = false;
+    url.path = "/stream/latency";
+    Connection conn;
+    if (!conn.connect(url) ||
+        !conn.sendAll("GET " + url.path + " HTTP/1.1\r\nHost: " + url.host + "\r\nConnection: close\r\n\r\n")) {
+        return;
+    }
+    string status;
+    if (!readResponseHeader(conn, status)) {
+        return;
+    }
+    cout << "ロボット側の区間（/stream/latency）: " << conn.readToEnd();
+}
+
+int main(int argc, char** argv) {
+    string url_text;
+    size_t max_frames = 300;
+    string csv_path;
+    double clock_offset_ms = 0.0;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--url" && i + 1 < argc) {
+            url_text = argv[++i];
+        } else if (arg == "--frames" && i + 1 < argc) {
+            max_frames = (size_t)atol(argv[++i]);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else if (arg == "--clock-offset-ms" && i + 1 < argc) {
+            clock_offset_ms = atof(argv[++i]);
+        } else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    Url url;
+    if (url_text.empty() || !parseUrl(url_text, url)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    Connection conn;
+    if (!conn.connect(url)) {
+        return 1;
+    }
+    string request = "GET " + url.path + " HTTP/1.1\r\nHost: " + url.host + ":" + url.port + "\r\n";
+    if (url.websocket) {
+        request += "Upgrade: websocket\r\nConnection: Upgrade\r\n"
+                   "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\nSec-WebSocket-Version: 13\r\n";
+    }
+    request += "\r\n";
+    string status;
+    if (!conn.sendAll(request) || !readResponseHeader(conn, status)) {
+        cerr << "レスポンスを受け取れません" << endl;
+        return 1;
+    }
+    if (status.find(url.websocket ? " 101" : " 200") == string::npos) {
+        cerr << "接続が拒否されました: " << status << endl;
+        return 1;
+    }
+
+    ofstream csv;
+    if (!csv_path.empty()) {
+        csv.open(csv_path);
+        if (!csv) {
+            cerr << "CSVを作成できません: " << csv_path << endl;
+            return 1;
+        }
+        csv << "index,counter,capture_us,encoded_us,received_us,decoded_us,timecode_us\n";
+    }
+
+    // 受信時刻をロボットの時計に合わせる量
+    int64_t offset_us = (int64_t)(clock_offset_ms * 1000.0);
+    LatencyTrace trace(max_frames > 0 ? max_frames : 1);
+    trace.setEnabled(true);
+
+    size_t frames = 0, no_header = 0, no_timecode = 0, decode_failed = 0;
+    size_t counters_read = 0, dropped = 0, repeated = 0, reordered = 0;
+    bool has_counter = false;
+    uint32_t last_counter = 0;
+    ReceivedFrame frame;
+    while (frames < max_frames) {
+        bool ok = url.websocket ? readWebSocketFrame(conn, frame) : readMjpegFrame(conn, frame);
+        if (!ok) {
+            cerr << "ストリームが途切れました（" << frames << "フレーム受信）" << endl;
+            break;
+        }
+        frames++;
+        uint64_t received_us = frame.received_us + offset_us;
+
+        cv::Mat image = cv::imdecode(cv::Mat(1, (int)frame.jpeg.size(), CV_8UC1, (void*)frame.jpeg.data()),
+                                     cv::IMREAD_COLOR);
+        uint64_t decoded_us = nowUs() + offset_us;
+        if (image.empty()) {
+            decode_failed++;
+            continue;
+        }
+
+        if (frame.capture_us != 0) {
+            trace.record("capture_to_encoded", frame.capture_us, frame.encoded_us);
+            trace.record("encoded_to_received", frame.encoded_us, received_us);
+            trace.record("capture_to_received", frame.capture_us, received_us);
+            trace.record("capture_to_decoded", frame.capture_us, decoded_us);
+        } else {
+            no_header++;
+        }
+
+        // 画素の撮影時刻（ずれの少し先を基準にして、時計が進んでいても一周分ずれないようにする）
+        uint64_t timecode_us = 0;
+        if (readCaptureTimecode(image, decoded_us + 60000000ULL, timecode_us)) {
+            trace.record("timecode_to_decoded", timecode_us, decoded_us);
+        } else {
+            no_timecode++;
+        }
+
+        // 合成入力のフレーム番号（上端の帯、表示用に回転した後は左端）
+        uint32_t counter = 0;
+        bool counter_ok = readFrameBand(image, FrameBandEdge::Left, counter) ||
+                          readFrameBand(image, FrameBandEdge::Top, counter);
+        if (counter_ok) {
+            counters_read++;
+            if (has_counter) {
+                if (counter == last_counter) {
+                    repeated++;
+                } else if (counter > last_counter) {
+                    dropped += counter - last_counter - 1;
+                } else {
+                    reordered++;
+                }
+            }
+            has_counter = true;
+            last_counter = counter;
+        }
+
+        if (csv.is_open()) {
+            csv << frames << "," << (counter_ok ? to_string(counter) : string()) << ","
+                << frame.capture_us << "," << frame.encoded_us << "," << received_us << ","
+                << decoded_us << "," << timecode_us << "\n";
+        }
+    }
+
+    cout << "受信 " << frames << "フレーム（デコード失敗 " << decode_failed
+         << "、時刻ヘッダーなし " << no_header << "、撮影時刻の帯なし " << no_timecode << "）" << endl;
+    if (counters_read > 0) {
+        cout << "フレーム番号: 読めた " << counters_read << "、取りこぼし " << dropped
+             << "、重複 " << repeated << "、順序の入れ替わり " << reordered << endl;
+    }
+    cout << trace.summary() << endl;
+    if (no_header == frames && frames > 0) {
+        cout << "（時刻ヘッダーがありません。robot_headを--latencyで起動してください）" << endl;
+    }
+    printServerLatency(url);
+    return 0;
+}
@@ -0,0 +1,267 @@
+/**
+ * @file session_tool.cpp
+ * @brief Inspect, slice, convert and export RobotHead session logs (.rsl)
+ * @author RobotC Project
+ * @date 2026-01-23
+ */
+
+#include "platform/session_log.h"
+#include "platform/black_box.h"
+#include "platform/mapped_file.h"
+#include <opencv2/imgcodecs.hpp>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <sys/stat.h>
+
+using namespace std;
+
+static void printUsage(const char* prog) {
+    cout << "使い方:\n"
+         << "  " << prog << " info <session.rsl>\n"
+         << "  " << prog << " list <session.rsl> [--type jpeg|raw|depth|tof|uart_rx|uart_tx|event] [--limit N]\n"
+         << "  " << prog << " slice <in.rsl> <out.rsl> --from 秒 --to 秒   (先頭の記録からの秒数)\n"
+         << "  " << prog << " convert <blackbox.rbb> <out.rsl>              (ブラックボックスのダンプを変換)\n"
+         << "  " << prog << " export <session.rsl> <dir>                    (画像をjpg、UART/イベントをCSVで書き出す)\n";
+}
+
+static double relativeSeconds(const SessionReader& reader, uint64_t timestamp_us) {
+    return (double)(timestamp_us - reader.firstUs()) / 1e6;
+}
+
+static string printable(const SessionRecord& record, size_t max_chars) {
+    string text(record.data, min(record.size, max_chars));
+    for (char& c : text) {
+        if (c == '\n' || c == '\r' || c == ',') {
+            c = ' ';
+        }
+    }
+    return text;
+}
+
+static bool isText(SessionRecordType type) {
+    return type == SessionRecordType::UartRx || type == SessionRecordType::UartTx || type == SessionRecordType::Event;
+}
+
+static int cmdInfo(const string& path) {
+    SessionReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    map<string, pair<size_t, uint64_t>> per_type;   // 件数, バイト数
+    for (size_t i = 0; i < reader.size(); i++) {
+        SessionRecord record = reader.record(i);
+        auto& entry = per_type[sessionRecordTypeName(record.type)];
+        entry.first++;
+        entry.second += record.size;
+    }
+    double duration = reader.size() > 0 ? relativeSeconds(reader, reader.lastUs()) : 0.0;
+
+    cout << "ファイル: " << path << " (" << reader.fileBytes() / 1024 << "KB)\n"
+         << "メモ: " << reader.header().note << "\n"
+         << "記録: " << reader.size() << "件, チャンク " << reader.chunkCount()
+         << (reader.indexRecovered() ? " (索引なし: チャンクから復元)" : "") << "\n"
+         << "時間: " << fixed << setprecision(3) << duration << "秒\n";
+    if (reader.header().tof_results_bytes != sizeof(VL53L8CX_ResultsData)) {
+        cout << "注意: ToFの結果の大きさが異なります（記録 " << reader.header().tof_results_bytes
+             << "バイト, このビルド " << sizeof(VL53L8CX_ResultsData) << "バイト）\n";
+    }
+    for (const auto& kv : per_type) {
+        cout << "  " << setw(8) << left << kv.first << right << setw(8) << kv.second.first << "件 "
+             << setw(10) << kv.second.second / 1024 << "KB";
+        if (duration > 0.0) {
+            cout << "  " << setprecision(1) << kv.second.first / duration << "/s";
+        }
+        cout << setprecision(3) << "\n";
+    }
+    return 0;
+}
+
+static int cmdList(const string& path, const string& type_filter, size_t limit) {
+    SessionReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    size_t shown = 0;
+    for (size_t i = 0; i < reader.size() && shown < limit; i++) {
+        SessionRecord record = reader.record(i);
+        const char* name = sessionRecordTypeName(record.type);
+        if (!type_filter.empty() && type_filter != name) {
+            continue;
+        }
+        cout << setw(8) << i << "  " << fixed << setprecision(6) << setw(12) << relativeSeconds(reader, record.timestamp_us)
+             << "  " << setw(8) << left << name << right << setw(8) << record.size;
+        if (isText(record.type)) {
+            cout << "  " << printable(record, 80);
+        } else if (record.type == SessionRecordType::RawFrame) {
+            cv::Mat view;
+            if (SessionReader::rawFrameView(record, view)) {
+                cout << "  " << view.cols << "x" << view.rows << "x" << view.channels();
+            }
+        }
+        cout << "\n";
+        shown++;
+    }
+    return 0;
+}
+
+static int cmdSlice(const string& in_path, const string& out_path, double from_s, double to_s) {
+    SessionReader reader;
+    if (!reader.open(in_path)) {
+        return 1;
+    }
+    uint64_t from_us = reader.firstUs() + (uint64_t)(max(from_s, 0.0) * 1e6);
+    uint64_t to_us = reader.firstUs() + (uint64_t)(max(to_s, 0.0) * 1e6);
+    SessionWriter writer;
+    writer.setBlocking(true);   // キューが一杯なら書き込みスレッドが追いつくまで待つ
+    if (!writer.open(out_path, reader.header().note)) {
+        return 1;
+    }
+    // 記録は時刻順に並んでいるので開始位置は索引の二分探索で決める
+    size_t written = 0;
+    for (size_t i = reader.lowerBound(from_us); i < reader.size(); i++) {
+        SessionRecord record = reader.record(i);
+        if (record.timestamp_us > to_us) {
+            break;
+        }
+        writer.append(record.type, record.data, record.size, record.timestamp_us);
+        written++;
+    }
+    writer.close();
+    cout << written << "件を書き出しました: " << out_path << endl;
+    return 0;
+}
+
+static int cmdConvert(const string& in_path, const string& out_path) {
+    MappedFile file;
+    if (!file.open(in_path) || file.size() < sizeof(BlackBoxDumpHeader)) {
+        cerr << "ダンプを開けません: " << in_path << endl;
+        return 1;
+    }
+    BlackBoxDumpHeader dump;
+    memcpy(&dump, file.data(), sizeof(dump));
+    if (memcmp(dump.magic, "RBBXDUMP", 8) != 0) {
+        cerr << "ブラックボックスのダンプではありません: " << in_path << endl;
+        return 1;
+    }
+    string note = string("blackbox:") + string(dump.reason, strnlen(dump.reason, sizeof(dump.reason)));
+    SessionWriter writer;
+    writer.setBlocking(true);   // キューが一杯なら書き込みスレッドが追いつくまで待つ
+    if (!writer.open(out_path, note)) {
+        return 1;
+    }
+    size_t pos = sizeof(dump);
+    size_t written = 0;
+    for (uint32_t i = 0; i < dump.record_count && pos + sizeof(BlackBoxRecordHeader) <= file.size(); i++) {
+        BlackBoxRecordHeader header;
+        memcpy(&header, file.data() + pos, sizeof(header));
+        if (pos + sizeof(header) + header.size > file.size()) {
+            break;
+        }
+        // 1〜5の種類は同じ値なのでそのまま使える
+        writer.append((SessionRecordType)header.type, file.data() + pos + sizeof(header), header.size,
+                      header.timestamp_us);
+        written++;
+        pos += (sizeof(header) + header.size + 7) / 8 * 8;
+    }
+    writer.close();
+    cout << written << "件を変換しました: " << out_path << endl;
+    return 0;
+}
+
+static int cmdExport(const string& path, const string& dir) {
+    SessionReader reader;
+    if (!reader.open(path)) {
+        return 1;
+    }
+    mkdir(dir.c_str(), 0755);
+    ofstream text_csv(dir + "/text.csv");
+    ofstream frames_csv(dir + "/frames.csv");
+    if (!text_csv || !frames_csv) {
+        cerr << "書き出し先を作成できません: " << dir << endl;
+        return 1;
+    }
+    text_csv << "index,time_s,timestamp_us,type,text\n";
+    frames_csv << "index,time_s,timestamp_us,file\n";
+
+    size_t frames = 0, texts = 0;
+    cv::Mat image;
+    for (size_t i = 0; i < reader.size(); i++) {
+        SessionRecord record = reader.record(i);
+        double t = relativeSeconds(reader, record.timestamp_us);
+        if (isText(record.type)) {
+            text_csv << i << "," << fixed << setprecision(6) << t << "," << record.timestamp_us << ","
+                     << sessionRecordTypeName(record.type) << "," << printable(record, record.size) << "\n";
+            texts++;
+        } else if (record.type == SessionRecordType::JpegFrame || record.type == SessionRecordType::RawFrame) {
+            char name[32];
+            snprintf(name, sizeof(name), "frame_%06zu.jpg", frames);
+            bool ok;
+            if (record.type == SessionRecordType::JpegFrame) {
+                // JPEGはデコードせずそのまま書き出す
+                ofstream out(dir + "/" + name, ios::binary);
+                out.write(record.data, record.size);
+                ok = (bool)out;
+            } else {
+                ok = SessionReader::decodeFrame(record, image) && cv::imwrite(dir + "/" + name, image);
+            }
+            if (ok) {
+                frames_csv << i << "," << fixed << setprecision(6) << t << "," << record.timestamp_us << ","
+                           << name << "\n";
+                frames++;
+            }
+        }
+    }
+    cout << "画像 " << frames << "枚, テキスト " << texts << "行を書き出しました: " << dir << endl;
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    string command = argv[1];
+    if (command == "info") {
+        return cmdInfo(argv[2]);
+    }
+    if (command == "list") {
+        string type_filter;
+        size_t limit = (size_t)-1;
+        for (int i = 3; i + 1 < argc; i += 2) {
+            string arg = argv[i];
+            if (arg == "--type") {
+                type_filter = argv[i + 1];
+            } else if (arg == "--limit") {
+                limit = (size_t)atol(argv[i + 1]);
+            }
+        }
+        return cmdList(argv[2], type_filter, limit);
+    }
+    if (command == "slice" && argc >= 4) {
+        double from_s = 0.0, to_s = 1e12;
+        for (int i = 4; i + 1 < argc; i += 2) {
+            string arg = argv[i];
+            if (arg == "--from") {
+                from_s = atof(argv[i + 1]);
+            } else if (arg == "--to") {
+                to_s = atof(argv[i + 1]);
+            }
+        }
+        return cmdSlice(argv[2], argv[3], from_s, to_s);
+    }
+    if (command == "convert" && argc >= 4) {
+        return cmdConvert(argv[2], argv[3]);
+    }
+    if (command == "export" && argc >= 4) {
+        return cmdExport(argv[2], argv[3]);
+    }
+    printUsage(argv[0]);
+    return 1;
+}
@@ -7,14 +7,107 @@ Raspberry Pi Zero 2W向けに最適化
   pip install ultralytics onnx onnxruntime
 
 使い方:
-  python3 export_yolov8_int8.py
+  python3 export_yolov8_int8.py [キャリブレーション画像ディレクトリ]
+
+キャリブレーション画像（実機カメラで撮影したjpg/png、100枚程度推奨）を与えると
+QDQ形式のINT8モデル yolov8n_320_int8.onnx を出力する。
+RobotHead側では --model でこのファイルを指定するとINT8推論になる。
 """
 
 from ultralytics import YOLO
 import onnx
 import os
+import sys
+import glob
+import numpy as np
+
+CALIB_MAX_IMAGES = 200
+
+
+class YOLOCalibrationReader:
+    """onnxruntime.quantization用のキャリブレーションデータリーダー
+
+    RobotHeadの前処理（blobFromImage: 1/255スケール, BGR→RGB, リサイズ）と同じ変換を行う
+    """
+
+    def __init__(self, image_dir, input_name, imgsz):
+        import cv2
+        self.cv2 = cv2
+        self.input_name = input_name
+        self.imgsz = imgsz
+        paths = sorted(glob.glob(os.path.join(image_dir, "*.jpg")) +
+                       glob.glob(os.path.join(image_dir, "*.png")))
+        self.paths = iter(paths[:CALIB_MAX_IMAGES])
+
+    def get_next(self):
+        for path in self.paths:
+            img = self.cv2.imread(path)
+            if img is None:
+                continue
+            img = self.cv2.resize(img, (self.imgsz, self.imgsz))
+            img = self.cv2.cvtColor(img, self.cv2.COLOR_BGR2RGB)
+            blob = img.astype(np.float32).transpose(2, 0, 1)[np.newaxis] / 255.0
+            return {self.input_name: blob}
+        return None
+
+
+def quantize_int8(onnx_path, calib_dir, imgsz):
+    """FP32 ONNXをQDQ形式のINT8 ONNXに静的量子化する"""
+    from onnxruntime.quantization import (quantize_static, CalibrationDataReader,
+                                          QuantFormat, QuantType)
+
+    model = onnx.load(onnx_path)
+    input_name = model.graph.input[0].name
 
-def export_yolov8_onnx_int8():
+    # 検出ヘッド（/model.22 のDFL・座標デコード部分）は精度劣化が大きいためFP32のまま残す
+    # → 出力テンソルはFP32になる（INT8出力のモデルもC++側のデコーダで扱える）
+    head_nodes = [n.name for n in model.graph.node if n.name.startswith("/model.22/dfl")
+                  or (n.name.startswith("/model.22/") and n.op_type in ("Concat", "Sigmoid", "Sub", "Add", "Div", "Mul"))]
+
+    reader_impl = YOLOCalibrationReader(calib_dir, input_name, imgsz)
+
+    class Reader(CalibrationDataReader):
+        def get_next(self):
+            return reader_impl.get_next()
+
+    int8_path = onnx_path.replace(".onnx", "_int8.onnx")
+    quantize_static(
+        onnx_path,
+        int8_path,
+        Reader(),
+        quant_format=QuantFormat.QDQ,       # OpenCV DNNはQuantizeLinear/DequantizeLinearをInt8レイヤーとして取り込む
+        activation_type=QuantType.QInt8,    # OpenCVのInt8カーネルは符号付きINT8
+        weight_type=QuantType.QInt8,
+        per_channel=False,
+        nodes_to_exclude=head_nodes,
+    )
+    return int8_path
+
+def write_manifest(onnx_path, imgsz, quantization, fallback=None):
+    """robot_headが読むマニフェスト（<モデル名>.yaml）を出力する
+
+    latency_ms / rss_mb は0（未計測）で出力し、Pi上で
+    detector_bench --write-manifest を実行すると実測値で更新される。
+    """
+    manifest_path = os.path.splitext(onnx_path)[0] + ".yaml"
+    lines = [
+        "%YAML:1.0",
+        "---",
+        f"input_size: {imgsz}",
+        "layout: yolov8",
+        "num_classes: 80",
+        "labels: coco.names",
+        f"quantization: {quantization}",
+        "latency_ms: 0.",
+        "rss_mb: 0.",
+        f"fallback: \"{os.path.basename(fallback) if fallback else ''}\"",
+    ]
+    with open(manifest_path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+    print(f"マニフェストを出力しました: {manifest_path}")
+    return manifest_path
+
+def export_yolov8_onnx_int8(calib_dir=None):
     """YOLOv8モデルをONNX形式（INT8量子化）でエクスポート"""
     
     # YOLOv8nモデル（最軽量版）をロード
@@ -60,21 +153,44 @@ def export_yolov8_onnx_int8():
     )
     print(f"軽量版エクスポート完了: {onnx_path_320}")
     
+    # 軽量版をINT8量子化（キャリブレーション画像がある場合のみ）
+    int8_path_320 = None
+    if calib_dir and os.path.isdir(calib_dir):
+        print(f"\nINT8量子化中（キャリブレーション画像: {calib_dir}）...")
+        int8_path_320 = quantize_int8(onnx_path_320, calib_dir, 320)
+        print(f"INT8量子化完了: {int8_path_320}")
+    else:
+        print("\nキャリブレーション画像ディレクトリが指定されていないためINT8量子化をスキップします")
+    
+    # マニフェスト（メモリ予算を超える場合はFP32 → INT8に切り替える）
+    write_manifest(onnx_path, 640, "fp32", fallback=onnx_path_320)
+    write_manifest(onnx_path_320, 320, "fp32", fallback=int8_path_320)
+    if int8_path_320:
+        write_manifest(int8_path_320, 320, "int8_qdq")
+    
     # 使用方法の出力
     print("\n=== エクスポートされたモデル ===")
     print(f"標準版（640x640）: {onnx_path}")
     print(f"軽量版（320x320）: {onnx_path_320}")
+    if int8_path_320:
+        print(f"INT8版（320x320）: {int8_path_320}")
     print("\n=== 使用方法 ===")
     print("1. ONNXモデルをRaspberry Piにコピー:")
     print(f"   scp {onnx_path_320} ryo@192.168.1.156:/home/ryo/models/")
     print("2. C++コードで読み込み:")
     print("   cv::dnn::readNetFromONNX(\"/home/ryo/models/yolov8n.onnx\")")
+    print("3. robot_headで使用:")
+    print("   sudo ./robot_head --stream --model ./Data/models/yolov8n_320_int8.onnx")
+    print("4. FP32とINT8の比較:")
+    print("   ./detector_bench --frames <frame_dir> --model yolov8n_320.onnx --model yolov8n_320_int8.onnx")
+    print("5. マニフェストに実測値（レイテンシ、RSS）を記録:")
+    print("   ./detector_bench --frames <frame_dir> --model yolov8n_320.onnx --model yolov8n_320_int8.onnx --write-manifest")
     
     return onnx_path, onnx_path_320
 
 if __name__ == "__main__":
     try:
-        export_yolov8_onnx_int8()
+        export_yolov8_onnx_int8(sys.argv[1] if len(sys.argv) > 1 else None)
     except Exception as e:
         print(f"エラー: {e}")
         print("\n必要なパッケージをインストールしてください:")